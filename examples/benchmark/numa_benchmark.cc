@@ -0,0 +1,157 @@
+//
+// MIT License
+// Copyright (c) 2019 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+/// \file numa_benchmark.cc
+/// \brief Bandwidth of tasks reading arrays which were first-touched on the NUMA
+/// node of the worker (local) vs. on another node (remote)
+
+#include "PTL/Concurrency.hh"
+#include "PTL/TaskGroup.hh"
+#include "PTL/ThreadPool.hh"
+#include "PTL/Timer.hh"
+#include "PTL/Topology.hh"
+#include "PTL/Utility.hh"
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+using namespace PTL;
+
+using value_type = double;
+using chunk_type = std::unique_ptr<value_type[]>;
+
+//============================================================================//
+
+// runs the function nitr times and returns the best time in seconds
+template <typename FuncT>
+double
+measure(int nitr, FuncT&& _func)
+{
+    double _best = 0.0;
+    for(int i = 0; i < nitr; ++i)
+    {
+        Timer _timer{};
+        _timer.Start();
+        _func();
+        _timer.Stop();
+        if(i == 0 || _timer.GetRealElapsed() < _best)
+            _best = _timer.GetRealElapsed();
+    }
+    return _best;
+}
+
+// prints the bandwidth given the number of bytes read
+void
+report(const char* _label, size_t _nthreads, size_t _bytes, double _secs)
+{
+    printf("[ptl-numa-benchmark]> %-24s threads: %3lu, time: %10.6f s, bandwidth: "
+           "%8.3f GB/s\n",
+           _label, (unsigned long) _nthreads, _secs, (_bytes / _secs) * 1.0e-9);
+}
+
+//============================================================================//
+
+int
+main(int argc, char** argv)
+{
+    const auto& _topo     = Topology::instance();
+    auto        _nthreads = GetEnv<size_t>("NUM_THREADS", effective_concurrency());
+    auto        _size     = GetEnv<size_t>("NUMA_CHUNK_SIZE", 1 << 20);
+    auto        _nchunks  = GetEnv<size_t>("NUMA_CHUNKS", 4 * _nthreads);
+    auto        _nitr     = GetEnv<int>("NUMA_ITERATIONS", 5);
+    const auto& _nodes    = _topo.nodes();
+    if(argc > 1)
+        _size = std::stoul(argv[1]);
+
+    printf("[ptl-numa-benchmark]> %lu NUMA node(s), %lu socket(s), %lu core(s), %lu "
+           "cpu(s)\n",
+           (unsigned long) _topo.num_nodes(), (unsigned long) _topo.num_sockets(),
+           (unsigned long) _topo.num_cores(), (unsigned long) _topo.num_cpus());
+    if(_nodes.size() < 2)
+        printf("[ptl-numa-benchmark]> single NUMA node: local and remote are the "
+               "same\n");
+
+    // alternate the workers between the nodes so every node has workers
+    ThreadPool::Config _cfg{};
+    _cfg.pool_size = _nthreads;
+    _cfg.placement = cpu_placement::NUMA_ROUND_ROBIN;
+    ThreadPool _pool{ _cfg };
+
+    // the ID of the i-th node modulo the number of nodes (the IDs are not contiguous
+    // when the process is restricted to some of the nodes)
+    auto _node_id = [&_nodes](size_t i) {
+        return (_nodes.empty()) ? 0 : _nodes.at(i % _nodes.size());
+    };
+
+    // chunk i belongs to the node (i % nnodes) and its pages are first-touched by a
+    // task queued on that node
+    std::vector<chunk_type> _chunks(_nchunks);
+    std::vector<value_type> _sums(_nchunks, 0.0);
+    {
+        TaskGroup<void> _tg{ &_pool };
+        for(size_t i = 0; i < _nchunks; ++i)
+        {
+            _chunks.at(i) = chunk_type{ new value_type[_size] };
+            _tg.set_numa_node(_node_id(i));
+            auto* _data = _chunks.at(i).get();
+            _tg.run([_data, _size, i]() {
+                for(size_t j = 0; j < _size; ++j)
+                    _data[j] = static_cast<value_type>(i + j);
+            });
+        }
+        _tg.join();
+    }
+
+    auto _read = [&](int _offset) {
+        TaskGroup<void> _tg{ &_pool };
+        for(size_t i = 0; i < _nchunks; ++i)
+        {
+            _tg.set_numa_node(_node_id(i + _offset));
+            auto* _data = _chunks.at(i).get();
+            auto* _sum  = &_sums.at(i);
+            _tg.run([_data, _sum, _size]() {
+                value_type _v = 0.0;
+                for(size_t j = 0; j < _size; ++j)
+                    _v += _data[j];
+                *_sum = _v;
+            });
+        }
+        _tg.join();
+    };
+
+    size_t _bytes = _nchunks * _size * sizeof(value_type);
+    double _secs  = measure(_nitr, [&]() { _read(0); });
+    report("node-local", _nthreads, _bytes, _secs);
+
+    _secs = measure(_nitr, [&]() { _read(1); });
+    report("node-remote", _nthreads, _bytes, _secs);
+
+    for(size_t i = 0; i < _nchunks; ++i)
+    {
+        value_type _n      = static_cast<value_type>(_size);
+        value_type _expect = _n * i + 0.5 * _n * (_n - 1);
+        if(_sums.at(i) != _expect)
+            throw std::runtime_error("numa benchmark produced the wrong result");
+    }
+
+    _pool.destroy_threadpool();
+    return 0;
+}
@@ -0,0 +1,197 @@
+//
+// MIT License
+// Copyright (c) 2019 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+/// \file pipeline_benchmark.cc
+/// \brief Streaming load -> rotate -> reconstruct -> write of synthetic images
+/// written as batches of TaskGroup stages (one barrier per stage) vs. a
+/// parallel_pipeline with a bounded number of tokens in flight
+
+#include "PTL/Concurrency.hh"
+#include "PTL/ParallelPipeline.hh"
+#include "PTL/TaskGroup.hh"
+#include "PTL/ThreadPool.hh"
+#include "PTL/Timer.hh"
+#include "PTL/Utility.hh"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace PTL;
+
+using image_t = std::vector<float>;
+
+//============================================================================//
+
+struct frame
+{
+    size_t  index = 0;
+    image_t data  = {};
+};
+
+// "reads" the image with the given index
+frame
+load(size_t _index, size_t _size)
+{
+    frame _frame{};
+    _frame.index = _index;
+    _frame.data.resize(_size * _size);
+    std::mt19937_64 _rng{ _index };
+    for(auto& itr : _frame.data)
+        itr = static_cast<float>(_rng() % 256);
+    return _frame;
+}
+
+// nearest-neighbor rotation about the center of the image
+frame
+rotate(frame&& _frame, size_t _size, float _theta)
+{
+    image_t _out(_frame.data.size(), 0.0f);
+    float   _c  = std::cos(_theta);
+    float   _s  = std::sin(_theta);
+    float   _mx = 0.5f * _size;
+    for(size_t j = 0; j < _size; ++j)
+    {
+        for(size_t i = 0; i < _size; ++i)
+        {
+            float _x = _c * (i - _mx) - _s * (j - _mx) + _mx;
+            float _y = _s * (i - _mx) + _c * (j - _mx) + _mx;
+            if(_x < 0.0f || _y < 0.0f || _x >= _size || _y >= _size)
+                continue;
+            _out[j * _size + i] = _frame.data[size_t(_y) * _size + size_t(_x)];
+        }
+    }
+    _frame.data = std::move(_out);
+    return std::move(_frame);
+}
+
+// rotates back and computes the difference with the source
+frame
+reconstruct(frame&& _frame, size_t _size, float _theta)
+{
+    auto _back = rotate(std::move(_frame), _size, -_theta);
+    auto _src  = load(_back.index, _size);
+    for(size_t i = 0; i < _back.data.size(); ++i)
+        _back.data[i] = std::fabs(_back.data[i] - _src.data[i]);
+    return _back;
+}
+
+// "writes" the image: accumulates the checksum in order
+void
+write(const frame& _frame, size_t& _next, double& _checksum)
+{
+    if(_frame.index != _next++)
+        throw std::runtime_error("frames written out of order");
+    for(const auto& itr : _frame.data)
+        _checksum += itr;
+}
+
+//============================================================================//
+
+int
+main(int argc, char** argv)
+{
+    auto _hwthreads = PTL::effective_concurrency();
+    auto _nframes   = GetEnv<size_t>("PIPELINE_FRAMES", 256);
+    auto _size      = GetEnv<size_t>("PIPELINE_IMAGE_SIZE", 512);
+    auto _ntokens   = GetEnv<size_t>("PIPELINE_TOKENS", 2 * _hwthreads);
+    auto _maxthr    = GetEnv<size_t>("NUM_THREADS", _hwthreads);
+    if(argc > 1)
+        _nframes = std::stoul(argv[1]);
+
+    const float _theta = 0.25f * static_cast<float>(M_PI);
+
+    for(size_t _nthreads = 1; _nthreads <= _maxthr; _nthreads *= 2)
+    {
+        ThreadPool _pool{ _nthreads };
+
+        // batches of frames, each stage joined before the next begins
+        double _staged_sum = 0.0;
+        size_t _next       = 0;
+        Timer  _staged{};
+        _staged.Start();
+        for(size_t _beg = 0; _beg < _nframes; _beg += _ntokens)
+        {
+            size_t             _end = std::min(_beg + _ntokens, _nframes);
+            std::vector<frame> _frames(_end - _beg);
+
+            TaskGroup<void> _tg{ &_pool };
+            for(size_t i = _beg; i < _end; ++i)
+                _tg.exec([&, i]() { _frames[i - _beg] = load(i, _size); });
+            _tg.join();
+            for(auto& itr : _frames)
+                _tg.exec([&]() { itr = rotate(std::move(itr), _size, _theta); });
+            _tg.join();
+            for(auto& itr : _frames)
+                _tg.exec([&]() { itr = reconstruct(std::move(itr), _size, _theta); });
+            _tg.join();
+            for(auto& itr : _frames)
+                write(itr, _next, _staged_sum);
+        }
+        _staged.Stop();
+
+        // pipeline: the same stages with at most _ntokens frames in flight
+        double _pipeline_sum = 0.0;
+        size_t _input        = 0;
+        _next                = 0;
+        Timer _pipelined{};
+        _pipelined.Start();
+        auto _load = [&](flow_control& _fc) {
+            if(_input == _nframes)
+            {
+                _fc.stop();
+                return frame{};
+            }
+            return load(_input++, _size);
+        };
+        auto _rotate = [&](frame _frame) {
+            return rotate(std::move(_frame), _size, _theta);
+        };
+        auto _reconstruct = [&](frame _frame) {
+            return reconstruct(std::move(_frame), _size, _theta);
+        };
+        auto _write = [&](frame _frame) { write(_frame, _next, _pipeline_sum); };
+
+        parallel_pipeline(
+            _ntokens,
+            make_filter<void, frame>(filter_mode::serial_in_order, _load) &
+                make_filter<frame, frame>(filter_mode::parallel, _rotate) &
+                make_filter<frame, frame>(filter_mode::parallel, _reconstruct) &
+                make_filter<frame, void>(filter_mode::serial_in_order, _write),
+            &_pool);
+        _pipelined.Stop();
+
+        if(_staged_sum != _pipeline_sum)
+            throw std::runtime_error("parallel_pipeline produced the wrong result");
+
+        printf("[ptl-pipeline-benchmark]> threads: %3lu, tokens: %3lu, frames: %5lu, "
+               "staged: %10.6f s, pipeline: %10.6f s, speedup: %6.3f\n",
+               (unsigned long) _nthreads, (unsigned long) _ntokens,
+               (unsigned long) _nframes, _staged.GetRealElapsed(),
+               _pipelined.GetRealElapsed(),
+               _staged.GetRealElapsed() / _pipelined.GetRealElapsed());
+
+        _pool.destroy_threadpool();
+    }
+
+    return 0;
+}
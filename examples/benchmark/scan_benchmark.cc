@@ -0,0 +1,140 @@
+//
+// MIT License
+// Copyright (c) 2019 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+/// \file scan_benchmark.cc
+/// \brief Bandwidth of parallel_scan and parallel_compact vs. the serial STL
+/// algorithms at increasing thread counts
+
+#include "PTL/Concurrency.hh"
+#include "PTL/ParallelAlgorithms.hh"
+#include "PTL/ThreadPool.hh"
+#include "PTL/Timer.hh"
+#include "PTL/Utility.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace PTL;
+
+using value_type = int64_t;
+using array_type = std::vector<value_type>;
+
+//============================================================================//
+
+// runs the function nitr times and returns the best time in seconds
+template <typename FuncT>
+double
+measure(int nitr, FuncT&& _func)
+{
+    double _best = 0.0;
+    for(int i = 0; i < nitr; ++i)
+    {
+        Timer _timer{};
+        _timer.Start();
+        _func();
+        _timer.Stop();
+        if(i == 0 || _timer.GetRealElapsed() < _best)
+            _best = _timer.GetRealElapsed();
+    }
+    return _best;
+}
+
+// prints the bandwidth given the number of bytes read and written
+void
+report(const char* _label, size_t _nthreads, size_t _bytes, double _secs)
+{
+    printf("[ptl-scan-benchmark]> %-24s threads: %3lu, time: %10.6f s, bandwidth: "
+           "%8.3f GB/s\n",
+           _label, (unsigned long) _nthreads, _secs, (_bytes / _secs) * 1.0e-9);
+}
+
+//============================================================================//
+
+int
+main(int argc, char** argv)
+{
+    auto _hwthreads = PTL::effective_concurrency();
+    auto _size      = GetEnv<size_t>("SCAN_SIZE", 1 << 24);
+    auto _nitr      = GetEnv<int>("SCAN_ITERATIONS", 5);
+    auto _maxthr    = GetEnv<size_t>("NUM_THREADS", _hwthreads);
+    if(argc > 1)
+        _size = std::stoul(argv[1]);
+
+    array_type _input(_size);
+    array_type _expect(_size);
+    array_type _output(_size);
+
+    std::mt19937 _rng{ 1 };
+    for(auto& itr : _input)
+        itr = _rng() % 1000;
+
+    auto _pred = [](value_type _v) { return (_v % 4) == 0; };
+
+    // serial reference: read + write of every element
+    size_t _scan_bytes = 2 * _size * sizeof(value_type);
+    double _secs       = measure(_nitr, [&]() {
+#if __cplusplus >= 201703L
+        std::inclusive_scan(_input.begin(), _input.end(), _expect.begin());
+#else
+        std::partial_sum(_input.begin(), _input.end(), _expect.begin());
+#endif
+    });
+    report("std::inclusive_scan", 1, _scan_bytes, _secs);
+
+    array_type _compact_expect{};
+    _compact_expect.reserve(_size);
+    std::copy_if(_input.begin(), _input.end(), std::back_inserter(_compact_expect),
+                 _pred);
+    // read of every element + write of the matching elements
+    size_t _compact_bytes = (_size + _compact_expect.size()) * sizeof(value_type);
+    _secs                 = measure(_nitr, [&]() {
+        std::copy_if(_input.begin(), _input.end(), _output.begin(), _pred);
+    });
+    report("std::copy_if", 1, _compact_bytes, _secs);
+
+    for(size_t _nthreads = 1; _nthreads <= _maxthr; _nthreads *= 2)
+    {
+        ThreadPool _pool{ _nthreads };
+
+        _secs = measure(_nitr, [&]() {
+            parallel_scan(_input.begin(), _input.end(), _output.begin(), &_pool);
+        });
+        if(_output != _expect)
+            throw std::runtime_error("parallel_scan produced the wrong result");
+        report("PTL::parallel_scan", _nthreads, _scan_bytes, _secs);
+
+        _secs = measure(_nitr, [&]() {
+            parallel_compact(_input.begin(), _input.end(), _output.begin(), _pred,
+                             &_pool);
+        });
+        if(!std::equal(_compact_expect.begin(), _compact_expect.end(), _output.begin()))
+            throw std::runtime_error("parallel_compact produced the wrong result");
+        report("PTL::parallel_compact", _nthreads, _compact_bytes, _secs);
+
+        _pool.destroy_threadpool();
+    }
+
+    return 0;
+}
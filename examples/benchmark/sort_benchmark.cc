@@ -0,0 +1,169 @@
+//
+// MIT License
+// Copyright (c) 2019 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+/// \file sort_benchmark.cc
+/// \brief Throughput of parallel_sort vs. std::sort for several input sizes and
+/// distributions at increasing thread counts, including calls from within a task
+
+#include "PTL/Concurrency.hh"
+#include "PTL/ParallelAlgorithms.hh"
+#include "PTL/TaskGroup.hh"
+#include "PTL/ThreadPool.hh"
+#include "PTL/Timer.hh"
+#include "PTL/Utility.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace PTL;
+
+using value_type = int64_t;
+using array_type = std::vector<value_type>;
+
+//============================================================================//
+
+// runs the function nitr times on a fresh copy of the input and returns the best
+// time in seconds
+template <typename FuncT>
+double
+measure(int nitr, const array_type& _input, array_type& _data, FuncT&& _func)
+{
+    double _best = 0.0;
+    for(int i = 0; i < nitr; ++i)
+    {
+        _data = _input;
+        Timer _timer{};
+        _timer.Start();
+        _func();
+        _timer.Stop();
+        if(i == 0 || _timer.GetRealElapsed() < _best)
+            _best = _timer.GetRealElapsed();
+    }
+    return _best;
+}
+
+// prints the sorting rate in millions of elements per second
+void
+report(const char* _label, const char* _dist, size_t _nthreads, size_t _size,
+       double _secs)
+{
+    printf("[ptl-sort-benchmark]> %-20s %-12s size: %10lu, threads: %3lu, time: "
+           "%10.6f s, rate: %9.3f Melem/s\n",
+           _label, _dist, (unsigned long) _size, (unsigned long) _nthreads, _secs,
+           (_size / _secs) * 1.0e-6);
+}
+
+// generates the input of the given distribution
+array_type
+generate(const std::string& _dist, size_t _size)
+{
+    std::mt19937_64 _rng{ 1 };
+    array_type      _data(_size);
+    for(auto& itr : _data)
+        itr = static_cast<value_type>(_rng() >> 1);
+
+    if(_dist == "sorted")
+        std::sort(_data.begin(), _data.end());
+    else if(_dist == "reversed")
+        std::sort(_data.begin(), _data.end(), std::greater<value_type>{});
+    else if(_dist == "few-unique")
+    {
+        for(auto& itr : _data)
+            itr %= 16;
+    }
+    else if(_dist == "nearly-sorted")
+    {
+        std::sort(_data.begin(), _data.end());
+        // swap ~1% of the elements
+        for(size_t i = 0; i < _size / 100; ++i)
+            std::swap(_data[_rng() % _size], _data[_rng() % _size]);
+    }
+    return _data;
+}
+
+//============================================================================//
+
+int
+main(int argc, char** argv)
+{
+    auto _hwthreads = PTL::effective_concurrency();
+    auto _maxsize   = GetEnv<size_t>("SORT_SIZE", 1 << 24);
+    auto _nitr      = GetEnv<int>("SORT_ITERATIONS", 3);
+    auto _maxthr    = GetEnv<size_t>("NUM_THREADS", _hwthreads);
+    if(argc > 1)
+        _maxsize = std::stoul(argv[1]);
+
+    const char* _dists[] = { "random", "sorted", "reversed", "few-unique",
+                             "nearly-sorted" };
+
+    std::vector<size_t> _sizes{};
+    for(size_t _size = 1 << 16; _size < _maxsize; _size *= 16)
+        _sizes.push_back(_size);
+    _sizes.push_back(_maxsize);
+
+    array_type _data{};
+    for(auto _size : _sizes)
+    {
+        for(const auto* _dist : _dists)
+        {
+            array_type _input  = generate(_dist, _size);
+            array_type _expect = _input;
+            std::sort(_expect.begin(), _expect.end());
+
+            double _secs = measure(_nitr, _input, _data,
+                                   [&]() { std::sort(_data.begin(), _data.end()); });
+            report("std::sort", _dist, 1, _size, _secs);
+
+            for(size_t _nthreads = 1; _nthreads <= _maxthr; _nthreads *= 2)
+            {
+                ThreadPool _pool{ _nthreads };
+
+                _secs = measure(_nitr, _input, _data, [&]() {
+                    parallel_sort(_data.begin(), _data.end(), &_pool);
+                });
+                if(_data != _expect)
+                    throw std::runtime_error("parallel_sort produced the wrong result");
+                report("PTL::parallel_sort", _dist, _nthreads, _size, _secs);
+
+                // nested: the sort is invoked from a task on the same pool
+                _secs = measure(_nitr, _input, _data, [&]() {
+                    TaskGroup<void> _tg{ &_pool };
+                    _tg.exec(
+                        [&]() { parallel_sort(_data.begin(), _data.end(), &_pool); });
+                    _tg.join();
+                });
+                if(_data != _expect)
+                    throw std::runtime_error("parallel_sort produced the wrong result");
+                report("PTL::parallel_sort*", _dist, _nthreads, _size, _secs);
+
+                _pool.destroy_threadpool();
+            }
+        }
+    }
+
+    printf("[ptl-sort-benchmark]> (*) invoked from within a task\n");
+
+    return 0;
+}
@@ -0,0 +1,98 @@
+//
+// MIT License
+// Copyright (c) 2019 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+/// \file timing_benchmark.cc
+/// \brief Cost of timing an interval with Timer (times() and the high-resolution
+/// clock) and with a TimingRegion (CycleClock), then fine-grained tasks wrapped in
+/// timing regions reported per region
+
+#include "PTL/Concurrency.hh"
+#include "PTL/TaskGroup.hh"
+#include "PTL/ThreadPool.hh"
+#include "PTL/Timer.hh"
+#include "PTL/TimingRegion.hh"
+#include "PTL/Utility.hh"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+using namespace PTL;
+
+//============================================================================//
+
+int
+main(int argc, char** argv)
+{
+    auto _hwthreads = PTL::effective_concurrency();
+    auto _niter     = GetEnv<size_t>("TIMING_ITERATIONS", 1000000);
+    auto _ntasks    = GetEnv<size_t>("TIMING_TASKS", 100000);
+    auto _work      = GetEnv<size_t>("TIMING_WORK", 100);
+    auto _nthreads  = GetEnv<size_t>("NUM_THREADS", _hwthreads);
+    if(argc > 1)
+        _niter = std::stoul(argv[1]);
+
+    // the cost of an empty interval
+    auto _beg = CycleClock::now();
+    for(size_t i = 0; i < _niter; ++i)
+    {
+        Timer _t{};
+        _t.Start();
+        _t.Stop();
+    }
+    double _timer_cost = CycleClock::seconds(CycleClock::now() - _beg);
+
+    _beg = CycleClock::now();
+    for(size_t i = 0; i < _niter; ++i)
+    {
+        PTL_TIMING_REGION("empty");
+    }
+    double _region_cost = CycleClock::seconds(CycleClock::now() - _beg);
+
+    printf("[ptl-timing-benchmark]> clock: %s (%.3f GHz), Timer: %7.1f ns/interval, "
+           "TimingRegion: %7.1f ns/interval\n",
+           CycleClock::source(), 1.0e-9 * CycleClock::ticks_per_second(),
+           1.0e9 * _timer_cost / _niter, 1.0e9 * _region_cost / _niter);
+
+    // the tasks accumulate into the tables of the workers
+    ThreadPool            _pool{ _nthreads };
+    std::atomic<uint64_t> _sum{ 0 };
+    {
+        PTL_TIMING_REGION("submit and join");
+        TaskGroup<void> _tg{ &_pool };
+        for(size_t i = 0; i < _ntasks; ++i)
+        {
+            _tg.exec([&_sum, i, _work]() {
+                PTL_TIMING_REGION("task");
+                uint64_t _v = i;
+                for(size_t j = 0; j < _work; ++j)
+                    _v = _v * 6364136223846793005ULL + 1442695040888963407ULL;
+                _sum += _v & 1;
+            });
+        }
+        _tg.join();
+    }
+
+    TimingRegion::report(std::cout);
+    TimingRegion::report(std::cout, TimingRegion::timer_reporter());
+
+    _pool.destroy_threadpool();
+    return 0;
+}
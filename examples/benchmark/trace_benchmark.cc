@@ -0,0 +1,104 @@
+//
+// MIT License
+// Copyright (c) 2019 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+/// \file trace_benchmark.cc
+/// \brief Overhead of the TaskTracer: fine-grained tasks executed with the tracer
+/// disabled and enabled (the trace of the last run is written to TRACE_OUTPUT)
+
+#include "PTL/Concurrency.hh"
+#include "PTL/TaskGroup.hh"
+#include "PTL/TaskTracer.hh"
+#include "PTL/ThreadPool.hh"
+#include "PTL/Timer.hh"
+#include "PTL/Utility.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+using namespace PTL;
+
+//============================================================================//
+
+// executes the tasks in batches joined by a task group, returns the wall time
+double
+run(ThreadPool& _pool, size_t _ntasks, size_t _batch, size_t _work)
+{
+    std::atomic<uint64_t> _sum{ 0 };
+    Timer                 _timer{};
+    _timer.Start();
+    for(size_t _beg = 0; _beg < _ntasks; _beg += _batch)
+    {
+        TaskGroup<void> _tg{ &_pool };
+        for(size_t i = _beg; i < std::min(_beg + _batch, _ntasks); ++i)
+        {
+            _tg.exec([&_sum, i, _work]() {
+                uint64_t _v = i;
+                for(size_t j = 0; j < _work; ++j)
+                    _v = _v * 6364136223846793005ULL + 1442695040888963407ULL;
+                _sum += _v & 1;
+            });
+        }
+        _tg.join();
+    }
+    _timer.Stop();
+    return _timer.GetRealElapsed();
+}
+
+//============================================================================//
+
+int
+main(int argc, char** argv)
+{
+    auto _hwthreads = PTL::effective_concurrency();
+    auto _ntasks    = GetEnv<size_t>("TRACE_TASKS", 200000);
+    auto _batch     = GetEnv<size_t>("TRACE_BATCH", 1000);
+    auto _work      = GetEnv<size_t>("TRACE_WORK", 100);
+    auto _nthreads  = GetEnv<size_t>("NUM_THREADS", _hwthreads);
+    auto _output    = GetEnv<std::string>("TRACE_OUTPUT", "");
+    if(argc > 1)
+        _ntasks = std::stoul(argv[1]);
+
+    ThreadPool _pool{ _nthreads };
+
+    // warm-up
+    run(_pool, _batch, _batch, _work);
+
+    TaskTracer::disable();
+    double _disabled = run(_pool, _ntasks, _batch, _work);
+
+    TaskTracer::enable();
+    double _enabled = run(_pool, _ntasks, _batch, _work);
+    TaskTracer::disable();
+
+    printf("[ptl-trace-benchmark]> threads: %3lu, tasks: %8lu, disabled: %10.6f s "
+           "(%7.1f ns/task), enabled: %10.6f s (%7.1f ns/task), overhead: %6.2f %%\n",
+           (unsigned long) _nthreads, (unsigned long) _ntasks, _disabled,
+           1.0e9 * _disabled / _ntasks, _enabled, 1.0e9 * _enabled / _ntasks,
+           100.0 * (_enabled - _disabled) / _disabled);
+
+    if(!_output.empty() && !TaskTracer::dump(_output))
+        fprintf(stderr, "[ptl-trace-benchmark]> unable to write '%s'\n",
+                _output.c_str());
+
+    _pool.destroy_threadpool();
+    return 0;
+}
@@ -0,0 +1,253 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//
+// ---------------------------------------------------------------
+//  Tasking class implementation
+//
+// Class Description:
+//
+// This file implements the detection of the CPU affinity mask and the
+// cgroup CPU quota of the process
+//
+// ---------------------------------------------------------------
+
+#include "PTL/Concurrency.hh"
+
+#include "PTL/Topology.hh"
+#include "PTL/Types.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+//======================================================================================//
+
+namespace PTL
+{
+namespace
+{
+//======================================================================================//
+
+bool
+read_file(const std::string& _fname, std::string& _contents)
+{
+    std::ifstream ifs{ _fname };
+    if(!ifs)
+        return false;
+    std::stringstream ss;
+    ss << ifs.rdbuf();
+    _contents = ss.str();
+    return true;
+}
+
+//--------------------------------------------------------------------------------------//
+
+// a limit of zero means unlimited
+double
+min_limit(double _lhs, double _rhs)
+{
+    if(_lhs <= 0.0)
+        return _rhs;
+    if(_rhs <= 0.0)
+        return _lhs;
+    return std::min(_lhs, _rhs);
+}
+
+//--------------------------------------------------------------------------------------//
+
+// the directories from <root>/<path> up to <root>. Inside a cgroup namespace the
+// path of the process may not exist below the mount point so missing levels are
+// simply skipped when read
+std::vector<std::string>
+cgroup_hierarchy(const std::string& _root, std::string _path)
+{
+    std::vector<std::string> _dirs{};
+    while(!_path.empty() && _path.back() == '/')
+        _path.pop_back();
+    while(!_path.empty())
+    {
+        _dirs.emplace_back(_root + _path);
+        auto _pos = _path.find_last_of('/');
+        _path     = (_pos == std::string::npos) ? std::string{} : _path.substr(0, _pos);
+    }
+    _dirs.emplace_back(_root);
+    return _dirs;
+}
+
+//--------------------------------------------------------------------------------------//
+
+double
+cgroup_v2_limit(const std::string& _root, const std::string& _path)
+{
+    double _limit = 0.0;
+    for(const auto& itr : cgroup_hierarchy(_root, _path))
+    {
+        std::string _contents{};
+        if(read_file(itr + "/cpu.max", _contents))
+            _limit = min_limit(_limit, concurrency::parse_cpu_max(_contents));
+    }
+    return _limit;
+}
+
+//--------------------------------------------------------------------------------------//
+
+double
+cgroup_v1_limit(const std::string& _root, const std::string& _controllers,
+                const std::string& _path)
+{
+    // the cpu controller is usually co-mounted with cpuacct
+    for(const auto& _mount : { _controllers, std::string{ "cpu,cpuacct" },
+                               std::string{ "cpuacct,cpu" }, std::string{ "cpu" } })
+    {
+        double _limit = 0.0;
+        bool   _found = false;
+        for(const auto& itr : cgroup_hierarchy(_root + "/" + _mount, _path))
+        {
+            std::string _quota{};
+            std::string _period{};
+            if(!read_file(itr + "/cpu.cfs_quota_us", _quota) ||
+               !read_file(itr + "/cpu.cfs_period_us", _period))
+                continue;
+            _found = true;
+            try
+            {
+                _limit = min_limit(_limit, concurrency::parse_cfs_quota(
+                                               std::stoll(_quota), std::stoll(_period)));
+            } catch(std::exception&)
+            {}
+        }
+        if(_found)
+            return _limit;
+    }
+    return 0.0;
+}
+
+//======================================================================================//
+}  // namespace
+
+//======================================================================================//
+
+unsigned
+effective_concurrency()
+{
+    static unsigned _v = concurrency::effective_concurrency(
+        concurrency::affinity_cpus(), concurrency::cgroup_cpu_limit());
+    return _v;
+}
+
+//======================================================================================//
+
+unsigned
+concurrency::affinity_cpus()
+{
+    return std::max<unsigned>(Topology::allowed_cpus().size(), 1);
+}
+
+//======================================================================================//
+
+double
+concurrency::cgroup_cpu_limit(const std::string& _proc_self_cgroup,
+                              const std::string& _cgroup_root)
+{
+    std::ifstream ifs{ _proc_self_cgroup };
+    if(!ifs)
+        return cgroup_v2_limit(_cgroup_root, "/");
+
+    // each line is <hierarchy-id>:<controller-list>:<path>. The cgroup v2 entry has
+    // an empty controller list, cgroup v1 has one line per hierarchy
+    double      _limit = 0.0;
+    std::string _line{};
+    while(std::getline(ifs, _line))
+    {
+        auto _first = _line.find(':');
+        if(_first == std::string::npos)
+            continue;
+        auto _second = _line.find(':', _first + 1);
+        if(_second == std::string::npos)
+            continue;
+
+        auto _controllers = _line.substr(_first + 1, _second - _first - 1);
+        auto _path        = _line.substr(_second + 1);
+        if(_controllers.empty())
+        {
+            _limit = min_limit(_limit, cgroup_v2_limit(_cgroup_root, _path));
+            continue;
+        }
+
+        std::stringstream ss{ _controllers };
+        std::string       _controller{};
+        while(std::getline(ss, _controller, ','))
+        {
+            if(_controller == "cpu")
+            {
+                _limit =
+                    min_limit(_limit, cgroup_v1_limit(_cgroup_root, _controllers, _path));
+                break;
+            }
+        }
+    }
+    return _limit;
+}
+
+//======================================================================================//
+
+double
+concurrency::parse_cpu_max(const std::string& _contents)
+{
+    std::stringstream ss{ _contents };
+    std::string       _quota{};
+    int64_t           _period = 100000;
+    ss >> _quota >> _period;
+    if(_quota.empty() || _quota == "max" || _period <= 0)
+        return 0.0;
+    try
+    {
+        return std::max(std::stod(_quota), 0.0) / static_cast<double>(_period);
+    } catch(std::exception&)
+    {
+        return 0.0;
+    }
+}
+
+//======================================================================================//
+
+double
+concurrency::parse_cfs_quota(int64_t _quota, int64_t _period)
+{
+    if(_quota <= 0 || _period <= 0)
+        return 0.0;
+    return static_cast<double>(_quota) / static_cast<double>(_period);
+}
+
+//======================================================================================//
+
+unsigned
+concurrency::effective_concurrency(unsigned _cpus, double _cpu_limit)
+{
+    unsigned _n = std::max<unsigned>(_cpus, 1);
+    if(_cpu_limit > 0.0)
+        _n = std::min(_n, std::max<unsigned>(std::ceil(_cpu_limit), 1));
+    return _n;
+}
+
+//======================================================================================//
+
+}  // namespace PTL
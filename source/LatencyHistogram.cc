@@ -0,0 +1,236 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ---------------------------------------------------------------
+//  Tasking class implementation
+//
+// Class Description:
+//
+// This file implements the log-linear latency histograms
+//
+// ---------------------------------------------------------------
+
+#include "PTL/LatencyHistogram.hh"
+
+#include "PTL/Utility.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <ostream>
+
+//======================================================================================//
+
+namespace PTL
+{
+//======================================================================================//
+
+std::atomic<bool> TaskLatency::f_enabled{ GetEnv<bool>("PTL_LATENCY", false) };
+
+//======================================================================================//
+
+LatencyHistogram::LatencyHistogram(const LatencyHistogram& rhs)
+{
+    merge(rhs);
+}
+
+//======================================================================================//
+
+LatencyHistogram&
+LatencyHistogram::operator=(const LatencyHistogram& rhs)
+{
+    if(this != &rhs)
+    {
+        reset();
+        merge(rhs);
+    }
+    return *this;
+}
+
+//======================================================================================//
+
+size_t
+LatencyHistogram::bucket(uint64_t _ns)
+{
+    if(_ns < sub_buckets)
+        return static_cast<size_t>(_ns);
+#if defined(__GNUC__)
+    size_t _msb = 63 - static_cast<size_t>(__builtin_clzll(_ns));
+#else
+    size_t _msb = 0;
+    while((_ns >> _msb) > 1)
+        ++_msb;
+#endif
+    // the sub-bucket is given by the bits following the most significant bit
+    size_t _shift = _msb - sub_bucket_bits;
+    return (_shift + 1) * sub_buckets + static_cast<size_t>(_ns >> _shift) - sub_buckets;
+}
+
+//======================================================================================//
+
+uint64_t
+LatencyHistogram::lower_bound(size_t _bucket)
+{
+    if(_bucket < sub_buckets)
+        return _bucket;
+    size_t _shift = _bucket / sub_buckets - 1;
+    return static_cast<uint64_t>(sub_buckets + _bucket % sub_buckets) << _shift;
+}
+
+//======================================================================================//
+
+uint64_t
+LatencyHistogram::upper_bound(size_t _bucket)
+{
+    if(_bucket < sub_buckets)
+        return _bucket;
+    size_t _shift = _bucket / sub_buckets - 1;
+    return lower_bound(_bucket) + ((uint64_t{ 1 } << _shift) - 1);
+}
+
+//======================================================================================//
+
+void
+LatencyHistogram::record(uint64_t _ns)
+{
+    m_counts[bucket(_ns)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(_ns, std::memory_order_relaxed);
+
+    auto _min = m_min.load(std::memory_order_relaxed);
+    while(_ns < _min &&
+          !m_min.compare_exchange_weak(_min, _ns, std::memory_order_relaxed))
+    {}
+    auto _max = m_max.load(std::memory_order_relaxed);
+    while(_ns > _max &&
+          !m_max.compare_exchange_weak(_max, _ns, std::memory_order_relaxed))
+    {}
+}
+
+//======================================================================================//
+
+void
+LatencyHistogram::merge(const LatencyHistogram& rhs)
+{
+    for(size_t i = 0; i < num_buckets; ++i)
+    {
+        auto _n = rhs.m_counts[i].load(std::memory_order_relaxed);
+        if(_n > 0)
+            m_counts[i].fetch_add(_n, std::memory_order_relaxed);
+    }
+    m_count.fetch_add(rhs.m_count.load(std::memory_order_relaxed),
+                      std::memory_order_relaxed);
+    m_sum.fetch_add(rhs.m_sum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+    auto _rmin = rhs.m_min.load(std::memory_order_relaxed);
+    auto _min  = m_min.load(std::memory_order_relaxed);
+    while(_rmin < _min &&
+          !m_min.compare_exchange_weak(_min, _rmin, std::memory_order_relaxed))
+    {}
+    auto _rmax = rhs.m_max.load(std::memory_order_relaxed);
+    auto _max  = m_max.load(std::memory_order_relaxed);
+    while(_rmax > _max &&
+          !m_max.compare_exchange_weak(_max, _rmax, std::memory_order_relaxed))
+    {}
+}
+
+//======================================================================================//
+
+void
+LatencyHistogram::reset()
+{
+    for(auto& itr : m_counts)
+        itr.store(0, std::memory_order_relaxed);
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_min.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+//======================================================================================//
+
+uint64_t
+LatencyHistogram::min() const
+{
+    return (count() > 0) ? m_min.load(std::memory_order_relaxed) : 0;
+}
+
+//======================================================================================//
+
+double
+LatencyHistogram::mean() const
+{
+    auto _n = count();
+    return (_n > 0) ? static_cast<double>(m_sum.load(std::memory_order_relaxed)) / _n
+                    : 0.0;
+}
+
+//======================================================================================//
+
+uint64_t
+LatencyHistogram::percentile(double _p) const
+{
+    // the counts are read once: the buckets may be updated while they are summed
+    count_type _total = 0;
+    count_type _counts[num_buckets];
+    for(size_t i = 0; i < num_buckets; ++i)
+        _total += (_counts[i] = m_counts[i].load(std::memory_order_relaxed));
+    if(_total == 0)
+        return 0;
+
+    _p = std::min(std::max(_p, 0.0), 100.0);
+    auto _rank =
+        std::max<count_type>(static_cast<count_type>(std::ceil(_p / 100.0 * _total)), 1);
+    count_type _sum = 0;
+    for(size_t i = 0; i < num_buckets; ++i)
+    {
+        _sum += _counts[i];
+        if(_sum >= _rank)
+            return std::min(upper_bound(i), max());
+    }
+    return max();
+}
+
+//======================================================================================//
+
+std::ostream&
+operator<<(std::ostream& os, const TaskLatency& _latency)
+{
+    auto _print = [&os](const char* _label, const LatencyHistogram& _hist) {
+        auto _us = [](uint64_t _ns) { return 1.0e-3 * static_cast<double>(_ns); };
+        os << "    " << std::setw(10) << std::left << _label << std::right
+           << " :: count = " << std::setw(10) << _hist.count() << std::fixed
+           << std::setprecision(3) << ", p50 = " << std::setw(12)
+           << _us(_hist.percentile(50.0)) << " us, p99 = " << std::setw(12)
+           << _us(_hist.percentile(99.0)) << " us, p999 = " << std::setw(12)
+           << _us(_hist.percentile(99.9)) << " us, max = " << std::setw(12)
+           << _us(_hist.max()) << " us\n";
+    };
+
+    auto _flags     = os.flags();
+    auto _precision = os.precision();
+    _print("queue wait", _latency.queue_wait);
+    _print("service", _latency.service);
+    os.flags(_flags);
+    os.precision(_precision);
+    return os;
+}
+
+//======================================================================================//
+
+}  // namespace PTL
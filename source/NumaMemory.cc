@@ -0,0 +1,153 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//
+// ---------------------------------------------------------------
+//  Tasking class implementation
+//
+// Class Description:
+//
+// This file implements the NUMA memory placement helpers via the mbind
+// system call (no dependency on libnuma)
+//
+// ---------------------------------------------------------------
+
+#include "PTL/NumaMemory.hh"
+
+#include "PTL/Topology.hh"
+#include "PTL/Types.hh"
+#include "PTL/Utility.hh"
+
+#include <cstdint>
+#include <new>
+#include <vector>
+
+#if defined(PTL_LINUX) || defined(PTL_MACOS)
+#    include <sys/mman.h>
+#    include <unistd.h>
+#endif
+
+#if defined(PTL_LINUX)
+#    include <sys/syscall.h>
+#endif
+
+//======================================================================================//
+
+namespace PTL
+{
+namespace
+{
+// from linux/mempolicy.h
+const int MPOL_PREFERRED_MODE = 1;
+
+}  // namespace
+
+//======================================================================================//
+
+bool
+numa::available()
+{
+#if defined(PTL_LINUX) && defined(SYS_mbind)
+    static bool _v = (Topology::instance().num_nodes() > 1);
+    return _v;
+#else
+    return false;
+#endif
+}
+
+//======================================================================================//
+
+size_t
+numa::page_size()
+{
+#if defined(PTL_LINUX) || defined(PTL_MACOS)
+    static size_t _v = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return _v;
+#else
+    return 4096;
+#endif
+}
+
+//======================================================================================//
+
+bool
+numa::bind(void* _addr, size_t _bytes, int _node)
+{
+#if defined(PTL_LINUX) && defined(SYS_mbind)
+    if(!available() || _node < 0 || !_addr)
+        return false;
+
+    // mbind only accepts page-aligned addresses
+    auto _page  = static_cast<uintptr_t>(page_size());
+    auto _first = reinterpret_cast<uintptr_t>(_addr);
+    auto _last  = _first + _bytes;
+    _first      = ((_first + _page - 1) / _page) * _page;
+    _last       = (_last / _page) * _page;
+    if(_last <= _first)
+        return false;
+
+    constexpr size_t           _bits = 8 * sizeof(unsigned long);
+    std::vector<unsigned long> _mask(_node / _bits + 1, 0);
+    _mask.at(_node / _bits) |= (1UL << (_node % _bits));
+    return syscall(SYS_mbind, reinterpret_cast<void*>(_first), _last - _first,
+                   MPOL_PREFERRED_MODE, _mask.data(), _mask.size() * _bits + 1, 0) == 0;
+#else
+    ConsumeParameters(_addr, _bytes, _node, MPOL_PREFERRED_MODE);
+    return false;
+#endif
+}
+
+//======================================================================================//
+
+void*
+numa::allocate(size_t _bytes, int _node)
+{
+    if(_bytes == 0)
+        _bytes = 1;
+#if defined(PTL_LINUX) || defined(PTL_MACOS)
+    void* _addr =
+        mmap(nullptr, _bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(_addr == MAP_FAILED)
+        throw std::bad_alloc{};
+    if(_node >= 0)
+        bind(_addr, _bytes, _node);
+    return _addr;
+#else
+    ConsumeParameters(_node);
+    return ::operator new(_bytes);
+#endif
+}
+
+//======================================================================================//
+
+void
+numa::deallocate(void* _addr, size_t _bytes)
+{
+    if(!_addr)
+        return;
+#if defined(PTL_LINUX) || defined(PTL_MACOS)
+    munmap(_addr, (_bytes == 0) ? 1 : _bytes);
+#else
+    ConsumeParameters(_bytes);
+    ::operator delete(_addr);
+#endif
+}
+
+//======================================================================================//
+
+}  // namespace PTL
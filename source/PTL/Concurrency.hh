@@ -0,0 +1,80 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//
+// ---------------------------------------------------------------
+// Tasking class header file
+//
+// Class Description:
+//
+// This file provides the number of CPUs the process can actually use,
+// i.e. the CPU affinity mask limited by the cgroup (v1 or v2) CPU quota,
+// which is the default size of the thread-pools
+//
+// ---------------------------------------------------------------
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace PTL
+{
+//======================================================================================//
+
+/// \brief the number of threads which can run concurrently: the CPUs in the affinity
+/// mask of the process limited by the CPU quota of its cgroup (rounded up).
+/// Computed once, never less than one
+unsigned
+effective_concurrency();
+
+namespace concurrency
+{
+//======================================================================================//
+
+/// number of CPUs in the affinity mask of the process (hardware_concurrency if the
+/// mask is not available)
+unsigned
+affinity_cpus();
+
+/// the CPU limit of the cgroup of the process (e.g. 2.5 for a quota of 250ms per
+/// 100ms period) or zero if there is no limit. The most restrictive limit along the
+/// cgroup hierarchy is used. The paths can be pointed at fixture files for testing
+double
+cgroup_cpu_limit(const std::string& _proc_self_cgroup = "/proc/self/cgroup",
+                 const std::string& _cgroup_root      = "/sys/fs/cgroup");
+
+/// the CPU limit in the contents of a cgroup v2 cpu.max file ("max 100000" or
+/// "<quota> <period>"), zero if there is no limit
+double
+parse_cpu_max(const std::string& _contents);
+
+/// the CPU limit of a cgroup v1 cpu.cfs_quota_us and cpu.cfs_period_us pair,
+/// zero if there is no limit (quota of -1)
+double
+parse_cfs_quota(int64_t _quota, int64_t _period);
+
+/// combine the number of CPUs and a CPU limit into a number of threads
+unsigned
+effective_concurrency(unsigned _cpus, double _cpu_limit);
+
+}  // namespace concurrency
+
+//======================================================================================//
+
+}  // namespace PTL
@@ -0,0 +1,335 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//
+// ---------------------------------------------------------------
+// Tasking class header file
+//
+// Class Description:
+//
+// This file provides a C++20 coroutine task type (CoTask) and the
+// awaitables for suspending a coroutine until a TaskGroup completes
+// or for resuming it on a ThreadPool. A suspended coroutine does not
+// occupy a thread: it is resumed by the worker which completes the
+// dependency. Enabled with the PTL_USE_COROUTINES option
+//
+// ---------------------------------------------------------------
+
+#pragma once
+
+#include "PTL/Config.hh"
+
+#if defined(PTL_USE_COROUTINES) && defined(__cpp_impl_coroutine)
+
+#    include "PTL/AutoLock.hh"
+#    include "PTL/Task.hh"
+#    include "PTL/TaskGroup.hh"
+#    include "PTL/ThreadPool.hh"
+#    include "PTL/Threading.hh"
+
+#    include <coroutine>
+#    include <exception>
+#    include <functional>
+#    include <memory>
+#    include <optional>
+#    include <type_traits>
+#    include <utility>
+
+namespace PTL
+{
+template <typename Tp = void>
+class CoTask;
+
+namespace internal
+{
+//--------------------------------------------------------------------------------------//
+// resumes the coroutine from a task on the thread-pool (or on this thread if the pool
+// has not been built)
+//
+inline void
+resume_on_pool(ThreadPool* _tp, std::coroutine_handle<> _handle)
+{
+    if(!_tp)
+    {
+        _handle.resume();
+        return;
+    }
+    auto _func = [_handle]() { _handle.resume(); };
+    _tp->add_task(std::make_shared<PackagedTask<void>>(std::move(_func)));
+}
+
+//--------------------------------------------------------------------------------------//
+// common part of the promise of a CoTask. The coroutine starts suspended and, upon
+// completion, transfers control to the awaiting coroutine (if any) or invokes the
+// completion callback of sync_wait
+//
+class co_promise_base
+{
+public:
+    struct final_awaiter
+    {
+        bool await_ready() noexcept { return false; }
+        void await_resume() noexcept {}
+
+        template <typename PromiseT>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<PromiseT> _h) noexcept
+        {
+            auto& _promise = _h.promise();
+            if(_promise.m_continuation)
+                return _promise.m_continuation;
+            // the callback may destroy the coroutine so it is moved out of the frame
+            auto _func = std::move(_promise.m_on_done);
+            if(_func)
+                _func();
+            return std::noop_coroutine();
+        }
+    };
+
+public:
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    final_awaiter       final_suspend() noexcept { return {}; }
+    void unhandled_exception() noexcept { m_exception = std::current_exception(); }
+
+    void set_continuation(std::coroutine_handle<> _h) { m_continuation = _h; }
+    void set_on_done(std::function<void()>&& _func) { m_on_done = std::move(_func); }
+    void rethrow() const
+    {
+        if(m_exception)
+            std::rethrow_exception(m_exception);
+    }
+
+private:
+    std::coroutine_handle<> m_continuation = {};
+    std::function<void()>   m_on_done      = {};
+    std::exception_ptr      m_exception    = {};
+};
+
+//--------------------------------------------------------------------------------------//
+
+template <typename Tp>
+class co_promise : public co_promise_base
+{
+public:
+    CoTask<Tp> get_return_object() noexcept;
+
+    template <typename Up>
+    void return_value(Up&& _value)
+    {
+        m_value.emplace(std::forward<Up>(_value));
+    }
+
+    Tp result()
+    {
+        rethrow();
+        return std::move(*m_value);
+    }
+
+private:
+    std::optional<Tp> m_value = {};
+};
+
+//--------------------------------------------------------------------------------------//
+
+template <>
+class co_promise<void> : public co_promise_base
+{
+public:
+    CoTask<void> get_return_object() noexcept;
+
+    void return_void() noexcept {}
+    void result() { rethrow(); }
+};
+
+}  // namespace internal
+
+//======================================================================================//
+
+/// \brief lazily started coroutine returning a value of type Tp. The coroutine starts
+/// when it is awaited (co_await) or passed to sync_wait. Within the coroutine:
+///     co_await resume_on(tp)      continues the coroutine on a worker of tp
+///     co_await task_group         suspends until the TaskGroup has no pending tasks
+///                                 and returns the result of join()
+///     co_await other_cotask       starts the other coroutine and returns its result
+template <typename Tp>
+class CoTask
+{
+public:
+    using promise_type = internal::co_promise<Tp>;
+    using handle_type  = std::coroutine_handle<promise_type>;
+    using result_type  = Tp;
+
+public:
+    CoTask() = default;
+    explicit CoTask(handle_type _handle)
+    : m_handle{ _handle }
+    {}
+
+    ~CoTask()
+    {
+        if(m_handle)
+            m_handle.destroy();
+    }
+
+    CoTask(const CoTask&) = delete;
+    CoTask& operator=(const CoTask&) = delete;
+
+    CoTask(CoTask&& rhs) noexcept
+    : m_handle{ std::exchange(rhs.m_handle, {}) }
+    {}
+
+    CoTask& operator=(CoTask&& rhs) noexcept
+    {
+        if(this != &rhs)
+        {
+            if(m_handle)
+                m_handle.destroy();
+            m_handle = std::exchange(rhs.m_handle, {});
+        }
+        return *this;
+    }
+
+public:
+    bool        valid() const { return static_cast<bool>(m_handle); }
+    bool        done() const { return !m_handle || m_handle.done(); }
+    handle_type handle() const { return m_handle; }
+
+    // the result (or rethrows the exception) of a completed coroutine
+    Tp get() { return m_handle.promise().result(); }
+
+    auto operator co_await() noexcept
+    {
+        struct awaiter
+        {
+            handle_type m_handle;
+
+            bool await_ready() const noexcept { return !m_handle || m_handle.done(); }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> _awaiting)
+            {
+                m_handle.promise().set_continuation(_awaiting);
+                return m_handle;
+            }
+
+            Tp await_resume() { return m_handle.promise().result(); }
+        };
+        return awaiter{ m_handle };
+    }
+
+private:
+    handle_type m_handle = {};
+};
+
+//--------------------------------------------------------------------------------------//
+
+namespace internal
+{
+template <typename Tp>
+inline CoTask<Tp>
+co_promise<Tp>::get_return_object() noexcept
+{
+    return CoTask<Tp>{ std::coroutine_handle<co_promise<Tp>>::from_promise(*this) };
+}
+
+inline CoTask<void>
+co_promise<void>::get_return_object() noexcept
+{
+    return CoTask<void>{ std::coroutine_handle<co_promise<void>>::from_promise(*this) };
+}
+}  // namespace internal
+
+//======================================================================================//
+
+/// \brief awaitable which suspends the coroutine and resumes it on a worker of the
+/// thread-pool
+inline auto
+resume_on(ThreadPool* _tp = internal::get_default_threadpool())
+{
+    struct awaiter
+    {
+        ThreadPool* m_pool;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> _h)
+        {
+            internal::resume_on_pool(m_pool, _h);
+        }
+        void await_resume() const noexcept {}
+    };
+    return awaiter{ _tp };
+}
+
+//--------------------------------------------------------------------------------------//
+/// \brief awaitable which suspends the coroutine until the task group has no pending
+/// tasks. The coroutine is resumed on the pool of the task group and the result of
+/// TaskGroup::join() is returned
+template <typename Tp, typename Arg, intmax_t MaxDepth>
+auto
+operator co_await(TaskGroup<Tp, Arg, MaxDepth>& _tg)
+{
+    struct awaiter
+    {
+        TaskGroup<Tp, Arg, MaxDepth>& m_tg;
+
+        bool await_ready() { return m_tg.pending() < 1; }
+        bool await_suspend(std::coroutine_handle<> _h)
+        {
+            // the last task completes before its result is stored in the future so
+            // the coroutine is not resumed inline (join() would wait on this thread)
+            auto* _tp = m_tg.pool();
+            return m_tg.on_completion([_tp, _h]() { internal::resume_on_pool(_tp, _h); });
+        }
+        auto await_resume() { return m_tg.join(); }
+    };
+    return awaiter{ _tg };
+}
+
+//--------------------------------------------------------------------------------------//
+/// \brief starts the coroutine on the calling thread and blocks until it completes.
+/// Intended for the entry point from non-coroutine code: calling it from within a task
+/// ties up the worker, so use co_await inside coroutines instead
+template <typename Tp>
+Tp
+sync_wait(CoTask<Tp>& _task)
+{
+    if(!_task.done())
+    {
+        Mutex     _lock{};
+        Condition _cond{};
+        bool      _finished = false;
+        _task.handle().promise().set_on_done([&]() {
+            AutoLock _lk{ _lock };
+            _finished = true;
+            _cond.notify_all();
+        });
+        _task.handle().resume();
+        AutoLock _lk{ _lock };
+        _cond.wait(_lk, [&]() { return _finished; });
+    }
+    return _task.get();
+}
+
+template <typename Tp>
+Tp
+sync_wait(CoTask<Tp>&& _task)
+{
+    return sync_wait(_task);
+}
+
+}  // namespace PTL
+
+#endif
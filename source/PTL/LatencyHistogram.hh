@@ -0,0 +1,147 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ---------------------------------------------------------------
+// Tasking class header file
+//
+// Class Description:
+//
+// This file provides the log-linear histograms of the queue wait and the
+// service time of the tasks
+//
+// ---------------------------------------------------------------
+
+#pragma once
+
+#include "PTL/Config.hh"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <limits>
+
+namespace PTL
+{
+//======================================================================================//
+
+/// \brief LatencyHistogram counts durations (in nanoseconds) in log-linear buckets
+/// (HDR-style): every power of two is split into 16 sub-buckets so a percentile is
+/// within about 6% of the recorded value. Any thread may record and histograms can
+/// be merged, e.g. the histograms of the workers into the histogram of the pool
+class LatencyHistogram
+{
+public:
+    using count_type = uint64_t;
+
+    static constexpr size_t sub_bucket_bits = 4;
+    static constexpr size_t sub_buckets     = size_t{ 1 } << sub_bucket_bits;
+    static constexpr size_t num_buckets     = (64 - sub_bucket_bits + 1) * sub_buckets;
+
+public:
+    LatencyHistogram() = default;
+    LatencyHistogram(const LatencyHistogram&);
+    LatencyHistogram& operator=(const LatencyHistogram&);
+
+    void record(uint64_t _ns);
+    void merge(const LatencyHistogram&);
+    void reset();
+
+    count_type count() const { return m_count.load(std::memory_order_relaxed); }
+    uint64_t   min() const;
+    uint64_t   max() const { return m_max.load(std::memory_order_relaxed); }
+    double     mean() const;
+    // the value (ns) which _p percent of the recorded values do not exceed
+    uint64_t percentile(double _p) const;
+
+    static size_t   bucket(uint64_t _ns);
+    static uint64_t lower_bound(size_t _bucket);
+    static uint64_t upper_bound(size_t _bucket);
+
+private:
+    std::atomic<count_type> m_counts[num_buckets] = {};
+    std::atomic<count_type> m_count{ 0 };
+    std::atomic<uint64_t>   m_sum{ 0 };
+    std::atomic<uint64_t>   m_min{ std::numeric_limits<uint64_t>::max() };
+    std::atomic<uint64_t>   m_max{ 0 };
+};
+
+//======================================================================================//
+
+/// \brief TaskLatency holds the histograms of the time the tasks waited in the queue
+/// (submission to start of execution) and of the time they executed. Recording is
+/// enabled with TaskLatency::enable() or PTL_LATENCY and requires PTL_USE_STATISTICS
+struct TaskLatency
+{
+    using clock_type = std::chrono::steady_clock;
+
+    LatencyHistogram queue_wait = {};
+    LatencyHistogram service    = {};
+
+    void merge(const TaskLatency& rhs)
+    {
+        queue_wait.merge(rhs.queue_wait);
+        service.merge(rhs.service);
+    }
+
+    void reset()
+    {
+        queue_wait.reset();
+        service.reset();
+    }
+
+    static bool enabled()
+    {
+#if defined(PTL_USE_STATISTICS)
+        return f_enabled.load(std::memory_order_relaxed);
+#else
+        return false;
+#endif
+    }
+
+    static void enable(bool _v = true) { f_enabled.store(_v); }
+    static void disable() { f_enabled.store(false); }
+
+    // nanoseconds of the steady clock
+    static int64_t now()
+    {
+        using nsec_t = std::chrono::nanoseconds;
+        return std::chrono::duration_cast<nsec_t>(clock_type::now().time_since_epoch())
+            .count();
+    }
+
+    // the time from _beg to _end (zero if the clock went backwards)
+    static uint64_t elapsed(int64_t _beg, int64_t _end)
+    {
+        return (_end > _beg) ? static_cast<uint64_t>(_end - _beg) : 0;
+    }
+
+private:
+    static std::atomic<bool> f_enabled;
+};
+
+//--------------------------------------------------------------------------------------//
+// prints the count and p50/p99/p999/max of the queue wait and the service time
+//
+std::ostream&
+operator<<(std::ostream&, const TaskLatency&);
+
+//======================================================================================//
+
+}  // namespace PTL
@@ -0,0 +1,398 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//
+// ---------------------------------------------------------------
+// Tasking class header file
+//
+// Class Description:
+//
+// This file provides memory helpers which place pages on the NUMA node of
+// the ThreadPool workers that will process them: a node-bound allocator
+// and an array whose chunks are bound to (or first-touched on) the nodes
+// of the workers that process them
+//
+// ---------------------------------------------------------------
+
+#pragma once
+
+#include "PTL/TaskGroup.hh"
+#include "PTL/ThreadPool.hh"
+#include "PTL/Topology.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace PTL
+{
+namespace numa
+{
+//======================================================================================//
+
+/// true if there is more than one NUMA node and pages can be bound to nodes
+bool
+available();
+
+/// size of a memory page
+size_t
+page_size();
+
+/// prefer the NUMA node for the pages in [_addr, _addr + _bytes). Only whole pages
+/// are bound. Returns false (and does nothing) if binding is not available
+bool
+bind(void* _addr, size_t _bytes, int _node);
+
+/// page-aligned allocation whose pages are bound to the NUMA node (no binding if
+/// the node is negative or binding is not available). The pages are not touched.
+/// Throws std::bad_alloc on failure
+void*
+allocate(size_t _bytes, int _node = -1);
+
+/// release memory obtained from allocate
+void
+deallocate(void* _addr, size_t _bytes);
+
+}  // namespace numa
+
+//======================================================================================//
+
+/// \brief NumaAllocator allocates storage bound to a NUMA node, e.g. for a
+/// std::vector whose data is processed by the workers of that node. A negative
+/// node (or a single-node machine) gives plain page-aligned storage
+template <typename Tp>
+class NumaAllocator
+{
+public:
+    using value_type = Tp;
+
+    template <typename Up>
+    friend class NumaAllocator;
+
+public:
+    explicit NumaAllocator(int _node = -1)
+    : m_node{ _node }
+    {}
+
+    template <typename Up>
+    NumaAllocator(const NumaAllocator<Up>& rhs)
+    : m_node{ rhs.m_node }
+    {}
+
+    Tp* allocate(size_t _n)
+    {
+        return static_cast<Tp*>(numa::allocate(_n * sizeof(Tp), m_node));
+    }
+
+    void deallocate(Tp* _ptr, size_t _n) { numa::deallocate(_ptr, _n * sizeof(Tp)); }
+
+    int node() const { return m_node; }
+
+    template <typename Up>
+    bool operator==(const NumaAllocator<Up>& rhs) const
+    {
+        return m_node == rhs.m_node;
+    }
+
+    template <typename Up>
+    bool operator!=(const NumaAllocator<Up>& rhs) const
+    {
+        return m_node != rhs.m_node;
+    }
+
+private:
+    int m_node = -1;
+};
+
+//======================================================================================//
+
+/// \brief NumaArray is a fixed-size array split into one chunk per worker of a
+/// ThreadPool. Each chunk is assigned to the NUMA node of the CPU its worker is
+/// pinned to (or, if the workers are not pinned, the chunks are spread over the
+/// nodes in contiguous blocks), the pages of each chunk are bound to its node and
+/// the elements are constructed (first-touched) by a task queued on that node.
+/// for_each_chunk() queues the processing of each chunk on the same node so, with
+/// workers pinned to the nodes (see cpu_placement), the data is processed where it
+/// resides. On a single-node machine this reduces to a parallel first-touch
+/// initialization.
+template <typename Tp>
+class NumaArray
+{
+public:
+    using value_type     = Tp;
+    using size_type      = size_t;
+    using iterator       = Tp*;
+    using const_iterator = const Tp*;
+    using range_type     = std::pair<size_type, size_type>;
+
+public:
+    explicit NumaArray(size_type _n, const Tp& _init = Tp{},
+                       ThreadPool* _tp      = internal::get_default_threadpool(),
+                       size_type   _nchunks = 0);
+    ~NumaArray();
+
+    NumaArray(const NumaArray&) = delete;
+    NumaArray& operator=(const NumaArray&) = delete;
+
+    NumaArray(NumaArray&&) noexcept;
+    NumaArray& operator=(NumaArray&&) noexcept;
+
+public:
+    size_type size() const { return m_size; }
+    bool      empty() const { return m_size == 0; }
+
+    Tp*       data() { return m_data; }
+    const Tp* data() const { return m_data; }
+
+    iterator       begin() { return m_data; }
+    iterator       end() { return m_data + m_size; }
+    const_iterator begin() const { return m_data; }
+    const_iterator end() const { return m_data + m_size; }
+
+    Tp&       operator[](size_type i) { return m_data[i]; }
+    const Tp& operator[](size_type i) const { return m_data[i]; }
+
+    /// number of chunks and the [begin, end) element offsets and node of a chunk
+    size_type  chunks() const { return m_nchunks; }
+    range_type chunk_range(size_type _i) const;
+    int        chunk_node(size_type _i) const;
+
+    /// executes _func(begin, end) for every chunk on a worker of the node of the
+    /// chunk (if the queue is NUMA-partitioned) and waits for completion
+    template <typename FuncT>
+    void for_each_chunk(FuncT&& _func);
+
+private:
+    void release();
+
+private:
+    ThreadPool* m_pool    = nullptr;
+    size_type   m_size    = 0;
+    size_type   m_nchunks = 0;
+    size_type   m_chunk   = 0;  // elements per chunk, spanning whole pages
+    Tp*         m_data    = nullptr;
+};
+
+//======================================================================================//
+
+template <typename Tp>
+NumaArray<Tp>::NumaArray(size_type _n, const Tp& _init, ThreadPool* _tp,
+                         size_type _nchunks)
+: m_pool{ _tp }
+, m_size{ _n }
+{
+    if(m_size == 0)
+        return;
+
+    if(_nchunks == 0)
+        _nchunks = (m_pool) ? std::max<size_type>(m_pool->size(), 1) : 1;
+
+    // round the chunks up to a multiple of lcm(page size, sizeof(Tp)) bytes so that
+    // every chunk starts on a page boundary and no page is shared by two nodes.
+    // In elements, the multiple is lcm / sizeof(Tp) = page size / gcd
+    size_type _gcd = numa::page_size();
+    for(size_type _rem = sizeof(Tp); _rem != 0;)
+    {
+        size_type _next = _gcd % _rem;
+        _gcd            = _rem;
+        _rem            = _next;
+    }
+    size_type _per_page = std::max<size_type>(numa::page_size() / _gcd, 1);
+    m_chunk             = (m_size + _nchunks - 1) / _nchunks;
+    m_chunk             = ((m_chunk + _per_page - 1) / _per_page) * _per_page;
+    m_nchunks           = (m_size + m_chunk - 1) / m_chunk;
+    m_data              = static_cast<Tp*>(numa::allocate(m_size * sizeof(Tp)));
+
+    if(numa::available())
+    {
+        for(size_type i = 0; i < m_nchunks; ++i)
+        {
+            auto _range = chunk_range(i);
+            numa::bind(m_data + _range.first,
+                       (_range.second - _range.first) * sizeof(Tp), chunk_node(i));
+        }
+    }
+
+    // first touch. A chunk whose copy throws destroys the elements it constructed
+    // and keeps the exception instead of throwing it out of its task. The other
+    // chunks and the mapping are then released and the exception is rethrown
+    std::vector<std::exception_ptr> _errors(m_nchunks);
+    for_each_chunk([this, &_init, &_errors](Tp* _beg, Tp* _end) {
+        Tp* _itr = _beg;
+        try
+        {
+            for(; _itr != _end; ++_itr)
+                new(_itr) Tp(_init);
+        } catch(...)
+        {
+            while(_itr != _beg)
+                (--_itr)->~Tp();
+            _errors.at((_beg - m_data) / m_chunk) = std::current_exception();
+        }
+    });
+
+    for(const auto& itr : _errors)
+    {
+        if(!itr)
+            continue;
+        for(size_type i = 0; i < m_nchunks; ++i)
+        {
+            auto _range = chunk_range(i);
+            for(size_type j = _range.first; !_errors.at(i) && j < _range.second; ++j)
+                m_data[j].~Tp();
+        }
+        numa::deallocate(m_data, m_size * sizeof(Tp));
+        m_data    = nullptr;
+        m_size    = 0;
+        m_nchunks = 0;
+        std::rethrow_exception(itr);
+    }
+}
+
+//======================================================================================//
+
+template <typename Tp>
+NumaArray<Tp>::~NumaArray()
+{
+    release();
+}
+
+//======================================================================================//
+
+template <typename Tp>
+NumaArray<Tp>::NumaArray(NumaArray&& rhs) noexcept
+: m_pool{ rhs.m_pool }
+, m_size{ rhs.m_size }
+, m_nchunks{ rhs.m_nchunks }
+, m_chunk{ rhs.m_chunk }
+, m_data{ rhs.m_data }
+{
+    rhs.m_size    = 0;
+    rhs.m_nchunks = 0;
+    rhs.m_data    = nullptr;
+}
+
+//======================================================================================//
+
+template <typename Tp>
+NumaArray<Tp>&
+NumaArray<Tp>::operator=(NumaArray&& rhs) noexcept
+{
+    if(this != &rhs)
+    {
+        release();
+        m_pool        = rhs.m_pool;
+        m_size        = rhs.m_size;
+        m_nchunks     = rhs.m_nchunks;
+        m_chunk       = rhs.m_chunk;
+        m_data        = rhs.m_data;
+        rhs.m_size    = 0;
+        rhs.m_nchunks = 0;
+        rhs.m_data    = nullptr;
+    }
+    return *this;
+}
+
+//======================================================================================//
+
+template <typename Tp>
+void
+NumaArray<Tp>::release()
+{
+    if(!m_data)
+        return;
+    if(!std::is_trivially_destructible<Tp>::value)
+    {
+        for(size_type i = 0; i < m_size; ++i)
+            m_data[i].~Tp();
+    }
+    numa::deallocate(m_data, m_size * sizeof(Tp));
+    m_data = nullptr;
+}
+
+//======================================================================================//
+
+template <typename Tp>
+typename NumaArray<Tp>::range_type
+NumaArray<Tp>::chunk_range(size_type _i) const
+{
+    return range_type{ std::min(_i * m_chunk, m_size),
+                       std::min((_i + 1) * m_chunk, m_size) };
+}
+
+//======================================================================================//
+
+template <typename Tp>
+int
+NumaArray<Tp>::chunk_node(size_type _i) const
+{
+    auto _nchunks = std::max<size_type>(m_nchunks, 1);
+    // the node of the CPU of the worker processing the chunk, the workers being
+    // assigned to the chunks in contiguous blocks
+    if(m_pool)
+    {
+        auto _nworkers = std::max<size_type>(m_pool->size(), 1);
+        auto _worker   = static_cast<intmax_t>((_i * _nworkers) / _nchunks);
+        int  _node     = m_pool->get_worker_node(_worker);
+        if(_node >= 0)
+            return _node;
+    }
+    // the workers are not pinned: the chunks are spread over the nodes
+    const auto& _nodes = Topology::instance().nodes();
+    if(_nodes.empty())
+        return 0;
+    return _nodes.at((_i * _nodes.size()) / _nchunks);
+}
+
+//======================================================================================//
+
+template <typename Tp>
+template <typename FuncT>
+void
+NumaArray<Tp>::for_each_chunk(FuncT&& _func)
+{
+    if(!m_pool || m_nchunks < 2)
+    {
+        for(size_type i = 0; i < m_nchunks; ++i)
+        {
+            auto _range = chunk_range(i);
+            _func(m_data + _range.first, m_data + _range.second);
+        }
+        return;
+    }
+
+    TaskGroup<void> _tg{ m_pool };
+    for(size_type i = 0; i < m_nchunks; ++i)
+    {
+        auto _range = chunk_range(i);
+        auto _beg   = m_data + _range.first;
+        auto _end   = m_data + _range.second;
+        _tg.set_numa_node(chunk_node(i));
+        _tg.exec([&_func, _beg, _end]() { _func(_beg, _end); });
+    }
+    _tg.join();
+}
+
+//======================================================================================//
+
+}  // namespace PTL
@@ -21,16 +21,31 @@
 
 #include "PTL/AutoLock.hh"
 #include "PTL/Backtrace.hh"
+#include "PTL/Concurrency.hh"
+#include "PTL/Coroutine.hh"
 #include "PTL/Globals.hh"
+#include "PTL/LatencyHistogram.hh"
+#include "PTL/NumaMemory.hh"
+#include "PTL/ParallelAlgorithms.hh"
+#include "PTL/ParallelPipeline.hh"
 #include "PTL/TBBTaskGroup.hh"
 #include "PTL/Task.hh"
+#include "PTL/TaskArena.hh"
 #include "PTL/TaskGroup.hh"
+#include "PTL/TaskHooks.hh"
+#include "PTL/TaskLabel.hh"
+#include "PTL/TaskMailbox.hh"
+#include "PTL/TaskTracer.hh"
 #include "PTL/TaskManager.hh"
 #include "PTL/TaskRunManager.hh"
 #include "PTL/ThreadData.hh"
 #include "PTL/ThreadPool.hh"
+#include "PTL/ThreadStatistics.hh"
 #include "PTL/Threading.hh"
 #include "PTL/Timer.hh"
+#include "PTL/TimerWheel.hh"
+#include "PTL/TimingRegion.hh"
+#include "PTL/Topology.hh"
 #include "PTL/Types.hh"
 #include "PTL/UserTaskQueue.hh"
 #include "PTL/Utility.hh"
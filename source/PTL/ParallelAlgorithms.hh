@@ -0,0 +1,624 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ---------------------------------------------------------------
+// Tasking class header file
+//
+// Class Description:
+//
+// This file provides data-parallel algorithms (prefix scans, stream
+// compaction, merging and sorting) which execute on the tasks of a
+// ThreadPool
+//
+// ---------------------------------------------------------------
+
+#pragma once
+
+#include "PTL/TaskGroup.hh"
+#include "PTL/ThreadPool.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace PTL
+{
+namespace internal
+{
+//--------------------------------------------------------------------------------------//
+// minimum number of elements per chunk before work is split across the thread-pool
+//
+inline size_t&
+parallel_grain_size()
+{
+    static size_t _v = GetEnv<size_t>("PTL_PARALLEL_GRAIN_SIZE", 16384);
+    return _v;
+}
+
+//--------------------------------------------------------------------------------------//
+// number of chunks to split _n elements into. One chunk per thread (plus the calling
+// thread) is ideal for bandwidth-bound algorithms since every element is touched a
+// fixed number of times
+//
+inline size_t
+get_num_chunks(ThreadPool* _tp, size_t _n, size_t _grain)
+{
+    if(_grain == 0)
+        _grain = parallel_grain_size();
+    if(!_tp || _tp->size() < 1 || _n <= _grain)
+        return 1;
+    size_t _nchunks = (_n + _grain - 1) / _grain;
+    return std::max<size_t>(std::min<size_t>(_nchunks, _tp->size() + 1), 1);
+}
+
+//--------------------------------------------------------------------------------------//
+// [begin, end) offsets of chunk _i of _nchunks
+//
+inline std::pair<size_t, size_t>
+get_chunk(size_t _n, size_t _nchunks, size_t _i)
+{
+    return std::pair<size_t, size_t>{ (_n * _i) / _nchunks, (_n * (_i + 1)) / _nchunks };
+}
+
+//--------------------------------------------------------------------------------------//
+// executes _func(i) for i in [0, _nchunks) and waits for completion. Chunk zero is
+// executed by the calling thread. When called from within a task, the nested tasks
+// are inserted into the bin of the calling thread and the calling thread processes
+// them while waiting so no additional threads are created.
+//
+template <typename FuncT>
+void
+parallel_chunks(ThreadPool* _tp, size_t _nchunks, FuncT&& _func)
+{
+    if(_nchunks < 2 || !_tp)
+    {
+        for(size_t i = 0; i < _nchunks; ++i)
+            _func(i);
+        return;
+    }
+
+    TaskGroup<void> _tg{ _tp };
+    for(size_t i = 1; i < _nchunks; ++i)
+        _tg.exec([&_func, i]() { _func(i); });
+
+    // the tasks reference _func (and the state it captures) so they must complete
+    // before an exception of chunk zero leaves the caller
+    try
+    {
+        _func(0);
+    } catch(...)
+    {
+        _tg.wait();
+        throw;
+    }
+    _tg.join();
+}
+
+//--------------------------------------------------------------------------------------//
+// the chunks are located by offsetting the iterators
+//
+template <typename ItrT>
+using is_random_access =
+    std::is_base_of<std::random_access_iterator_tag,
+                    typename std::iterator_traits<ItrT>::iterator_category>;
+
+}  // namespace internal
+
+//======================================================================================//
+//
+//  Prefix scans
+//
+//  Two-pass (reduce-then-downsweep) scheme: the first pass reduces each chunk
+//  independently, the chunk totals are scanned serially and the second pass
+//  scans each chunk seeded with the total of all the preceding chunks. The
+//  binary operation must be associative. Output may alias the input.
+//
+//======================================================================================//
+
+template <typename InputIt, typename OutputIt, typename BinaryOp>
+OutputIt
+parallel_scan(InputIt _first, InputIt _last, OutputIt _d_first, BinaryOp _op,
+              ThreadPool* _tp = internal::get_default_threadpool(), size_t _grain = 0)
+{
+    static_assert(internal::is_random_access<InputIt>::value &&
+                      internal::is_random_access<OutputIt>::value,
+                  "parallel_scan requires random-access iterators");
+    using value_type = typename std::iterator_traits<InputIt>::value_type;
+
+    auto _n = static_cast<size_t>(std::distance(_first, _last));
+    if(_n == 0)
+        return _d_first;
+
+    auto _nchunks = internal::get_num_chunks(_tp, _n, _grain);
+    if(_nchunks < 2)
+        return std::partial_sum(_first, _last, _d_first, _op);
+
+    // pass 1: reduce each chunk (except the last, its total is never needed)
+    std::vector<value_type> _sums(_nchunks);
+    internal::parallel_chunks(_tp, _nchunks - 1, [&](size_t i) {
+        auto       _chunk = internal::get_chunk(_n, _nchunks, i);
+        auto       _itr   = _first + _chunk.first;
+        auto       _end   = _first + _chunk.second;
+        value_type _sum   = *_itr++;
+        for(; _itr != _end; ++_itr)
+            _sum = _op(_sum, *_itr);
+        _sums[i] = std::move(_sum);
+    });
+
+    // scan the chunk totals so _sums[i] holds the total preceding chunk i + 1
+    for(size_t i = 1; i < _nchunks - 1; ++i)
+        _sums[i] = _op(_sums[i - 1], _sums[i]);
+
+    // pass 2: scan each chunk seeded with the preceding total
+    internal::parallel_chunks(_tp, _nchunks, [&](size_t i) {
+        auto _chunk = internal::get_chunk(_n, _nchunks, i);
+        auto _itr   = _first + _chunk.first;
+        auto _end   = _first + _chunk.second;
+        auto _out   = _d_first + _chunk.first;
+        if(i == 0)
+        {
+            std::partial_sum(_itr, _end, _out, _op);
+            return;
+        }
+        value_type _sum = _sums[i - 1];
+        for(; _itr != _end; ++_itr, ++_out)
+        {
+            _sum = _op(_sum, *_itr);
+            *_out = _sum;
+        }
+    });
+
+    return _d_first + _n;
+}
+
+//--------------------------------------------------------------------------------------//
+
+template <typename InputIt, typename OutputIt>
+OutputIt
+parallel_scan(InputIt _first, InputIt _last, OutputIt _d_first,
+              ThreadPool* _tp = internal::get_default_threadpool(), size_t _grain = 0)
+{
+    using value_type = typename std::iterator_traits<InputIt>::value_type;
+    return parallel_scan(_first, _last, _d_first, std::plus<value_type>{}, _tp, _grain);
+}
+
+//--------------------------------------------------------------------------------------//
+
+template <typename InputIt, typename OutputIt, typename Tp, typename BinaryOp>
+OutputIt
+parallel_exclusive_scan(InputIt _first, InputIt _last, OutputIt _d_first, Tp _init,
+                        BinaryOp _op, ThreadPool* _tp = internal::get_default_threadpool(),
+                        size_t _grain = 0)
+{
+    static_assert(internal::is_random_access<InputIt>::value &&
+                      internal::is_random_access<OutputIt>::value,
+                  "parallel_exclusive_scan requires random-access iterators");
+    auto _n = static_cast<size_t>(std::distance(_first, _last));
+    if(_n == 0)
+        return _d_first;
+
+    auto _nchunks = internal::get_num_chunks(_tp, _n, _grain);
+
+    auto _scan_chunk = [&](size_t i, Tp _sum) {
+        auto _chunk = internal::get_chunk(_n, _nchunks, i);
+        auto _itr   = _first + _chunk.first;
+        auto _end   = _first + _chunk.second;
+        auto _out   = _d_first + _chunk.first;
+        for(; _itr != _end; ++_itr, ++_out)
+        {
+            Tp _val = _op(_sum, *_itr);
+            *_out   = std::move(_sum);
+            _sum    = std::move(_val);
+        }
+    };
+
+    if(_nchunks < 2)
+    {
+        _scan_chunk(0, std::move(_init));
+        return _d_first + _n;
+    }
+
+    // pass 1: reduce each chunk (except the last)
+    std::vector<Tp> _sums(_nchunks, _init);
+    internal::parallel_chunks(_tp, _nchunks - 1, [&](size_t i) {
+        auto _chunk = internal::get_chunk(_n, _nchunks, i);
+        auto _itr   = _first + _chunk.first;
+        auto _end   = _first + _chunk.second;
+        Tp   _sum   = *_itr++;
+        for(; _itr != _end; ++_itr)
+            _sum = _op(_sum, *_itr);
+        _sums[i + 1] = std::move(_sum);
+    });
+
+    // scan the chunk totals so _sums[i] holds the seed value of chunk i
+    for(size_t i = 1; i < _nchunks; ++i)
+        _sums[i] = _op(_sums[i - 1], _sums[i]);
+
+    // pass 2: scan each chunk seeded with the preceding total
+    internal::parallel_chunks(_tp, _nchunks,
+                              [&](size_t i) { _scan_chunk(i, _sums[i]); });
+
+    return _d_first + _n;
+}
+
+//--------------------------------------------------------------------------------------//
+
+template <typename InputIt, typename OutputIt, typename Tp>
+OutputIt
+parallel_exclusive_scan(InputIt _first, InputIt _last, OutputIt _d_first, Tp _init,
+                        ThreadPool* _tp = internal::get_default_threadpool(),
+                        size_t      _grain = 0)
+{
+    return parallel_exclusive_scan(_first, _last, _d_first, std::move(_init),
+                                   std::plus<Tp>{}, _tp, _grain);
+}
+
+//======================================================================================//
+//
+//  Stream compaction
+//
+//  Both algorithms are stable: the relative order of the elements is preserved.
+//  The first pass counts the matching elements of each chunk, the counts are
+//  scanned serially into output offsets and the second pass copies each chunk
+//  to its offset. The output ranges must not overlap the input.
+//
+//======================================================================================//
+
+/// \brief copies the elements of [first, last) for which pred returns true to
+/// d_first, returns the end of the output range (like std::copy_if)
+template <typename InputIt, typename OutputIt, typename UnaryPred>
+OutputIt
+parallel_compact(InputIt _first, InputIt _last, OutputIt _d_first, UnaryPred _pred,
+                 ThreadPool* _tp = internal::get_default_threadpool(), size_t _grain = 0)
+{
+    static_assert(internal::is_random_access<InputIt>::value &&
+                      internal::is_random_access<OutputIt>::value,
+                  "parallel_compact requires random-access iterators");
+    auto _n       = static_cast<size_t>(std::distance(_first, _last));
+    auto _nchunks = internal::get_num_chunks(_tp, _n, _grain);
+    if(_nchunks < 2)
+        return std::copy_if(_first, _last, _d_first, _pred);
+
+    std::vector<size_t> _offsets(_nchunks + 1, 0);
+    internal::parallel_chunks(_tp, _nchunks, [&](size_t i) {
+        auto _chunk     = internal::get_chunk(_n, _nchunks, i);
+        _offsets[i + 1] = static_cast<size_t>(
+            std::count_if(_first + _chunk.first, _first + _chunk.second, _pred));
+    });
+
+    for(size_t i = 1; i < _nchunks + 1; ++i)
+        _offsets[i] += _offsets[i - 1];
+
+    internal::parallel_chunks(_tp, _nchunks, [&](size_t i) {
+        auto _chunk = internal::get_chunk(_n, _nchunks, i);
+        if(_offsets[i + 1] == _offsets[i])
+            return;
+        std::copy_if(_first + _chunk.first, _first + _chunk.second,
+                     _d_first + _offsets[i], _pred);
+    });
+
+    return _d_first + _offsets.back();
+}
+
+//--------------------------------------------------------------------------------------//
+/// \brief copies the elements of [first, last) for which pred returns true to
+/// d_true and the remaining elements to d_false, returns the end of both output
+/// ranges (like std::partition_copy)
+template <typename InputIt, typename OutputTrueIt, typename OutputFalseIt,
+          typename UnaryPred>
+std::pair<OutputTrueIt, OutputFalseIt>
+parallel_partition(InputIt _first, InputIt _last, OutputTrueIt _d_true,
+                   OutputFalseIt _d_false, UnaryPred _pred,
+                   ThreadPool* _tp = internal::get_default_threadpool(), size_t _grain = 0)
+{
+    static_assert(internal::is_random_access<InputIt>::value &&
+                      internal::is_random_access<OutputTrueIt>::value &&
+                      internal::is_random_access<OutputFalseIt>::value,
+                  "parallel_partition requires random-access iterators");
+    auto _n       = static_cast<size_t>(std::distance(_first, _last));
+    auto _nchunks = internal::get_num_chunks(_tp, _n, _grain);
+    if(_nchunks < 2)
+        return std::partition_copy(_first, _last, _d_true, _d_false, _pred);
+
+    // number of elements in chunk satisfying the predicate
+    std::vector<size_t> _offsets(_nchunks + 1, 0);
+    internal::parallel_chunks(_tp, _nchunks, [&](size_t i) {
+        auto _chunk     = internal::get_chunk(_n, _nchunks, i);
+        _offsets[i + 1] = static_cast<size_t>(
+            std::count_if(_first + _chunk.first, _first + _chunk.second, _pred));
+    });
+
+    for(size_t i = 1; i < _nchunks + 1; ++i)
+        _offsets[i] += _offsets[i - 1];
+
+    internal::parallel_chunks(_tp, _nchunks, [&](size_t i) {
+        auto _chunk = internal::get_chunk(_n, _nchunks, i);
+        // elements before this chunk not satisfying the predicate
+        auto _nfalse = _chunk.first - _offsets[i];
+        std::partition_copy(_first + _chunk.first, _first + _chunk.second,
+                            _d_true + _offsets[i], _d_false + _nfalse, _pred);
+    });
+
+    auto _ntrue = _offsets.back();
+    return std::pair<OutputTrueIt, OutputFalseIt>{ _d_true + _ntrue,
+                                                   _d_false + (_n - _ntrue) };
+}
+
+//======================================================================================//
+//
+//  Merging and sorting
+//
+//  The merge splits the output range into one piece per thread by locating the
+//  corresponding split points of the two inputs with a binary search along the
+//  merge path, so every piece is merged independently. The sort is a parallel
+//  merge sort: the range is split into one chunk per thread which are sorted
+//  with std::sort and then merged pairwise in rounds, each round executing all
+//  of its (parallel) merges as a single set of tasks. All of the work is
+//  submitted to the existing thread-pool; no threads are created, so the
+//  algorithms can safely be called from within a task.
+//
+//======================================================================================//
+
+namespace internal
+{
+//--------------------------------------------------------------------------------------//
+// number of elements from [_first1, _first1 + _n1) among the first _k elements of the
+// stable merge of the two ranges
+//
+template <typename InputIt1, typename InputIt2, typename Compare>
+size_t
+merge_path_split(InputIt1 _first1, size_t _n1, InputIt2 _first2, size_t _n2, size_t _k,
+                 Compare& _comp)
+{
+    size_t _lo = (_k > _n2) ? (_k - _n2) : 0;
+    size_t _hi = std::min(_k, _n1);
+    while(_lo < _hi)
+    {
+        size_t _mid = _lo + (_hi - _lo + 1) / 2;
+        // element _mid - 1 of the first range precedes element _k - _mid of second
+        if(!_comp(*(_first2 + (_k - _mid)), *(_first1 + (_mid - 1))))
+            _lo = _mid;
+        else
+            _hi = _mid - 1;
+    }
+    return _lo;
+}
+
+//--------------------------------------------------------------------------------------//
+// computes the split points of the first range for the _npieces pieces of the output.
+// These are all located before any of the pieces are merged since the binary search of
+// one piece probes the elements which are (possibly moved) by the neighboring pieces
+//
+template <typename InputIt1, typename InputIt2, typename Compare>
+void
+merge_path_splits(InputIt1 _first1, size_t _n1, InputIt2 _first2, size_t _n2,
+                  Compare& _comp, size_t _npieces, size_t* _splits)
+{
+    for(size_t i = 0; i < _npieces; ++i)
+    {
+        auto _k    = get_chunk(_n1 + _n2, _npieces, i).first;
+        _splits[i] = merge_path_split(_first1, _n1, _first2, _n2, _k, _comp);
+    }
+    _splits[_npieces] = _n1;
+}
+
+//--------------------------------------------------------------------------------------//
+// merges piece _i of _npieces of the output range given the split points of the first
+// range. When MoveV is true, the elements are moved from the inputs
+//
+template <bool MoveV, typename InputIt1, typename InputIt2, typename OutputIt,
+          typename Compare>
+void
+merge_piece(InputIt1 _first1, InputIt2 _first2, size_t _n, OutputIt _d_first,
+            Compare& _comp, const size_t* _splits, size_t _npieces, size_t _i)
+{
+    auto   _range = get_chunk(_n, _npieces, _i);
+    size_t _beg1  = _splits[_i];
+    size_t _end1  = _splits[_i + 1];
+    size_t _beg2  = _range.first - _beg1;
+    size_t _end2  = _range.second - _end1;
+    if(MoveV)
+    {
+        std::merge(std::make_move_iterator(_first1 + _beg1),
+                   std::make_move_iterator(_first1 + _end1),
+                   std::make_move_iterator(_first2 + _beg2),
+                   std::make_move_iterator(_first2 + _end2), _d_first + _range.first,
+                   _comp);
+    }
+    else
+    {
+        std::merge(_first1 + _beg1, _first1 + _end1, _first2 + _beg2, _first2 + _end2,
+                   _d_first + _range.first, _comp);
+    }
+}
+
+}  // namespace internal
+
+//--------------------------------------------------------------------------------------//
+/// \brief merges the sorted ranges [first1, last1) and [first2, last2) into d_first
+/// (like std::merge). The merge is stable and the output must not overlap the inputs
+template <typename InputIt1, typename InputIt2, typename OutputIt, typename Compare>
+OutputIt
+parallel_merge(InputIt1 _first1, InputIt1 _last1, InputIt2 _first2, InputIt2 _last2,
+               OutputIt _d_first, Compare _comp,
+               ThreadPool* _tp = internal::get_default_threadpool(), size_t _grain = 0)
+{
+    static_assert(internal::is_random_access<InputIt1>::value &&
+                      internal::is_random_access<InputIt2>::value &&
+                      internal::is_random_access<OutputIt>::value,
+                  "parallel_merge requires random-access iterators");
+    auto _n1      = static_cast<size_t>(std::distance(_first1, _last1));
+    auto _n2      = static_cast<size_t>(std::distance(_first2, _last2));
+    auto _nchunks = internal::get_num_chunks(_tp, _n1 + _n2, _grain);
+    if(_nchunks < 2)
+        return std::merge(_first1, _last1, _first2, _last2, _d_first, _comp);
+
+    std::vector<size_t> _splits(_nchunks + 1, 0);
+    internal::merge_path_splits(_first1, _n1, _first2, _n2, _comp, _nchunks,
+                                _splits.data());
+
+    internal::parallel_chunks(_tp, _nchunks, [&](size_t i) {
+        internal::merge_piece<false>(_first1, _first2, _n1 + _n2, _d_first, _comp,
+                                     _splits.data(), _nchunks, i);
+    });
+    return _d_first + (_n1 + _n2);
+}
+
+//--------------------------------------------------------------------------------------//
+
+template <typename InputIt1, typename InputIt2, typename OutputIt>
+OutputIt
+parallel_merge(InputIt1 _first1, InputIt1 _last1, InputIt2 _first2, InputIt2 _last2,
+               OutputIt _d_first, ThreadPool* _tp = internal::get_default_threadpool(),
+               size_t _grain = 0)
+{
+    using value_type = typename std::iterator_traits<InputIt1>::value_type;
+    return parallel_merge(_first1, _last1, _first2, _last2, _d_first,
+                          std::less<value_type>{}, _tp, _grain);
+}
+
+//--------------------------------------------------------------------------------------//
+/// \brief sorts [first, last) (like std::sort). The value type must be default
+/// constructible and move assignable since a temporary buffer of the same size is
+/// used for merging
+template <typename RandomIt, typename Compare>
+void
+parallel_sort(RandomIt _first, RandomIt _last, Compare _comp,
+              ThreadPool* _tp = internal::get_default_threadpool(), size_t _grain = 0)
+{
+    static_assert(internal::is_random_access<RandomIt>::value,
+                  "parallel_sort requires random-access iterators");
+    using value_type = typename std::iterator_traits<RandomIt>::value_type;
+    using buffer_t   = std::vector<value_type>;
+    using buffer_itr = typename buffer_t::iterator;
+
+    auto _n       = static_cast<size_t>(std::distance(_first, _last));
+    auto _nchunks = internal::get_num_chunks(_tp, _n, _grain);
+    if(_nchunks < 2)
+    {
+        std::sort(_first, _last, _comp);
+        return;
+    }
+
+    // boundaries of the sorted runs
+    std::vector<size_t> _runs(_nchunks + 1, 0);
+    for(size_t i = 0; i < _nchunks; ++i)
+        _runs[i + 1] = internal::get_chunk(_n, _nchunks, i).second;
+
+    internal::parallel_chunks(_tp, _nchunks, [&](size_t i) {
+        std::sort(_first + _runs[i], _first + _runs[i + 1], _comp);
+    });
+
+    buffer_t _buffer(_n);
+    bool     _in_buffer = false;
+
+    // merge the runs pairwise, alternating between the input range and buffer
+    auto _merge_round = [&](RandomIt _src, buffer_itr _dst, bool _to_buffer) {
+        size_t _nruns  = _runs.size() - 1;
+        size_t _npairs = (_nruns + 1) / 2;
+        // distribute one piece per thread among the merges in this round
+        size_t _npieces = std::max<size_t>(_nchunks / _npairs, 1);
+
+        // offsets of each pair: beginning, middle and end
+        auto _bounds = [&](size_t _pair) {
+            return std::make_tuple(_runs[2 * _pair],
+                                   _runs[std::min(2 * _pair + 1, _nruns)],
+                                   _runs[std::min(2 * _pair + 2, _nruns)]);
+        };
+
+        // locate all the split points before any of the elements are moved
+        std::vector<size_t> _splits(_npairs * (_npieces + 1), 0);
+        for(size_t _pair = 0; _pair < _npairs; ++_pair)
+        {
+            size_t _beg, _mid, _end;
+            std::tie(_beg, _mid, _end) = _bounds(_pair);
+            auto* _psplits             = _splits.data() + _pair * (_npieces + 1);
+            if(_to_buffer)
+            {
+                internal::merge_path_splits(_src + _beg, _mid - _beg, _src + _mid,
+                                            _end - _mid, _comp, _npieces, _psplits);
+            }
+            else
+            {
+                internal::merge_path_splits(_dst + _beg, _mid - _beg, _dst + _mid,
+                                            _end - _mid, _comp, _npieces, _psplits);
+            }
+        }
+
+        internal::parallel_chunks(_tp, _npairs * _npieces, [&](size_t i) {
+            size_t _pair  = i / _npieces;
+            size_t _piece = i % _npieces;
+            size_t _beg, _mid, _end;
+            std::tie(_beg, _mid, _end) = _bounds(_pair);
+            auto* _psplits             = _splits.data() + _pair * (_npieces + 1);
+            if(_to_buffer)
+            {
+                internal::merge_piece<true>(_src + _beg, _src + _mid, _end - _beg,
+                                            _dst + _beg, _comp, _psplits, _npieces,
+                                            _piece);
+            }
+            else
+            {
+                internal::merge_piece<true>(_dst + _beg, _dst + _mid, _end - _beg,
+                                            _src + _beg, _comp, _psplits, _npieces,
+                                            _piece);
+            }
+        });
+
+        std::vector<size_t> _merged{};
+        for(size_t i = 0; i < _nruns + 1; i += 2)
+            _merged.emplace_back(_runs[i]);
+        if(_merged.back() != _n)
+            _merged.emplace_back(_n);
+        _runs = std::move(_merged);
+    };
+
+    while(_runs.size() > 2)
+    {
+        _merge_round(_first, _buffer.begin(), !_in_buffer);
+        _in_buffer = !_in_buffer;
+    }
+
+    if(_in_buffer)
+    {
+        internal::parallel_chunks(_tp, _nchunks, [&](size_t i) {
+            auto _chunk = internal::get_chunk(_n, _nchunks, i);
+            std::move(_buffer.begin() + _chunk.first, _buffer.begin() + _chunk.second,
+                      _first + _chunk.first);
+        });
+    }
+}
+
+//--------------------------------------------------------------------------------------//
+
+template <typename RandomIt>
+void
+parallel_sort(RandomIt _first, RandomIt _last,
+              ThreadPool* _tp = internal::get_default_threadpool(), size_t _grain = 0)
+{
+    using value_type = typename std::iterator_traits<RandomIt>::value_type;
+    parallel_sort(_first, _last, std::less<value_type>{}, _tp, _grain);
+}
+
+}  // namespace PTL
@@ -0,0 +1,303 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//
+// ---------------------------------------------------------------
+// Tasking class header file
+//
+// Class Description:
+//
+// This file provides a pipeline of filters (stages) which stream tokens
+// through the tasks of a ThreadPool with a bounded number of tokens
+// in flight
+//
+// ---------------------------------------------------------------
+
+#pragma once
+
+#include "PTL/AutoLock.hh"
+#include "PTL/Globals.hh"
+#include "PTL/Threading.hh"
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace PTL
+{
+class ThreadPool;
+
+namespace internal
+{
+ThreadPool*
+get_default_threadpool();
+}  // namespace internal
+
+//======================================================================================//
+
+/// \brief execution mode of a filter in a parallel_pipeline
+///     - parallel: any number of tokens are processed concurrently
+///     - serial_in_order: one token at a time, in the order produced by the input
+///     - serial_out_of_order: one token at a time, in any order
+enum class filter_mode : short
+{
+    parallel = 0,
+    serial_in_order,
+    serial_out_of_order
+};
+
+//======================================================================================//
+
+/// \brief passed to the input filter of a parallel_pipeline. Calling stop() signals
+/// the end of the input: the value returned by that invocation is discarded
+class flow_control
+{
+public:
+    void stop() { m_stopped = true; }
+    bool is_stopped() const { return m_stopped; }
+
+private:
+    bool m_stopped = false;
+};
+
+//======================================================================================//
+
+namespace internal
+{
+//--------------------------------------------------------------------------------------//
+// type-erased stage of a pipeline. The token values are passed between the stages as
+// shared pointers
+//
+struct pipeline_stage
+{
+    using item_type     = std::shared_ptr<void>;
+    using function_type = std::function<item_type(item_type&&, flow_control&)>;
+
+    filter_mode   mode = filter_mode::parallel;
+    function_type func = {};
+};
+
+using pipeline_stage_list_t = std::vector<pipeline_stage>;
+
+//--------------------------------------------------------------------------------------//
+// wraps the user function of a filter in the type-erased function of a stage. The user
+// function is moved into a shared holder since std::function requires a copyable
+// target, so move-only functions can be used as filters
+//
+template <typename InT, typename OutT>
+struct pipeline_function
+{
+    using item_type = pipeline_stage::item_type;
+
+    template <typename FuncT>
+    static pipeline_stage::function_type wrap(FuncT&& _func)
+    {
+        auto _holder = std::make_shared<decay_t<FuncT>>(std::forward<FuncT>(_func));
+        return [_holder](item_type&& _item, flow_control&) -> item_type {
+            auto* _value = static_cast<InT*>(_item.get());
+            return std::make_shared<OutT>((*_holder)(std::move(*_value)));
+        };
+    }
+};
+
+template <typename OutT>
+struct pipeline_function<void, OutT>
+{
+    using item_type = pipeline_stage::item_type;
+
+    template <typename FuncT>
+    static pipeline_stage::function_type wrap(FuncT&& _func)
+    {
+        auto _holder = std::make_shared<decay_t<FuncT>>(std::forward<FuncT>(_func));
+        return [_holder](item_type&&, flow_control& _fc) -> item_type {
+            return std::make_shared<OutT>((*_holder)(_fc));
+        };
+    }
+};
+
+template <typename InT>
+struct pipeline_function<InT, void>
+{
+    using item_type = pipeline_stage::item_type;
+
+    template <typename FuncT>
+    static pipeline_stage::function_type wrap(FuncT&& _func)
+    {
+        auto _holder = std::make_shared<decay_t<FuncT>>(std::forward<FuncT>(_func));
+        return [_holder](item_type&& _item, flow_control&) -> item_type {
+            (*_holder)(std::move(*static_cast<InT*>(_item.get())));
+            return item_type{};
+        };
+    }
+};
+
+template <>
+struct pipeline_function<void, void>
+{
+    using item_type = pipeline_stage::item_type;
+
+    template <typename FuncT>
+    static pipeline_stage::function_type wrap(FuncT&& _func)
+    {
+        auto _holder = std::make_shared<decay_t<FuncT>>(std::forward<FuncT>(_func));
+        return [_holder](item_type&&, flow_control& _fc) -> item_type {
+            (*_holder)(_fc);
+            return item_type{};
+        };
+    }
+};
+
+//--------------------------------------------------------------------------------------//
+// executes the stages. Each runner (the calling thread plus up to one task per thread
+// in the pool) reads a token from the input filter and carries it through all of the
+// stages so the data stays in the cache of the thread which produced it. A token which
+// reaches a serial filter that is busy (or, for serial_in_order, is not next in order)
+// is parked and the runner goes back to the input. The runner leaving the serial filter
+// hands the next parked token to the ready list where it is picked up (with priority
+// over the input) by the next runner looking for work
+//
+class pipeline
+{
+public:
+    using item_type  = pipeline_stage::item_type;
+    using stage_list = pipeline_stage_list_t;
+
+    pipeline(size_t _max_tokens, const stage_list& _stages);
+
+    // runs tokens through the pipeline until the input is exhausted or a filter throws
+    void run();
+    // rethrows the first exception thrown by a filter, if any
+    void rethrow() const;
+
+private:
+    struct token
+    {
+        size_t    seq     = 0;
+        size_t    stage   = 0;
+        bool      claimed = false;  // resumed token already owns its serial stage
+        item_type item    = {};
+    };
+
+    struct serial_state
+    {
+        Mutex                   lock         = {};
+        bool                    busy         = false;
+        size_t                  next_seq     = 0;
+        std::map<size_t, token> in_order     = {};
+        std::deque<token>       out_of_order = {};
+    };
+
+    bool next(token&);
+    void process(token&);
+    void finish();
+    void cancel();
+
+private:
+    size_t                                     m_max_tokens = 1;
+    size_t                                     m_in_flight  = 0;
+    size_t                                     m_next_seq   = 0;
+    bool                                       m_input_busy = false;
+    bool                                       m_input_done = false;
+    std::atomic<bool>                          m_cancelled{ false };
+    const stage_list&                          m_stages;
+    std::vector<std::unique_ptr<serial_state>> m_serial    = {};
+    std::deque<token>                          m_ready     = {};
+    std::exception_ptr                         m_exception = {};
+    Mutex                                      m_lock      = {};
+    Condition                                  m_cond      = {};
+};
+
+//--------------------------------------------------------------------------------------//
+
+void
+run_pipeline(size_t _max_tokens, const pipeline_stage_list_t& _stages, ThreadPool* _tp);
+
+}  // namespace internal
+
+//======================================================================================//
+
+/// \brief a chain of one or more filters of a parallel_pipeline which accepts values of
+/// type InT (void for the input filter) and produces values of type OutT (void for the
+/// output filter). Filters are created with make_filter and chained with operator&
+template <typename InT, typename OutT>
+class filter
+{
+public:
+    using stage_list = internal::pipeline_stage_list_t;
+
+public:
+    filter() = default;
+    explicit filter(stage_list _stages)
+    : m_stages{ std::move(_stages) }
+    {}
+
+    const stage_list& stages() const { return m_stages; }
+
+private:
+    stage_list m_stages = {};
+};
+
+//--------------------------------------------------------------------------------------//
+/// \brief creates a filter. The input filter (InT = void) is invoked as
+/// func(flow_control&) and is always executed serially in order, the remaining filters
+/// are invoked with the (moved) output of the preceding filter. The filter owns a copy
+/// of func (moved from an rvalue, so func may be move-only) which may be modified by the
+/// invocations (i.e. a non-const operator()). The copies of a filter share it and the
+/// func of a parallel filter is invoked concurrently
+template <typename InT, typename OutT, typename FuncT>
+filter<InT, OutT>
+make_filter(filter_mode _mode, FuncT&& _func)
+{
+    internal::pipeline_stage _stage{};
+    _stage.mode = _mode;
+    _stage.func =
+        internal::pipeline_function<InT, OutT>::wrap(std::forward<FuncT>(_func));
+    return filter<InT, OutT>{ internal::pipeline_stage_list_t{ std::move(_stage) } };
+}
+
+//--------------------------------------------------------------------------------------//
+/// \brief chains two filters
+template <typename InT, typename MidT, typename OutT>
+filter<InT, OutT>
+operator&(const filter<InT, MidT>& _lhs, const filter<MidT, OutT>& _rhs)
+{
+    auto _stages = _lhs.stages();
+    _stages.insert(_stages.end(), _rhs.stages().begin(), _rhs.stages().end());
+    return filter<InT, OutT>{ std::move(_stages) };
+}
+
+//--------------------------------------------------------------------------------------//
+/// \brief runs the pipeline until the input filter calls flow_control::stop(). At most
+/// max_tokens tokens are in flight at any time. The calling thread participates in the
+/// processing so this can be called from within a task. The first exception thrown by
+/// a filter cancels the pipeline and is rethrown
+inline void
+parallel_pipeline(size_t _max_tokens, const filter<void, void>& _filter,
+                  ThreadPool* _tp = internal::get_default_threadpool())
+{
+    internal::run_pipeline(_max_tokens, _filter.stages(), _tp);
+}
+
+}  // namespace PTL
@@ -0,0 +1,137 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//
+// ---------------------------------------------------------------
+// Tasking class header file
+//
+// Class Description:
+//
+// This file provides the parking lot of the idle workers of a thread-pool:
+// each worker sleeps on a condition of its own so that the notifications
+// can wake one specific worker instead of every worker
+//
+// ---------------------------------------------------------------
+
+#pragma once
+
+#include "PTL/Threading.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace PTL
+{
+//======================================================================================//
+
+/// \brief ParkingLot replaces a condition variable shared by the workers of a pool. A
+/// worker waits on a condition of its own (e.g. the one of its mailbox) and is listed
+/// as parked while it waits. notify_one() wakes the most recently parked worker (its
+/// cache is the warmest), notify_all() wakes every parked worker and notify(cond)
+/// wakes only the worker waiting on cond, if it is parked. A woken worker is removed
+/// from the list so the next notify_one() wakes another one. All the functions must
+/// be called with the lock passed to wait() held
+class ParkingLot
+{
+public:
+    using size_type = size_t;
+    using lock_type = std::unique_lock<Mutex>;
+
+public:
+    ParkingLot()  = default;
+    ~ParkingLot() = default;
+
+    ParkingLot(const ParkingLot&) = delete;
+    ParkingLot(ParkingLot&&)      = delete;
+    ParkingLot& operator=(const ParkingLot&) = delete;
+    ParkingLot& operator=(ParkingLot&&) = delete;
+
+public:
+    void notify_one()
+    {
+        if(m_parked.empty())
+            return;
+        auto* _cond = m_parked.back();
+        m_parked.pop_back();
+        _cond->notify_one();
+    }
+
+    void notify_all()
+    {
+        for(auto* itr : m_parked)
+            itr->notify_one();
+        m_parked.clear();
+    }
+
+    // wakes the worker waiting on _cond, a worker which is not parked checks the
+    // predicate before it parks
+    void notify(Condition& _cond)
+    {
+        if(unpark(_cond))
+            _cond.notify_one();
+    }
+
+    template <typename PredT>
+    void wait(lock_type& _lock, Condition& _cond, PredT _pred)
+    {
+        while(!_pred())
+        {
+            m_parked.push_back(&_cond);
+            _cond.wait(_lock);
+            unpark(_cond);
+        }
+    }
+
+    template <typename ClockT, typename DurT, typename PredT>
+    bool wait_until(lock_type& _lock, Condition& _cond,
+                    const std::chrono::time_point<ClockT, DurT>& _time, PredT _pred)
+    {
+        while(!_pred())
+        {
+            m_parked.push_back(&_cond);
+            auto _status = _cond.wait_until(_lock, _time);
+            unpark(_cond);
+            if(_status == std::cv_status::timeout)
+                return _pred();
+        }
+        return true;
+    }
+
+    size_type size() const { return m_parked.size(); }
+    bool      empty() const { return m_parked.empty(); }
+
+private:
+    bool unpark(Condition& _cond)
+    {
+        auto itr = std::find(m_parked.begin(), m_parked.end(), &_cond);
+        if(itr == m_parked.end())
+            return false;
+        m_parked.erase(itr);
+        return true;
+    }
+
+private:
+    std::vector<Condition*> m_parked = {};
+};
+
+//======================================================================================//
+
+}  // namespace PTL
@@ -0,0 +1,160 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//
+// ---------------------------------------------------------------
+// Tasking class header file
+//
+// Class Description:
+//
+// This file provides a native task arena: a separate queue of tasks within
+// a ThreadPool with a limit on the number of workers executing its tasks at
+// the same time and a weight which determines its share of the workers
+//
+// ---------------------------------------------------------------
+
+#pragma once
+
+#include "PTL/Task.hh"
+#include "PTL/ThreadPool.hh"
+#include "PTL/Threading.hh"
+#include "PTL/UserTaskQueue.hh"
+#include "PTL/Utility.hh"
+#include "PTL/VTask.hh"
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+
+namespace PTL
+{
+namespace internal
+{
+ThreadPool*
+get_default_threadpool();
+}  // namespace internal
+
+//======================================================================================//
+
+/// \brief TaskArena isolates a group of tasks within a (native) ThreadPool. The tasks
+/// of an arena are held in a queue of their own and the workers of the pool choose
+/// between the queue of the pool (weight of one) and the queues of the arenas by
+/// stride scheduling, i.e. each queue receives a share of the executed tasks
+/// proportional to its weight. At most max_concurrency workers execute the tasks of
+/// an arena at the same time (zero for no limit).
+///
+/// The task groups created within a task of an arena (or within execute()) submit
+/// to the arena and a thread waiting on the task group of an arena only helps with
+/// the tasks of that arena. A thread executing a task of an arena never picks up the
+/// tasks of another arena (or of the pool) while it waits, so nested waits in one
+/// tenant cannot be blocked behind the work of another.
+///
+/// With the TBB backend, the tasks are passed to the thread-pool. The destructor
+/// executes the tasks remaining in the queue in the calling thread, as does add_task()
+/// once the thread-pool is destroyed. The queue has a bin per worker and follows the
+/// size of an elastic thread-pool.
+class TaskArena
+{
+public:
+    using size_type    = ThreadPool::size_type;
+    using task_pointer = ThreadPool::task_pointer;
+    using queue_type   = UserTaskQueue;
+
+public:
+    explicit TaskArena(ThreadPool* _tp              = internal::get_default_threadpool(),
+                       size_type   _max_concurrency = 0, size_type _weight = 1);
+    ~TaskArena();
+
+    // registered with the thread-pool by address
+    TaskArena(const TaskArena&) = delete;
+    TaskArena(TaskArena&&)      = delete;
+    TaskArena& operator=(const TaskArena&) = delete;
+    TaskArena& operator=(TaskArena&&) = delete;
+
+public:
+    // insert a task into the queue of the arena
+    size_type add_task(task_pointer&& _task);
+
+    // insert a function into the queue of the arena without a future
+    template <typename FuncT>
+    void enqueue(FuncT&& _func)
+    {
+        add_task(std::make_shared<Task<void>>(true, 0, std::forward<FuncT>(_func)));
+    }
+
+    // execute a function in the calling thread within the arena
+    template <typename FuncT>
+    auto execute(FuncT&& _func) -> decltype(_func())
+    {
+        auto*           _prev = current();
+        ScopeDestructor _dtor{ [_prev]() { current() = _prev; } };
+        current() = this;
+        return _func();
+    }
+
+    void      set_max_concurrency(size_type _v) { m_max_concurrency = _v; }
+    void      set_weight(size_type _v) { m_weight = (_v > 0) ? _v : 1; }
+    size_type max_concurrency() const { return m_max_concurrency; }
+    size_type weight() const { return m_weight; }
+    // number of tasks in the queue and number of workers executing tasks
+    size_type size() const { return m_queue->size(); }
+    bool      empty() const { return m_queue->empty(); }
+    size_type active() const { return m_active.load() & ~closing_bit; }
+
+    ThreadPool*     pool() const { return m_pool.load(); }
+    VUserTaskQueue* get_queue() const { return m_queue; }
+
+    // arena of the task executed by the calling thread (nullptr if none)
+    static TaskArena*& current();
+
+protected:
+    friend class ThreadPool;
+
+    // tasks are waiting and a worker may start executing one
+    bool ready() const
+    {
+        return !m_queue->empty() &&
+               (m_max_concurrency == 0 || active() < m_max_concurrency);
+    }
+
+    // a worker starts (fails at the concurrency limit) and finishes executing a task
+    bool acquire();
+    void release();
+
+private:
+    // set in m_active by the destructor, the last worker to finish then signals it
+    static constexpr size_t closing_bit = size_t{ 1 }
+                                          << (std::numeric_limits<size_t>::digits - 1);
+
+private:
+    // cleared by the pool under its arena lock (shared by m_lock) when it is destroyed
+    std::atomic<ThreadPool*> m_pool{ nullptr };
+    ThreadPool::lock_t       m_lock{};
+    std::atomic<size_t>      m_max_concurrency{ 0 };
+    std::atomic<size_t>      m_weight{ 1 };
+    std::atomic<size_t>      m_active{ 0 };
+    std::atomic<uintmax_t>   m_pass{ 0 };  // stride scheduling by the pool
+    queue_type*              m_queue    = nullptr;
+    bool                     m_released = false;  // guarded by m_release_mutex
+    Mutex                    m_release_mutex{};
+    Condition                m_release_cond{};
+};
+
+}  // namespace PTL
@@ -35,7 +35,12 @@
 #include "PTL/Config.hh"
 #include "PTL/Globals.hh"
 #include "PTL/JoinFunction.hh"
+#include "PTL/LatencyHistogram.hh"
 #include "PTL/Task.hh"
+#include "PTL/TaskArena.hh"
+#include "PTL/TaskHooks.hh"
+#include "PTL/TaskLabel.hh"
+#include "PTL/TaskTracer.hh"
 #include "PTL/ThreadData.hh"
 #include "PTL/ThreadPool.hh"
 #include "PTL/Threading.hh"
@@ -43,6 +48,7 @@
 #include "PTL/VTask.hh"
 #include "PTL/VUserTaskQueue.hh"
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <cstdint>
@@ -64,6 +70,16 @@
 
 namespace PTL
 {
+//--------------------------------------------------------------------------------------//
+/// \brief thrown by the future of a task whose result type is not default-constructible
+/// when the task was skipped after TaskGroup::cancel()
+struct TaskCancelled : std::runtime_error
+{
+    TaskCancelled()
+    : std::runtime_error("[PTL::TaskGroup] task skipped after cancel()")
+    {}
+};
+
 namespace internal
 {
 std::atomic_uintmax_t&
@@ -74,8 +90,140 @@ get_default_threadpool();
 
 intmax_t
 get_task_depth();
+
+//--------------------------------------------------------------------------------------//
+// invoked by the task which completes the last pending task of a task group: wakes the
+// waiting threads and invokes the registered completion callbacks. The callbacks are
+// moved out under the lock since the task group may be destroyed once it is released
+//
+inline void
+task_group_complete(Mutex& _lock, Condition& _cond,
+                    std::vector<std::function<void()>>& _callbacks)
+{
+    std::vector<std::function<void()>> _funcs{};
+    {
+        AutoLock _lk{ _lock };
+        std::swap(_funcs, _callbacks);
+        _cond.notify_all();
+    }
+    for(auto& itr : _funcs)
+        itr();
+}
+
+//--------------------------------------------------------------------------------------//
+// result of a task with a return value which was skipped because its task group was
+// cancelled. The skip is recorded by the task group so TaskGroup::join() never reads it
+//
+template <typename Tp, enable_if_t<std::is_default_constructible<Tp>::value, int> = 0>
+Tp
+cancelled_result()
+{
+    return Tp{};
+}
+
+template <typename Tp, enable_if_t<!std::is_default_constructible<Tp>::value, int> = 0>
+Tp
+cancelled_result()
+{
+    throw TaskCancelled{};
+}
+
+//--------------------------------------------------------------------------------------//
+// cancellation state and the number of tasks which were executed or skipped
+//
+struct task_group_status
+{
+    using flag_type = std::shared_ptr<std::atomic_bool>;
+
+    // checked by a task before it executes the user function
+    bool skip()
+    {
+        if(!cancelled->load(std::memory_order_relaxed))
+            return false;
+        ++skipped;
+        return true;
+    }
+
+    // submission time of a task, zero if the latency of the group is not recorded
+    int64_t submitted() const { return (latency) ? TaskLatency::now() : 0; }
+
+    // records the queue wait of a task and returns the start of its execution
+    int64_t started(int64_t _submit)
+    {
+        if(!latency || _submit == 0)
+            return 0;
+        auto _now = TaskLatency::now();
+        latency->queue_wait.record(TaskLatency::elapsed(_submit, _now));
+        return _now;
+    }
+
+    // records the service time of a task which started at _start
+    void finished(int64_t _start)
+    {
+        if(latency && _start != 0)
+            latency->service.record(TaskLatency::elapsed(_start, TaskLatency::now()));
+    }
+
+    // records that the task at _index of the task list was skipped
+    void skip_task(size_t _index)
+    {
+        AutoLock _lk{ skipped_lock };
+        skipped_tasks.push_back(_index);
+    }
+
+    // indices of the skipped tasks in ascending order
+    std::vector<size_t> get_skipped_tasks()
+    {
+        AutoLock            _lk{ skipped_lock };
+        std::vector<size_t> _tasks = skipped_tasks;
+        std::sort(_tasks.begin(), _tasks.end());
+        return _tasks;
+    }
+
+    void clear_skipped_tasks()
+    {
+        AutoLock _lk{ skipped_lock };
+        skipped_tasks.clear();
+    }
+
+    using latency_type = std::shared_ptr<TaskLatency>;
+
+    flag_type             cancelled = std::make_shared<std::atomic_bool>(false);
+    std::atomic_uintmax_t completed{ 0 };
+    std::atomic_uintmax_t skipped{ 0 };
+    latency_type latency = (TaskLatency::enabled()) ? std::make_shared<TaskLatency>()
+                                                    : latency_type{};
+    Mutex               skipped_lock{};
+    std::vector<size_t> skipped_tasks{};
+};
 }  // namespace internal
 
+//======================================================================================//
+
+/// \brief read-only view of the cancellation state of a TaskGroup which long-running
+/// tasks can poll to stop early. Remains valid after the task group is destroyed. A
+/// default-constructed token is never cancelled
+class CancellationToken
+{
+public:
+    using flag_type = std::shared_ptr<const std::atomic_bool>;
+
+    CancellationToken() = default;
+    explicit CancellationToken(flag_type _flag)
+    : m_flag{ std::move(_flag) }
+    {}
+
+    bool is_cancelled() const
+    {
+        return (m_flag) ? m_flag->load(std::memory_order_relaxed) : false;
+    }
+
+private:
+    flag_type m_flag = {};
+};
+
+//======================================================================================//
+
 template <typename Tp, typename Arg = Tp, intmax_t MaxDepth = 0>
 class TaskGroup
 {
@@ -104,6 +252,8 @@ public:
     using reverse_iterator       = typename future_list_t::reverse_iterator;
     using const_iterator         = typename future_list_t::const_iterator;
     using const_reverse_iterator = typename future_list_t::const_reverse_iterator;
+    using callback_list_t        = container_type<std::function<void()>>;
+    using status_type            = internal::task_group_status;
     //------------------------------------------------------------------------//
     template <typename... Args>
     using task_type = Task<ArgTp, decay_t<Args>...>;
@@ -173,6 +323,53 @@ public:
     void notify();
     void notify_all();
 
+    // cancel the task group: the tasks which have not started are skipped without
+    // executing the user function (the results of skipped tasks are not joined and
+    // their futures hold a value-initialized result, or throw TaskCancelled if the
+    // result is not default-constructible).
+    // The task group remains cancelled until reset_cancellation() is called
+    void cancel() { m_status.cancelled->store(true); }
+    bool is_cancelled() const { return m_status.cancelled->load(); }
+    void reset_cancellation() { m_status.cancelled->store(false); }
+
+    // token for polling the cancellation state from within the tasks
+    CancellationToken get_cancellation_token() const
+    {
+        return CancellationToken{ m_status.cancelled };
+    }
+
+    // number of tasks which executed the user function or were skipped after cancel()
+    uintmax_t completed() const { return m_status.completed.load(); }
+    uintmax_t skipped() const { return m_status.skipped.load(); }
+
+    // histograms of the queue wait and service time of the tasks of this group. Only
+    // recorded if TaskLatency was enabled when the task group was created
+    TaskLatency get_latency() const
+    {
+        return (m_status.latency) ? *m_status.latency : TaskLatency{};
+    }
+    void reset_latency()
+    {
+        if(m_status.latency)
+            m_status.latency->reset();
+    }
+
+    // register a function which is invoked (once) by the thread which completes the
+    // last pending task. Returns false (and does not register the function) if no
+    // tasks are pending
+    bool on_completion(std::function<void()>&& _func);
+
+    // NUMA node which the tasks created after this call are queued on if the
+    // thread-pool partitions its queue by node (-1 for the node of the submitter)
+    void set_numa_node(int _node) { m_numa_node = _node; }
+    int  numa_node() const { return m_numa_node; }
+
+    // arena which the tasks created after this call are queued in (nullptr for the
+    // queue of the thread-pool). Defaults to the arena of the task (or of
+    // TaskArena::execute) which creates the task group
+    void       set_arena(TaskArena* _arena) { m_arena = _arena; }
+    TaskArena* arena() const { return m_arena; }
+
     void reserve(size_t _n)
     {
         m_task_list.reserve(_n);
@@ -183,16 +380,30 @@ public:
     template <typename Func, typename... Args>
     std::shared_ptr<task_type<Args...>> wrap(Func func, Args... args)
     {
-        return operator+=(std::make_shared<task_type<Args...>>(
-            is_native_task_group(), m_depth, std::move(func), std::move(args)...));
+        auto _task = std::make_shared<task_type<Args...>>(
+            is_native_task_group(), m_depth, std::move(func), std::move(args)...);
+        _task->set_numa_node(m_numa_node);
+        return operator+=(std::move(_task));
     }
 
-    template <typename Func, typename... Args, typename Up = Tp>
+    // the overload is selected by the result type of the tasks (e.g. TaskGroup<void, int>
+    // executes tasks which return an int)
+    template <typename Func, typename... Args, typename Up = ArgTp>
     enable_if_t<std::is_void<Up>::value, void> exec(Func func, Args... args);
 
-    template <typename Func, typename... Args, typename Up = Tp>
+    template <typename Func, typename... Args, typename Up = ArgTp>
     enable_if_t<!std::is_void<Up>::value, void> exec(Func func, Args... args);
 
+    // executes the function in a task with the label (e.g. PTL_TASK_LABEL("name")).
+    // The tasks created by the function inherit the label if it executes in the
+    // calling thread
+    template <typename Func, typename... Args>
+    void exec(const TaskLabel* _label, Func func, Args... args)
+    {
+        TaskLabel::Scope _scope{ _label };
+        exec(std::move(func), std::move(args)...);
+    }
+
     template <typename Func, typename... Args>
     void run(Func func, Args... args)
     {
@@ -261,6 +472,11 @@ protected:
     atomic_int&       task_count() { return m_tot_task_count; }
     const atomic_int& task_count() const { return m_tot_task_count; }
 
+    //------------------------------------------------------------------------//
+    // invoke _func with the result of every task which was not skipped
+    template <typename Func>
+    inline void for_each_result(Func&& _func);
+
 protected:
     static int f_verbose;
     // Private variables
@@ -275,6 +491,10 @@ protected:
     tbb_task_group_t* m_tbb_task_group = nullptr;
     task_list_t       m_task_list      = {};
     future_list_t     m_future_list    = {};
+    callback_list_t   m_callbacks      = {};
+    status_type       m_status         = {};
+    int               m_numa_node      = -1;
+    TaskArena*        m_arena          = TaskArena::current();
 
 private:
     void internal_update();
@@ -375,9 +595,13 @@ TaskGroup<Tp, Arg, MaxDepth>::wait()
 
     ThreadPool*     tpool = (m_pool) ? m_pool : data->thread_pool;
     VUserTaskQueue* taskq = (tpool) ? tpool->get_queue() : data->current_queue;
+    if(m_arena)
+        taskq = m_arena->get_queue();
 
     bool _is_main     = data->is_main;
     bool _within_task = data->within_task;
+    // a thread only executes the tasks of the arena it is executing a task of
+    bool _isolated = (TaskArena::current() != m_arena);
 
     auto is_active_state = [&]() {
         return (tpool->state()->load(std::memory_order_relaxed) !=
@@ -385,22 +609,24 @@ TaskGroup<Tp, Arg, MaxDepth>::wait()
     };
 
     auto execute_this_threads_tasks = [&]() {
-        if(!taskq)
+        if(!taskq || _isolated)
             return;
 
-        // only want to process if within a task
-        if((!_is_main || tpool->size() < 2) && _within_task)
+        // only want to process if within a task (or attached to the pool)
+        if((!_is_main || tpool->size() < 2) && (_within_task || data->is_attached))
         {
             int bin = static_cast<int>(taskq->GetThreadBin());
             // const auto nitr = (tpool) ? tpool->size() :
             // Thread::hardware_concurrency();
             while(this->pending() > 0)
             {
+                tpool->poll_broadcast();
+                tpool->poll_mailbox();
                 if(!taskq->empty())
                 {
                     auto _task = taskq->GetTask(bin);
                     if(_task)
-                        (*_task)();
+                        ThreadPool::run_task(data, _task.get());
                 }
             }
         }
@@ -437,6 +663,14 @@ TaskGroup<Tp, Arg, MaxDepth>::wait()
         }
     }
 
+    // the time the thread is blocked in the join
+    TaskTracer::record(TaskTracer::join_begin, this);
+    TaskHooks::notify(TaskHooks::wait_begin, this);
+    ScopeDestructor _join{ [this]() {
+        TaskHooks::notify(TaskHooks::wait_end, this);
+        TaskTracer::record(TaskTracer::join_end, this);
+    } };
+
     intmax_t wake_size = 2;
     AutoLock _lock(m_task_lock, std::defer_lock);
 
@@ -445,20 +679,24 @@ TaskGroup<Tp, Arg, MaxDepth>::wait()
         execute_this_threads_tasks();
 
         // while loop protects against spurious wake-ups
-        while(_is_main && pending() > 0 && is_active_state())
+        while((_is_main || _isolated) && pending() > 0 && is_active_state())
         {
             // auto _wake = [&]() { return (wake_size > pending() ||
             // !is_active_state());
             // };
 
             // lock before sleeping on condition
+            // a worker of the pool executes the pending broadcast
+            if(!_is_main)
+                tpool->poll_broadcast();
+
             if(!_lock.owns_lock())
                 _lock.lock();
 
             // Wait until signaled that a task has been competed
             // Unlock mutex while wait, then lock it back when signaled
-            // when true, this wakes the thread
-            if(pending() >= wake_size)
+            // when true, this wakes the thread (a worker checks for broadcasts)
+            if(pending() >= wake_size && _is_main)
             {
                 m_task_cond.wait(_lock);
             }
@@ -497,13 +735,11 @@ TaskGroup<Tp, Arg, MaxDepth>::get_scope_destructor()
     auto& _counter   = m_tot_task_count;
     auto& _task_cond = task_cond();
     auto& _task_lock = task_lock();
-    return ScopeDestructor{ [&_task_cond, &_task_lock, &_counter]() {
+    auto& _callbacks = m_callbacks;
+    return ScopeDestructor{ [&_task_cond, &_task_lock, &_counter, &_callbacks]() {
         auto _count = --(_counter);
         if(_count < 1)
-        {
-            AutoLock _lk{ _task_lock };
-            _task_cond.notify_all();
-        }
+            internal::task_group_complete(_task_lock, _task_cond, _callbacks);
     } };
 }
 
@@ -515,6 +751,17 @@ TaskGroup<Tp, Arg, MaxDepth>::notify()
     m_task_cond.notify_one();
 }
 
+template <typename Tp, typename Arg, intmax_t MaxDepth>
+bool
+TaskGroup<Tp, Arg, MaxDepth>::on_completion(std::function<void()>&& _func)
+{
+    AutoLock _lk{ m_task_lock };
+    if(pending() < 1)
+        return false;
+    m_callbacks.emplace_back(std::move(_func));
+    return true;
+}
+
 template <typename Tp, typename Arg, intmax_t MaxDepth>
 void
 TaskGroup<Tp, Arg, MaxDepth>::notify_all()
@@ -531,26 +778,33 @@ TaskGroup<Tp, Arg, MaxDepth>::exec(Func func, Args... args)
     if(MaxDepth > 0 && !m_tbb_task_group && ThreadData::GetInstance() &&
        ThreadData::GetInstance()->task_depth > MaxDepth)
     {
-        local_exec<Tp>(std::move(func), std::move(args)...);
+        local_exec<ArgTp>(std::move(func), std::move(args)...);
     }
     else
     {
         auto& _counter   = m_tot_task_count;
         auto& _task_cond = task_cond();
         auto& _task_lock = task_lock();
-        auto  _task      = wrap([&_task_cond, &_task_lock, &_counter, func, args...]() {
+        auto& _callbacks = m_callbacks;
+        auto& _status    = m_status;
+        auto  _submitted = _status.submitted();
+        auto  _task      = wrap([&_task_cond, &_task_lock, &_counter, &_callbacks,
+                                 &_status, _submitted, func, args...]() {
             auto* _tdata = ThreadData::GetInstance();
             if(_tdata)
                 ++(_tdata->task_depth);
-            func(args...);
+            if(!_status.skip())
+            {
+                auto _start = _status.started(_submitted);
+                func(args...);
+                _status.finished(_start);
+                ++(_status.completed);
+            }
             auto _count = --(_counter);
             if(_tdata)
                 --(_tdata->task_depth);
             if(_count < 1)
-            {
-                AutoLock _lk{ _task_lock };
-                _task_cond.notify_all();
-            }
+                internal::task_group_complete(_task_lock, _task_cond, _callbacks);
         });
 
         if(m_tbb_task_group)
@@ -562,6 +816,10 @@ TaskGroup<Tp, Arg, MaxDepth>::exec(Func func, Args... args)
                 _tbb_task_group->run([_ptask]() { (*_ptask)(); });
             });
         }
+        else if(m_arena)
+        {
+            m_arena->add_task(std::move(_task));
+        }
         else
         {
             m_pool->add_task(std::move(_task));
@@ -576,26 +834,42 @@ TaskGroup<Tp, Arg, MaxDepth>::exec(Func func, Args... args)
     if(MaxDepth > 0 && !m_tbb_task_group && ThreadData::GetInstance() &&
        ThreadData::GetInstance()->task_depth > MaxDepth)
     {
-        local_exec<Tp>(std::move(func), std::move(args)...);
+        local_exec<ArgTp>(std::move(func), std::move(args)...);
     }
     else
     {
         auto& _counter   = m_tot_task_count;
         auto& _task_cond = task_cond();
         auto& _task_lock = task_lock();
-        auto  _task      = wrap([&_task_cond, &_task_lock, &_counter, func, args...]() {
+        auto& _callbacks = m_callbacks;
+        auto& _status    = m_status;
+        auto  _submitted = _status.submitted();
+        auto  _index     = m_task_list.size();
+        auto  _task      = wrap([&_task_cond, &_task_lock, &_counter, &_callbacks,
+                                 &_status, _submitted, _index, func,
+                                 args...]() -> ArgTp {
             auto* _tdata = ThreadData::GetInstance();
             if(_tdata)
                 ++(_tdata->task_depth);
+            if(_status.skip())
+            {
+                _status.skip_task(_index);
+                auto _count = --(_counter);
+                if(_tdata)
+                    --(_tdata->task_depth);
+                if(_count < 1)
+                    internal::task_group_complete(_task_lock, _task_cond, _callbacks);
+                return internal::cancelled_result<ArgTp>();
+            }
+            auto   _start = _status.started(_submitted);
             auto&& _ret   = func(args...);
-            auto   _count = --(_counter);
+            _status.finished(_start);
+            ++(_status.completed);
+            auto _count = --(_counter);
             if(_tdata)
                 --(_tdata->task_depth);
             if(_count < 1)
-            {
-                AutoLock _lk{ _task_lock };
-                _task_cond.notify_all();
-            }
+                internal::task_group_complete(_task_lock, _task_cond, _callbacks);
             return std::forward<decltype(_ret)>(_ret);
         });
 
@@ -608,6 +882,10 @@ TaskGroup<Tp, Arg, MaxDepth>::exec(Func func, Args... args)
                 _tbb_task_group->run([_ptask]() { (*_ptask)(); });
             });
         }
+        else if(m_arena)
+        {
+            m_arena->add_task(std::move(_task));
+        }
         else
         {
             m_pool->add_task(std::move(_task));
@@ -625,7 +903,11 @@ TaskGroup<Tp, Arg, MaxDepth>::local_exec(Func func, Args... args)
         ++(_tdata->task_depth);
     promise_type _p{};
     m_future_list.emplace_back(_p.get_future());
-    func(args...);
+    if(!m_status.skip())
+    {
+        func(args...);
+        ++(m_status.completed);
+    }
     _p.set_value();
     if(_tdata)
         --(_tdata->task_depth);
@@ -636,32 +918,51 @@ template <typename Up, typename Func, typename... Args>
 enable_if_t<!std::is_void<Up>::value, void>
 TaskGroup<Tp, Arg, MaxDepth>::local_exec(Func func, Args... args)
 {
+    // a skipped task does not add a result
+    if(m_status.skip())
+        return;
     auto* _tdata = ThreadData::GetInstance();
     if(_tdata)
         ++(_tdata->task_depth);
     promise_type _p{};
     m_future_list.emplace_back(_p.get_future());
     _p.set_value(func(args...));
+    ++(m_status.completed);
     if(_tdata)
         --(_tdata->task_depth);
 }
 
 template <typename Tp, typename Arg, intmax_t MaxDepth>
-template <typename Up, enable_if_t<!std::is_void<Up>::value, int>>
-inline Up
-TaskGroup<Tp, Arg, MaxDepth>::join(Up accum)
+template <typename Func>
+inline void
+TaskGroup<Tp, Arg, MaxDepth>::for_each_result(Func&& _func)
 {
-    this->wait();
+    // the results of the tasks skipped after cancel() are discarded
+    auto   _skipped = m_status.get_skipped_tasks();
+    auto   _sitr    = _skipped.begin();
+    size_t _index   = 0;
     for(auto& itr : m_task_list)
     {
-        using RetT = decay_t<decltype(itr->get())>;
-        accum      = std::move(m_join(std::ref(accum), std::forward<RetT>(itr->get())));
+        if(_sitr != _skipped.end() && *_sitr == _index++)
+        {
+            ++_sitr;
+            continue;
+        }
+        _func(itr->get());
     }
     for(auto& itr : m_future_list)
-    {
-        using RetT = decay_t<decltype(itr.get())>;
-        accum      = std::move(m_join(std::ref(accum), std::forward<RetT>(itr.get())));
-    }
+        _func(itr.get());
+}
+
+template <typename Tp, typename Arg, intmax_t MaxDepth>
+template <typename Up, enable_if_t<!std::is_void<Up>::value, int>>
+inline Up
+TaskGroup<Tp, Arg, MaxDepth>::join(Up accum)
+{
+    this->wait();
+    for_each_result([&](ArgTp _v) {
+        accum = std::move(m_join(std::ref(accum), std::forward<ArgTp>(_v)));
+    });
     this->clear();
     return accum;
 }
@@ -688,16 +989,7 @@ inline void
 TaskGroup<Tp, Arg, MaxDepth>::join()
 {
     this->wait();
-    for(auto& itr : m_task_list)
-    {
-        using RetT = decay_t<decltype(itr->get())>;
-        m_join(std::forward<RetT>(itr->get()));
-    }
-    for(auto& itr : m_future_list)
-    {
-        using RetT = decay_t<decltype(itr.get())>;
-        m_join(std::forward<RetT>(itr.get()));
-    }
+    for_each_result([&](ArgTp _v) { m_join(std::forward<ArgTp>(_v)); });
     this->clear();
 }
 
@@ -707,6 +999,7 @@ TaskGroup<Tp, Arg, MaxDepth>::clear()
 {
     m_future_list.clear();
     m_task_list.clear();
+    m_status.clear_skipped_tasks();
 }
 
 template <typename Tp, typename Arg, intmax_t MaxDepth>
@@ -728,6 +1021,10 @@ TaskGroup<Tp, Arg, MaxDepth>::internal_update()
     {
         m_tbb_task_group = new tbb_task_group_t{};
     }
+
+    // an arena of another thread-pool does not apply
+    if(m_arena && m_arena->pool() != m_pool)
+        m_arena = nullptr;
 }
 
 template <typename Tp, typename Arg, intmax_t MaxDepth>
@@ -0,0 +1,105 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ---------------------------------------------------------------
+// Tasking class header file
+//
+// Class Description:
+//
+// This file provides the registration of callbacks which are invoked at the
+// points of the lifecycle of the tasks and of the threads of the pools, e.g.
+// for external profilers (NVTX, ITT)
+//
+// ---------------------------------------------------------------
+
+#pragma once
+
+#include "PTL/Config.hh"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+namespace PTL
+{
+//======================================================================================//
+
+/// \brief TaskHooks invokes the registered callbacks at the lifecycle events of the
+/// tasks and the workers. The object passed to a callback is the VTask for the task
+/// events, the TaskGroup for the wait events and the ThreadPool for the worker events.
+/// The label of a task (VTask::label) identifies the kind of task in a callback.
+/// The callbacks run in the thread of the event and must not throw. Without a
+/// callback for an event the dispatch is a relaxed load and a branch; without
+/// PTL_USE_TASK_HOOKS it is compiled out
+class TaskHooks
+{
+public:
+    enum event_type : uint8_t
+    {
+        create = 0,    // a task was constructed
+        enqueue,       // a task was added to a queue of a thread-pool
+        begin,         // a task starts executing
+        end,           // a task finished executing
+        steal,         // a task was taken from the queue of another thread
+        wait_begin,    // a thread starts waiting on a task group
+        wait_end,      // a thread stops waiting on a task group
+        worker_start,  // a worker of a thread-pool starts
+        worker_stop,   // a worker of a thread-pool stops
+        num_events
+    };
+
+    using mask_type     = uint32_t;
+    using handle_type   = uint64_t;
+    using callback_type = std::function<void(event_type, const void*)>;
+
+    static constexpr mask_type all_events = (mask_type{ 1 } << num_events) - 1;
+    static constexpr mask_type mask(event_type _v) { return mask_type{ 1 } << _v; }
+
+public:
+    // registers a callback for the events in _mask and returns the handle for
+    // remove(). Returns zero (and does nothing) without PTL_USE_TASK_HOOKS
+    static handle_type add(callback_type _func, mask_type _mask = all_events);
+    static bool        remove(handle_type);
+    static void        clear();
+
+    // whether any callback is registered for the event
+    static bool active(event_type _v)
+    {
+        return (f_mask.load(std::memory_order_relaxed) & mask(_v)) != 0;
+    }
+
+    static void notify(event_type _type, const void* _obj)
+    {
+#if defined(PTL_USE_TASK_HOOKS)
+        if(active(_type))
+            dispatch(_type, _obj);
+#else
+        (void) _type;
+        (void) _obj;
+#endif
+    }
+
+private:
+    static void dispatch(event_type, const void*);
+
+    static std::atomic<mask_type> f_mask;
+};
+
+//======================================================================================//
+
+}  // namespace PTL
@@ -0,0 +1,90 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ---------------------------------------------------------------
+// Tasking class header file
+//
+// Class Description:
+//
+// This file provides the labels and the source locations which identify the
+// tasks in the statistics, the traces and the lifecycle hooks
+//
+// ---------------------------------------------------------------
+
+#pragma once
+
+#include <string>
+
+//--------------------------------------------------------------------------------------//
+// label of the call site: a static TaskLabel holding the name and the source location,
+// e.g. tg.exec(PTL_TASK_LABEL("update"), func)
+//
+#define PTL_TASK_LABEL(NAME)                                                             \
+    ([]() -> const ::PTL::TaskLabel* {                                                   \
+        static const ::PTL::TaskLabel _ptl_task_label = { NAME, __FILE__, __LINE__ };    \
+        return &_ptl_task_label;                                                         \
+    }())
+
+namespace PTL
+{
+//======================================================================================//
+
+/// \brief TaskLabel is the name and the source location of a kind of task. The labels
+/// have static storage: the tasks only hold a pointer so labeling a task does not
+/// allocate and a label pointer is a cheap key for aggregation. Labels are created at
+/// a call site with PTL_TASK_LABEL or interned from a runtime name with intern()
+struct TaskLabel
+{
+    const char* name;
+    const char* file;
+    int         line;
+
+    // the label for the name (and location), created once and never released
+    static const TaskLabel* intern(const std::string& _name, const char* _file = nullptr,
+                                   int _line = 0);
+
+    // the label applied to the tasks created by this thread which are not labeled
+    // explicitly (nullptr if none)
+    static const TaskLabel*& current()
+    {
+        static thread_local const TaskLabel* _v = nullptr;
+        return _v;
+    }
+
+    /// \brief labels the tasks created by this thread during the lifetime of the scope
+    class Scope
+    {
+    public:
+        explicit Scope(const TaskLabel* _label)
+        : m_prev{ current() }
+        {
+            current() = _label;
+        }
+        ~Scope() { current() = m_prev; }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const TaskLabel* m_prev = nullptr;
+    };
+};
+
+//======================================================================================//
+
+}  // namespace PTL
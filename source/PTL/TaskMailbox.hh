@@ -0,0 +1,127 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//
+// ---------------------------------------------------------------
+// Tasking class header file
+//
+// Class Description:
+//
+// This file provides the mailbox of a worker thread: a queue of the tasks
+// which were submitted for that specific thread. It also serves as the inbox
+// of the tasks submitted to a thread-pool by threads outside of the pool
+//
+// ---------------------------------------------------------------
+
+#pragma once
+
+#include "PTL/Threading.hh"
+#include "PTL/VTask.hh"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace PTL
+{
+//======================================================================================//
+
+/// \brief TaskMailbox is an unbounded multiple-producer single-consumer queue of tasks
+/// (linked list with a stub node). Any thread pushes with a single atomic exchange
+/// and only the worker which owns the mailbox pops, so popping requires no claims or
+/// locks and the tasks can never be stolen by another thread. When several threads
+/// may consume (the inbox of a pool), the caller must ensure only one pops at a time
+class TaskMailbox
+{
+public:
+    using task_pointer = std::shared_ptr<VTask>;
+    using size_type    = size_t;
+
+public:
+    TaskMailbox()
+    : m_head{ &m_stub }
+    , m_tail{ &m_stub }
+    {}
+
+    ~TaskMailbox()
+    {
+        while(pop())
+        {}
+        if(m_tail != &m_stub)
+            delete m_tail;
+    }
+
+    TaskMailbox(const TaskMailbox&) = delete;
+    TaskMailbox(TaskMailbox&&)      = delete;
+    TaskMailbox& operator=(const TaskMailbox&) = delete;
+    TaskMailbox& operator=(TaskMailbox&&) = delete;
+
+public:
+    // any thread
+    void push(task_pointer&& _task)
+    {
+        auto* _node = new node{ std::move(_task) };
+        m_size.fetch_add(1, std::memory_order_relaxed);
+        node* _prev = m_head.exchange(_node, std::memory_order_acq_rel);
+        _prev->next.store(_node, std::memory_order_release);
+    }
+
+    // owner only: returns nullptr if empty or if a push has not been linked yet
+    task_pointer pop()
+    {
+        node* _next = m_tail->next.load(std::memory_order_acquire);
+        if(!_next)
+            return nullptr;
+        // the popped node becomes the stub
+        task_pointer _task = std::move(_next->task);
+        if(m_tail != &m_stub)
+            delete m_tail;
+        m_tail = _next;
+        m_size.fetch_sub(1, std::memory_order_relaxed);
+        return _task;
+    }
+
+    bool      empty() const { return m_size.load(std::memory_order_relaxed) == 0; }
+    size_type size() const { return m_size.load(std::memory_order_relaxed); }
+
+    // the owner parks on this condition while it is idle (see ParkingLot)
+    Condition& condition() { return m_cond; }
+
+private:
+    struct node
+    {
+        node() = default;
+        explicit node(task_pointer&& _task)
+        : task{ std::move(_task) }
+        {}
+
+        task_pointer       task = nullptr;
+        std::atomic<node*> next{ nullptr };
+    };
+
+    std::atomic<node*>     m_head;  // last pushed node (producers)
+    node*                  m_tail;  // stub node (consumer)
+    std::atomic<size_type> m_size{ 0 };
+    node                   m_stub{};
+    Condition              m_cond{};
+};
+
+//======================================================================================//
+
+}  // namespace PTL
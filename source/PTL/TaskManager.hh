@@ -30,9 +30,11 @@
 
 #pragma once
 
+#include "PTL/Concurrency.hh"
 #include "PTL/Globals.hh"
 #include "PTL/Task.hh"
 #include "PTL/TaskGroup.hh"
+#include "PTL/TaskLabel.hh"
 #include "PTL/ThreadPool.hh"
 
 #include <iostream>
@@ -65,7 +67,7 @@ public:
     /// get the singleton pointer
     static TaskManager* GetInstance();
     static TaskManager* GetInstanceIfExists();
-    static unsigned     ncores() { return std::thread::hardware_concurrency(); }
+    static unsigned     ncores() { return PTL::effective_concurrency(); }
 
 public:
     //------------------------------------------------------------------------//
@@ -146,6 +148,16 @@ public:
         return _ptask;
     }
     //------------------------------------------------------------------------//
+    // packaged_task with a label (e.g. PTL_TASK_LABEL("name"))
+    //------------------------------------------------------------------------//
+    template <typename FuncT, typename... Args>
+    auto async(const TaskLabel* _label, FuncT&& func, Args... args)
+        -> std::shared_ptr<PackagedTask<decay_t<decltype(func(args...))>, Args...>>
+    {
+        TaskLabel::Scope _scope{ _label };
+        return async(std::forward<FuncT>(func), std::move(args)...);
+    }
+    //------------------------------------------------------------------------//
 
 public:
     //------------------------------------------------------------------------//
@@ -237,7 +249,7 @@ PTL::TaskManager::GetInstance()
 {
     if(!fgInstance())
     {
-        auto nthreads = std::thread::hardware_concurrency();
+        auto nthreads = PTL::effective_concurrency();
         std::cout << "Allocating mad::TaskManager with " << nthreads << " thread(s)..."
                   << std::endl;
         new TaskManager(TaskRunManager::GetMasterRunManager()->GetThreadPool());
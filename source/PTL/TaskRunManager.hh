@@ -25,6 +25,7 @@
 
 #pragma once
 
+#include "PTL/Concurrency.hh"
 #include "PTL/ThreadPool.hh"
 #include "PTL/VUserTaskQueue.hh"
 
@@ -63,13 +64,16 @@ public:
 
 public:
     // Inherited methods to re-implement for MT case
-    virtual void Initialize(uint64_t n = std::thread::hardware_concurrency());
+    virtual void Initialize(uint64_t n = effective_concurrency());
     virtual void Terminate();
     ThreadPool*  GetThreadPool() const { return m_thread_pool; }
     TaskManager* GetTaskManager() const { return m_task_manager; }
     bool         IsInitialized() const { return m_is_initialized; }
     int          GetVerbose() const { return m_verbose; }
     void         SetVerbose(int val) { m_verbose = val; }
+    // print the task latency histograms of the thread-pool when terminating
+    bool GetLatencySummary() const { return m_latency_summary; }
+    void SetLatencySummary(bool val) { m_latency_summary = val; }
 
 public:  // with description
     // Singleton implementing master thread behavior
@@ -82,12 +86,13 @@ private:
 
 protected:
     // Barriers: synch points between master and workers
-    bool            m_is_initialized = false;
-    int             m_verbose        = 0;
-    uint64_t        m_workers        = 0;
-    VUserTaskQueue* m_task_queue     = nullptr;
-    ThreadPool*     m_thread_pool    = nullptr;
-    TaskManager*    m_task_manager   = nullptr;
+    bool            m_is_initialized  = false;
+    bool            m_latency_summary = GetEnv<bool>("PTL_LATENCY_SUMMARY", false);
+    int             m_verbose         = 0;
+    uint64_t        m_workers         = 0;
+    VUserTaskQueue* m_task_queue      = nullptr;
+    ThreadPool*     m_thread_pool     = nullptr;
+    TaskManager*    m_task_manager    = nullptr;
 };
 
 }  // namespace PTL
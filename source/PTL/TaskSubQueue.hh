@@ -26,6 +26,7 @@
 
 #include <atomic>
 #include <cassert>
+#include <iterator>
 #include <list>
 #include <memory>
 #include <utility>
@@ -56,11 +57,19 @@ public:
     void ReleaseClaim();
 
     void         PushTask(task_pointer&&) PTL_NO_SANITIZE_THREAD;
+    template <typename ItrT>
+    void PushTasks(ItrT _beg, ItrT _end) PTL_NO_SANITIZE_THREAD;
     task_pointer PopTask(bool front = true) PTL_NO_SANITIZE_THREAD;
+    // pops the oldest task unless it is pool-bound
+    task_pointer StealTask() PTL_NO_SANITIZE_THREAD;
 
     size_type size() const;
     bool      empty() const;
 
+    // NUMA node of the worker which owns the bin (-1 if not known)
+    int  GetNode() const { return m_node.load(std::memory_order_relaxed); }
+    void SetNode(int _node);
+
 private:
     // mutex
 #if defined(PTL_USE_LOCKS)
@@ -70,6 +79,8 @@ private:
     std::atomic<size_type> m_ntasks;
     // for checking if being modified
     std::atomic_bool m_available;
+    // NUMA node of the owning worker
+    std::atomic<int> m_node;
     // used my master queue to keep track of number of tasks
     std::atomic_uintmax_t* m_all_tasks;
     // queue of tasks
@@ -81,6 +92,7 @@ private:
 inline TaskSubQueue::TaskSubQueue(std::atomic_uintmax_t* _ntasks)
 : m_ntasks(0)
 , m_available(true)
+, m_node(-1)
 , m_all_tasks(_ntasks)
 {}
 
@@ -89,6 +101,7 @@ inline TaskSubQueue::TaskSubQueue(std::atomic_uintmax_t* _ntasks)
 inline TaskSubQueue::TaskSubQueue(const TaskSubQueue& rhs)
 : m_ntasks(0)
 , m_available(true)
+, m_node(rhs.GetNode())
 , m_all_tasks(rhs.m_all_tasks)
 {}
 
@@ -100,7 +113,9 @@ TaskSubQueue::AcquireClaim()
     bool is_avail = m_available.load(std::memory_order_relaxed);
     if(!is_avail)
         return false;
-    return m_available.compare_exchange_strong(is_avail, false,
+    // acquire pairs with the release in ReleaseClaim: the new holder sees the tasks
+    // as the previous holder left them
+    return m_available.compare_exchange_strong(is_avail, false, std::memory_order_acquire,
                                                std::memory_order_relaxed);
 }
 
@@ -132,6 +147,16 @@ TaskSubQueue::empty() const
 
 //======================================================================================//
 
+inline void
+TaskSubQueue::SetNode(int _node)
+{
+    // avoid dirtying the cache line when the node has not changed
+    if(m_node.load(std::memory_order_relaxed) != _node)
+        m_node.store(_node, std::memory_order_relaxed);
+}
+
+//======================================================================================//
+
 inline void
 TaskSubQueue::PushTask(task_pointer&& task)
 {
@@ -146,6 +171,22 @@ TaskSubQueue::PushTask(task_pointer&& task)
 
 //======================================================================================//
 
+template <typename ItrT>
+inline void
+TaskSubQueue::PushTasks(ItrT _beg, ItrT _end)
+{
+    // no need to lock these if claim is acquired via atomic
+    assert(m_available.load(std::memory_order_relaxed) == false);
+    m_ntasks += std::distance(_beg, _end);
+#if defined(PTL_USE_LOCKS)
+    AutoLock lk{ m_mutex };
+#endif
+    for(; _beg != _end; ++_beg)
+        m_task_queue.emplace_front(std::move(*_beg));
+}
+
+//======================================================================================//
+
 inline TaskSubQueue::task_pointer
 TaskSubQueue::PopTask(bool front)
 {
@@ -176,5 +217,27 @@ TaskSubQueue::PopTask(bool front)
     return _task;
 }
 
+//======================================================================================//
+
+inline TaskSubQueue::task_pointer
+TaskSubQueue::StealTask()
+{
+    // no need to lock -- claim is acquired via atomic
+    assert(m_available.load(std::memory_order_relaxed) == false);
+    if(m_ntasks.load() == 0)
+        return nullptr;
+
+#if defined(PTL_USE_LOCKS)
+    AutoLock lk{ m_mutex };
+#endif
+    if(m_task_queue.back()->is_pool_bound())
+        return nullptr;
+    task_pointer _task = std::move(m_task_queue.back());
+    m_task_queue.pop_back();
+    --m_ntasks;
+
+    return _task;
+}
+
 //======================================================================================//
 }  // namespace PTL
@@ -0,0 +1,115 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ---------------------------------------------------------------
+// Tasking class header file
+//
+// Class Description:
+//
+// This file provides a tracer of the scheduling events of the tasks which
+// writes the timelines of the threads as Chrome trace JSON (chrome://tracing,
+// Perfetto)
+//
+// ---------------------------------------------------------------
+
+#pragma once
+
+#include "PTL/TaskLabel.hh"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+namespace PTL
+{
+//======================================================================================//
+
+/// \brief TaskTracer records the scheduling events (enqueue, start, end, steal, park,
+/// wake and the joins of task groups) with TSC timestamps into a ring buffer per
+/// thread. A disabled tracer costs a relaxed load per event. The events are written
+/// as Chrome trace JSON on demand or, when an output file is set (PTL_TRACE_FILE),
+/// by ThreadPool::destroy_threadpool. Tracing is enabled with enable() or PTL_TRACE.
+/// The execution of a task with a TaskLabel is named by the label. A dump is only
+/// consistent for the threads which are not recording at the time
+class TaskTracer
+{
+public:
+    using size_type = size_t;
+
+    enum event_type : uint8_t
+    {
+        enqueue = 0,
+        start,
+        end,
+        steal,
+        park,
+        wake,
+        join_begin,
+        join_end
+    };
+
+    struct event
+    {
+        uint64_t         tsc   = 0;
+        const void*      task  = nullptr;
+        const TaskLabel* label = nullptr;
+        event_type       type  = enqueue;
+    };
+
+public:
+    static bool enabled() { return f_enabled.load(std::memory_order_relaxed); }
+    static void enable(bool _v = true);
+    static void disable() { enable(false); }
+
+    // number of events kept per thread, applies to the threads which start recording
+    // afterwards
+    static void      set_capacity(size_type);
+    static size_type get_capacity();
+
+    // the file written by ThreadPool::destroy_threadpool (empty to disable)
+    static void        set_output(const std::string&);
+    static std::string get_output();
+
+    static void record(event_type _type, const void* _task = nullptr,
+                       const TaskLabel* _label = nullptr)
+    {
+        if(enabled())
+            push(_type, _task, _label);
+    }
+
+    // writes the recorded events as Chrome trace JSON
+    static void dump(std::ostream&);
+    static bool dump(const std::string& _fname);
+    static bool dump_output();  // writes to the output file if set
+    // discards the events recorded so far
+    static void clear();
+
+    // ticks of the CycleClock
+    static uint64_t timestamp();
+
+private:
+    static void push(event_type, const void*, const TaskLabel*);
+
+    static std::atomic<bool> f_enabled;
+};
+
+//======================================================================================//
+
+}  // namespace PTL
@@ -26,7 +26,10 @@
 #pragma once
 
 #include "PTL/Config.hh"
+#include "PTL/LatencyHistogram.hh"
+#include "PTL/ThreadStatistics.hh"
 
+#include <atomic>
 #include <cstdint>
 #include <deque>
 
@@ -126,6 +129,7 @@ using tbb_task_arena_t     = tbb::task_arena;
 
 //--------------------------------------------------------------------------------------//
 
+class TaskMailbox;
 class ThreadPool;
 class VUserTaskQueue;
 
@@ -143,12 +147,18 @@ public:
     void update();
 
 public:
-    bool                       is_main       = false;
-    bool                       within_task   = false;
-    intmax_t                   task_depth    = 0;
-    ThreadPool*                thread_pool   = nullptr;
-    VUserTaskQueue*            current_queue = nullptr;
-    TaskStack<VUserTaskQueue*> queue_stack   = {};
+    bool                       is_main        = false;
+    bool                       within_task    = false;
+    bool                       is_attached    = false;  // ThreadPool::attach
+    intmax_t                   task_depth     = 0;
+    uintmax_t                  broadcast_seen = 0;  // last broadcast of the pool
+    ThreadPool*                thread_pool    = nullptr;
+    TaskMailbox*               mailbox        = nullptr;  // tasks for this thread
+    std::atomic<intmax_t>      worker_slot{ -1 };         // bin in the queue of the pool
+    VUserTaskQueue*            current_queue  = nullptr;
+    TaskStack<VUserTaskQueue*> queue_stack    = {};
+    ThreadStatistics           statistics{};  // scheduler statistics of the thread
+    TaskLatency                latency{};     // latency of the tasks it executed
 
 public:
     // Public functions
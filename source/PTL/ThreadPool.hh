@@ -32,9 +32,16 @@
 
 #include "PTL/AutoLock.hh"
 #include "PTL/Config.hh"
+#include "PTL/ParkingLot.hh"
+#include "PTL/TaskHooks.hh"
+#include "PTL/TaskMailbox.hh"
+#include "PTL/TaskTracer.hh"
 #include "PTL/ThreadData.hh"
 #include "PTL/Threading.hh"
+#include "PTL/TimerWheel.hh"
+#include "PTL/Topology.hh"
 #include "PTL/Types.hh"
+#include "PTL/Utility.hh"
 #include "PTL/VTask.hh"
 #include "PTL/VUserTaskQueue.hh"
 
@@ -56,6 +63,7 @@
 #include <cstdint>
 #include <cstdlib>
 #include <deque>
+#include <exception>
 #include <functional>
 #include <iostream>
 #include <map>
@@ -82,6 +90,8 @@ static const short NONINIT = 3;
 }  // namespace state
 }  // namespace thread_pool
 
+class TaskArena;
+
 class ThreadPool
 {
 public:
@@ -94,10 +104,13 @@ public:
     using atomic_int_type  = std::shared_ptr<std::atomic_uintmax_t>;
     using pool_state_type  = std::shared_ptr<std::atomic_short>;
     using atomic_bool_type = std::shared_ptr<std::atomic_bool>;
+    using atomic_time_type = std::shared_ptr<std::atomic<intmax_t>>;
     // objects
     using task_type    = VTask;
     using lock_t       = std::shared_ptr<Mutex>;
+    using rlock_t      = std::shared_ptr<RecursiveMutex>;
     using condition_t  = std::shared_ptr<Condition>;
+    using parking_t    = std::shared_ptr<ParkingLot>;
     using task_pointer = std::shared_ptr<task_type>;
     using task_queue_t = VUserTaskQueue;
     // containers
@@ -107,17 +120,28 @@ public:
     using thread_index_map_t = std::map<uintmax_t, ThreadId>;
     using thread_vec_t       = std::vector<Thread>;
     using thread_data_t      = std::vector<std::shared_ptr<ThreadData>>;
+    using statistics_t       = std::vector<WorkerStatistics>;
     // functions
     using initialize_func_t = std::function<void()>;
     using finalize_func_t   = std::function<void()>;
+    using broadcast_func_t  = std::function<void()>;
     using affinity_func_t   = std::function<intmax_t(intmax_t)>;
+    // timers
+    using timer_id_t       = TimerWheel::timer_id;
+    using timer_point_t    = TimerWheel::time_point;
+    using timer_duration_t = TimerWheel::duration;
+    using timer_error_t    = TimerWheel::error_handler;
 
     static affinity_func_t& affinity_functor()
     {
-        static affinity_func_t _v = [](intmax_t) {
+        // assign the CPUs the process is allowed to run on in turn
+        static affinity_func_t _v = [](intmax_t) -> intmax_t {
             static std::atomic<intmax_t> assigned;
+            static const auto&           _cpus   = Topology::instance().cpus();
             intmax_t                     _assign = assigned++;
-            return _assign % Thread::hardware_concurrency();
+            if(_cpus.empty())
+                return _assign % Thread::hardware_concurrency();
+            return static_cast<intmax_t>(_cpus.at(_assign % _cpus.size()).cpu);
         };
         return _v;
     }
@@ -151,6 +175,16 @@ public:
         affinity_func_t   set_affinity = affinity_functor();
         initialize_func_t initializer  = initialization_functor();
         finalize_func_t   finalizer    = finalization_functor();
+        // elastic sizing: grow towards max_pool_size while tasks back up for longer
+        // than grow_delay and retire workers which have been idle for linger
+        bool                      elastic       = f_elastic();
+        size_type                 min_pool_size = 1;
+        size_type                 max_pool_size = f_default_pool_size();
+        std::chrono::milliseconds grow_delay    = std::chrono::milliseconds{ 10 };
+        std::chrono::milliseconds linger        = f_elastic_linger();
+        // pin the threads according to a cpu_placement policy of the CPU topology
+        // instead of set_affinity (implies use_affinity unless NONE)
+        short placement = f_cpu_placement();
     };
 
 public:
@@ -175,14 +209,67 @@ public:
     // Public functions
     size_type initialize_threadpool(size_type);  // start the threads
     size_type destroy_threadpool();              // destroy the threads
-    size_type stop_thread();
-
+    size_type stop_thread();  // request a thread to exit, does not wait for it
+
+    // execute a function exactly once on every worker thread (or on the threads in
+    // the set, including the calling thread) and wait for it to complete. The workers
+    // execute the function between tasks, while idle and while waiting on a task
+    // group so it is safe to call from within a task. A targeted worker which is
+    // blocked elsewhere (e.g. on a lock held by the calling thread) delays the
+    // completion, the other workers do not. When the pool is not running, only the
+    // calling thread executes the function (if it is targeted).
+    // Returns the number of threads which executed the function.
+    // With the TBB backend a task cannot be directed to a thread: the function is
+    // executed at most once on each thread which joins the arena of the pool within
+    // a short delay, so it may run on fewer threads than size()
     template <typename FuncT>
-    void execute_on_all_threads(FuncT&& _func);
+    size_type execute_on_all_threads(FuncT&& _func);
 
     template <typename FuncT>
-    void execute_on_specific_threads(const std::set<std::thread::id>& _tid,
-                                     FuncT&&                          _func);
+    size_type execute_on_specific_threads(const std::set<std::thread::id>& _tid,
+                                          FuncT&&                          _func);
+
+    // executes the pending broadcast (or the tasks in the mailbox) in the calling
+    // worker thread, returns true if anything was executed. Invoked by the workers
+    // of this pool which are waiting on a task group
+    bool poll_broadcast();
+    bool poll_mailbox();
+
+    // registers the calling (non-worker) thread as a temporary worker: it gets thread
+    // data for this pool and a slot past the ones of the workers, so it submits to and
+    // takes tasks from a bin which no other attached thread uses (while there are fewer
+    // attached threads than bins), and executes tasks while waiting on a task group.
+    // Returns false if the thread is a worker or already attached. The thread must
+    // detach before the pool is destroyed
+    class ScopedAttach;
+    bool attach();
+    void detach();
+    bool is_attached() const;
+    // executes tasks in the calling attached thread until the predicate is satisfied
+    // (waits if the thread is not attached)
+    template <typename PredT>
+    void execute_until(PredT&& _pred);
+
+    // snapshots of the scheduler statistics of the workers which have run in the
+    // pool, relative to the last reset. The counters are only updated when PTL is
+    // built with PTL_USE_STATISTICS
+    statistics_t get_statistics() const;
+    void         reset_statistics();
+
+    // histograms of the queue wait (submission to start) and the service time of the
+    // tasks executed by each worker and merged over the workers. Recorded when
+    // TaskLatency is enabled (PTL_LATENCY). reset_statistics() clears them as well
+    std::vector<TaskLatency> get_worker_latencies() const;
+    TaskLatency              get_latency() const;
+
+    // executions and execution time of the labeled tasks (see TaskLabel) executed by
+    // the workers since the last reset, merged by label in the order of decreasing
+    // execution time. Recorded when PTL is built with PTL_USE_STATISTICS
+    std::vector<LabelStatistics> get_label_statistics() const;
+
+    // executes a task in the calling thread and records its trace events, statistics
+    // and latency in the thread data (if not null)
+    static void run_task(ThreadData*, VTask*);
 
     task_queue_t*  get_queue() const { return m_task_queue; }
     task_queue_t*& get_valid_queue(task_queue_t*&) const;
@@ -199,6 +286,8 @@ public:
     static void set_default_use_tbb(bool _v) { set_use_tbb(_v); }
     /// set the default use of cpu affinity
     static void set_default_use_cpu_affinity(bool _v);
+    /// set the default cpu_placement policy
+    static void set_default_cpu_placement(short _v) { f_cpu_placement() = _v; }
     /// set the default scheduling priority of threads in thread-pool
     static void set_default_scheduling_priority(int _v) { f_thread_priority() = _v; }
     /// set the default verbosity
@@ -210,6 +299,8 @@ public:
     static bool get_default_use_tbb() { return f_use_tbb(); }
     /// get the default use of cpu affinity
     static bool get_default_use_cpu_affinity() { return f_use_cpu_affinity(); }
+    /// get the default cpu_placement policy
+    static short get_default_cpu_placement() { return f_cpu_placement(); }
     /// get the default scheduling priority of threads in thread-pool
     static int get_default_scheduling_priority() { return f_thread_priority(); }
     /// get the default verbosity
@@ -220,11 +311,35 @@ public:
 public:
     // add tasks for threads to process
     size_type add_task(task_pointer&& task, int bin = -1);
-    // size_type add_thread_task(ThreadId id, task_pointer&& task);
+    // add a task which is only executed by the worker thread with the given id. The
+    // task is placed in the mailbox of the worker, which the worker drains before
+    // the bins of the queue, and it is never stolen. If the id is the calling thread
+    // and not a worker, the task is executed directly. Throws if the id is neither
+    size_type add_thread_task(ThreadId id, task_pointer&& task);
     // add a generic container with iterator
     template <typename ListT>
     size_type add_tasks(ListT&);
 
+    // add tasks which are executed once a time-point is reached, after a delay or
+    // periodically. Expired timers are moved into the task queue in batches by the
+    // worker threads, which otherwise park no longer than the next deadline. Timers
+    // only expire while the (non-TBB) thread-pool is running
+    template <typename FuncT>
+    timer_id_t add_task_at(timer_point_t _when, FuncT&& _func);
+    template <typename RepT, typename PeriodT, typename FuncT>
+    timer_id_t add_task_after(const std::chrono::duration<RepT, PeriodT>& _delay,
+                              FuncT&&                                     _func);
+    template <typename RepT, typename PeriodT, typename FuncT>
+    timer_id_t add_periodic(const std::chrono::duration<RepT, PeriodT>& _period,
+                            FuncT&&                                     _func);
+    // remove a pending timer, returns false if it already expired or was removed
+    bool      cancel_timer(timer_id_t _id) { return m_timers->cancel(_id); }
+    size_type pending_timers() const { return m_timers->size(); }
+    // invoked in the worker with the id of the timer and the exception when a delayed
+    // or periodic task throws. By default (or if reset with an empty function) the
+    // exception is reported on std::cerr when the pool is verbose
+    void set_timer_error_handler(timer_error_t _func);
+
     Thread* get_thread(size_type _n) const;
     Thread* get_thread(std::thread::id id) const;
 
@@ -247,9 +362,23 @@ public:
     // get the pool state
     const pool_state_type& state() const { return m_pool_state; }
     // see how many main task threads there are
-    size_type size() const { return m_pool_size; }
+    size_type size() const { return m_pool_size->load(); }
     // set the thread pool size
     void resize(size_type _n);
+    // elastic sizing between a minimum and maximum number of threads
+    void set_elastic(bool _v) { m_elastic = _v; }
+    void set_elastic_limits(size_type _min, size_type _max);
+    void set_elastic_linger(std::chrono::milliseconds _v) { m_linger = _v; }
+    bool is_elastic() const { return m_elastic; }
+    // federation: the idle workers of this pool execute tasks from the queues of the
+    // linked pools while all the workers of a linked pool are busy. At most
+    // max_workers threads of this pool help at a time and only while the linked
+    // queue holds at least min_backlog tasks. Pool-bound tasks (e.g. inserted into a
+    // specific bin) are never taken. Linked pools must not be moved and the links
+    // are removed when either pool is destroyed
+    void link_pool(ThreadPool* _donor);
+    void unlink_pool(ThreadPool* _donor);
+    void set_federation_limits(size_type _max_workers, size_type _min_backlog);
     // affinity assigns threads to cores, assignment at constructor
     bool using_affinity() const { return m_use_affinity; }
     bool is_alive() { return m_alive_flag->load(); }
@@ -260,7 +389,12 @@ public:
     int  get_active_threads_count() const { return m_thread_awake->load(); }
 
     void set_affinity(affinity_func_t f) { m_affinity_func = std::move(f); }
-    void set_affinity(intmax_t i, Thread&) const;
+    // pins thread i to the CPU given by the affinity function, returns the CPU (or -1
+    // if the thread could not be pinned)
+    intmax_t set_affinity(intmax_t i, Thread&) const;
+    // the NUMA node of the CPU which worker i is pinned to, -1 if the worker is not
+    // pinned
+    int get_worker_node(intmax_t i) const;
     void set_priority(int _prio, Thread&) const;
 
     void set_verbose(int n) { m_verbose = n; }
@@ -270,20 +404,69 @@ public:
     tbb_task_arena_t* get_task_arena();
 
 public:
-    // read FORCE_NUM_THREADS environment variable
-    static const thread_id_map_t& get_thread_ids();
-    static uintmax_t              get_thread_id(ThreadId);
-    static uintmax_t              get_this_thread_id();
-    static uintmax_t              add_thread_id(ThreadId = ThisThread::get_id());
+    // thread indices: a thread is registered on first use and its index is recycled
+    // when it exits. The index of the calling thread is cached in thread-local storage.
+    // Only the calling thread registers itself: the index of another thread which is
+    // not registered is unregistered_thread_id
+    static constexpr uintmax_t unregistered_thread_id = ~uintmax_t{ 0 };
+
+    static thread_id_map_t get_thread_ids();  // snapshot of the registered threads
+    static uintmax_t       get_thread_id(ThreadId);
+    static uintmax_t       get_this_thread_id();
+    static uintmax_t       add_thread_id(ThreadId = ThisThread::get_id());
 
 protected:
     void execute_thread(VUserTaskQueue*);  // function thread sits in
     int  insert(task_pointer&&, int = -1);
     int  run_on_this(task_pointer&&);
 
+    timer_id_t add_timer(timer_point_t, timer_duration_t, TimerWheel::function_type&&);
+    size_type  dispatch_timers();
+    void       report_timer_error(timer_id_t, const std::exception_ptr&) const;
+    size_type  drain_inbox();
+
+    void grow_if_backlogged();
+    bool retire_thread(ThreadId);
+    void reap_threads();
+
+    bool         help_linked_pools();
+    task_pointer steal_from_linked_pools();
+    void         request_help();
+    void         unlink_all();
+
+    // broadcasts (execute_on_all_threads)
+    size_type broadcast(broadcast_func_t&&, const std::set<std::thread::id>*);
+    bool run_broadcast(ThreadData*, bool _leave = false);
+    void leave_broadcasts(ThreadData*);
+
+    // mailboxes (add_thread_task)
+    void open_mailbox(ThreadData*);
+    void close_mailbox(ThreadData*);
+    bool run_mailbox(ThreadData*);
+
+    // attached threads
+    bool execute_attached_task();
+    void wait_attached_task(std::chrono::milliseconds);
+#if defined(PTL_USE_TBB)
+    size_type tbb_broadcast(const broadcast_func_t&, const std::set<std::thread::id>*);
+#endif
+
+    // dense slots of the workers, i.e. their bins in the queue (GetThreadBin)
+    void acquire_worker_slot(ThreadData*);
+    void release_worker_slot(ThreadData*);
+
+    // native task arenas, unregister_arena is called with m_arena_lock held
+    friend class TaskArena;
+    void register_arena(TaskArena*);
+    void unregister_arena(TaskArena*);
+    void detach_arenas();
+    void resize_arenas();
+    bool arena_ready();
+    bool execute_arena_task(bool _pool_ready);
+
 protected:
     // called in THREAD INIT
-    static void start_thread(ThreadPool*, thread_data_t*, intmax_t = -1);
+    static void start_thread(ThreadPool*, thread_data_t*, intmax_t = -1, uintmax_t = 0);
 
     void record_entry();
     void record_exit();
@@ -294,19 +477,93 @@ private:
     bool             m_use_affinity      = false;
     bool             m_tbb_tp            = false;
     bool             m_delete_task_queue = false;
+    bool             m_elastic           = false;
     int              m_verbose           = f_verbose();
     int              m_priority          = f_thread_priority();
-    size_type        m_pool_size         = 0;
+    size_type        m_min_size          = 1;
+    size_type        m_max_size          = 0;
     ThreadId         m_main_tid          = ThisThread::get_id();
+    atomic_int_type  m_pool_size         = std::make_shared<std::atomic_uintmax_t>(0);
     atomic_bool_type m_alive_flag        = std::make_shared<std::atomic_bool>(false);
     pool_state_type  m_pool_state        = std::make_shared<std::atomic_short>(0);
     atomic_int_type  m_thread_awake      = std::make_shared<std::atomic_uintmax_t>(0);
     atomic_int_type  m_thread_active     = std::make_shared<std::atomic_uintmax_t>(0);
+    atomic_bool_type m_timer_keeper      = std::make_shared<std::atomic_bool>(false);
+    atomic_time_type m_timer_wait        = std::make_shared<std::atomic<intmax_t>>(
+        timer_point_t::max().time_since_epoch().count());
+    atomic_time_type m_backlog_since     = std::make_shared<std::atomic<intmax_t>>(0);
+    atomic_bool_type m_help_requested    = std::make_shared<std::atomic_bool>(false);
+    atomic_int_type  m_helping           = std::make_shared<std::atomic_uintmax_t>(0);
+    atomic_bool_type m_has_donors        = std::make_shared<std::atomic_bool>(false);
+    atomic_bool_type m_has_helpers       = std::make_shared<std::atomic_bool>(false);
+    atomic_bool_type m_has_arenas        = std::make_shared<std::atomic_bool>(false);
+    atomic_int_type  m_broadcast_gen     = std::make_shared<std::atomic_uintmax_t>(0);
+    atomic_int_type  m_broadcast_left    = std::make_shared<std::atomic_uintmax_t>(0);
+    atomic_bool_type m_inbox_draining    = std::make_shared<std::atomic_bool>(false);
+
+    // elastic sizing
+    std::chrono::milliseconds m_grow_delay = std::chrono::milliseconds{ 10 };
+    std::chrono::milliseconds m_linger     = std::chrono::milliseconds{ 1000 };
+
+    // federation: the lists of linked pools are copy-on-write so the workers read a
+    // snapshot without locking, f_federation_mutex only serializes the changes
+    using pool_list_t   = std::vector<ThreadPool*>;
+    using pool_list_ptr = std::shared_ptr<const pool_list_t>;
+
+    atomic_int_type m_help_max     = std::make_shared<std::atomic_uintmax_t>(0);
+    atomic_int_type m_help_backlog = std::make_shared<std::atomic_uintmax_t>(1);
+    pool_list_ptr   m_donors       = std::make_shared<pool_list_t>();  // pools helped
+    pool_list_ptr   m_helpers      = std::make_shared<pool_list_t>();  // pools helping
+
+    // the worker holding slot i + 1 (guarded by m_slot_lock). A worker which leaves
+    // hands its slot to the last one so the slots stay in [1, number of workers]
+    std::vector<ThreadData*> m_worker_slots = {};
+
+    // broadcasts: the function and the targeted threads (null for every worker) of
+    // the current broadcast, the workers taking part and whether a broadcast is in
+    // progress (guarded by m_broadcast_mutex and signaled through m_broadcast_cond)
+    std::shared_ptr<broadcast_func_t> m_broadcast_func    = {};
+    const std::set<std::thread::id>*  m_broadcast_tids    = nullptr;
+    std::set<std::thread::id>         m_broadcast_workers = {};
+    bool                              m_broadcast_busy    = false;
+
+    // tasks submitted by the threads outside of the pool: a single worker at a time
+    // (m_inbox_draining) moves them into the queue in batches
+    std::shared_ptr<TaskMailbox> m_inbox = std::make_shared<TaskMailbox>();
+
+    // mailboxes of the workers (guarded by m_mailbox_lock)
+    uomap<ThreadId, std::shared_ptr<TaskMailbox>> m_mailboxes = {};
+
+    // the counts of the workers at the last reset (guarded by TypeMutex<ThreadPool>)
+    uomap<const ThreadData*, WorkerStatistics>             m_statistics_base = {};
+    uomap<const ThreadData*, std::vector<LabelStatistics>> m_label_base      = {};
+
+    // attached threads: their thread data and the thread data they had before
+    // (guarded by m_attach_lock)
+    using attached_data_t = std::pair<ThreadData*, std::shared_ptr<ThreadData>>;
+    uomap<ThreadId, attached_data_t> m_attached = {};
+
+    // task arenas: copy-on-write like the lists of linked pools (m_arena_lock only
+    // serializes the changes), the pass of the queue of the pool and the virtual time
+    // of the stride scheduling
+    using arena_list_t   = std::vector<TaskArena*>;
+    using arena_list_ptr = std::shared_ptr<const arena_list_t>;
+
+    atomic_int_type m_pool_pass   = std::make_shared<std::atomic_uintmax_t>(0);
+    atomic_int_type m_arena_vtime = std::make_shared<std::atomic_uintmax_t>(0);
+    arena_list_ptr  m_arenas      = std::make_shared<arena_list_t>();
 
     // locks
-    lock_t m_task_lock = std::make_shared<Mutex>();
-    // conditions
-    condition_t m_task_cond = std::make_shared<Condition>();
+    lock_t  m_task_lock       = std::make_shared<Mutex>();
+    lock_t  m_arena_lock      = std::make_shared<Mutex>();
+    lock_t  m_broadcast_mutex = std::make_shared<Mutex>();
+    lock_t  m_mailbox_lock    = std::make_shared<Mutex>();
+    lock_t  m_slot_lock       = std::make_shared<Mutex>();
+    lock_t  m_attach_lock     = std::make_shared<Mutex>();
+    rlock_t m_resize_lock     = std::make_shared<RecursiveMutex>();
+    // conditions, the idle workers park on the condition of their mailbox
+    parking_t   m_task_cond      = std::make_shared<ParkingLot>();
+    condition_t m_broadcast_cond = std::make_shared<Condition>();
 
     // containers
     bool_list_t   m_is_joined    = {};  // join list
@@ -315,24 +572,33 @@ private:
     thread_list_t m_stop_threads = {};  // storage for stopped threads
     thread_vec_t  m_threads      = {};
     thread_data_t m_thread_data  = {};
+    // node of the CPU worker i is pinned to, -1 if not pinned (guarded by
+    // m_resize_lock)
+    std::vector<int> m_worker_nodes = {};
 
     // task queue
     task_queue_t*     m_task_queue     = nullptr;
     tbb_task_arena_t* m_tbb_task_arena = nullptr;
     tbb_task_group_t* m_tbb_task_group = nullptr;
 
+    // delayed and periodic tasks
+    std::shared_ptr<TimerWheel> m_timers = std::make_shared<TimerWheel>();
+
     // functions
     initialize_func_t m_init_func     = initialization_functor();
     finalize_func_t   m_fini_func     = finalization_functor();
     affinity_func_t   m_affinity_func = affinity_functor();
 
 private:
-    static bool&            f_use_tbb();
-    static bool&            f_use_cpu_affinity();
-    static int&             f_thread_priority();
-    static int&             f_verbose();
-    static size_type&       f_default_pool_size();
-    static thread_id_map_t& f_thread_ids();
+    static bool&                      f_use_tbb();
+    static bool&                      f_use_cpu_affinity();
+    static short&                     f_cpu_placement();
+    static int&                       f_thread_priority();
+    static int&                       f_verbose();
+    static size_type&                 f_default_pool_size();
+    static bool&                      f_elastic();
+    static std::chrono::milliseconds& f_elastic_linger();
+    static Mutex&                     f_federation_mutex();
 };
 
 //--------------------------------------------------------------------------------------//
@@ -340,7 +606,7 @@ inline void
 ThreadPool::notify()
 {
     // wake up one thread that is waiting for a task to be available
-    if(m_thread_awake->load() < m_pool_size)
+    if(m_thread_awake->load() < m_pool_size->load())
     {
         AutoLock l(*m_task_lock);
         m_task_cond->notify_one();
@@ -362,7 +628,7 @@ ThreadPool::notify(size_type ntasks)
         return;
 
     // wake up as many threads that tasks just added
-    if(m_thread_awake->load() < m_pool_size)
+    if(m_thread_awake->load() < m_pool_size->load())
     {
         AutoLock l(*m_task_lock);
         if(ntasks < this->size())
@@ -436,11 +702,28 @@ ThreadPool::run_on_this(task_pointer&& _task)
 inline int
 ThreadPool::insert(task_pointer&& task, int bin)
 {
-    static thread_local ThreadData* _data = ThreadData::GetInstance();
-
-    // pass the task to the queue
-    auto ibin = get_valid_queue(m_task_queue)->InsertTask(std::move(task), _data, bin);
+    // the thread data only applies to the threads of this pool: a worker of another
+    // pool submitting from within a task must not be treated as an owner of a bin
+    ThreadData* _data = ThreadData::GetInstance();
+    if(_data && _data->thread_pool != this)
+        _data = nullptr;
+
+    // threads outside of the pool do not compete with the workers for the bins:
+    // the task goes to the inbox, which the workers drain in batches
+    int ibin = 0;
+    if(!_data && bin < 0)
+    {
+        TaskTracer::record(TaskTracer::enqueue, task.get(), task->label());
+        TaskHooks::notify(TaskHooks::enqueue, task.get());
+        if(TaskLatency::enabled() && task->submit_time() == 0)
+            task->set_submit_time(TaskLatency::now());
+        m_inbox->push(std::move(task));
+    }
+    else
+        ibin = get_valid_queue(m_task_queue)->InsertTask(std::move(task), _data, bin);
     notify();
+    if(m_has_helpers->load(std::memory_order_relaxed))
+        request_help();
     return ibin;
 }
 //--------------------------------------------------------------------------------------//
@@ -454,6 +737,52 @@ ThreadPool::add_task(task_pointer&& task, int bin)
     return static_cast<size_type>(insert(std::move(task), bin));
 }
 //--------------------------------------------------------------------------------------//
+inline ThreadPool::size_type
+ThreadPool::dispatch_timers()
+{
+    if(m_timers->empty())
+        return 0;
+
+    auto _now = TimerWheel::clock_type::now();
+    if(!m_timers->due(_now))
+        return 0;
+
+    TimerWheel::task_list_t _expired{};
+    if(m_timers->advance(_now, _expired) == 0)
+        return 0;
+
+    auto _n = get_valid_queue(m_task_queue)->InsertTasks(std::move(_expired));
+    notify(_n);
+    return _n;
+}
+//--------------------------------------------------------------------------------------//
+template <typename FuncT>
+inline ThreadPool::timer_id_t
+ThreadPool::add_task_at(timer_point_t _when, FuncT&& _func)
+{
+    return add_timer(_when, timer_duration_t::zero(), std::forward<FuncT>(_func));
+}
+//--------------------------------------------------------------------------------------//
+template <typename RepT, typename PeriodT, typename FuncT>
+inline ThreadPool::timer_id_t
+ThreadPool::add_task_after(const std::chrono::duration<RepT, PeriodT>& _delay,
+                           FuncT&&                                     _func)
+{
+    return add_timer(TimerWheel::clock_type::now() +
+                         std::chrono::duration_cast<timer_duration_t>(_delay),
+                     timer_duration_t::zero(), std::forward<FuncT>(_func));
+}
+//--------------------------------------------------------------------------------------//
+template <typename RepT, typename PeriodT, typename FuncT>
+inline ThreadPool::timer_id_t
+ThreadPool::add_periodic(const std::chrono::duration<RepT, PeriodT>& _period,
+                         FuncT&&                                     _func)
+{
+    auto _dt = std::chrono::duration_cast<timer_duration_t>(_period);
+    return add_timer(TimerWheel::clock_type::now() + _dt, _dt,
+                     std::forward<FuncT>(_func));
+}
+//--------------------------------------------------------------------------------------//
 template <typename ListT>
 inline ThreadPool::size_type
 ThreadPool::add_tasks(ListT& c)
@@ -487,234 +816,138 @@ ThreadPool::add_tasks(ListT& c)
 }
 //--------------------------------------------------------------------------------------//
 template <typename FuncT>
-inline void
+inline ThreadPool::size_type
 ThreadPool::execute_on_all_threads(FuncT&& _func)
 {
-    if(m_tbb_tp && m_tbb_task_group)
-    {
-#if defined(PTL_USE_TBB)
-        // TBB lazily activates threads to process tasks and the main thread
-        // participates in processing the tasks so getting a specific
-        // function to execute only on the worker threads requires some trickery
-        //
-        std::set<std::thread::id> _first{};
-        Mutex                     _mutex{};
-        // init function which executes function and returns 1 only once
-        auto _init = [&]() {
-            int _once = 0;
-            _mutex.lock();
-            if(_first.find(std::this_thread::get_id()) == _first.end())
-            {
-                // we need to reset this thread-local static for multiple invocations
-                // of the same template instantiation
-                _once = 1;
-                _first.insert(std::this_thread::get_id());
-            }
-            _mutex.unlock();
-            if(_once != 0)
-            {
-                _func();
-                return 1;
-            }
-            return 0;
-        };
-        // this will collect the number of threads which have
-        // executed the _init function above
-        std::atomic<size_t> _total_init{ 0 };
-        // max parallelism by TBB
-        size_t _maxp = tbb_global_control()->active_value(
-            tbb::global_control::max_allowed_parallelism);
-        // create a task arean
-        auto* _arena = get_task_arena();
-        // size of the thread-pool
-        size_t _sz = size();
-        // number of cores
-        size_t _ncore = Threading::GetNumberOfCores();
-        // maximum depth for recursion
-        size_t _dmax = std::max<size_t>(_ncore, 8);
-        // how many threads we need to initialize
-        size_t _num = std::min(_maxp, std::min(_sz, _ncore));
-        // this is the task passed to the task-group
-        std::function<void()> _init_task;
-        _init_task = [&]() {
-            add_thread_id();
-            static thread_local size_type _depth = 0;
-            int                           _ret   = 0;
-            // don't let the main thread execute the function
-            if(!is_main())
-            {
-                // execute the function
-                _ret = _init();
-                // add the result
-                _total_init += _ret;
-            }
-            // if the function did not return anything, recursively execute
-            // two more tasks
-            ++_depth;
-            if(_ret == 0 && _depth < _dmax && _total_init.load() < _num)
-            {
-                tbb::task_group tg{};
-                tg.run([&]() { _init_task(); });
-                tg.run([&]() { _init_task(); });
-                ThisThread::sleep_for(std::chrono::milliseconds{ 1 });
-                tg.wait();
-            }
-            --_depth;
-        };
+    return broadcast(broadcast_func_t{ std::forward<FuncT>(_func) }, nullptr);
+}
 
-        // TBB won't oversubscribe so we need to limit by ncores - 1
-        size_t nitr        = 0;
-        auto   _fname      = __FUNCTION__;
-        auto   _write_info = [&]() {
-            std::cout << "[" << _fname << "]> Total initialized: " << _total_init
-                      << ", expected: " << _num << ", max-parallel: " << _maxp
-                      << ", size: " << _sz << ", ncore: " << _ncore << std::endl;
-        };
-        while(_total_init < _num)
+//--------------------------------------------------------------------------------------//
+
+template <typename FuncT>
+inline ThreadPool::size_type
+ThreadPool::execute_on_specific_threads(const std::set<std::thread::id>& _tids,
+                                        FuncT&&                          _func)
+{
+    return broadcast(broadcast_func_t{ std::forward<FuncT>(_func) }, &_tids);
+}
+
+//--------------------------------------------------------------------------------------//
+
+inline bool
+ThreadPool::poll_mailbox()
+{
+    ThreadData* _data = ThreadData::GetInstance();
+    if(!_data || _data->thread_pool != this || !_data->mailbox || _data->mailbox->empty())
+        return false;
+    return run_mailbox(_data);
+}
+
+//--------------------------------------------------------------------------------------//
+
+inline bool
+ThreadPool::poll_broadcast()
+{
+    ThreadData* _data = ThreadData::GetInstance();
+    if(!_data || _data->thread_pool != this || _data->is_main || _data->is_attached ||
+       _data->broadcast_seen == m_broadcast_gen->load(std::memory_order_acquire))
+        return false;
+    return run_broadcast(_data);
+}
+
+//--------------------------------------------------------------------------------------//
+
+inline void
+ThreadPool::run_task(ThreadData* _data, VTask* _task)
+{
+    const TaskLabel* _label = _task->label();
+    TaskTracer::record(TaskTracer::start, _task, _label);
+    TaskHooks::notify(TaskHooks::begin, _task);
+#if defined(PTL_USE_STATISTICS)
+    // only the labeled tasks and the tasks with a submission time are timed
+    bool _latency = (TaskLatency::enabled() && _task->submit_time() != 0);
+    if(_data && (_label || _latency))
+    {
+        auto _beg = TaskLatency::now();
+        (*_task)();
+        auto _end = TaskLatency::now();
+        if(_label)
         {
-            auto _n = 2 * _num;
-            while(--_n > 0)
-            {
-                _arena->execute(
-                    [&]() { m_tbb_task_group->run([&]() { _init_task(); }); });
-            }
-            _arena->execute([&]() { m_tbb_task_group->wait(); });
-            // don't loop infinitely but use a strict condition
-            if(nitr++ > 2 * (_num + 1) && (_total_init - 1) == _num)
-            {
-                _write_info();
-                break;
-            }
-            // at this point we need to exit
-            if(nitr > 4 * (_ncore + 1))
-            {
-                _write_info();
-                break;
-            }
+            auto _ns = std::chrono::nanoseconds{ TaskLatency::elapsed(_beg, _end) };
+            _data->statistics.add_label(_label, _ns);
+        }
+        if(_latency)
+        {
+            auto _wait = TaskLatency::elapsed(_task->submit_time(), _beg);
+            _data->latency.queue_wait.record(_wait);
+            _data->latency.service.record(TaskLatency::elapsed(_beg, _end));
         }
-        if(get_verbose() > 3)
-            _write_info();
-#endif
     }
-    else if(get_queue())
+    else
     {
-        get_queue()->ExecuteOnAllThreads(this, std::forward<FuncT>(_func));
+        (*_task)();
     }
+    if(_data)
+        _data->statistics.add(ThreadStatistics::tasks_executed);
+#else
+    ConsumeParameters(_data);
+    (*_task)();
+#endif
+    TaskHooks::notify(TaskHooks::end, _task);
+    TaskTracer::record(TaskTracer::end, _task, _label);
 }
 
 //--------------------------------------------------------------------------------------//
 
-template <typename FuncT>
+inline bool
+ThreadPool::is_attached() const
+{
+    ThreadData* _data = ThreadData::GetInstance();
+    return (_data && _data->thread_pool == this && _data->is_attached);
+}
+
+//--------------------------------------------------------------------------------------//
+
+template <typename PredT>
 inline void
-ThreadPool::execute_on_specific_threads(const std::set<std::thread::id>& _tids,
-                                        FuncT&&                          _func)
+ThreadPool::execute_until(PredT&& _pred)
 {
-    if(m_tbb_tp && m_tbb_task_group)
+    // the predicate is not signaled so an idle thread parks for a millisecond at most
+    while(!_pred())
     {
-#if defined(PTL_USE_TBB)
-        // TBB lazily activates threads to process tasks and the main thread
-        // participates in processing the tasks so getting a specific
-        // function to execute only on the worker threads requires some trickery
-        //
-        std::set<std::thread::id> _first{};
-        Mutex                     _mutex{};
-        // init function which executes function and returns 1 only once
-        auto _exec = [&]() {
-            int _once = 0;
-            _mutex.lock();
-            if(_first.find(std::this_thread::get_id()) == _first.end())
-            {
-                // we need to reset this thread-local static for multiple invocations
-                // of the same template instantiation
-                _once = 1;
-                _first.insert(std::this_thread::get_id());
-            }
-            _mutex.unlock();
-            if(_once != 0)
-            {
-                _func();
-                return 1;
-            }
-            return 0;
-        };
-        // this will collect the number of threads which have
-        // executed the _exec function above
-        std::atomic<size_t> _total_exec{ 0 };
-        // number of cores
-        size_t _ncore = Threading::GetNumberOfCores();
-        // maximum depth for recursion
-        size_t _dmax = std::max<size_t>(_ncore, 8);
-        // how many threads we need to initialize
-        size_t _num = _tids.size();
-        // create a task arena
-        auto* _arena = get_task_arena();
-        // this is the task passed to the task-group
-        std::function<void()> _exec_task;
-        _exec_task = [&]() {
-            add_thread_id();
-            static thread_local size_type _depth    = 0;
-            int                           _ret      = 0;
-            auto                          _this_tid = std::this_thread::get_id();
-            // don't let the main thread execute the function
-            if(_tids.count(_this_tid) > 0)
-            {
-                // execute the function
-                _ret = _exec();
-                // add the result
-                _total_exec += _ret;
-            }
-            // if the function did not return anything, recursively execute
-            // two more tasks
-            ++_depth;
-            if(_ret == 0 && _depth < _dmax && _total_exec.load() < _num)
-            {
-                tbb::task_group tg{};
-                tg.run([&]() { _exec_task(); });
-                tg.run([&]() { _exec_task(); });
-                ThisThread::sleep_for(std::chrono::milliseconds{ 1 });
-                tg.wait();
-            }
-            --_depth;
-        };
-
-        // TBB won't oversubscribe so we need to limit by ncores - 1
-        size_t nitr        = 0;
-        auto   _fname      = __FUNCTION__;
-        auto   _write_info = [&]() {
-            std::cout << "[" << _fname << "]> Total executed: " << _total_exec
-                      << ", expected: " << _num << ", size: " << size() << std::endl;
-        };
-        while(_total_exec < _num)
-        {
-            auto _n = 2 * _num;
-            while(--_n > 0)
-            {
-                _arena->execute(
-                    [&]() { m_tbb_task_group->run([&]() { _exec_task(); }); });
-            }
-            _arena->execute([&]() { m_tbb_task_group->wait(); });
-            // don't loop infinitely but use a strict condition
-            if(nitr++ > 2 * (_num + 1) && (_total_exec - 1) == _num)
-            {
-                _write_info();
-                break;
-            }
-            // at this point we need to exit
-            if(nitr > 8 * (_num + 1))
-            {
-                _write_info();
-                break;
-            }
-        }
-        if(get_verbose() > 3)
-            _write_info();
-#endif
+        if(!execute_attached_task())
+            wait_attached_task(std::chrono::milliseconds{ 1 });
     }
-    else if(get_queue())
+}
+
+//======================================================================================//
+/// \brief ScopedAttach attaches the calling thread to a thread-pool as a temporary
+/// worker for the lifetime of the object
+class ThreadPool::ScopedAttach
+{
+public:
+    explicit ScopedAttach(ThreadPool* _pool)
+    : m_pool{ _pool }
+    , m_attached{ _pool && _pool->attach() }
+    {}
+
+    ~ScopedAttach()
     {
-        get_queue()->ExecuteOnSpecificThreads(_tids, this, std::forward<FuncT>(_func));
+        if(m_attached)
+            m_pool->detach();
     }
-}
+
+    ScopedAttach(const ScopedAttach&) = delete;
+    ScopedAttach(ScopedAttach&&)      = delete;
+    ScopedAttach& operator=(const ScopedAttach&) = delete;
+    ScopedAttach& operator=(ScopedAttach&&) = delete;
+
+    bool attached() const { return m_attached; }
+
+private:
+    ThreadPool* m_pool     = nullptr;
+    bool        m_attached = false;
+};
 
 //======================================================================================//
 
@@ -0,0 +1,318 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ---------------------------------------------------------------
+// Tasking class header file
+//
+// Class Description:
+//
+// This file provides the scheduler statistics of a thread: the counters are
+// updated by the thread itself and read by ThreadPool::get_statistics
+//
+// ---------------------------------------------------------------
+
+#pragma once
+
+#include "PTL/Config.hh"
+#include "PTL/TaskLabel.hh"
+#include "PTL/Threading.hh"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// the instrumentation of the scheduler is compiled out unless PTL_USE_STATISTICS
+#if defined(PTL_USE_STATISTICS)
+#    define PTL_STATISTICS(...) __VA_ARGS__
+#else
+#    define PTL_STATISTICS(...)
+#endif
+
+namespace PTL
+{
+//======================================================================================//
+
+/// \brief WorkerStatistics is a snapshot of the scheduler statistics of a thread
+struct WorkerStatistics
+{
+    ThreadId                 thread_id      = {};
+    uintmax_t                tasks_executed = 0;
+    uintmax_t                local_pops     = 0;  // tasks taken from the own bin
+    uintmax_t                steals         = 0;  // tasks taken from another bin
+    uintmax_t                failed_steals  = 0;  // searches which found no task
+    uintmax_t                failed_claims  = 0;  // AcquireClaim on a busy bin
+    uintmax_t                parks          = 0;  // sleeps on the condition
+    uintmax_t                wakeups        = 0;  // sleeps which ended with work
+    std::chrono::nanoseconds idle_time      = std::chrono::nanoseconds::zero();
+    std::chrono::nanoseconds busy_time      = std::chrono::nanoseconds::zero();
+
+    WorkerStatistics& operator-=(const WorkerStatistics&);
+};
+
+//======================================================================================//
+
+/// \brief LabelStatistics is the number of executions and the execution time of the
+/// tasks with a label
+struct LabelStatistics
+{
+    const TaskLabel*         label          = nullptr;
+    uintmax_t                tasks_executed = 0;
+    std::chrono::nanoseconds busy_time      = std::chrono::nanoseconds::zero();
+};
+
+//======================================================================================//
+
+/// \brief ThreadStatistics holds the live counters of a thread. Only the owning thread
+/// updates them (a relaxed load and store, no read-modify-write) and any thread may
+/// take a snapshot. The counters are padded to a cache line of their own
+class ThreadStatistics
+{
+public:
+    enum counter : short
+    {
+        tasks_executed = 0,
+        local_pops,
+        steals,
+        failed_steals,
+        failed_claims,
+        parks,
+        wakeups,
+        idle_ns,
+        busy_ns,
+        num_counters
+    };
+
+    using clock_type = std::chrono::steady_clock;
+
+public:
+    ThreadStatistics() = default;
+    ~ThreadStatistics() { delete m_labels.load(std::memory_order_relaxed); }
+
+    ThreadStatistics(const ThreadStatistics&) = delete;
+    ThreadStatistics& operator=(const ThreadStatistics&) = delete;
+
+    // owner only
+    void add(counter _c, uintmax_t _n = 1)
+    {
+        increment(m_counters[_c], _n);
+    }
+
+    // adds the nanoseconds elapsed since the time-point
+    void add_elapsed(counter _c, clock_type::time_point _beg)
+    {
+        using nsec_t = std::chrono::nanoseconds;
+        auto _ns     = std::chrono::duration_cast<nsec_t>(clock_type::now() - _beg);
+        add(_c, static_cast<uintmax_t>(_ns.count()));
+    }
+
+    void     set_thread_id(ThreadId _tid) { m_thread_id = _tid; }
+    ThreadId get_thread_id() const { return m_thread_id; }
+
+    // owner only: adds an execution of a labeled task. The table of the labels is
+    // allocated on the first execution of a label so unlabeled tasks cost nothing
+    void add_label(const TaskLabel*, std::chrono::nanoseconds);
+
+    // any thread
+    uintmax_t                    get(counter _c) const;
+    WorkerStatistics             snapshot() const;
+    std::vector<LabelStatistics> label_snapshot() const;
+
+private:
+    // open-addressing table keyed by the (interned) label, written by the owner only.
+    // The entries are published by storing the label last. A table which fills up is
+    // replaced by a larger copy and kept (in prev) for the threads reading it
+    struct label_entry
+    {
+        std::atomic<const TaskLabel*> label{ nullptr };
+        std::atomic<uintmax_t>        tasks{ 0 };
+        std::atomic<uintmax_t>        ns{ 0 };
+    };
+
+    struct label_table
+    {
+        explicit label_table(size_t _n)
+        : entries{ new label_entry[_n] }
+        , mask{ _n - 1 }
+        {}
+
+        std::unique_ptr<label_entry[]> entries;
+        size_t                         mask = 0;
+        size_t                         size = 0;
+        std::unique_ptr<label_table>   prev = {};
+
+        label_entry& find(const TaskLabel* _label) const
+        {
+            auto _h = (reinterpret_cast<uintptr_t>(_label) >> 4) * 0x9E3779B97F4A7C15ULL;
+            for(auto i = static_cast<size_t>(_h);; ++i)
+            {
+                auto& _entry = entries[i & mask];
+                auto* _v     = _entry.label.load(std::memory_order_relaxed);
+                if(_v == _label || !_v)
+                    return _entry;
+            }
+        }
+    };
+
+    static void increment(std::atomic<uintmax_t>& _v, uintmax_t _n)
+    {
+        _v.store(_v.load(std::memory_order_relaxed) + _n, std::memory_order_relaxed);
+    }
+
+    label_table* grow_labels(label_table*);
+
+private:
+    static constexpr size_t cache_line = 64;
+
+    char                      m_front_pad[cache_line]  = {};
+    std::atomic<uintmax_t>    m_counters[num_counters] = {};
+    ThreadId                  m_thread_id              = {};
+    std::atomic<label_table*> m_labels{ nullptr };
+    char                      m_back_pad[cache_line]   = {};
+};
+
+//======================================================================================//
+
+inline uintmax_t
+ThreadStatistics::get(counter _c) const
+{
+    return m_counters[_c].load(std::memory_order_relaxed);
+}
+
+//--------------------------------------------------------------------------------------//
+
+inline WorkerStatistics
+ThreadStatistics::snapshot() const
+{
+    WorkerStatistics _v{};
+    _v.thread_id      = m_thread_id;
+    _v.tasks_executed = get(tasks_executed);
+    _v.local_pops     = get(local_pops);
+    _v.steals         = get(steals);
+    _v.failed_steals  = get(failed_steals);
+    _v.failed_claims  = get(failed_claims);
+    _v.parks          = get(parks);
+    _v.wakeups        = get(wakeups);
+    _v.idle_time      = std::chrono::nanoseconds{ get(idle_ns) };
+    _v.busy_time      = std::chrono::nanoseconds{ get(busy_ns) };
+    return _v;
+}
+
+//--------------------------------------------------------------------------------------//
+
+inline void
+ThreadStatistics::add_label(const TaskLabel* _label, std::chrono::nanoseconds _ns)
+{
+    auto  _n     = static_cast<uintmax_t>(_ns.count());
+    auto* _table = m_labels.load(std::memory_order_relaxed);
+    if(_table)
+    {
+        auto& _entry = _table->find(_label);
+        if(_entry.label.load(std::memory_order_relaxed) == _label)
+        {
+            increment(_entry.tasks, 1);
+            increment(_entry.ns, _n);
+            return;
+        }
+    }
+
+    // a new label: the table is kept at most half full
+    if(!_table || 2 * (_table->size + 1) > _table->mask + 1)
+        _table = grow_labels(_table);
+    auto& _entry = _table->find(_label);
+    ++_table->size;
+    _entry.tasks.store(1, std::memory_order_relaxed);
+    _entry.ns.store(_n, std::memory_order_relaxed);
+    _entry.label.store(_label, std::memory_order_release);
+}
+
+//--------------------------------------------------------------------------------------//
+
+inline ThreadStatistics::label_table*
+ThreadStatistics::grow_labels(label_table* _table)
+{
+    auto* _new = new label_table{ (_table) ? 2 * (_table->mask + 1) : 16 };
+    if(_table)
+    {
+        for(size_t i = 0; i <= _table->mask; ++i)
+        {
+            const auto& _old   = _table->entries[i];
+            auto*       _label = _old.label.load(std::memory_order_relaxed);
+            if(!_label)
+                continue;
+            auto& _entry = _new->find(_label);
+            _entry.tasks.store(_old.tasks.load(std::memory_order_relaxed),
+                               std::memory_order_relaxed);
+            _entry.ns.store(_old.ns.load(std::memory_order_relaxed),
+                            std::memory_order_relaxed);
+            _entry.label.store(_label, std::memory_order_relaxed);
+        }
+        _new->size = _table->size;
+        _new->prev.reset(_table);
+    }
+    m_labels.store(_new, std::memory_order_release);
+    return _new;
+}
+
+//--------------------------------------------------------------------------------------//
+
+inline std::vector<LabelStatistics>
+ThreadStatistics::label_snapshot() const
+{
+    std::vector<LabelStatistics> _v{};
+    auto*                        _table = m_labels.load(std::memory_order_acquire);
+    if(!_table)
+        return _v;
+
+    for(size_t i = 0; i <= _table->mask; ++i)
+    {
+        const auto&     _entry = _table->entries[i];
+        LabelStatistics _s{};
+        _s.label = _entry.label.load(std::memory_order_acquire);
+        if(!_s.label)
+            continue;
+        _s.tasks_executed = _entry.tasks.load(std::memory_order_relaxed);
+        _s.busy_time      = std::chrono::nanoseconds{ static_cast<intmax_t>(
+            _entry.ns.load(std::memory_order_relaxed)) };
+        _v.emplace_back(_s);
+    }
+    return _v;
+}
+
+//--------------------------------------------------------------------------------------//
+
+inline WorkerStatistics&
+WorkerStatistics::operator-=(const WorkerStatistics& rhs)
+{
+    tasks_executed -= rhs.tasks_executed;
+    local_pops -= rhs.local_pops;
+    steals -= rhs.steals;
+    failed_steals -= rhs.failed_steals;
+    failed_claims -= rhs.failed_claims;
+    parks -= rhs.parks;
+    wakeups -= rhs.wakeups;
+    idle_time -= rhs.idle_time;
+    busy_time -= rhs.busy_time;
+    return *this;
+}
+
+//======================================================================================//
+
+}  // namespace PTL
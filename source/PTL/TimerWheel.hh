@@ -0,0 +1,209 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//
+// ---------------------------------------------------------------
+// Tasking class header file
+//
+// Class Description:
+//
+// This file provides a hierarchical timer wheel which holds delayed and
+// periodic functions until they expire and then hands them out in batches
+// as tasks for a ThreadPool
+//
+// ---------------------------------------------------------------
+
+#pragma once
+
+#include "PTL/Threading.hh"
+#include "PTL/VTask.hh"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace PTL
+{
+namespace internal
+{
+//======================================================================================//
+
+using timer_error_handler_t = std::function<void(uint64_t, std::exception_ptr)>;
+
+/// \brief task created for each expiration of a timer. An exception thrown by the
+/// function is passed to the error handler of the wheel (with the id of the timer)
+/// or, without a handler, propagates to the caller
+class timer_task : public VTask
+{
+public:
+    using handler_pointer = std::shared_ptr<const timer_error_handler_t>;
+
+    timer_task(void_func_t&& _func, uint64_t _id, handler_pointer _handler)
+    : VTask{ true, 0 }
+    , m_id{ _id }
+    , m_handler{ std::move(_handler) }
+    {
+        m_func = std::move(_func);
+    }
+
+    void operator()() override;
+
+private:
+    uint64_t        m_id      = 0;
+    handler_pointer m_handler = {};
+};
+
+}  // namespace internal
+
+//======================================================================================//
+
+/// \brief TimerWheel stores timers in four levels of slots (256 x 64 x 64 x 64 ticks)
+/// plus an overflow list. Scheduling and cancelling are O(1) and expiring a tick
+/// only touches the slots for that tick, so a large number of pending timers does
+/// not add to the per-tick cost. Timers in higher levels are cascaded down as the
+/// wheel turns. The tick resolution defaults to PTL_TIMER_RESOLUTION_US (1000 us).
+class TimerWheel
+{
+public:
+    using clock_type    = std::chrono::steady_clock;
+    using time_point    = clock_type::time_point;
+    using duration      = clock_type::duration;
+    using function_type = std::function<void()>;
+    using task_pointer  = std::shared_ptr<VTask>;
+    using task_list_t   = std::vector<task_pointer>;
+    using timer_id      = uint64_t;
+    using error_handler = internal::timer_error_handler_t;
+    using tick_type     = uint64_t;
+    using size_type     = size_t;
+
+    static constexpr size_t num_levels  = 4;
+    static constexpr size_t root_bits   = 8;
+    static constexpr size_t level_bits  = 6;
+    static constexpr size_t root_slots  = (1 << root_bits);
+    static constexpr size_t level_slots = (1 << level_bits);
+
+public:
+    explicit TimerWheel(duration _resolution = default_resolution());
+    ~TimerWheel();
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel(TimerWheel&&)      = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+    TimerWheel& operator=(TimerWheel&&) = delete;
+
+public:
+    /// add a timer which expires at \param _when and, if \param _period is non-zero,
+    /// every period thereafter. Returns an id which can be passed to cancel()
+    timer_id schedule(time_point _when, duration _period, function_type&& _func);
+    /// remove a pending timer. Returns false if the timer already expired (one-shot)
+    /// or was never scheduled. An expiration already handed out still runs
+    bool cancel(timer_id);
+    /// expire all the timers up to \param _now and append their tasks to the list.
+    /// Returns zero without blocking if another thread is advancing the wheel
+    size_type advance(time_point _now, task_list_t&);
+    /// invoked with the id of the timer and the exception when the function of a
+    /// timer throws (applies to the expirations handed out afterwards). Without a
+    /// handler the exception propagates out of the task
+    void set_error_handler(error_handler);
+
+    /// number of pending timers
+    size_type size() const { return m_size.load(std::memory_order_relaxed); }
+    bool      empty() const { return (size() == 0); }
+    /// whether advance() will expire (or cascade) anything at \param _now
+    bool due(time_point _now) const;
+    /// the earliest time at which advance() has work, time_point::max() if empty
+    time_point next_deadline() const;
+    duration   resolution() const { return m_resolution; }
+
+    static duration default_resolution();
+
+private:
+    struct entry
+    {
+        timer_id                       id        = 0;
+        tick_type                      expiry    = 0;
+        tick_type                      period    = 0;
+        bool                           cancelled = false;
+        std::shared_ptr<function_type> func      = {};
+    };
+
+    using slot_type = std::vector<entry*>;
+
+    tick_type to_tick(time_point, bool _round_up) const;
+    tick_type place(entry*);
+    void      cascade(size_t _level);
+    void      expire(task_list_t&);
+    void      purge();
+    tick_type compute_next() const;
+
+private:
+    duration                                       m_resolution;
+    time_point                                     m_origin     = clock_type::now();
+    tick_type                                      m_current    = 0;
+    std::atomic<tick_type>                         m_next       = { ~tick_type{ 0 } };
+    std::atomic<size_type>                         m_size       = { 0 };
+    std::atomic<timer_id>                          m_counter    = { 0 };
+    Mutex                                          m_mutex      = {};
+    std::array<std::vector<slot_type>, num_levels> m_levels     = {};
+    slot_type                                      m_overflow   = {};
+    std::unordered_map<timer_id, entry*>           m_entries    = {};
+    std::shared_ptr<const error_handler>           m_on_error   = {};
+};
+
+//--------------------------------------------------------------------------------------//
+
+inline bool
+TimerWheel::due(time_point _now) const
+{
+    return !empty() && to_tick(_now, false) >= m_next.load(std::memory_order_acquire);
+}
+
+//--------------------------------------------------------------------------------------//
+
+inline TimerWheel::time_point
+TimerWheel::next_deadline() const
+{
+    auto _next = m_next.load();
+    if(empty() || _next == ~tick_type{ 0 })
+        return time_point::max();
+    return m_origin + _next * m_resolution;
+}
+
+//--------------------------------------------------------------------------------------//
+
+inline TimerWheel::tick_type
+TimerWheel::to_tick(time_point _t, bool _round_up) const
+{
+    if(_t <= m_origin)
+        return 0;
+    auto _d = (_t - m_origin).count();
+    auto _r = m_resolution.count();
+    return static_cast<tick_type>((_round_up) ? ((_d + _r - 1) / _r) : (_d / _r));
+}
+
+//======================================================================================//
+
+}  // namespace PTL
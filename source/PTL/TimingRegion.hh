@@ -0,0 +1,204 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ---------------------------------------------------------------
+// Tasking class header file
+//
+// Class Description:
+//
+// This file provides a low-overhead clock (TSC where available) and scoped
+// timing regions which accumulate into per-thread tables that are merged
+// when reported
+//
+// ---------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <limits>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#    include <intrin.h>
+#    define PTL_CYCLE_CLOCK_USE_TSC
+#elif defined(__x86_64__) || defined(__i386__)
+#    define PTL_CYCLE_CLOCK_USE_TSC
+#elif defined(__linux__)
+#    include <time.h>
+#    define PTL_CYCLE_CLOCK_USE_MONOTONIC_RAW
+#endif
+
+//--------------------------------------------------------------------------------------//
+// times the rest of the enclosing scope as the region NAME (a string literal)
+//
+#define PTL_TIMING_REGION_JOIN_(A, B) A##B
+#define PTL_TIMING_REGION_JOIN(A, B) PTL_TIMING_REGION_JOIN_(A, B)
+#define PTL_TIMING_REGION(NAME)                                                          \
+    ::PTL::TimingRegion PTL_TIMING_REGION_JOIN(_ptl_timing_region_, __LINE__) { NAME }
+
+namespace PTL
+{
+//======================================================================================//
+
+/// \brief CycleClock reads the time stamp counter on x86 (no system call, tens of
+/// cycles), CLOCK_MONOTONIC_RAW on other Linux targets and the steady clock
+/// elsewhere. The ticks are converted to seconds with a rate which is calibrated
+/// against the steady clock once (at least 10 ms after the library is loaded).
+/// The TSC is assumed to be invariant, as on all current x86 processors
+struct CycleClock
+{
+    static uint64_t now()
+    {
+#if defined(PTL_CYCLE_CLOCK_USE_TSC) && defined(_MSC_VER)
+        return __rdtsc();
+#elif defined(PTL_CYCLE_CLOCK_USE_TSC)
+        return __builtin_ia32_rdtsc();
+#elif defined(PTL_CYCLE_CLOCK_USE_MONOTONIC_RAW)
+        timespec _ts{};
+        clock_gettime(CLOCK_MONOTONIC_RAW, &_ts);
+        return static_cast<uint64_t>(_ts.tv_sec) * 1000000000ULL +
+               static_cast<uint64_t>(_ts.tv_nsec);
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+#endif
+    }
+
+    // the source of the ticks: "tsc", "clock_monotonic_raw" or "steady_clock"
+    static const char* source();
+    static double      ticks_per_second();
+    static double      seconds(uint64_t _ticks)
+    {
+        return static_cast<double>(_ticks) / ticks_per_second();
+    }
+};
+
+//======================================================================================//
+
+/// \brief TimingResult is the time of a region merged over the threads
+struct TimingResult
+{
+    std::string name    = {};
+    uint64_t    count   = 0;
+    size_t      threads = 0;  // number of threads which entered the region
+    double      total   = 0.0;  // seconds
+    double      min     = 0.0;
+    double      max     = 0.0;
+
+    double mean() const { return (count > 0) ? (total / count) : 0.0; }
+};
+
+//======================================================================================//
+
+namespace internal
+{
+// the accumulated ticks of a region in the table of a thread. Only the owning
+// thread updates it (a relaxed load and store, no read-modify-write)
+struct timing_entry
+{
+    const char*           name = nullptr;
+    std::atomic<uint64_t> count{ 0 };
+    std::atomic<uint64_t> ticks{ 0 };
+    std::atomic<uint64_t> min{ std::numeric_limits<uint64_t>::max() };
+    std::atomic<uint64_t> max{ 0 };
+
+    void add(uint64_t _ticks)
+    {
+        constexpr auto _relaxed = std::memory_order_relaxed;
+        count.store(count.load(_relaxed) + 1, _relaxed);
+        ticks.store(ticks.load(_relaxed) + _ticks, _relaxed);
+        if(_ticks < min.load(_relaxed))
+            min.store(_ticks, _relaxed);
+        if(_ticks > max.load(_relaxed))
+            max.store(_ticks, _relaxed);
+    }
+};
+}  // namespace internal
+
+//======================================================================================//
+
+/// \brief TimingRegion times its lifetime (or until stop()) with the CycleClock and
+/// adds it to the region of the name in the table of the calling thread. The regions
+/// are identified by the address of the name, so the names should be string literals,
+/// and the entry of a region is allocated the first time a thread enters it. The
+/// tables are merged by name when the results are requested, and the table of a
+/// thread which exits is merged into the results and released. The reporters format
+/// the results: as a table, or in the format of Timer (Real=...s)
+class TimingRegion
+{
+public:
+    using result_list_t = std::vector<TimingResult>;
+    using reporter_type = std::function<void(std::ostream&, const result_list_t&)>;
+
+public:
+    explicit TimingRegion(const char* _name)
+    : m_entry{ get_entry(_name) }
+    , m_start{ CycleClock::now() }
+    {}
+
+    ~TimingRegion() { stop(); }
+
+    TimingRegion(const TimingRegion&) = delete;
+    TimingRegion& operator=(const TimingRegion&) = delete;
+
+    // ends the timing before the end of the scope
+    void stop()
+    {
+        if(!m_entry)
+            return;
+        m_entry->add(CycleClock::now() - m_start);
+        m_entry = nullptr;
+    }
+
+public:
+    // adds ticks of the CycleClock measured elsewhere to the region
+    static void record(const char* _name, uint64_t _ticks)
+    {
+        get_entry(_name)->add(_ticks);
+    }
+
+    // the regions merged over the threads in the order of decreasing total time
+    static result_list_t get_results();
+    // discards the times recorded so far (regions which are timing at the time may
+    // be partially kept)
+    static void reset();
+
+    static void report(std::ostream&);
+    static void report(std::ostream&, const reporter_type&);
+
+    static reporter_type table_reporter();
+    static reporter_type timer_reporter();
+
+private:
+    static internal::timing_entry* get_entry(const char*);
+
+private:
+    internal::timing_entry* m_entry = nullptr;
+    uint64_t                m_start = 0;
+};
+
+//======================================================================================//
+
+}  // namespace PTL
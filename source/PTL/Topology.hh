@@ -0,0 +1,145 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//
+// ---------------------------------------------------------------
+// Tasking class header file
+//
+// Class Description:
+//
+// This file provides the CPU topology of the machine (sockets, cores, SMT
+// siblings, NUMA nodes and shared caches) read from sysfs and the placement
+// policies used to pin the threads of a ThreadPool
+//
+// ---------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace PTL
+{
+namespace cpu_placement
+{
+static const short NONE             = 0;  // use the affinity function of the pool
+static const short COMPACT          = 1;  // fill SMT siblings, then cores, then sockets
+static const short SCATTER          = 2;  // spread over sockets, then cores, then SMT
+static const short PHYSICAL_CORES   = 3;  // one thread per physical core
+static const short NUMA_ROUND_ROBIN = 4;  // alternate between NUMA nodes
+
+}  // namespace cpu_placement
+
+//======================================================================================//
+
+/// \brief Topology describes the CPUs the process is allowed to run on. On Linux it
+/// is read from /sys/devices/system/{cpu,node}, elsewhere (or if sysfs is missing)
+/// every CPU is treated as a separate core of a single socket and NUMA node.
+class Topology
+{
+public:
+    using size_type  = size_t;
+    using cpu_list_t = std::vector<int>;
+
+    struct Cpu
+    {
+        int cpu    = -1;  // logical CPU number
+        int core   = -1;  // index of the physical core in the topology
+        int socket = 0;   // physical package id
+        int node   = 0;   // NUMA node
+        int smt    = 0;   // index among the SMT siblings of the core
+    };
+
+    struct Cache
+    {
+        int         level = 0;
+        std::string type  = {};  // Data, Instruction or Unified
+        size_type   size  = 0;   // in bytes
+        cpu_list_t  cpus  = {};  // CPUs sharing the cache
+    };
+
+public:
+    Topology() = default;
+
+    /// the topology of this machine restricted to the affinity mask of the process,
+    /// discovered once (below PTL_SYSFS_ROOT instead of /sys/devices/system if set)
+    static const Topology& instance();
+
+    /// read the topology below the sysfs root (the directory containing the cpu and
+    /// node directories). If _allowed is not empty, only those CPUs are included.
+    /// Pointing the root at a fake sysfs tree allows testing any topology
+    static Topology discover(const std::string& _root    = "/sys/devices/system",
+                             const cpu_list_t&  _allowed = {});
+
+    /// the CPUs in the affinity mask of the process (of its main thread), which does
+    /// not depend on the calling thread being pinned
+    static cpu_list_t allowed_cpus();
+
+    /// parse a sysfs CPU list, e.g. "0-3,8,10-11"
+    static cpu_list_t parse_cpu_list(const std::string&);
+
+    /// parse a sysfs cache size, e.g. "32K"
+    static size_type parse_size(const std::string&);
+
+public:
+    const std::vector<Cpu>&   cpus() const { return m_cpus; }
+    const std::vector<Cache>& caches() const { return m_caches; }
+
+    size_type num_cpus() const { return m_cpus.size(); }
+    size_type num_cores() const { return m_num_cores; }
+    size_type num_sockets() const { return m_num_sockets; }
+    size_type num_nodes() const { return m_nodes.size(); }
+
+    /// the IDs of the NUMA nodes of the CPUs, in ascending order. The IDs are not
+    /// contiguous when the process is restricted to some of the nodes
+    const std::vector<int>& nodes() const { return m_nodes; }
+
+    /// the NUMA node of a logical CPU (zero if unknown)
+    int node_of(int _cpu) const;
+    /// the NUMA node of the CPU the calling thread is currently running on, or the
+    /// node set by set_current_node
+    int current_node() const;
+    /// fix the node returned by current_node for the calling thread, e.g. for a
+    /// thread bound to the CPUs of one node (-1 looks up the CPU again)
+    static void set_current_node(int _node) { thread_node() = _node; }
+    /// the CPUs of a NUMA node
+    cpu_list_t node_cpus(int _node) const;
+
+    /// the order in which threads are assigned to CPUs by a cpu_placement policy.
+    /// Thread i is pinned to element i modulo the size of the list
+    cpu_list_t placement(short _policy) const;
+
+    /// affinity function (thread index -> CPU) for a cpu_placement policy
+    std::function<intmax_t(intmax_t)> placement_functor(short _policy) const;
+
+private:
+    static int& thread_node();
+
+private:
+    size_type          m_num_cores   = 0;
+    size_type          m_num_sockets = 0;
+    std::vector<Cpu>   m_cpus        = {};
+    std::vector<Cache> m_caches      = {};
+    std::vector<int>   m_nodes       = {};
+    std::vector<int>   m_cpu_nodes   = {};  // indexed by logical CPU
+};
+
+}  // namespace PTL
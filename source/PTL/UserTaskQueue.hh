@@ -28,6 +28,7 @@
 #include "PTL/Globals.hh"
 #include "PTL/TaskSubQueue.hh"
 #include "PTL/Threading.hh"
+#include "PTL/Topology.hh"
 #include "PTL/VTask.hh"
 #include "PTL/VUserTaskQueue.hh"
 
@@ -60,6 +61,10 @@ public:
     // Virtual function for inserting a task into the queue
     intmax_t InsertTask(task_pointer&&, ThreadData* = nullptr,
                         intmax_t subq = -1) override PTL_NO_SANITIZE_THREAD;
+    // inserting a batch of tasks claims each bin once
+    size_type InsertTasks(task_list_t&&) override;
+    // takes the oldest task of a bin for the worker of a linked pool
+    task_pointer StealTask() override;
 
     // if executing only tasks in threads bin
     task_pointer GetThreadBinTask();
@@ -87,26 +92,65 @@ public:
     intmax_t GetThreadBin() const override;
 
 protected:
-    intmax_t GetInsertBin() const;
+    // the number of bins must be loaded before the bins: the container published
+    // with a number of workers holds at least that many bins (plus one)
+    intmax_t               GetNumBins() const;
+    TaskSubQueueContainer& GetSubQueues() const;
+    intmax_t               GetInsertBin() const;
+    // first bin at or after _n owned by a worker on the NUMA node (_n if none)
+    intmax_t GetNodeBin(int _node, intmax_t _n) const;
+    // NUMA node of the calling thread
+    int CurrentNode() const;
 
 private:
-    void AcquireHold();
-    void ReleaseHold();
+    // push a task which is already counted into the first bin at or after _n which
+    // can be claimed, trying the bins of the NUMA node first (if _node >= 0)
+    intmax_t InsertIntoBin(task_pointer&&, intmax_t _n, int _node);
+    // push tasks which are already counted into the bins, the tasks with a NUMA hint
+    // go to the bins of their node
+    void DistributeTasks(task_list_t&);
 
 private:
-    bool                       m_is_clone;
-    intmax_t                   m_thread_bin;
-    mutable intmax_t           m_insert_bin;
-    std::atomic_bool*          m_hold      = nullptr;
-    std::atomic_uintmax_t*     m_ntasks    = nullptr;
-    Mutex*                     m_mutex     = nullptr;
-    TaskSubQueueContainer*     m_subqueues = nullptr;
-    std::vector<int>           m_rand_list = {};
-    std::vector<int>::iterator m_rand_itr  = {};
+    bool                          m_is_clone;
+    bool                          m_numa;
+    intmax_t                      m_thread_bin;
+    mutable std::atomic<intmax_t> m_insert_bin;
+    std::atomic_uintmax_t*        m_ntasks    = nullptr;
+    Mutex*                        m_mutex     = nullptr;
+    std::vector<int>              m_rand_list = {};
+    std::vector<int>::iterator    m_rand_itr  = {};
+    // replaced by resize() while the workers index the bins
+    std::atomic<TaskSubQueueContainer*> m_subqueues{ nullptr };
+    // containers replaced by resize() which other threads may still be indexing
+    std::vector<TaskSubQueueContainer*> m_retired_subqueues = {};
 };
 
 //======================================================================================//
 
+inline intmax_t
+UserTaskQueue::GetNumBins() const
+{
+    return m_workers.load(std::memory_order_acquire) + 1;
+}
+
+//======================================================================================//
+
+inline UserTaskQueue::TaskSubQueueContainer&
+UserTaskQueue::GetSubQueues() const
+{
+    return *m_subqueues.load(std::memory_order_acquire);
+}
+
+//======================================================================================//
+
+inline int
+UserTaskQueue::CurrentNode() const
+{
+    return Topology::instance().current_node();
+}
+
+//======================================================================================//
+
 inline bool
 UserTaskQueue::empty() const
 {
@@ -126,7 +170,7 @@ UserTaskQueue::size() const
 inline UserTaskQueue::size_type
 UserTaskQueue::bin_size(size_type bin) const
 {
-    return (*m_subqueues)[bin]->size();
+    return GetSubQueues()[bin]->size();
 }
 
 //======================================================================================//
@@ -134,7 +178,7 @@ UserTaskQueue::bin_size(size_type bin) const
 inline bool
 UserTaskQueue::bin_empty(size_type bin) const
 {
-    return (*m_subqueues)[bin]->empty();
+    return GetSubQueues()[bin]->empty();
 }
 
 //======================================================================================//
@@ -142,7 +186,7 @@ UserTaskQueue::bin_empty(size_type bin) const
 inline bool
 UserTaskQueue::true_empty() const
 {
-    for(const auto& itr : *m_subqueues)
+    for(const auto& itr : GetSubQueues())
         if(!itr->empty())
             return false;
     return true;
@@ -154,7 +198,7 @@ inline UserTaskQueue::size_type
 UserTaskQueue::true_size() const
 {
     size_type _n = 0;
-    for(const auto& itr : *m_subqueues)
+    for(const auto& itr : GetSubQueues())
         _n += itr->size();
     return _n;
 }
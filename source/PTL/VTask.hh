@@ -29,6 +29,9 @@
 
 #pragma once
 
+#include "PTL/TaskHooks.hh"
+#include "PTL/TaskLabel.hh"
+
 #include <cstddef>
 #include <cstdint>
 #include <functional>
@@ -50,9 +53,11 @@ public:
     VTask(bool _is_native, intmax_t _depth)
     : m_is_native{ _is_native }
     , m_depth{ _depth }
-    {}
+    {
+        TaskHooks::notify(TaskHooks::create, this);
+    }
 
-    VTask()          = default;
+    VTask() { TaskHooks::notify(TaskHooks::create, this); }
     virtual ~VTask() = default;
 
     VTask(const VTask&) = delete;
@@ -69,10 +74,33 @@ public:
     bool     is_native_task() const { return m_is_native; }
     intmax_t depth() const { return m_depth; }
 
+    // NUMA node the task should preferably be queued on (-1 for any)
+    int  numa_node() const { return m_numa_node; }
+    void set_numa_node(int _node) { m_numa_node = _node; }
+
+    // a pool-bound task is only executed by the threads of the pool it was submitted
+    // to, i.e. never by the workers of a linked pool (see ThreadPool::link_pool)
+    bool is_pool_bound() const { return m_pool_bound; }
+    void set_pool_bound(bool _v) { m_pool_bound = _v; }
+
+    // time (TaskLatency::now) the task was first submitted to a queue, zero if the
+    // latency is not recorded
+    int64_t submit_time() const { return m_submit_time; }
+    void    set_submit_time(int64_t _v) { m_submit_time = _v; }
+
+    // label of the task for the statistics, the traces and the hooks. Defaults to the
+    // TaskLabel::Scope of the thread which creates the task
+    const TaskLabel* label() const { return m_label; }
+    void             set_label(const TaskLabel* _label) { m_label = _label; }
+
 protected:
-    bool        m_is_native = false;
-    intmax_t    m_depth     = 0;
-    void_func_t m_func      = []() {};
+    bool             m_is_native   = false;
+    bool             m_pool_bound  = false;
+    int              m_numa_node   = -1;
+    intmax_t         m_depth       = 0;
+    int64_t          m_submit_time = 0;
+    const TaskLabel* m_label       = TaskLabel::current();
+    void_func_t      m_func        = []() {};
 };
 
 //======================================================================================//
@@ -35,6 +35,7 @@
 #include <functional>
 #include <memory>
 #include <set>
+#include <vector>
 
 namespace PTL
 {
@@ -50,6 +51,7 @@ public:
     using size_type     = uintmax_t;
     using function_type = std::function<void()>;
     using ThreadIdSet   = std::set<ThreadId>;
+    using task_list_t   = std::vector<task_pointer>;
 
 public:
     // Constructor - accepting the number of workers
@@ -76,6 +78,21 @@ public:
     virtual intmax_t InsertTask(task_pointer&&, ThreadData* = nullptr,
                                 intmax_t subq = -1) PTL_NO_SANITIZE_THREAD = 0;
 
+    // Virtual function for inserting a batch of tasks into the queue. The default
+    // inserts them one at a time, overload to distribute them more cheaply
+    // parameters:
+    //      1. list of tasks to insert (emptied)
+    // return:
+    //      size_type - number of tasks inserted
+    virtual size_type InsertTasks(task_list_t&&);
+
+    // Virtual function for taking a task on behalf of the worker of another (linked)
+    // thread-pool. Pool-bound tasks must not be returned. The default does not
+    // share tasks
+    // returns:
+    //      VTask* - a task or nullptr
+    virtual task_pointer StealTask() { return nullptr; }
+
     // Overload this function to hold threads
     virtual void     Wait()               = 0;
     virtual intmax_t GetThreadBin() const = 0;
@@ -99,12 +116,13 @@ public:
     virtual void ExecuteOnSpecificThreads(ThreadIdSet tid_set, ThreadPool* tp,
                                           function_type f) = 0;
 
-    intmax_t workers() const { return m_workers; }
+    intmax_t workers() const { return m_workers.load(std::memory_order_acquire); }
 
     virtual VUserTaskQueue* clone() = 0;
 
 protected:
-    intmax_t m_workers = 0;
+    // changed by resize() while the workers use the queue
+    AtomicInt m_workers{ 0 };
 };
 
 }  // namespace PTL
@@ -0,0 +1,274 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//
+// ---------------------------------------------------------------
+//  Tasking class implementation
+//
+// Class Description:
+//
+// This file implements the execution of a parallel_pipeline
+//
+// ---------------------------------------------------------------
+
+#include "PTL/ParallelPipeline.hh"
+
+#include "PTL/TaskGroup.hh"
+#include "PTL/ThreadPool.hh"
+
+#include <algorithm>
+
+//======================================================================================//
+
+namespace PTL
+{
+namespace internal
+{
+//======================================================================================//
+
+pipeline::pipeline(size_t _max_tokens, const stage_list& _stages)
+: m_max_tokens{ std::max<size_t>(_max_tokens, 1) }
+, m_stages{ _stages }
+{
+    m_serial.reserve(m_stages.size());
+    for(const auto& itr : m_stages)
+    {
+        if(itr.mode == filter_mode::parallel)
+            m_serial.emplace_back(nullptr);
+        else
+            m_serial.emplace_back(new serial_state{});
+    }
+}
+
+//======================================================================================//
+
+void
+pipeline::run()
+{
+    token _token{};
+    while(next(_token))
+        process(_token);
+}
+
+//======================================================================================//
+
+void
+pipeline::rethrow() const
+{
+    if(m_exception)
+        std::rethrow_exception(m_exception);
+}
+
+//======================================================================================//
+// acquires the next token for this runner: a parked token which has become ready or a
+// new token from the input filter. Returns false when there is nothing left to do
+//
+bool
+pipeline::next(token& _token)
+{
+    AutoLock _lk{ m_lock };
+    while(true)
+    {
+        if(m_cancelled.load(std::memory_order_relaxed))
+            return false;
+
+        if(!m_ready.empty())
+        {
+            _token = std::move(m_ready.front());
+            m_ready.pop_front();
+            return true;
+        }
+
+        if(!m_input_done && !m_input_busy && m_in_flight < m_max_tokens)
+        {
+            // the input filter is serial: only one runner reads at a time
+            m_input_busy = true;
+            ++m_in_flight;
+            _lk.unlock();
+
+            flow_control _fc{};
+            item_type    _item{};
+            try
+            {
+                _item = m_stages.front().func(item_type{}, _fc);
+            } catch(...)
+            {
+                cancel();
+                _fc.stop();
+            }
+
+            _lk.lock();
+            m_input_busy = false;
+            if(_fc.is_stopped())
+            {
+                m_input_done = true;
+                --m_in_flight;
+                m_cond.notify_all();
+                continue;
+            }
+
+            _token         = token{};
+            _token.seq     = m_next_seq++;
+            _token.stage   = 1;
+            _token.item    = std::move(_item);
+            // another runner may read the next input
+            m_cond.notify_one();
+            return true;
+        }
+
+        if(m_input_done && m_in_flight == 0)
+            return false;
+
+        m_cond.wait(_lk);
+    }
+}
+
+//======================================================================================//
+// carries the token through the remaining stages until it either completes or is
+// parked at a serial stage
+//
+void
+pipeline::process(token& _token)
+{
+    for(; _token.stage < m_stages.size(); ++_token.stage)
+    {
+        if(m_cancelled.load(std::memory_order_relaxed))
+            return;
+
+        const auto& _stage  = m_stages.at(_token.stage);
+        auto*       _serial = m_serial.at(_token.stage).get();
+        bool        _order  = (_stage.mode == filter_mode::serial_in_order);
+
+        if(_serial && !_token.claimed)
+        {
+            AutoLock _lk{ _serial->lock };
+            if(_serial->busy || (_order && _token.seq != _serial->next_seq))
+            {
+                if(_order)
+                    _serial->in_order.emplace(_token.seq, std::move(_token));
+                else
+                    _serial->out_of_order.emplace_back(std::move(_token));
+                return;
+            }
+            _serial->busy = true;
+        }
+        _token.claimed = false;
+
+        try
+        {
+            flow_control _fc{};
+            _token.item = _stage.func(std::move(_token.item), _fc);
+        } catch(...)
+        {
+            cancel();
+            return;
+        }
+
+        if(_serial)
+        {
+            token _resume{};
+            bool  _found = false;
+            {
+                AutoLock _lk{ _serial->lock };
+                _serial->busy = false;
+                if(_order)
+                {
+                    ++_serial->next_seq;
+                    auto itr = _serial->in_order.find(_serial->next_seq);
+                    if(itr != _serial->in_order.end())
+                    {
+                        _resume = std::move(itr->second);
+                        _serial->in_order.erase(itr);
+                        _found = true;
+                    }
+                }
+                else if(!_serial->out_of_order.empty())
+                {
+                    _resume = std::move(_serial->out_of_order.front());
+                    _serial->out_of_order.pop_front();
+                    _found = true;
+                }
+                if(_found)
+                    _serial->busy = true;
+            }
+
+            if(_found)
+            {
+                _resume.claimed = true;
+                AutoLock _lk{ m_lock };
+                m_ready.emplace_back(std::move(_resume));
+                m_cond.notify_one();
+            }
+        }
+    }
+
+    finish();
+}
+
+//======================================================================================//
+
+void
+pipeline::finish()
+{
+    AutoLock _lk{ m_lock };
+    --m_in_flight;
+    if(m_input_done && m_in_flight == 0)
+        m_cond.notify_all();
+    else
+        m_cond.notify_one();
+}
+
+//======================================================================================//
+// records the exception being handled and stops all of the runners. The parked tokens
+// are discarded when the pipeline is destroyed
+//
+void
+pipeline::cancel()
+{
+    AutoLock _lk{ m_lock };
+    if(!m_exception)
+        m_exception = std::current_exception();
+    m_cancelled.store(true);
+    m_cond.notify_all();
+}
+
+//======================================================================================//
+
+void
+run_pipeline(size_t _max_tokens, const pipeline_stage_list_t& _stages, ThreadPool* _tp)
+{
+    if(_stages.empty())
+        return;
+
+    pipeline _pipeline{ _max_tokens, _stages };
+
+    // no more runners than the tokens which can be in flight
+    size_t _nrunners = (_tp) ? (_tp->size() + 1) : 1;
+    _nrunners        = std::min(_nrunners, std::max<size_t>(_max_tokens, 1));
+
+    TaskGroup<void> _tg{ _tp };
+    for(size_t i = 1; i < _nrunners; ++i)
+        _tg.exec([&_pipeline]() { _pipeline.run(); });
+    _pipeline.run();
+    _tg.join();
+
+    _pipeline.rethrow();
+}
+
+}  // namespace internal
+}  // namespace PTL
@@ -0,0 +1,153 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//
+// ---------------------------------------------------------------
+//  Tasking class implementation
+//
+// Class Description:
+//
+// This file implements the native task arenas of a ThreadPool
+//
+// ---------------------------------------------------------------
+
+#include "PTL/TaskArena.hh"
+
+#include "PTL/ThreadData.hh"
+
+#include <algorithm>
+
+//======================================================================================//
+
+namespace PTL
+{
+//======================================================================================//
+
+TaskArena*&
+TaskArena::current()
+{
+    static thread_local TaskArena* _instance = nullptr;
+    return _instance;
+}
+
+//======================================================================================//
+
+TaskArena::TaskArena(ThreadPool* _tp, size_type _max_concurrency, size_type _weight)
+: m_pool{ _tp }
+, m_lock{ (_tp && !_tp->is_tbb_threadpool()) ? _tp->m_arena_lock : nullptr }
+, m_max_concurrency{ _max_concurrency }
+, m_weight{ std::max<size_type>(_weight, 1) }
+, m_queue{ new queue_type{
+      static_cast<intmax_t>(std::max<size_type>((_tp) ? _tp->size() : 0, 1)) } }
+{
+    if(m_lock)
+        _tp->register_arena(this);
+}
+
+//======================================================================================//
+
+TaskArena::~TaskArena()
+{
+    // the pool detaches its arenas under the same lock before it is deleted
+    if(m_lock)
+    {
+        AutoLock _lk(*m_lock);
+        auto*    _pool = m_pool.exchange(nullptr);
+        if(_pool)
+            _pool->unregister_arena(this);
+    }
+
+    // a worker may still be executing a task of the arena. Once unregistered no worker
+    // starts one so the last worker to finish signals the destructor
+    if(m_active.fetch_or(closing_bit) != 0)
+    {
+        AutoLock _lk(m_release_mutex);
+        m_release_cond.wait(_lk, [this]() { return m_released; });
+    }
+
+    // execute the remaining tasks so that the task groups waiting on them complete
+    execute([this]() {
+        while(!m_queue->empty())
+        {
+            auto _task = m_queue->GetTask();
+            if(_task)
+                (*_task)();
+        }
+    });
+
+    delete m_queue;
+}
+
+//======================================================================================//
+
+TaskArena::size_type
+TaskArena::add_task(task_pointer&& _task)
+{
+    auto* _pool = m_pool.load();
+
+    // the TBB backend isolates the tasks in the arena of the thread-pool
+    if(_pool && _pool->is_tbb_threadpool())
+        return _pool->add_task(std::move(_task));
+
+    // if the thread-pool is not running, just execute
+    if(!_pool || !_pool->is_alive() || !_task->is_native_task())
+    {
+        execute([&_task]() { (*_task)(); });
+        return 0;
+    }
+
+    // the thread data only applies to the threads of the pool
+    ThreadData* _data = ThreadData::GetInstance();
+    if(_data && _data->thread_pool != _pool)
+        _data = nullptr;
+
+    auto _bin = m_queue->InsertTask(std::move(_task), _data);
+    _pool->notify();
+    return static_cast<size_type>(_bin);
+}
+
+//======================================================================================//
+
+bool
+TaskArena::acquire()
+{
+    auto _n = m_active.load();
+    do
+    {
+        if(m_max_concurrency != 0 && _n >= m_max_concurrency)
+            return false;
+    } while(!m_active.compare_exchange_weak(_n, _n + 1));
+    return true;
+}
+
+//======================================================================================//
+
+void
+TaskArena::release()
+{
+    if(m_active.fetch_sub(1) == (closing_bit | 1))
+    {
+        AutoLock _lk(m_release_mutex);
+        m_released = true;
+        m_release_cond.notify_all();
+    }
+}
+
+//======================================================================================//
+
+}  // namespace PTL
@@ -0,0 +1,158 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ---------------------------------------------------------------
+//  Tasking class implementation
+//
+// Class Description:
+//
+// This file implements the registration and the dispatch of the callbacks
+// of the lifecycle events
+//
+// ---------------------------------------------------------------
+
+#include "PTL/TaskHooks.hh"
+
+#include "PTL/AutoLock.hh"
+#include "PTL/Threading.hh"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace PTL
+{
+namespace
+{
+struct hook_entry
+{
+    TaskHooks::handle_type   handle;
+    TaskHooks::mask_type     mask;
+    TaskHooks::callback_type func;
+};
+
+using hook_list_t = std::vector<hook_entry>;
+
+//--------------------------------------------------------------------------------------//
+// the list is replaced (never modified) on registration so the dispatch only holds a
+// reference to the list while invoking the callbacks
+//
+struct hook_state
+{
+    Mutex                              mutex{};
+    TaskHooks::handle_type             next = 1;
+    std::shared_ptr<const hook_list_t> list = std::make_shared<hook_list_t>();
+};
+
+hook_state&
+state()
+{
+    // leaked so the hooks remain valid for the threads which outlive the statics
+    static auto* _v = new hook_state{};
+    return *_v;
+}
+
+TaskHooks::mask_type
+combined_mask(const hook_list_t& _list)
+{
+    TaskHooks::mask_type _v = 0;
+    for(const auto& itr : _list)
+        _v |= itr.mask;
+    return _v;
+}
+}  // namespace
+
+//======================================================================================//
+
+std::atomic<TaskHooks::mask_type> TaskHooks::f_mask{ 0 };
+
+//======================================================================================//
+
+TaskHooks::handle_type
+TaskHooks::add(callback_type _func, mask_type _mask)
+{
+#if defined(PTL_USE_TASK_HOOKS)
+    _mask &= all_events;
+    if(!_func || _mask == 0)
+        return 0;
+
+    auto&    _state = state();
+    AutoLock _lk(_state.mutex);
+    auto     _list   = std::make_shared<hook_list_t>(*_state.list);
+    auto     _handle = _state.next++;
+    _list->emplace_back(hook_entry{ _handle, _mask, std::move(_func) });
+    std::atomic_store(&_state.list, std::shared_ptr<const hook_list_t>{ _list });
+    f_mask.store(combined_mask(*_list), std::memory_order_release);
+    return _handle;
+#else
+    (void) _func;
+    (void) _mask;
+    return 0;
+#endif
+}
+
+//======================================================================================//
+
+bool
+TaskHooks::remove(handle_type _handle)
+{
+    auto&    _state = state();
+    AutoLock _lk(_state.mutex);
+    auto     _list = std::make_shared<hook_list_t>();
+    _list->reserve(_state.list->size());
+    for(const auto& itr : *_state.list)
+    {
+        if(itr.handle != _handle)
+            _list->emplace_back(itr);
+    }
+    if(_list->size() == _state.list->size())
+        return false;
+    f_mask.store(combined_mask(*_list), std::memory_order_release);
+    std::atomic_store(&_state.list, std::shared_ptr<const hook_list_t>{ _list });
+    return true;
+}
+
+//======================================================================================//
+
+void
+TaskHooks::clear()
+{
+    auto&    _state = state();
+    AutoLock _lk(_state.mutex);
+    f_mask.store(0, std::memory_order_release);
+    std::shared_ptr<const hook_list_t> _list = std::make_shared<hook_list_t>();
+    std::atomic_store(&_state.list, _list);
+}
+
+//======================================================================================//
+
+void
+TaskHooks::dispatch(event_type _type, const void* _obj)
+{
+    auto _list = std::atomic_load(&state().list);
+    auto _mask = mask(_type);
+    for(const auto& itr : *_list)
+    {
+        if((itr.mask & _mask) != 0)
+            itr.func(_type, _obj);
+    }
+}
+
+//======================================================================================//
+
+}  // namespace PTL
@@ -0,0 +1,94 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ---------------------------------------------------------------
+//  Tasking class implementation
+//
+// Class Description:
+//
+// This file implements the interning of the task labels
+//
+// ---------------------------------------------------------------
+
+#include "PTL/TaskLabel.hh"
+
+#include "PTL/AutoLock.hh"
+#include "PTL/Threading.hh"
+
+#include <deque>
+#include <map>
+#include <tuple>
+#include <utility>
+
+namespace PTL
+{
+namespace
+{
+using label_key_t = std::tuple<std::string, std::string, int>;
+
+//--------------------------------------------------------------------------------------//
+// the interned strings and labels: a deque never relocates its elements so the
+// pointers handed out remain valid
+//
+struct label_state
+{
+    Mutex                                   mutex{};
+    std::deque<std::string>                 strings{};
+    std::deque<TaskLabel>                   labels{};
+    std::map<label_key_t, const TaskLabel*> index{};
+};
+
+label_state&
+state()
+{
+    // leaked so the labels remain valid for the tasks which outlive the statics
+    static auto* _v = new label_state{};
+    return *_v;
+}
+}  // namespace
+
+//======================================================================================//
+
+const TaskLabel*
+TaskLabel::intern(const std::string& _name, const char* _file, int _line)
+{
+    auto&       _state = state();
+    label_key_t _key{ _name, (_file) ? _file : "", _line };
+
+    AutoLock _lk(_state.mutex);
+    auto     itr = _state.index.find(_key);
+    if(itr != _state.index.end())
+        return itr->second;
+
+    _state.strings.emplace_back(_name);
+    const char* _pname = _state.strings.back().c_str();
+    const char* _pfile = nullptr;
+    if(_file)
+    {
+        _state.strings.emplace_back(_file);
+        _pfile = _state.strings.back().c_str();
+    }
+    _state.labels.emplace_back(TaskLabel{ _pname, _pfile, _line });
+    auto* _label = &_state.labels.back();
+    _state.index.emplace(std::move(_key), _label);
+    return _label;
+}
+
+//======================================================================================//
+
+}  // namespace PTL
@@ -20,6 +20,7 @@
 //  Tasking class implementation
 #include "PTL/TaskRunManager.hh"
 
+#include "PTL/Concurrency.hh"
 #include "PTL/Config.hh"
 #include "PTL/TaskManager.hh"
 #include "PTL/ThreadPool.hh"
@@ -72,7 +73,7 @@ TaskRunManager::GetInstance(bool useTBB)
 //======================================================================================//
 
 TaskRunManager::TaskRunManager(bool useTBB)
-: m_workers(std::thread::hardware_concurrency())
+: m_workers(effective_concurrency())
 {
     if(!GetPrivateMasterRunManager())
         GetPrivateMasterRunManager() = this;
@@ -148,6 +149,12 @@ void
 TaskRunManager::Terminate()
 {
     m_is_initialized = false;
+    if(m_thread_pool && m_latency_summary && TaskLatency::enabled())
+    {
+        std::cout << "[PTL::TaskRunManager] task latency of " << m_thread_pool->size()
+                  << " workers:\n"
+                  << m_thread_pool->get_latency() << std::flush;
+    }
     if(m_thread_pool)
         m_thread_pool->destroy_threadpool();
     delete m_task_manager;
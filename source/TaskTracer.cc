@@ -0,0 +1,385 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ---------------------------------------------------------------
+//  Tasking class implementation
+//
+// Class Description:
+//
+// This file implements the tracer of the scheduling events and the Chrome
+// trace JSON output
+//
+// ---------------------------------------------------------------
+
+#include "PTL/TaskTracer.hh"
+
+#include "PTL/AutoLock.hh"
+#include "PTL/ThreadPool.hh"
+#include "PTL/TimingRegion.hh"
+#include "PTL/Utility.hh"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+//======================================================================================//
+
+namespace PTL
+{
+namespace
+{
+//--------------------------------------------------------------------------------------//
+// the events of a thread: the thread is the only writer and the number of recorded
+// events is published after each event. When the thread exits, the buffer (and its
+// events) is kept until another thread reuses it
+//
+struct trace_buffer
+{
+    trace_buffer(size_t _capacity, uintmax_t _tid)
+    : events(_capacity)
+    , mask(_capacity - 1)
+    , tid(_tid)
+    {}
+
+    std::vector<TaskTracer::event> events;
+    size_t                         mask = 0;
+    std::atomic<uintmax_t>         tid{ 0 };
+    std::atomic<uint64_t>          head{ 0 };
+    std::atomic<bool>              in_use{ true };
+};
+
+//--------------------------------------------------------------------------------------//
+
+size_t
+round_capacity(size_t _n)
+{
+    size_t _v = 1;
+    while(_v < _n)
+        _v <<= 1;
+    return _v;
+}
+
+//--------------------------------------------------------------------------------------//
+
+struct trace_state
+{
+    Mutex                  mutex{};
+    size_t                 capacity   = GetEnv<size_t>("PTL_TRACE_CAPACITY", 1 << 16);
+    std::string            output     = GetEnv<std::string>("PTL_TRACE_FILE", "");
+    uint64_t               since      = 0;  // events before clear() are skipped
+    uint64_t               origin_tsc = TaskTracer::timestamp();
+    std::vector<std::shared_ptr<trace_buffer>> buffers = {};
+};
+
+//--------------------------------------------------------------------------------------//
+// never deleted: the pools destroyed during the static destruction may write the output
+//
+trace_state&
+state()
+{
+    static auto* _instance = []() {
+        auto* _v     = new trace_state{};
+        _v->capacity = round_capacity(std::max<size_t>(_v->capacity, 1));
+        return _v;
+    }();
+    return *_instance;
+}
+
+//--------------------------------------------------------------------------------------//
+
+thread_local trace_buffer* tl_buffer = nullptr;
+
+// hands the buffer of the thread back when it exits
+struct trace_buffer_releaser
+{
+    ~trace_buffer_releaser()
+    {
+        if(tl_buffer)
+            tl_buffer->in_use.store(false, std::memory_order_release);
+        tl_buffer = nullptr;
+    }
+};
+
+//--------------------------------------------------------------------------------------//
+
+trace_buffer*
+this_buffer()
+{
+    if(!tl_buffer)
+    {
+        static thread_local trace_buffer_releaser _releaser{};
+
+        auto&    _state = state();
+        auto     _tid   = ThreadPool::get_this_thread_id();
+        AutoLock _lk(_state.mutex);
+        // the buffer of an exited thread is reused if it has the current capacity
+        for(const auto& itr : _state.buffers)
+        {
+            if(!itr->in_use.load(std::memory_order_acquire) &&
+               itr->events.size() == _state.capacity)
+            {
+                itr->in_use.store(true, std::memory_order_relaxed);
+                itr->tid.store(_tid, std::memory_order_relaxed);
+                itr->head.store(0, std::memory_order_release);
+                tl_buffer = itr.get();
+                return tl_buffer;
+            }
+        }
+        _state.buffers.emplace_back(
+            std::make_shared<trace_buffer>(_state.capacity, _tid));
+        tl_buffer = _state.buffers.back().get();
+    }
+    return tl_buffer;
+}
+
+//--------------------------------------------------------------------------------------//
+
+bool
+initially_enabled()
+{
+    // an output file enables tracing unless PTL_TRACE is explicitly off
+    return GetEnv<bool>("PTL_TRACE", !state().output.empty());
+}
+
+//--------------------------------------------------------------------------------------//
+// writes a string of a JSON document
+//
+void
+write_escaped(std::ostream& os, const char* _str)
+{
+    for(; _str && *_str; ++_str)
+    {
+        if(*_str == '"' || *_str == '\\')
+            os << '\\' << *_str;
+        else if(static_cast<unsigned char>(*_str) >= 0x20)
+            os << *_str;
+    }
+}
+
+//--------------------------------------------------------------------------------------//
+// writes the name and the source location of a label as arguments of an event
+//
+void
+write_label(std::ostream& os, const TaskLabel& _label)
+{
+    if(_label.name)
+    {
+        os << ",\"label\":\"";
+        write_escaped(os, _label.name);
+        os << "\"";
+    }
+    if(_label.file)
+    {
+        os << ",\"location\":\"";
+        write_escaped(os, _label.file);
+        os << ":" << _label.line << "\"";
+    }
+}
+}  // namespace
+
+//======================================================================================//
+
+std::atomic<bool> TaskTracer::f_enabled{ initially_enabled() };
+
+//======================================================================================//
+
+void
+TaskTracer::enable(bool _v)
+{
+    state();
+    f_enabled.store(_v, std::memory_order_relaxed);
+}
+
+//======================================================================================//
+
+void
+TaskTracer::set_capacity(size_type _n)
+{
+    auto&    _state = state();
+    AutoLock _lk(_state.mutex);
+    _state.capacity = round_capacity(std::max<size_type>(_n, 1));
+}
+
+//======================================================================================//
+
+TaskTracer::size_type
+TaskTracer::get_capacity()
+{
+    auto&    _state = state();
+    AutoLock _lk(_state.mutex);
+    return _state.capacity;
+}
+
+//======================================================================================//
+
+void
+TaskTracer::set_output(const std::string& _fname)
+{
+    auto&    _state = state();
+    AutoLock _lk(_state.mutex);
+    _state.output = _fname;
+}
+
+//======================================================================================//
+
+std::string
+TaskTracer::get_output()
+{
+    auto&    _state = state();
+    AutoLock _lk(_state.mutex);
+    return _state.output;
+}
+
+//======================================================================================//
+
+uint64_t
+TaskTracer::timestamp()
+{
+    return CycleClock::now();
+}
+
+//======================================================================================//
+
+void
+TaskTracer::push(event_type _type, const void* _task, const TaskLabel* _label)
+{
+    auto* _buffer = this_buffer();
+    auto  _n      = _buffer->head.load(std::memory_order_relaxed);
+    auto& _event  = _buffer->events[_n & _buffer->mask];
+    _event.tsc    = timestamp();
+    _event.task   = _task;
+    _event.label  = _label;
+    _event.type   = _type;
+    _buffer->head.store(_n + 1, std::memory_order_release);
+}
+
+//======================================================================================//
+
+void
+TaskTracer::clear()
+{
+    auto&    _state = state();
+    AutoLock _lk(_state.mutex);
+    _state.since = timestamp();
+}
+
+//======================================================================================//
+
+void
+TaskTracer::dump(std::ostream& os)
+{
+    auto& _state = state();
+
+    uint64_t                                   _since  = 0;
+    uint64_t                                   _origin = 0;
+    std::vector<std::shared_ptr<trace_buffer>> _buffers{};
+    {
+        AutoLock _lk(_state.mutex);
+        _since   = _state.since;
+        _origin  = _state.origin_tsc;
+        _buffers = _state.buffers;
+    }
+
+    double _ticks_per_us = CycleClock::ticks_per_second() * 1.0e-6;
+
+    static const char* _names[] = { "enqueue", "task", "task", "steal",
+                                     "park",    "park", "join", "join" };
+    static const char* _phases[] = { "i", "B", "E", "i", "B", "E", "B", "E" };
+
+    auto _flags     = os.flags();
+    auto _precision = os.precision();
+    os << std::fixed << std::setprecision(3);
+    os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+    bool _first = true;
+    auto _next  = [&]() -> std::ostream& {
+        os << ((_first) ? "\n" : ",\n");
+        _first = false;
+        return os;
+    };
+
+    for(const auto& itr : _buffers)
+    {
+        auto _tid = itr->tid.load(std::memory_order_relaxed);
+        _next() << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << _tid
+                << ",\"args\":{\"name\":\"PTL thread " << _tid << "\"}}";
+
+        uint64_t _head = itr->head.load(std::memory_order_acquire);
+        uint64_t _size = itr->events.size();
+        for(uint64_t i = (_head > _size) ? (_head - _size) : 0; i < _head; ++i)
+        {
+            auto _event = itr->events[i & itr->mask];
+            if(_event.tsc < _since || _event.tsc < _origin)
+                continue;
+            double _ts = static_cast<double>(_event.tsc - _origin) / _ticks_per_us;
+            // the execution of a labeled task is named by the label
+            const char* _name = _names[_event.type];
+            if(_event.label && _event.label->name &&
+               (_event.type == start || _event.type == end))
+                _name = _event.label->name;
+            _next() << "{\"name\":\"";
+            write_escaped(os, _name);
+            os << "\",\"cat\":\"ptl\",\"ph\":\"" << _phases[_event.type]
+               << "\",\"ts\":" << _ts << ",\"pid\":0,\"tid\":" << _tid;
+            if(_phases[_event.type][0] == 'i')
+                os << ",\"s\":\"t\"";
+            if(_event.task)
+            {
+                os << ",\"args\":{\"task\":\"" << _event.task << "\"";
+                if(_event.label)
+                    write_label(os, *_event.label);
+                os << "}";
+            }
+            os << "}";
+        }
+    }
+
+    os << "\n]}\n";
+    os.flags(_flags);
+    os.precision(_precision);
+}
+
+//======================================================================================//
+
+bool
+TaskTracer::dump(const std::string& _fname)
+{
+    std::ofstream ofs{ _fname };
+    if(!ofs)
+        return false;
+    dump(ofs);
+    return static_cast<bool>(ofs);
+}
+
+//======================================================================================//
+
+bool
+TaskTracer::dump_output()
+{
+    auto _fname = get_output();
+    if(_fname.empty())
+        return false;
+    return dump(_fname);
+}
+
+//======================================================================================//
+
+}  // namespace PTL
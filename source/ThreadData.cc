@@ -42,7 +42,10 @@ ThreadData::ThreadData(ThreadPool* tp)
 , thread_pool(tp)
 , current_queue((tp) ? tp->get_queue() : nullptr)
 , queue_stack({ current_queue })
-{}
+{
+    // thread data is always created by the thread it describes
+    statistics.set_thread_id(ThisThread::get_id());
+}
 
 //======================================================================================//
 
@@ -29,13 +29,20 @@
 // ---------------------------------------------------------------
 
 #include "PTL/ThreadPool.hh"
+#include "PTL/Concurrency.hh"
+#include "PTL/TaskArena.hh"
 #include "PTL/ThreadData.hh"
 #include "PTL/Threading.hh"
 #include "PTL/UserTaskQueue.hh"
 #include "PTL/Utility.hh"
 #include "PTL/VUserTaskQueue.hh"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cassert>
+#include <exception>
+#include <limits>
 #include <mutex>
 #include <new>
 #include <stdexcept>
@@ -52,16 +59,238 @@ thread_data()
 {
     return ThreadData::GetInstance();
 }
-}  // namespace
 
-//======================================================================================//
+//--------------------------------------------------------------------------------------//
+// lock-free registry of the thread indices. Each index is a slot holding the id of the
+// thread which owns it (a default-constructed id if free) and a thread takes the lowest
+// free slot so the indices of exited threads are recycled. An index is never shared:
+// a thread which cannot claim a requested index takes a free one instead. The slots
+// are allocated in blocks which are never freed so lookups never race with a
+// reallocation and only the slots below the high-water mark are searched
+//
+class thread_index_registry
+{
+public:
+    static constexpr size_t block_size = 64;
+    static constexpr size_t max_blocks = 1024;
+    static constexpr size_t max_slots  = block_size * max_blocks;
+
+    using slot_type  = std::atomic<ThreadId>;
+    using block_type = std::array<slot_type, block_size>;
+
+    // claims the lowest free slot for the calling thread. Only called by the thread
+    // itself (once, its index is cached) since it releases the slot on exit
+    uintmax_t acquire(ThreadId _tid)
+    {
+        auto _high = m_high.load(std::memory_order_acquire);
+        for(size_t i = 0; i < _high; ++i)
+        {
+            if(claim(i, _tid))
+                return i;
+        }
+        // every slot below the mark is taken: extend it
+        for(size_t i = m_high.fetch_add(1); i < max_slots; i = m_high.fetch_add(1))
+        {
+            if(claim(i, _tid))
+                return i;
+        }
+        throw std::runtime_error("[PTL::ThreadPool] exhausted the thread indices");
+    }
+
+    // claims a specific slot for the calling thread, or the lowest free slot if it is
+    // owned by another thread. Returns the index which was claimed
+    uintmax_t assign(ThreadId _tid, uintmax_t _idx)
+    {
+        if(_idx >= max_slots || !claim(_idx, _tid))
+            return acquire(_tid);
+        auto _high = m_high.load(std::memory_order_relaxed);
+        while(_high <= _idx && !m_high.compare_exchange_weak(_high, _idx + 1))
+        {}
+        return _idx;
+    }
+
+    // releases the slot of the calling thread (its cached index)
+    void release(uintmax_t _idx)
+    {
+        slot(_idx).store(ThreadId{}, std::memory_order_release);
+    }
+
+    intmax_t find(ThreadId _tid) const
+    {
+        auto _high = m_high.load(std::memory_order_acquire);
+        for(size_t i = 0; i < _high; ++i)
+        {
+            const auto* _slot = find_slot(i);
+            if(_slot && _slot->load(std::memory_order_acquire) == _tid)
+                return i;
+        }
+        return -1;
+    }
+
+    ThreadPool::thread_id_map_t snapshot() const
+    {
+        ThreadPool::thread_id_map_t _ids{};
+        auto                        _high = m_high.load(std::memory_order_acquire);
+        for(size_t i = 0; i < _high; ++i)
+        {
+            const auto* _slot = find_slot(i);
+            if(!_slot)
+                continue;
+            auto _tid = _slot->load(std::memory_order_acquire);
+            if(_tid != ThreadId{})
+                _ids.emplace(_tid, i);
+        }
+        return _ids;
+    }
+
+private:
+    bool claim(size_t _idx, ThreadId _tid)
+    {
+        ThreadId _free{};
+        auto&    _slot = slot(_idx);
+        return (_slot.load(std::memory_order_relaxed) == _free &&
+                _slot.compare_exchange_strong(_free, _tid, std::memory_order_acq_rel));
+    }
+
+    // the slot if its block has been allocated
+    const slot_type* find_slot(size_t _idx) const
+    {
+        auto* _block = m_blocks[_idx / block_size].load(std::memory_order_acquire);
+        return (_block) ? &(*_block)[_idx % block_size] : nullptr;
+    }
+
+    slot_type& slot(size_t _idx)
+    {
+        auto& _ptr   = m_blocks[_idx / block_size];
+        auto* _block = _ptr.load(std::memory_order_acquire);
+        if(!_block)
+        {
+            auto* _new = new block_type{};
+            for(auto& itr : *_new)
+                itr.store(ThreadId{}, std::memory_order_relaxed);
+            if(_ptr.compare_exchange_strong(_block, _new, std::memory_order_acq_rel))
+                _block = _new;
+            else
+                delete _new;
+        }
+        return (*_block)[_idx % block_size];
+    }
+
+private:
+    std::atomic<size_t>                              m_high{ 0 };
+    std::array<std::atomic<block_type*>, max_blocks> m_blocks{};
+};
+
+//--------------------------------------------------------------------------------------//
+// never destroyed since threads release their index after static destruction
+//
+thread_index_registry&
+thread_indices()
+{
+    static auto* _v = new thread_index_registry{};
+    return *_v;
+}
+
+//--------------------------------------------------------------------------------------//
+// index of the calling thread, -1 until it is registered
+//
+thread_local intmax_t tl_thread_index = -1;
+
+//--------------------------------------------------------------------------------------//
+// releases the index of the calling thread when it exits
+//
+struct thread_index_releaser
+{
+    ~thread_index_releaser()
+    {
+        if(tl_thread_index >= 0)
+            thread_indices().release(tl_thread_index);
+        tl_thread_index = -1;
+    }
+};
+
+//--------------------------------------------------------------------------------------//
+// slow path of ThreadPool::get_this_thread_id(): _idx < 0 takes the lowest free index,
+// otherwise the index is requested (the lowest free index is taken if it is in use)
+//
+uintmax_t
+register_this_thread(intmax_t _idx = -1)
+{
+    static thread_local thread_index_releaser _releaser{};
+    if(tl_thread_index >= 0)
+        thread_indices().release(tl_thread_index);
+    auto  _tid      = ThisThread::get_id();
+    auto& _registry = thread_indices();
+    auto  _new      = (_idx < 0) ? _registry.acquire(_tid) : _registry.assign(_tid, _idx);
+    tl_thread_index = static_cast<intmax_t>(_new);
+    return tl_thread_index;
+}
+
+//--------------------------------------------------------------------------------------//
+// copies of the copy-on-write lists of linked pools with an entry added or removed
+//
+template <typename Tp>
+std::shared_ptr<const std::vector<Tp>>
+list_with(const std::shared_ptr<const std::vector<Tp>>& _list, Tp _value)
+{
+    auto _copy = std::make_shared<std::vector<Tp>>(*_list);
+    _copy->emplace_back(_value);
+    return _copy;
+}
+
+template <typename Tp>
+std::shared_ptr<const std::vector<Tp>>
+list_without(const std::shared_ptr<const std::vector<Tp>>& _list, Tp _value)
+{
+    auto _copy = std::make_shared<std::vector<Tp>>(*_list);
+    _copy->erase(std::remove(_copy->begin(), _copy->end(), _value), _copy->end());
+    return _copy;
+}
 
-ThreadPool::thread_id_map_t&
-ThreadPool::f_thread_ids()
+//--------------------------------------------------------------------------------------//
+// waits until no thread holds a snapshot of a list which has been replaced. Snapshots
+// are only held while the linked queues are searched so this is brief
+//
+template <typename Tp>
+void
+wait_for_readers(std::shared_ptr<const Tp>&& _list)
+{
+    while(_list.use_count() > 1)
+        std::this_thread::yield();
+    std::atomic_thread_fence(std::memory_order_acquire);
+}
+
+//--------------------------------------------------------------------------------------//
+// raises the pass of the stride scheduling to at least _value and returns it
+//
+uintmax_t
+fetch_max(std::atomic_uintmax_t& _pass, uintmax_t _value)
+{
+    auto _v = _pass.load(std::memory_order_relaxed);
+    while(_v < _value && !_pass.compare_exchange_weak(_v, _value))
+    {}
+    return std::max(_v, _value);
+}
+
+#if defined(PTL_USE_TBB)
+//--------------------------------------------------------------------------------------//
+// generation of the TBB broadcasts and the last one executed by the calling thread
+//
+std::atomic_uintmax_t&
+tbb_broadcast_generation()
+{
+    static std::atomic_uintmax_t _v{ 0 };
+    return _v;
+}
+
+uintmax_t&
+tbb_broadcast_seen()
 {
-    static auto _v = thread_id_map_t{};
+    static thread_local uintmax_t _v = 0;
     return _v;
 }
+#endif
+}  // namespace
 
 //======================================================================================//
 
@@ -83,6 +312,26 @@ ThreadPool::f_use_cpu_affinity()
 
 //======================================================================================//
 
+short&
+ThreadPool::f_cpu_placement()
+{
+    static EnvChoiceList<short> _choices = {
+        EnvChoice<short>(cpu_placement::NONE, "none", "affinity function of the pool"),
+        EnvChoice<short>(cpu_placement::COMPACT, "compact",
+                         "fill SMT siblings, then cores, then sockets"),
+        EnvChoice<short>(cpu_placement::SCATTER, "scatter",
+                         "spread over sockets, then cores, then SMT siblings"),
+        EnvChoice<short>(cpu_placement::PHYSICAL_CORES, "cores",
+                         "one thread per physical core"),
+        EnvChoice<short>(cpu_placement::NUMA_ROUND_ROBIN, "numa",
+                         "alternate between NUMA nodes")
+    };
+    static short _v = GetEnv<short>("PTL_CPU_PLACEMENT", _choices, cpu_placement::NONE);
+    return _v;
+}
+
+//======================================================================================//
+
 int&
 ThreadPool::f_thread_priority()
 {
@@ -104,8 +353,26 @@ ThreadPool::f_verbose()
 ThreadPool::size_type&
 ThreadPool::f_default_pool_size()
 {
-    static size_type _v =
-        GetEnv<size_type>("PTL_NUM_THREADS", Thread::hardware_concurrency());
+    static size_type _v = GetEnv<size_type>("PTL_NUM_THREADS", effective_concurrency());
+    return _v;
+}
+
+//======================================================================================//
+
+bool&
+ThreadPool::f_elastic()
+{
+    static bool _v = GetEnv<bool>("PTL_ELASTIC", false);
+    return _v;
+}
+
+//======================================================================================//
+
+std::chrono::milliseconds&
+ThreadPool::f_elastic_linger()
+{
+    static auto _v =
+        std::chrono::milliseconds{ GetEnv<int64_t>("PTL_ELASTIC_LINGER_MS", 1000) };
     return _v;
 }
 
@@ -113,7 +380,8 @@ ThreadPool::f_default_pool_size()
 // static member function that calls the member function we want the thread to
 // run
 void
-ThreadPool::start_thread(ThreadPool* tp, thread_data_t* _data, intmax_t _idx)
+ThreadPool::start_thread(ThreadPool* tp, thread_data_t* _data, intmax_t _idx,
+                         uintmax_t _bcast)
 {
     if(tp->get_verbose() > 0)
     {
@@ -121,20 +389,21 @@ ThreadPool::start_thread(ThreadPool* tp, thread_data_t* _data, intmax_t _idx)
         std::cerr << "[PTL::ThreadPool] Starting thread " << _idx << "..." << std::endl;
     }
 
-    auto _thr_data = std::make_shared<ThreadData>(tp);
+    auto _thr_data            = std::make_shared<ThreadData>(tp);
+    _thr_data->broadcast_seen = _bcast;
+    _idx                      = register_this_thread(_idx);
+    Threading::SetThreadId(_idx);
     {
         AutoLock lock(TypeMutex<ThreadPool>(), std::defer_lock);
         if(!lock.owns_lock())
             lock.lock();
-        if(_idx < 0)
-            _idx = f_thread_ids().size();
-        f_thread_ids()[std::this_thread::get_id()] = _idx;
-        Threading::SetThreadId(_idx);
         _data->emplace_back(_thr_data);
     }
     thread_data() = _thr_data.get();
     tp->record_entry();
+    TaskHooks::notify(TaskHooks::worker_start, tp);
     tp->execute_thread(thread_data()->current_queue);
+    TaskHooks::notify(TaskHooks::worker_stop, tp);
     tp->record_exit();
 
     if(tp->get_verbose() > 0)
@@ -179,34 +448,26 @@ ThreadPool::set_default_use_cpu_affinity(bool enable)
 
 //======================================================================================//
 
-const ThreadPool::thread_id_map_t&
+ThreadPool::thread_id_map_t
 ThreadPool::get_thread_ids()
 {
-    return f_thread_ids();
+    return thread_indices().snapshot();
 }
 
 //======================================================================================//
 
+constexpr uintmax_t ThreadPool::unregistered_thread_id;
+
+//======================================================================================//
+
 uintmax_t
 ThreadPool::get_thread_id(ThreadId _tid)
 {
-    uintmax_t _idx = 0;
-    {
-        AutoLock lock(TypeMutex<ThreadPool>(), std::defer_lock);
-        if(!lock.owns_lock())
-            lock.lock();
-        auto itr = f_thread_ids().find(_tid);
-        if(itr == f_thread_ids().end())
-        {
-            _idx                 = f_thread_ids().size();
-            f_thread_ids()[_tid] = _idx;
-        }
-        else
-        {
-            _idx = itr->second;
-        }
-    }
-    return _idx;
+    if(_tid == ThisThread::get_id())
+        return get_this_thread_id();
+    // claiming an index for another thread would leak it: only the thread releases it
+    auto _idx = thread_indices().find(_tid);
+    return (_idx < 0) ? unregistered_thread_id : static_cast<uintmax_t>(_idx);
 }
 
 //======================================================================================//
@@ -214,7 +475,9 @@ ThreadPool::get_thread_id(ThreadId _tid)
 uintmax_t
 ThreadPool::get_this_thread_id()
 {
-    return get_thread_id(ThisThread::get_id());
+    if(tl_thread_index >= 0)
+        return tl_thread_index;
+    return register_this_thread();
 }
 
 //======================================================================================//
@@ -222,16 +485,13 @@ ThreadPool::get_this_thread_id()
 uintmax_t
 ThreadPool::add_thread_id(ThreadId _tid)
 {
-    AutoLock lock(TypeMutex<ThreadPool>(), std::defer_lock);
-    if(!lock.owns_lock())
-        lock.lock();
-    if(f_thread_ids().find(_tid) == f_thread_ids().end())
-    {
-        auto _idx            = f_thread_ids().size();
-        f_thread_ids()[_tid] = _idx;
-        Threading::SetThreadId(_idx);
-    }
-    return f_thread_ids().at(_tid);
+    if(_tid != ThisThread::get_id())
+        return get_thread_id(_tid);
+    if(tl_thread_index >= 0)
+        return tl_thread_index;
+    auto _idx = register_this_thread();
+    Threading::SetThreadId(_idx);
+    return _idx;
 }
 
 //======================================================================================//
@@ -255,15 +515,22 @@ ThreadPool::Config::Config(bool _init, bool _use_tbb, bool _use_affinity, int _v
 //======================================================================================//
 
 ThreadPool::ThreadPool(const Config& _cfg)
-: m_use_affinity{ _cfg.use_affinity }
+: m_use_affinity{ _cfg.use_affinity || _cfg.placement != cpu_placement::NONE }
 , m_tbb_tp{ _cfg.use_tbb }
+, m_elastic{ _cfg.elastic }
 , m_verbose{ _cfg.verbose }
 , m_priority{ _cfg.priority }
+, m_min_size{ std::max<size_type>(_cfg.min_pool_size, 1) }
+, m_max_size{ std::max(_cfg.max_pool_size, _cfg.pool_size) }
 , m_pool_state{ std::make_shared<std::atomic_short>(thread_pool::state::NONINIT) }
+, m_grow_delay{ _cfg.grow_delay }
+, m_linger{ _cfg.linger }
 , m_task_queue{ _cfg.task_queue }
 , m_init_func{ _cfg.initializer }
 , m_fini_func{ _cfg.finalizer }
-, m_affinity_func{ _cfg.set_affinity }
+, m_affinity_func{ (_cfg.placement == cpu_placement::NONE)
+                       ? _cfg.set_affinity
+                       : Topology::instance().placement_functor(_cfg.placement) }
 {
     auto master_id = get_this_thread_id();
     if(master_id != 0 && m_verbose > 1)
@@ -272,7 +539,13 @@ ThreadPool::ThreadPool(const Config& _cfg)
         std::cerr << "[PTL::ThreadPool] ThreadPool created on worker thread" << std::endl;
     }
 
-    thread_data() = new ThreadData(this);
+    // the exceptions of the timers are reported according to the verbosity
+    set_timer_error_handler(timer_error_t{});
+
+    // a pool created within a task keeps the thread data of the worker since it
+    // describes the pool and queue the thread is executing for
+    if(!thread_data() || thread_data()->is_main)
+        thread_data() = new ThreadData(this);
 
     // initialize after get_this_thread_id so master is zero
     if(_cfg.init)
@@ -302,6 +575,13 @@ ThreadPool::ThreadPool(const size_type& pool_size, initialize_func_t _init_func,
 
 ThreadPool::~ThreadPool()
 {
+    // a pool destroyed without destroy_threadpool() must not be left in the lists of
+    // the pools linked to it, which would otherwise keep using its queue
+    unlink_all();
+    // and the arenas of a pool destroyed without destroy_threadpool() must not keep
+    // a pointer to it
+    detach_arenas();
+
     if(m_alive_flag->load())
     {
         std::cerr << "Warning! ThreadPool was not properly destroyed! Call "
@@ -351,7 +631,7 @@ ThreadPool::record_exit()
 
 //======================================================================================//
 
-void
+intmax_t
 ThreadPool::set_affinity(intmax_t i, Thread& _thread) const
 {
     try
@@ -361,15 +641,28 @@ ThreadPool::set_affinity(intmax_t i, Thread& _thread) const
         if(m_verbose > 0)
         {
             AutoLock lock(TypeMutex<decltype(std::cerr)>());
-            std::cerr << "[PTL::ThreadPool] Setting pin affinity for thread "
-                      << get_thread_id(_thread.get_id()) << " to " << _pin << std::endl;
+            std::cerr << "[PTL::ThreadPool] Setting pin affinity for thread " << i
+                      << " to " << _pin << std::endl;
         }
-        Threading::SetPinAffinity(_pin, native_thread);
+        if(Threading::SetPinAffinity(_pin, native_thread))
+            return _pin;
     } catch(std::runtime_error& e)
     {
         std::cerr << "[PTL::ThreadPool] Error setting pin affinity: " << e.what()
                   << std::endl;
     }
+    return -1;
+}
+
+//======================================================================================//
+
+int
+ThreadPool::get_worker_node(intmax_t i) const
+{
+    RecursiveAutoLock _resize_lock(*m_resize_lock);
+    if(i < 0 || static_cast<size_t>(i) >= m_worker_nodes.size())
+        return -1;
+    return m_worker_nodes.at(i);
 }
 
 //======================================================================================//
@@ -383,9 +676,8 @@ ThreadPool::set_priority(int _prio, Thread& _thread) const
         if(m_verbose > 0)
         {
             AutoLock lock(TypeMutex<decltype(std::cerr)>());
-            std::cerr << "[PTL::ThreadPool] Setting thread "
-                      << get_thread_id(_thread.get_id()) << " priority to " << _prio
-                      << std::endl;
+            std::cerr << "[PTL::ThreadPool] Setting thread " << _thread.get_id()
+                      << " priority to " << _prio << std::endl;
         }
         Threading::SetThreadPriority(_prio, native_thread);
     } catch(std::runtime_error& e)
@@ -406,6 +698,9 @@ ThreadPool::initialize_threadpool(size_type proposed_size)
     if(proposed_size < 1)
         return 0;
 
+    // an elastic pool may resize itself from a worker thread
+    RecursiveAutoLock _resize_lock(*m_resize_lock);
+
     //--------------------------------------------------------------------//
     // store that has been started
     if(!m_alive_flag->load())
@@ -417,10 +712,10 @@ ThreadPool::initialize_threadpool(size_type proposed_size)
     if(m_tbb_tp)
     {
         m_tbb_tp                               = true;
-        m_pool_size                            = proposed_size;
+        m_pool_size->store(proposed_size);
         tbb_global_control_t*& _global_control = tbb_global_control();
         // delete if wrong size
-        if(m_pool_size != proposed_size)
+        if(m_pool_size->load() != proposed_size)
         {
             delete _global_control;
             _global_control = nullptr;
@@ -434,7 +729,7 @@ ThreadPool::initialize_threadpool(size_type proposed_size)
             {
                 AutoLock lock(TypeMutex<decltype(std::cerr)>());
                 std::cerr << "[PTL::ThreadPool] ThreadPool [TBB] initialized with "
-                          << m_pool_size << " threads." << std::endl;
+                          << m_pool_size->load() << " threads." << std::endl;
             }
         }
 
@@ -445,17 +740,20 @@ ThreadPool::initialize_threadpool(size_type proposed_size)
             execute_on_all_threads([this]() { m_init_func(); });
         }
 
-        return m_pool_size;
+        return m_pool_size->load();
     }
 #endif
 
     m_alive_flag->store(true);
 
+    // join the threads which have left the pool
+    reap_threads();
+
     //--------------------------------------------------------------------//
     // if started, stop some thread if smaller or return if equal
     if(m_pool_state->load() == thread_pool::state::STARTED)
     {
-        if(m_pool_size > proposed_size)
+        if(m_pool_size->load() > proposed_size)
         {
             while(stop_thread() > proposed_size)
                 ;
@@ -463,33 +761,34 @@ ThreadPool::initialize_threadpool(size_type proposed_size)
             {
                 AutoLock lock(TypeMutex<decltype(std::cerr)>());
                 std::cerr << "[PTL::ThreadPool] ThreadPool initialized with "
-                          << m_pool_size << " threads." << std::endl;
+                          << m_pool_size->load() << " threads." << std::endl;
             }
             if(!m_task_queue)
             {
                 m_delete_task_queue = true;
-                m_task_queue        = new UserTaskQueue(m_pool_size);
+                m_task_queue        = new UserTaskQueue(m_pool_size->load());
             }
             else
             {
-                m_task_queue->resize(m_pool_size);
+                m_task_queue->resize(m_pool_size->load());
             }
-            return m_pool_size;
+            resize_arenas();
+            return m_pool_size->load();
         }
-        else if(m_pool_size == proposed_size)  // NOLINT
+        else if(m_pool_size->load() == proposed_size)  // NOLINT
         {
             if(m_verbose > 0)
             {
                 AutoLock lock(TypeMutex<decltype(std::cerr)>());
-                std::cerr << "ThreadPool initialized with " << m_pool_size << " threads."
-                          << std::endl;
+                std::cerr << "ThreadPool initialized with " << m_pool_size->load()
+                          << " threads." << std::endl;
             }
             if(!m_task_queue)
             {
                 m_delete_task_queue = true;
-                m_task_queue        = new UserTaskQueue(m_pool_size);
+                m_task_queue        = new UserTaskQueue(m_pool_size->load());
             }
-            return m_pool_size;
+            return m_pool_size->load();
         }
     }
 
@@ -498,6 +797,16 @@ ThreadPool::initialize_threadpool(size_type proposed_size)
     {
         AutoLock _task_lock(*m_task_lock);
         m_is_joined.reserve(proposed_size);
+        // withdraw requests for threads to stop which no thread has picked up yet
+        while(!m_is_stopped.empty() && m_pool_size->load() < proposed_size)
+        {
+            m_is_stopped.pop_back();
+            ++(*m_pool_size);
+        }
+        short _partial = thread_pool::state::PARTIAL;
+        if(m_is_stopped.empty())
+            m_pool_state->compare_exchange_strong(_partial,
+                                                  thread_pool::state::STARTED);
     }
 
     if(!m_task_queue)
@@ -506,24 +815,45 @@ ThreadPool::initialize_threadpool(size_type proposed_size)
         m_task_queue        = new UserTaskQueue(proposed_size);
     }
 
-    auto this_tid = get_this_thread_id();
-    for(size_type i = m_pool_size; i < proposed_size; ++i)
+    // the thread which created the pool may have exited (releasing its index) before
+    // a worker grows the pool
+    auto this_tid = get_thread_id(m_main_tid);
+    if(this_tid == unregistered_thread_id)
+        this_tid = 0;
+    for(size_type i = m_pool_size->load(); i < proposed_size; ++i)
     {
         // add the threads
         try
         {
-            // create thread
-            Thread thr{ ThreadPool::start_thread, this, &m_thread_data,
-                        this_tid + i + 1 };
-            // only reaches here if successful creation of thread
-            ++m_pool_size;
-            // store thread
-            m_main_threads.push_back(thr.get_id());
-            // list of joined thread booleans
-            m_is_joined.push_back(false);
-            // set the affinity
+            // create thread, it takes part in the broadcasts which start afterwards
+            // and its mailbox exists before it starts
+            AutoLock _bcast_lock(*m_broadcast_mutex);
+            AutoLock _mbox_lock(*m_mailbox_lock);
+            Thread   thr{ ThreadPool::start_thread, this, &m_thread_data,
+                        this_tid + i + 1, m_broadcast_gen->load() };
+            m_mailboxes[thr.get_id()] = std::make_shared<TaskMailbox>();
+            m_broadcast_workers.emplace(thr.get_id());
+            _mbox_lock.unlock();
+            _bcast_lock.unlock();
+            {
+                // an idle worker may be retiring (and reaping) concurrently
+                AutoLock _task_lock(*m_task_lock);
+                // only reaches here if successful creation of thread
+                ++(*m_pool_size);
+                // store thread
+                m_main_threads.push_back(thr.get_id());
+                // list of joined thread booleans
+                m_is_joined.push_back(false);
+            }
+            // set the affinity and keep the node of the CPU
             if(m_use_affinity)
-                set_affinity(i, thr);
+            {
+                auto _cpu = set_affinity(i, thr);
+                if(m_worker_nodes.size() <= i)
+                    m_worker_nodes.resize(i + 1, -1);
+                auto _node = Topology::instance().node_of(static_cast<int>(_cpu));
+                m_worker_nodes.at(i) = (_cpu < 0) ? -1 : _node;
+            }
             set_priority(m_priority, thr);
             // store
             m_threads.emplace_back(std::move(thr));
@@ -542,6 +872,9 @@ ThreadPool::initialize_threadpool(size_type proposed_size)
     }
     //------------------------------------------------------------------------//
 
+    // the queues of the arenas have a bin per worker like the queue of the pool
+    resize_arenas();
+
     AutoLock _task_lock(*m_task_lock);
 
     // thread pool size doesn't match with join vector
@@ -559,8 +892,8 @@ ThreadPool::initialize_threadpool(size_type proposed_size)
     if(m_verbose > 0)
     {
         AutoLock lock(TypeMutex<decltype(std::cerr)>());
-        std::cerr << "[PTL::ThreadPool] ThreadPool initialized with " << m_pool_size
-                  << " threads." << std::endl;
+        std::cerr << "[PTL::ThreadPool] ThreadPool initialized with "
+                  << m_pool_size->load() << " threads." << std::endl;
     }
 
     return m_main_threads.size();
@@ -576,6 +909,12 @@ ThreadPool::destroy_threadpool()
     // the modified m_pool_state may not show up to other threads until its
     // modified in a lock!
     //------------------------------------------------------------------------//
+    // linked pools stop taking tasks from this pool (and giving tasks to it)
+    unlink_all();
+
+    // the arenas execute their remaining tasks in the thread which destroys them
+    detach_arenas();
+
     m_pool_state->store(thread_pool::state::STOPPED);
 
     //--------------------------------------------------------------------//
@@ -614,6 +953,9 @@ ThreadPool::destroy_threadpool()
     if(!m_alive_flag->load())
         return 0;
 
+    // wait for an elastic resize in progress
+    RecursiveAutoLock _resize_lock(*m_resize_lock);
+
     //------------------------------------------------------------------------//
     // notify all threads we are shutting down
     m_task_lock->lock();
@@ -621,6 +963,9 @@ ThreadPool::destroy_threadpool()
     m_task_lock->unlock();
     //------------------------------------------------------------------------//
 
+    // join the threads which already left the pool
+    reap_threads();
+
     if(m_is_joined.size() != m_main_threads.size())
     {
         std::stringstream ss;
@@ -648,24 +993,22 @@ ThreadPool::destroy_threadpool()
         if(std::this_thread::get_id() == m_main_threads[i])
             continue;
 
-        //--------------------------------------------------------------------//
-        // thread id and index
-        auto _tid = m_main_threads[i];
-
-        //--------------------------------------------------------------------//
-        // erase thread from thread ID list
-        if(f_thread_ids().find(_tid) != f_thread_ids().end())
-            f_thread_ids().erase(f_thread_ids().find(_tid));
-
         //--------------------------------------------------------------------//
         // it's joined
         m_is_joined.at(i) = true;
     }
 
-    m_thread_data.clear();
+    {
+        AutoLock _lk(TypeMutex<ThreadPool>());
+        m_thread_data.clear();
+        m_statistics_base.clear();
+        m_label_base.clear();
+    }
     m_threads.clear();
     m_main_threads.clear();
     m_is_joined.clear();
+    m_is_stopped.clear();
+    m_stop_threads.clear();
 
     m_alive_flag->store(false);
 
@@ -680,6 +1023,10 @@ ThreadPool::destroy_threadpool()
 
     auto _active = m_thread_active->load();
 
+    // the timelines of the workers are complete once they have exited
+    if(TaskTracer::enabled())
+        TaskTracer::dump_output();
+
     if(get_verbose() > 0)
     {
         if(_active == 0)
@@ -710,125 +1057,1154 @@ ThreadPool::destroy_threadpool()
 ThreadPool::size_type
 ThreadPool::stop_thread()
 {
-    if(!m_alive_flag->load() || m_pool_size == 0)
+    if(!m_alive_flag->load() || m_pool_size->load() == 0)
         return 0;
 
-    m_pool_state->store(thread_pool::state::PARTIAL);
+    RecursiveAutoLock _resize_lock(*m_resize_lock);
+
+    // join the threads which have left the pool since the last call
+    reap_threads();
 
     //------------------------------------------------------------------------//
-    // notify all threads we are shutting down
-    m_task_lock->lock();
+    // post a request for a thread to leave the pool. The first thread which sees
+    // the request exits so this does not wait for a thread to finish its task
+    AutoLock _task_lock(*m_task_lock);
+
+    short _started = thread_pool::state::STARTED;
+    if(m_pool_size->load() == 0 ||
+       (!m_pool_state->compare_exchange_strong(_started, thread_pool::state::PARTIAL) &&
+        _started != thread_pool::state::PARTIAL))
+        return m_pool_size->load();
+
     m_is_stopped.push_back(true);
+    --(*m_pool_size);
     m_task_cond->notify_one();
-    m_task_lock->unlock();
     //------------------------------------------------------------------------//
 
-    while(!m_is_stopped.empty() && m_stop_threads.empty())
-        ;
+    return m_pool_size->load();
+}
 
-    // lock up the task queue
-    AutoLock _task_lock(*m_task_lock);
+//======================================================================================//
 
-    while(!m_stop_threads.empty())
-    {
-        auto tid = m_stop_threads.front();
-        // remove from stopped
-        m_stop_threads.pop_front();
-        // remove from main
-        for(auto itr = m_main_threads.begin(); itr != m_main_threads.end(); ++itr)
-        {
-            if(*itr == tid)
-            {
-                m_main_threads.erase(itr);
-                break;
-            }
-        }
-        // remove from join list
-        m_is_joined.pop_back();
-    }
+ThreadPool::timer_id_t
+ThreadPool::add_timer(timer_point_t _when, timer_duration_t _period,
+                      TimerWheel::function_type&& _func)
+{
+    // TBB schedules its own threads so there are no workers to expire the timers
+    if(m_tbb_tp)
+        throw std::runtime_error(
+            "[PTL::ThreadPool] delayed and periodic tasks require a non-TBB ThreadPool");
 
-    m_pool_state->store(thread_pool::state::STARTED);
+    auto _id = m_timers->schedule(_when, _period, std::move(_func));
 
-    m_pool_size = m_main_threads.size();
-    return m_main_threads.size();
+    // if this is the next timer, wake the thread parked until a later deadline
+    // (or a thread to park until this one if no thread is parked on the timers)
+    if(m_timers->next_deadline().time_since_epoch().count() < m_timer_wait->load())
+        notify_all();
+    return _id;
 }
 
 //======================================================================================//
 
-ThreadPool::task_queue_t*&
-ThreadPool::get_valid_queue(task_queue_t*& _queue) const
+void
+ThreadPool::set_timer_error_handler(timer_error_t _func)
 {
-    if(!_queue)
-        _queue = new UserTaskQueue{ static_cast<intmax_t>(m_pool_size) };
-    return _queue;
+    if(!_func)
+    {
+        _func = [this](timer_id_t _id, std::exception_ptr _err) {
+            report_timer_error(_id, _err);
+        };
+    }
+    m_timers->set_error_handler(std::move(_func));
 }
+
 //======================================================================================//
 
 void
-ThreadPool::execute_thread(VUserTaskQueue* _task_queue)
+ThreadPool::report_timer_error(timer_id_t _id, const std::exception_ptr& _err) const
 {
-    // how long the thread waits on condition variable
-    // static int wait_time = GetEnv<int>("PTL_POOL_WAIT_TIME", 5);
-
-    ++(*m_thread_awake);
+    if(m_verbose <= 0 || !_err)
+        return;
 
-    // initialization function
-    m_init_func();
-    // finalization function (executed when scope is destroyed)
-    ScopeDestructor _fini{ [this]() { m_fini_func(); } };
+    try
+    {
+        std::rethrow_exception(_err);
+    } catch(std::exception& e)
+    {
+        AutoLock lock(TypeMutex<decltype(std::cerr)>());
+        std::cerr << "[PTL::ThreadPool] Exception thrown by timer " << _id << ": "
+                  << e.what() << std::endl;
+    } catch(...)
+    {
+        AutoLock lock(TypeMutex<decltype(std::cerr)>());
+        std::cerr << "[PTL::ThreadPool] Unknown exception thrown by timer " << _id
+                  << std::endl;
+    }
+}
 
-    ThreadId    tid  = ThisThread::get_id();
-    ThreadData* data = thread_data();
-    // auto        thread_bin = _task_queue->GetThreadBin();
-    // auto        workers    = _task_queue->workers();
+//======================================================================================//
 
-    auto start   = std::chrono::steady_clock::now();
-    auto elapsed = std::chrono::duration<double>{};
-    // check for updates for 60 seconds max
-    while(!_task_queue && elapsed.count() < 60)
+void
+ThreadPool::reap_threads()
+{
+    thread_vec_t _exited{};
     {
-        elapsed = std::chrono::steady_clock::now() - start;
-        data->update();
-        _task_queue = data->current_queue;
+        AutoLock _task_lock(*m_task_lock);
+        while(!m_stop_threads.empty())
+        {
+            auto _tid = m_stop_threads.front();
+            m_stop_threads.pop_front();
+            // remove from main
+            auto mitr = std::find(m_main_threads.begin(), m_main_threads.end(), _tid);
+            if(mitr != m_main_threads.end())
+                m_main_threads.erase(mitr);
+            // remove from join list
+            m_is_joined.pop_back();
+            // move out of the active threads
+            for(auto itr = m_threads.begin(); itr != m_threads.end(); ++itr)
+            {
+                if(itr->get_id() == _tid)
+                {
+                    _exited.emplace_back(std::move(*itr));
+                    m_threads.erase(itr);
+                    break;
+                }
+            }
+        }
     }
 
-    if(!_task_queue)
+    // these threads have left execute_thread so this only waits on the finalizer
+    for(auto& itr : _exited)
+        itr.join();
+}
+
+//======================================================================================//
+
+bool
+ThreadPool::retire_thread(ThreadId _tid)
+{
+    // called by an idle worker holding m_task_lock
+    if(!m_elastic || m_pool_size->load() <= m_min_size ||
+       m_pool_state->load() != thread_pool::state::STARTED)
+        return false;
+
+    // the queue shrinks with the pool. m_resize_lock is taken before m_task_lock
+    // elsewhere so the worker stays if another thread is resizing the pool
+    RecursiveAutoLock _resize_lock(*m_resize_lock, std::try_to_lock);
+    if(!_resize_lock.owns_lock())
+        return false;
+
+    --(*m_pool_size);
+    m_stop_threads.push_back(_tid);
+    if(m_task_queue)
+        m_task_queue->resize(static_cast<intmax_t>(m_pool_size->load()));
+    resize_arenas();
+    // let a remaining thread take over waiting on the timers
+    if(!m_timers->empty())
+        m_task_cond->notify_all();
+
+    if(m_verbose > 0)
     {
-        --(*m_thread_awake);
-        throw std::runtime_error("No task queue was found after 60 seconds!");
+        AutoLock lock(TypeMutex<decltype(std::cerr)>());
+        std::cerr << "[PTL::ThreadPool] Retiring idle thread. ThreadPool size is "
+                  << m_pool_size->load() << " threads." << std::endl;
     }
+    return true;
+}
 
-    assert(data->current_queue != nullptr);
-    assert(_task_queue == data->current_queue);
+//======================================================================================//
 
-    // essentially a dummy run
-    if(_task_queue)
+void
+ThreadPool::grow_if_backlogged()
+{
+    // the backlog counts when there are more queued tasks than threads and none of
+    // the threads is idle
+    auto _size = m_pool_size->load();
+    if(_size >= m_max_size || !m_task_queue || m_task_queue->size() <= _size ||
+       m_thread_awake->load() < _size)
     {
-        data->within_task = true;
-        auto _task        = _task_queue->GetTask();
-        if(_task)
-        {
-            (*_task)();
-        }
-        data->within_task = false;
+        if(m_backlog_since->load(std::memory_order_relaxed) != 0)
+            m_backlog_since->store(0, std::memory_order_relaxed);
+        return;
     }
 
-    // threads stay in this loop forever until thread-pool destroyed
-    while(true)
-    {
-        static thread_local auto p_task_lock = m_task_lock;
+    // grow once the backlog has been there for the grow delay
+    intmax_t _since = 0;
+    intmax_t _now   = timer_point_t::clock::now().time_since_epoch().count();
+    if(m_backlog_since->compare_exchange_strong(_since, _now) ||
+       timer_duration_t{ _now - _since } < m_grow_delay)
+        return;
+
+    // only one thread resizes and never while the pool is being destroyed
+    RecursiveAutoLock _resize_lock(*m_resize_lock, std::try_to_lock);
+    if(!_resize_lock.owns_lock() || !m_alive_flag->load() ||
+       m_pool_state->load() != thread_pool::state::STARTED ||
+       m_pool_size->load() >= m_max_size)
+        return;
+
+    initialize_threadpool(m_pool_size->load() + 1);
+    m_task_queue->resize(static_cast<intmax_t>(m_pool_size->load()));
+    m_backlog_since->store(0);
+}
 
-        //--------------------------------------------------------------------//
-        // Try to pick a task
-        AutoLock _task_lock(*p_task_lock, std::defer_lock);
-        //--------------------------------------------------------------------//
+//======================================================================================//
 
-        auto leave_pool = [&]() {
-            auto _state      = [&]() { return static_cast<int>(m_pool_state->load()); };
-            auto _pool_state = _state();
-            if(_pool_state > 0)
-            {
-                // stop whole pool
+void
+ThreadPool::set_elastic_limits(size_type _min, size_type _max)
+{
+    m_min_size = std::max<size_type>(_min, 1);
+    m_max_size = std::max(_min, _max);
+}
+
+//======================================================================================//
+
+Mutex&
+ThreadPool::f_federation_mutex()
+{
+    static Mutex _v{};
+    return _v;
+}
+
+//======================================================================================//
+
+void
+ThreadPool::link_pool(ThreadPool* _donor)
+{
+    if(!_donor || _donor == this)
+        return;
+    AutoLock _lk(f_federation_mutex());
+    auto     _donors = std::atomic_load(&m_donors);
+    if(std::find(_donors->begin(), _donors->end(), _donor) != _donors->end())
+        return;
+    auto _helpers = std::atomic_load(&_donor->m_helpers);
+    std::atomic_store(&m_donors, list_with(_donors, _donor));
+    std::atomic_store(&_donor->m_helpers, list_with(_helpers, this));
+    m_has_donors->store(true);
+    _donor->m_has_helpers->store(true);
+}
+
+//======================================================================================//
+
+void
+ThreadPool::unlink_pool(ThreadPool* _donor)
+{
+    AutoLock _lk(f_federation_mutex());
+    auto     _donors = std::atomic_load(&m_donors);
+    if(std::find(_donors->begin(), _donors->end(), _donor) == _donors->end())
+        return;
+    auto _helpers = list_without(std::atomic_load(&_donor->m_helpers), this);
+    _donor->m_has_helpers->store(!_helpers->empty());
+    wait_for_readers(std::atomic_exchange(&_donor->m_helpers, _helpers));
+    _donors = list_without(_donors, _donor);
+    m_has_donors->store(!_donors->empty());
+    wait_for_readers(std::atomic_exchange(&m_donors, _donors));
+}
+
+//======================================================================================//
+
+void
+ThreadPool::unlink_all()
+{
+    AutoLock _lk(f_federation_mutex());
+    auto     _donors  = std::atomic_load(&m_donors);
+    auto     _helpers = std::atomic_load(&m_helpers);
+    for(auto* itr : *_donors)
+    {
+        auto _list = list_without(std::atomic_load(&itr->m_helpers), this);
+        itr->m_has_helpers->store(!_list->empty());
+        wait_for_readers(std::atomic_exchange(&itr->m_helpers, _list));
+    }
+    for(auto* itr : *_helpers)
+    {
+        auto _list = list_without(std::atomic_load(&itr->m_donors), this);
+        itr->m_has_donors->store(!_list->empty());
+        wait_for_readers(std::atomic_exchange(&itr->m_donors, _list));
+    }
+    m_has_donors->store(false);
+    m_has_helpers->store(false);
+    // the snapshots above are released first since they count as readers and the
+    // empty lists are separate since a shared one would count as a reader of the other
+    _donors  = std::make_shared<pool_list_t>();
+    _helpers = std::make_shared<pool_list_t>();
+    wait_for_readers(std::atomic_exchange(&m_donors, _donors));
+    wait_for_readers(std::atomic_exchange(&m_helpers, _helpers));
+}
+
+//======================================================================================//
+
+void
+ThreadPool::set_federation_limits(size_type _max_workers, size_type _min_backlog)
+{
+    m_help_max->store(_max_workers);
+    m_help_backlog->store(std::max<size_type>(_min_backlog, 1));
+}
+
+//======================================================================================//
+
+void
+ThreadPool::request_help()
+{
+    // only when every worker of this pool is busy
+    if(m_thread_awake->load() < m_pool_size->load())
+        return;
+
+    auto _helpers = std::atomic_load(&m_helpers);
+    for(auto* itr : *_helpers)
+    {
+        if(!itr->m_alive_flag->load() ||
+           itr->m_thread_awake->load() >= itr->m_pool_size->load())
+            continue;
+        // another thread already asked and the helper has not picked it up yet
+        if(itr->m_help_requested->load(std::memory_order_relaxed))
+            return;
+        // wake one idle worker of the helper
+        AutoLock _task_lock(*itr->m_task_lock);
+        itr->m_help_requested->store(true);
+        itr->m_task_cond->notify_one();
+        return;
+    }
+}
+
+//======================================================================================//
+
+ThreadPool::task_pointer
+ThreadPool::steal_from_linked_pools()
+{
+    auto _max = m_help_max->load(std::memory_order_relaxed);
+    if(m_helping->load() >= ((_max == 0) ? m_pool_size->load() : _max))
+        return nullptr;
+
+    // holding the snapshot keeps the linked pools from being destroyed while their
+    // queues are accessed: unlinking waits for the snapshots to be released
+    auto _donors  = std::atomic_load(&m_donors);
+    auto _backlog = m_help_backlog->load(std::memory_order_relaxed);
+    for(auto* itr : *_donors)
+    {
+        auto* _queue = itr->m_task_queue;
+        if(!_queue || itr->m_tbb_tp || !itr->m_alive_flag->load() ||
+           itr->m_pool_state->load() != thread_pool::state::STARTED ||
+           itr->m_thread_awake->load() < itr->m_pool_size->load() ||
+           _queue->size() < _backlog)
+            continue;
+        auto _task = _queue->StealTask();
+        if(_task)
+        {
+            ++(*m_helping);
+            return _task;
+        }
+    }
+    return nullptr;
+}
+
+//======================================================================================//
+
+bool
+ThreadPool::help_linked_pools()
+{
+    if(!m_has_donors->load(std::memory_order_relaxed))
+        return false;
+
+    m_help_requested->store(false);
+
+    // tasks of this pool always come first
+    bool _helped = false;
+    while(m_task_queue && m_task_queue->empty() &&
+          m_pool_state->load() == thread_pool::state::STARTED)
+    {
+        auto _task = steal_from_linked_pools();
+        if(!_task)
+            break;
+        TaskTracer::record(TaskTracer::steal, _task.get(), _task->label());
+        TaskHooks::notify(TaskHooks::steal, _task.get());
+        run_task(thread_data(), _task.get());
+        --(*m_helping);
+        _helped = true;
+    }
+    return _helped;
+}
+
+//======================================================================================//
+
+ThreadPool::size_type
+ThreadPool::broadcast(broadcast_func_t&& _func, const std::set<std::thread::id>* _tids)
+{
+#if defined(PTL_USE_TBB)
+    if(m_tbb_tp && m_tbb_task_group)
+        return tbb_broadcast(_func, _tids);
+#endif
+
+    bool _targeted = (!_tids || _tids->count(ThisThread::get_id()) > 0);
+    if(!m_alive_flag->load())
+    {
+        if(!_targeted)
+            return 0;
+        _func();
+        return 1;
+    }
+
+    auto _count  = std::make_shared<std::atomic<size_type>>(0);
+    auto _shared = std::make_shared<broadcast_func_t>(std::move(_func));
+    auto _exec   = std::make_shared<broadcast_func_t>([_shared, _count]() {
+        (*_shared)();
+        ++(*_count);
+    });
+
+    ThreadData* _data   = ThreadData::GetInstance();
+    bool        _worker = (_data && _data->thread_pool == this && !_data->is_main &&
+                           !_data->is_attached);
+
+    // one broadcast at a time: a worker executes the pending broadcast while waiting.
+    // Every targeted worker registered at this point executes the function once, the
+    // calling worker executes it directly. The workers which are not targeted skip it
+    // and are not waited on
+    {
+        AutoLock _lk(*m_broadcast_mutex);
+        while(m_broadcast_busy)
+        {
+            if(_worker && _data->broadcast_seen != m_broadcast_gen->load())
+            {
+                _lk.unlock();
+                run_broadcast(_data);
+                _lk.lock();
+                continue;
+            }
+            m_broadcast_cond->wait(_lk);
+        }
+        m_broadcast_busy = true;
+
+        // the targeted workers other than the calling one
+        size_type _n = 0;
+        for(const auto& itr : m_broadcast_workers)
+        {
+            bool _self = (_worker && itr == ThisThread::get_id());
+            if(!_self && (!_tids || _tids->count(itr) > 0))
+                ++_n;
+        }
+        m_broadcast_func = _exec;
+        m_broadcast_tids = _tids;
+        m_broadcast_left->store(_n);
+        auto _gen = ++(*m_broadcast_gen);
+        if(_worker)
+            _data->broadcast_seen = _gen;
+    }
+
+    notify_all();
+    // a thread outside of the pool only executes a broadcast which targets it
+    if((_worker || _tids) && _targeted)
+        (*_exec)();
+
+    // the workers check for the broadcast between tasks and the last one signals
+    AutoLock _lk(*m_broadcast_mutex);
+    while(m_broadcast_left->load() > 0)
+        m_broadcast_cond->wait(_lk);
+    m_broadcast_func.reset();
+    m_broadcast_tids = nullptr;
+    m_broadcast_busy = false;
+    m_broadcast_cond->notify_all();
+    return _count->load();
+}
+
+//======================================================================================//
+
+bool
+ThreadPool::run_broadcast(ThreadData* _data, bool _leave)
+{
+    std::shared_ptr<broadcast_func_t> _func{};
+    {
+        AutoLock _lk(*m_broadcast_mutex);
+        // a thread leaving the pool is not part of the later broadcasts
+        if(_leave)
+            m_broadcast_workers.erase(ThisThread::get_id());
+        auto _gen = m_broadcast_gen->load();
+        if(_data->broadcast_seen == _gen)
+            return false;
+        _data->broadcast_seen = _gen;
+        // the broadcast is over or does not target the thread, which is not waited on
+        if(!m_broadcast_func ||
+           (m_broadcast_tids && m_broadcast_tids->count(ThisThread::get_id()) == 0))
+            return false;
+        _func = m_broadcast_func;
+    }
+
+    ScopeDestructor _dtor{ [this]() {
+        if(--(*m_broadcast_left) == 0)
+        {
+            AutoLock _lk(*m_broadcast_mutex);
+            m_broadcast_cond->notify_all();
+        }
+    } };
+    (*_func)();
+    return true;
+}
+
+//======================================================================================//
+
+void
+ThreadPool::leave_broadcasts(ThreadData* _data)
+{
+    // a broadcast which started before the thread left still counts on it
+    run_broadcast(_data, true);
+}
+
+//======================================================================================//
+
+bool
+ThreadPool::attach()
+{
+    if(m_tbb_tp || !m_alive_flag->load())
+        return false;
+
+    ThreadData*& _data = thread_data();
+    if(_data && _data->thread_pool == this && !_data->is_main)
+        return false;
+
+    // the attached thread is not the main thread of the pool: it executes the tasks
+    // while waiting on a task group
+    auto _attached         = std::make_shared<ThreadData>(this);
+    _attached->is_main     = false;
+    _attached->is_attached = true;
+    get_this_thread_id();
+
+    AutoLock _lk(*m_attach_lock);
+    // its slot (i.e. its bin modulo the number of bins) is the first one past the
+    // slots of the workers which no other attached thread holds
+    std::set<intmax_t> _taken{};
+    for(const auto& itr : m_attached)
+        _taken.insert(itr.second.second->worker_slot.load(std::memory_order_relaxed));
+    intmax_t _slot = 0;
+    {
+        AutoLock _slot_lk(*m_slot_lock);
+        _slot = static_cast<intmax_t>(m_worker_slots.size()) + 1;
+    }
+    while(_taken.count(_slot) > 0)
+        ++_slot;
+    _attached->worker_slot.store(_slot, std::memory_order_relaxed);
+
+    m_attached[ThisThread::get_id()] = attached_data_t{ _data, _attached };
+    _data                            = _attached.get();
+    return true;
+}
+
+//======================================================================================//
+
+void
+ThreadPool::detach()
+{
+    AutoLock _lk(*m_attach_lock);
+    auto     itr = m_attached.find(ThisThread::get_id());
+    if(itr == m_attached.end())
+        return;
+    thread_data() = itr->second.first;
+    m_attached.erase(itr);
+}
+
+//======================================================================================//
+
+bool
+ThreadPool::execute_attached_task()
+{
+    ThreadData* _data = thread_data();
+    if(!_data || _data->thread_pool != this || !_data->is_attached ||
+       !m_alive_flag->load())
+        return false;
+
+    drain_inbox();
+
+    bool _within       = _data->within_task;
+    _data->within_task = true;
+    ScopeDestructor _restore{ [_data, _within]() { _data->within_task = _within; } };
+
+    if(execute_arena_task(true))
+        return true;
+
+    auto* _task_queue = get_valid_queue(m_task_queue);
+    if(_task_queue->empty())
+        return false;
+
+    auto _task = _task_queue->GetTask();
+    if(!_task)
+        return false;
+    run_task(_data, _task.get());
+    return true;
+}
+
+//======================================================================================//
+
+void
+ThreadPool::wait_attached_task(std::chrono::milliseconds _timeout)
+{
+    // parks like an idle worker so that a submitted task wakes the thread up
+    Condition _park{};
+    auto      _until = std::chrono::steady_clock::now() + _timeout;
+    auto      _wake  = [this]() {
+        return (!get_valid_queue(m_task_queue)->empty() || !m_inbox->empty() ||
+                arena_ready() || m_pool_state->load() == thread_pool::state::STOPPED);
+    };
+    AutoLock _task_lock(*m_task_lock);
+    // the notification may have been meant for a worker and the thread may return
+    // from execute_until() without executing the task so it is passed on
+    if(m_task_cond->wait_until(_task_lock, _park, _until, _wake))
+        m_task_cond->notify_one();
+}
+
+//======================================================================================//
+
+ThreadPool::statistics_t
+ThreadPool::get_statistics() const
+{
+    statistics_t _v{};
+    AutoLock     _lk(TypeMutex<ThreadPool>());
+    _v.reserve(m_thread_data.size());
+    for(const auto& itr : m_thread_data)
+    {
+        _v.emplace_back(itr->statistics.snapshot());
+        auto _base = m_statistics_base.find(itr.get());
+        if(_base != m_statistics_base.end())
+            _v.back() -= _base->second;
+    }
+    return _v;
+}
+
+//======================================================================================//
+
+void
+ThreadPool::reset_statistics()
+{
+    // the counters are only written by their threads so the current counts become the
+    // base of the later snapshots instead
+    AutoLock _lk(TypeMutex<ThreadPool>());
+    for(const auto& itr : m_thread_data)
+    {
+        m_statistics_base[itr.get()] = itr->statistics.snapshot();
+        m_label_base[itr.get()]      = itr->statistics.label_snapshot();
+        itr->latency.reset();
+    }
+}
+
+//======================================================================================//
+
+std::vector<TaskLatency>
+ThreadPool::get_worker_latencies() const
+{
+    std::vector<TaskLatency> _v{};
+    AutoLock                 _lk(TypeMutex<ThreadPool>());
+    _v.reserve(m_thread_data.size());
+    for(const auto& itr : m_thread_data)
+        _v.emplace_back(itr->latency);
+    return _v;
+}
+
+//======================================================================================//
+
+std::vector<LabelStatistics>
+ThreadPool::get_label_statistics() const
+{
+    std::vector<LabelStatistics> _v{};
+    {
+        // the labels are interned so the address of a label is its id
+        std::unordered_map<const TaskLabel*, size_t> _index{};
+        AutoLock                                     _lk(TypeMutex<ThreadPool>());
+        for(const auto& titr : m_thread_data)
+        {
+            for(const auto& itr : titr->statistics.label_snapshot())
+            {
+                auto _ins = _index.emplace(itr.label, _v.size());
+                if(_ins.second)
+                {
+                    _v.emplace_back(itr);
+                    continue;
+                }
+                auto& _entry = _v.at(_ins.first->second);
+                _entry.tasks_executed += itr.tasks_executed;
+                _entry.busy_time += itr.busy_time;
+            }
+        }
+
+        // the counts at the last reset (which are never larger than the current ones)
+        for(const auto& titr : m_label_base)
+        {
+            for(const auto& itr : titr.second)
+            {
+                auto& _entry = _v.at(_index.at(itr.label));
+                _entry.tasks_executed -= itr.tasks_executed;
+                _entry.busy_time -= itr.busy_time;
+            }
+        }
+    }
+    _v.erase(std::remove_if(_v.begin(), _v.end(),
+                            [](const LabelStatistics& itr) {
+                                return itr.tasks_executed == 0;
+                            }),
+             _v.end());
+    std::sort(_v.begin(), _v.end(),
+              [](const LabelStatistics& lhs, const LabelStatistics& rhs) {
+                  return lhs.busy_time > rhs.busy_time;
+              });
+    return _v;
+}
+
+//======================================================================================//
+
+TaskLatency
+ThreadPool::get_latency() const
+{
+    TaskLatency _v{};
+    AutoLock    _lk(TypeMutex<ThreadPool>());
+    for(const auto& itr : m_thread_data)
+        _v.merge(itr->latency);
+    return _v;
+}
+
+//======================================================================================//
+
+ThreadPool::size_type
+ThreadPool::drain_inbox()
+{
+    // the inbox has a single consumer: the other workers skip it while it is drained
+    if(m_inbox->empty() || m_inbox_draining->exchange(true, std::memory_order_acquire))
+        return 0;
+
+    // a batch per drain keeps the draining worker from starving its own tasks
+    static constexpr size_type max_batch = 64;
+
+    VUserTaskQueue::task_list_t _tasks{};
+    _tasks.reserve(std::min<size_type>(m_inbox->size(), max_batch));
+    while(_tasks.size() < max_batch)
+    {
+        auto _task = m_inbox->pop();
+        if(!_task)
+            break;
+        _tasks.emplace_back(std::move(_task));
+    }
+    m_inbox_draining->store(false, std::memory_order_release);
+
+    auto _n = get_valid_queue(m_task_queue)->InsertTasks(std::move(_tasks));
+    // the draining worker picks up one of the tasks itself
+    if(_n > 1)
+        notify(_n - 1);
+    return _n;
+}
+
+//======================================================================================//
+
+ThreadPool::size_type
+ThreadPool::add_thread_task(ThreadId _tid, task_pointer&& _task)
+{
+    std::shared_ptr<TaskMailbox> _mailbox{};
+    {
+        // pushed under the lock so that the worker cannot close the mailbox between
+        // the look-up and the push
+        AutoLock _lk(*m_mailbox_lock);
+        auto     itr = m_mailboxes.find(_tid);
+        if(itr != m_mailboxes.end())
+        {
+            // recorded before the push, as insert() does, since the owner may execute
+            // the task as soon as it is pushed
+            TaskTracer::record(TaskTracer::enqueue, _task.get(), _task->label());
+            TaskHooks::notify(TaskHooks::enqueue, _task.get());
+            if(TaskLatency::enabled() && _task->submit_time() == 0)
+                _task->set_submit_time(TaskLatency::now());
+            _mailbox = itr->second;
+            _mailbox->push(std::move(_task));
+        }
+    }
+
+    if(_mailbox)
+    {
+        // only the owner is woken up (if it is idle), it checks its mailbox under the
+        // task lock before it parks
+        AutoLock _lk(*m_task_lock);
+        m_task_cond->notify(_mailbox->condition());
+        return 1;
+    }
+
+    if(_tid == ThisThread::get_id())
+    {
+        run_task(thread_data(), _task.get());
+        return 0;
+    }
+
+    std::stringstream ss;
+    ss << "[PTL::ThreadPool] " << __FUNCTION__ << " :: thread " << _tid
+       << " is not a worker of the thread-pool";
+    throw std::runtime_error(ss.str());
+}
+
+//======================================================================================//
+
+void
+ThreadPool::open_mailbox(ThreadData* _data)
+{
+    AutoLock _lk(*m_mailbox_lock);
+    auto     itr  = m_mailboxes.find(ThisThread::get_id());
+    _data->mailbox = (itr != m_mailboxes.end()) ? itr->second.get() : nullptr;
+}
+
+//======================================================================================//
+
+void
+ThreadPool::close_mailbox(ThreadData* _data)
+{
+    if(!_data->mailbox)
+        return;
+
+    std::shared_ptr<TaskMailbox> _mailbox{};
+    {
+        AutoLock _lk(*m_mailbox_lock);
+        auto     itr = m_mailboxes.find(ThisThread::get_id());
+        if(itr != m_mailboxes.end())
+        {
+            _mailbox = itr->second;
+            m_mailboxes.erase(itr);
+        }
+    }
+
+    // the tasks submitted before the mailbox was closed still run on this thread
+    run_mailbox(_data);
+    _data->mailbox = nullptr;
+}
+
+//======================================================================================//
+
+bool
+ThreadPool::run_mailbox(ThreadData* _data)
+{
+    bool _within       = _data->within_task;
+    bool _executed     = false;
+    _data->within_task = true;
+    while(task_pointer _task = _data->mailbox->pop())
+    {
+        run_task(_data, _task.get());
+        _executed = true;
+    }
+    _data->within_task = _within;
+    return _executed;
+}
+
+//======================================================================================//
+
+#if defined(PTL_USE_TBB)
+ThreadPool::size_type
+ThreadPool::tbb_broadcast(const broadcast_func_t&         _func,
+                          const std::set<std::thread::id>* _tids)
+{
+    // TBB lazily activates threads and a task cannot be directed to a specific thread:
+    // one task per thread is enqueued into the arena and each task blocks its thread
+    // at a barrier until all of them have started so that no thread takes two of
+    // them. If fewer threads join the arena, the barrier expires and the generation
+    // ensures a thread does not execute the function twice
+    auto*  _arena = get_task_arena();
+    size_t _maxp =
+        tbb::global_control::active_value(tbb::global_control::max_allowed_parallelism);
+    size_t _conc = static_cast<size_t>(std::max<int>(_arena->max_concurrency(), 2));
+    size_t _num  = std::max<size_t>(std::min<size_t>({ size(), _maxp, _conc - 1 }), 1);
+    auto   _gen  = ++tbb_broadcast_generation();
+    auto   _tid  = ThisThread::get_id();
+
+    size_type _executed = 0;
+    if(_tids && _tids->count(_tid) > 0)
+    {
+        _func();
+        ++_executed;
+    }
+    // the calling thread never executes it within the tasks
+    tbb_broadcast_seen() = _gen;
+
+    using clock_type = std::chrono::steady_clock;
+
+    Mutex     _mutex{};
+    Condition _cond{};
+    size_t    _arrived = 0;
+    size_t    _done    = 0;
+    auto      _expire  = clock_type::now() + std::chrono::milliseconds{ 100 };
+    auto      _task    = [&]() {
+        add_thread_id();
+        auto& _seen = tbb_broadcast_seen();
+        bool  _run  = (_seen != _gen);
+        if(_tids && _tids->count(ThisThread::get_id()) == 0)
+            _run = false;
+        _seen = _gen;
+        if(_run)
+            _func();
+
+        AutoLock _lk(_mutex);
+        if(_run)
+            ++_executed;
+        if(++_arrived >= _num)
+            _cond.notify_all();
+        else
+            _cond.wait_until(_lk, _expire, [&]() { return _arrived >= _num; });
+        // notified with the lock held since the caller owns the mutex and condition
+        if(++_done == _num)
+            _cond.notify_all();
+    };
+
+    for(size_t i = 0; i < _num; ++i)
+        _arena->enqueue(_task);
+
+    AutoLock _lk(_mutex);
+    _cond.wait(_lk, [&]() { return _done >= _num; });
+
+    auto _expected = (_tids) ? _tids->size() : _num;
+    if(get_verbose() > 3 || (get_verbose() > 0 && _executed < _expected))
+    {
+        AutoLock lock(TypeMutex<decltype(std::cerr)>());
+        std::cerr << "[PTL::ThreadPool] broadcast executed on " << _executed
+                  << " threads, expected: " << _num << ", size: " << size() << std::endl;
+    }
+    return _executed;
+}
+#endif
+
+//======================================================================================//
+
+void
+ThreadPool::acquire_worker_slot(ThreadData* _data)
+{
+    AutoLock _lk(*m_slot_lock);
+    m_worker_slots.emplace_back(_data);
+    _data->worker_slot.store(m_worker_slots.size(), std::memory_order_relaxed);
+}
+
+//======================================================================================//
+
+void
+ThreadPool::release_worker_slot(ThreadData* _data)
+{
+    AutoLock _lk(*m_slot_lock);
+    auto     _slot = _data->worker_slot.exchange(-1, std::memory_order_relaxed);
+    if(_slot < 1 || static_cast<size_t>(_slot) > m_worker_slots.size())
+        return;
+    // the last worker moves into the slot which was released
+    auto* _last                  = m_worker_slots.back();
+    m_worker_slots.at(_slot - 1) = _last;
+    m_worker_slots.pop_back();
+    if(_last != _data)
+        _last->worker_slot.store(_slot, std::memory_order_relaxed);
+}
+
+//======================================================================================//
+
+void
+ThreadPool::register_arena(TaskArena* _arena)
+{
+    AutoLock _lk(*m_arena_lock);
+    _arena->m_pass = m_arena_vtime->load();
+    _arena->m_queue->resize(std::max<intmax_t>(m_pool_size->load(), 1));
+    std::atomic_store(&m_arenas, list_with(std::atomic_load(&m_arenas), _arena));
+    m_has_arenas->store(true);
+}
+
+//======================================================================================//
+
+void
+ThreadPool::unregister_arena(TaskArena* _arena)
+{
+    // the workers acquire an arena before they release their snapshot so none starts
+    // a task of the arena once the snapshots are released
+    auto _arenas = list_without(std::atomic_load(&m_arenas), _arena);
+    m_has_arenas->store(!_arenas->empty());
+    wait_for_readers(std::atomic_exchange(&m_arenas, _arenas));
+}
+
+//======================================================================================//
+
+void
+ThreadPool::detach_arenas()
+{
+    // the arenas share m_arena_lock and only read m_pool while holding it
+    AutoLock _lk(*m_arena_lock);
+    for(auto* itr : *std::atomic_load(&m_arenas))
+        itr->m_pool = nullptr;
+    arena_list_ptr _none = std::make_shared<arena_list_t>();
+    m_has_arenas->store(false);
+    wait_for_readers(std::atomic_exchange(&m_arenas, _none));
+}
+
+//======================================================================================//
+
+void
+ThreadPool::resize_arenas()
+{
+    AutoLock _lk(*m_arena_lock);
+    for(auto* itr : *std::atomic_load(&m_arenas))
+        itr->m_queue->resize(std::max<intmax_t>(m_pool_size->load(), 1));
+}
+
+//======================================================================================//
+
+bool
+ThreadPool::arena_ready()
+{
+    if(!m_has_arenas->load(std::memory_order_relaxed))
+        return false;
+
+    auto _arenas = std::atomic_load(&m_arenas);
+    for(auto* itr : *_arenas)
+    {
+        if(itr->ready())
+            return true;
+    }
+    return false;
+}
+
+//======================================================================================//
+
+bool
+ThreadPool::execute_arena_task(bool _pool_ready)
+{
+    if(!m_has_arenas->load(std::memory_order_relaxed))
+        return false;
+
+    // stride scheduling: the queue which received the least service relative to its
+    // weight is served next. A queue which was idle resumes at the virtual time, i.e.
+    // it does not make up for the time it was idle. The passes are atomics so the
+    // workers choose concurrently and the shares are only approximate while they do
+    const uintmax_t _stride = (1 << 20);
+    TaskArena*      _arena  = nullptr;
+    {
+        // the snapshot keeps the arenas from being destroyed until one is acquired
+        auto      _arenas = std::atomic_load(&m_arenas);
+        uintmax_t _pass   = 0;
+        do
+        {
+            const uintmax_t _vtime = m_arena_vtime->load(std::memory_order_relaxed);
+            _arena                 = nullptr;
+            _pass                  = std::numeric_limits<uintmax_t>::max();
+            if(_pool_ready)
+                _pass = fetch_max(*m_pool_pass, _vtime);
+            for(auto* itr : *_arenas)
+            {
+                if(!itr->ready())
+                    continue;
+                auto _v = fetch_max(itr->m_pass, _vtime);
+                if(_v < _pass)
+                {
+                    _pass  = _v;
+                    _arena = itr;
+                }
+            }
+
+            if(!_arena)
+            {
+                // the queue of the pool is served
+                if(_pool_ready)
+                {
+                    fetch_max(*m_arena_vtime, _pass);
+                    m_pool_pass->fetch_add(_stride);
+                }
+                return false;
+            }
+            // another worker reached the concurrency limit of the arena first
+        } while(!_arena->acquire());
+
+        fetch_max(*m_arena_vtime, _pass);
+        _arena->m_pass += _stride / _arena->m_weight.load();
+    }
+
+    auto _task = _arena->m_queue->GetTask();
+    if(_task)
+    {
+        ThreadData* _data   = ThreadData::GetInstance();
+        bool        _within = (_data) ? _data->within_task : false;
+        if(_data)
+            _data->within_task = true;
+        _arena->execute([_data, &_task]() { run_task(_data, _task.get()); });
+        if(_data)
+            _data->within_task = _within;
+    }
+    _arena->release();
+    return (_task != nullptr);
+}
+
+//======================================================================================//
+
+ThreadPool::task_queue_t*&
+ThreadPool::get_valid_queue(task_queue_t*& _queue) const
+{
+    if(!_queue)
+        _queue = new UserTaskQueue{ static_cast<intmax_t>(m_pool_size->load()) };
+    return _queue;
+}
+//======================================================================================//
+
+void
+ThreadPool::execute_thread(VUserTaskQueue* _task_queue)
+{
+    // how long the thread waits on condition variable
+    // static int wait_time = GetEnv<int>("PTL_POOL_WAIT_TIME", 5);
+
+    ++(*m_thread_awake);
+
+    // the bin of the worker in the queue, kept until it leaves the broadcasts
+    ThreadData* data = thread_data();
+    acquire_worker_slot(data);
+    ScopeDestructor _slot{ [this, data]() { release_worker_slot(data); } };
+
+    // take part in the broadcasts until the thread leaves the pool
+    ScopeDestructor _bcast{ [this, data]() { leave_broadcasts(data); } };
+
+    // initialization function
+    m_init_func();
+    // finalization function (executed when scope is destroyed)
+    ScopeDestructor _fini{ [this]() { m_fini_func(); } };
+    // the tasks for this thread which remain are executed before finalization
+    open_mailbox(data);
+    ScopeDestructor _mbox{ [this, data]() { close_mailbox(data); } };
+
+    ThreadId tid = ThisThread::get_id();
+    // auto        thread_bin = _task_queue->GetThreadBin();
+    // auto        workers    = _task_queue->workers();
+
+    auto start   = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::duration<double>{};
+    // check for updates for 60 seconds max
+    while(!_task_queue && elapsed.count() < 60)
+    {
+        elapsed = std::chrono::steady_clock::now() - start;
+        data->update();
+        _task_queue = data->current_queue;
+    }
+
+    if(!_task_queue)
+    {
+        --(*m_thread_awake);
+        throw std::runtime_error("No task queue was found after 60 seconds!");
+    }
+
+    assert(data->current_queue != nullptr);
+    assert(_task_queue == data->current_queue);
+
+    // essentially a dummy run
+    if(_task_queue)
+    {
+        data->within_task = true;
+        auto _task        = _task_queue->GetTask();
+        if(_task)
+            run_task(data, _task.get());
+        data->within_task = false;
+    }
+
+    auto p_task_lock = m_task_lock;
+    // the worker parks on the condition of its mailbox so that a task submitted for it
+    // wakes only this worker
+    Condition  _no_mailbox{};
+    Condition& _park = (data->mailbox) ? data->mailbox->condition() : _no_mailbox;
+
+    // threads stay in this loop forever until thread-pool destroyed
+    while(true)
+    {
+        //--------------------------------------------------------------------//
+        // Try to pick a task
+        AutoLock _task_lock(*p_task_lock, std::defer_lock);
+        //--------------------------------------------------------------------//
+
+        auto leave_pool = [&]() {
+            auto _state      = [&]() { return static_cast<int>(m_pool_state->load()); };
+            auto _pool_state = _state();
+            if(_pool_state > 0)
+            {
+                // stop whole pool
                 if(_pool_state == thread_pool::state::STOPPED)
                 {
                     if(_task_lock.owns_lock())
@@ -844,6 +2220,16 @@ ThreadPool::execute_thread(VUserTaskQueue* _task_queue)
                     {
                         m_stop_threads.push_back(tid);
                         m_is_stopped.pop_back();
+                        // the last pending request puts the pool back to started
+                        short _partial = thread_pool::state::PARTIAL;
+                        if(m_is_stopped.empty())
+                            m_pool_state->compare_exchange_strong(
+                                _partial, thread_pool::state::STARTED);
+                        // let a remaining thread take over waiting on the timers
+                        if(!m_timers->empty())
+                            m_task_cond->notify_all();
+                        if(m_thread_awake->load() > 0)
+                            --(*m_thread_awake);
                         if(_task_lock.owns_lock())
                             _task_lock.unlock();
                         // exit entire function
@@ -867,11 +2253,42 @@ ThreadPool::execute_thread(VUserTaskQueue* _task_queue)
             auto _state = [&]() { return static_cast<int>(m_pool_state->load()); };
             auto _size  = [&]() { return _task_queue->true_size(); };
             auto _empty = [&]() { return _task_queue->empty(); };
-            auto _wake  = [&]() { return (!_empty() || _size() > 0 || _state() > 0); };
+            auto _bcast = [&]() {
+                return (data->broadcast_seen != m_broadcast_gen->load());
+            };
+            auto _mail  = [&]() { return (data->mailbox && !data->mailbox->empty()); };
+            auto _wake  = [&]() {
+                return (!_empty() || _size() > 0 || _state() > 0 || _bcast() ||
+                        _mail() || !m_inbox->empty() || arena_ready());
+            };
 
             if(leave_pool())
                 return;
 
+            // execute the function of a broadcast
+            if(poll_broadcast())
+                continue;
+
+            // execute the tasks submitted for this thread
+            if(_mail() && run_mailbox(data))
+                continue;
+
+            // move the tasks submitted from outside of the pool into the queue
+            if(drain_inbox() > 0)
+                continue;
+
+            // move any expired timers into the queue
+            if(dispatch_timers() > 0)
+                continue;
+
+            // execute the tasks of the arenas
+            if(execute_arena_task(false))
+                continue;
+
+            // execute tasks of the linked pools which are falling behind
+            if(help_linked_pools())
+                continue;
+
             if(_task_queue->true_size() == 0)
             {
                 if(m_thread_awake->load() > 0)
@@ -884,17 +2301,63 @@ ThreadPool::execute_thread(VUserTaskQueue* _task_queue)
                 // Wait until there is a task in the queue
                 // Unlocks mutex while waiting, then locks it back when signaled
                 // use lambda to control waking
-                m_task_cond->wait(_task_lock, _wake);
+                // an elastic pool retires the thread if it stays idle for the linger
+                auto _linger   = (m_elastic && m_pool_size->load() > m_min_size)
+                                     ? timer_point_t::clock::now() + m_linger
+                                     : timer_point_t::max();
+                auto _deadline = m_timers->next_deadline();
+                auto _unkept   = [&]() {
+                    return (_wake() || m_help_requested->load() ||
+                            (!m_timers->empty() && !m_timer_keeper->load()));
+                };
+#if defined(PTL_USE_STATISTICS)
+                auto _parked = ThreadStatistics::clock_type::now();
+                data->statistics.add(ThreadStatistics::parks);
+#endif
+                TaskTracer::record(TaskTracer::park);
+                if(_deadline != timer_point_t::max() && !m_timer_keeper->exchange(true))
+                {
+                    // when timers are pending, one thread parks until the next
+                    // deadline (or until an earlier timer is added) so that the
+                    // other threads are not woken up for every expiration
+                    auto _rearm = [&]() {
+                        return (_wake() || m_timers->next_deadline() < _deadline);
+                    };
+                    m_timer_wait->store(_deadline.time_since_epoch().count());
+                    m_task_cond->wait_until(_task_lock, _park,
+                                            std::min(_deadline, _linger), _rearm);
+                    m_timer_wait->store(timer_point_t::max().time_since_epoch().count());
+                    m_timer_keeper->store(false);
+                }
+                else if(_linger != timer_point_t::max())
+                {
+                    m_task_cond->wait_until(_task_lock, _park, _linger, _unkept);
+                }
+                else
+                {
+                    m_task_cond->wait(_task_lock, _park, _unkept);
+                }
+
+                TaskTracer::record(TaskTracer::wake);
+#if defined(PTL_USE_STATISTICS)
+                data->statistics.add_elapsed(ThreadStatistics::idle_ns, _parked);
+                if(_wake())
+                    data->statistics.add(ThreadStatistics::wakeups);
+#endif
 
                 if(_state() == thread_pool::state::STOPPED)
                     return;
 
+                if(!_wake() && timer_point_t::clock::now() >= _linger &&
+                   retire_thread(tid))
+                    return;
+
                 // unlock if owned
                 if(_task_lock.owns_lock())
                     _task_lock.unlock();
 
                 // notify that is awake
-                if(m_thread_awake->load() < m_pool_size)
+                if(m_thread_awake->load() < m_pool_size->load())
                     ++(*m_thread_awake);
             }
             else
@@ -916,14 +2379,32 @@ ThreadPool::execute_thread(VUserTaskQueue* _task_queue)
         //----------------------------------------------------------------//
 
         // execute the task(s)
+        PTL_STATISTICS(auto _busy = ThreadStatistics::clock_type::now());
         while(!_task_queue->empty())
         {
-            auto _task = _task_queue->GetTask();
-            if(_task)
+            // the tasks submitted for this thread take priority over the bins
+            if(data->mailbox && !data->mailbox->empty())
+                run_mailbox(data);
+
+            // keep the external submissions flowing while the queue is busy
+            drain_inbox();
+
+            // the queue of the pool and the arenas are served according to the weights
+            if(!execute_arena_task(true))
             {
-                (*_task)();
+                auto _task = _task_queue->GetTask();
+                if(_task)
+                    run_task(data, _task.get());
             }
+            poll_broadcast();
+            dispatch_timers();
+            if(m_elastic)
+                grow_if_backlogged();
+            // a backlog remaining while every worker is busy is shared
+            if(m_has_helpers->load(std::memory_order_relaxed) && !_task_queue->empty())
+                request_help();
         }
+        PTL_STATISTICS(data->statistics.add_elapsed(ThreadStatistics::busy_ns, _busy));
         //----------------------------------------------------------------//
 
         // disable guard against recursive deadlock
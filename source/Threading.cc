@@ -23,6 +23,7 @@
 //
 
 #include "PTL/Threading.hh"
+#include "PTL/Topology.hh"
 #include "PTL/Types.hh"
 #include "PTL/Utility.hh"
 
@@ -34,10 +35,6 @@
 #    include <sys/sysctl.h>
 #endif
 
-#if defined(PTL_LINUX)
-#    include <fstream>
-#endif
-
 using namespace PTL;
 
 //======================================================================================//
@@ -76,34 +73,9 @@ Threading::GetNumberOfPhysicalCpus()
     sysctlbyname("hw.physicalcpu", &count, &count_len, nullptr, 0);
     return static_cast<unsigned>(count);
 #elif defined(PTL_LINUX)
-    unsigned      core_id_count = 0;
-    std::ifstream ifs("/proc/cpuinfo");
-    if(ifs)
-    {
-        std::set<std::string> core_ids;
-        while(true)
-        {
-            std::string line = {};
-            getline(ifs, line);
-            if(!ifs.good())
-                break;
-            if(line.find("core id") != std::string::npos)
-            {
-                for(std::string itr : { "core id", ":", " ", "\t" })
-                {
-                    static auto _npos = std::string::npos;
-                    auto        _pos  = _npos;
-                    while((_pos = line.find(itr)) != _npos)
-                        line = line.replace(_pos, itr.length(), "");
-                }
-                core_ids.insert(line);
-            }
-        }
-        core_id_count = static_cast<unsigned>(core_ids.size());
-        if(core_id_count > 0)
-            return core_id_count;
-    }
-    return GetNumberOfCores();
+    // all the cores of the machine, not only the ones in the affinity mask
+    static unsigned _n = static_cast<unsigned>(Topology::discover().num_cores());
+    return _n;
 #else
     return GetNumberOfCores();
 #endif
@@ -0,0 +1,376 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//
+// ---------------------------------------------------------------
+//  Tasking class implementation
+//
+// Class Description:
+//
+// This file implements the hierarchical timer wheel used by ThreadPool
+// for delayed and periodic tasks
+//
+// ---------------------------------------------------------------
+
+#include "PTL/TimerWheel.hh"
+
+#include "PTL/AutoLock.hh"
+#include "PTL/Utility.hh"
+
+#include <algorithm>
+#include <exception>
+
+//======================================================================================//
+
+namespace PTL
+{
+//======================================================================================//
+
+void
+internal::timer_task::operator()()
+{
+    // there is no future to carry an exception so it goes to the handler of the wheel
+    if(!m_handler)
+    {
+        m_func();
+        return;
+    }
+
+    try
+    {
+        m_func();
+    } catch(...)
+    {
+        (*m_handler)(m_id, std::current_exception());
+    }
+}
+
+//======================================================================================//
+
+constexpr size_t TimerWheel::num_levels;
+constexpr size_t TimerWheel::root_bits;
+constexpr size_t TimerWheel::level_bits;
+constexpr size_t TimerWheel::root_slots;
+constexpr size_t TimerWheel::level_slots;
+
+//======================================================================================//
+
+namespace
+{
+// bit offset of the ticks covered by a level of the wheel
+inline size_t
+level_shift(size_t _level)
+{
+    return (_level == 0) ? 0
+                         : TimerWheel::root_bits + (_level - 1) * TimerWheel::level_bits;
+}
+}  // namespace
+
+//======================================================================================//
+
+TimerWheel::duration
+TimerWheel::default_resolution()
+{
+    static auto _v = GetEnv<int64_t>("PTL_TIMER_RESOLUTION_US", 1000);
+    return std::chrono::duration_cast<duration>(
+        std::chrono::microseconds{ std::max<int64_t>(_v, 1) });
+}
+
+//======================================================================================//
+
+TimerWheel::TimerWheel(duration _resolution)
+: m_resolution{ std::max<duration>(_resolution, duration{ 1 }) }
+{
+    m_levels[0].resize(root_slots);
+    for(size_t i = 1; i < num_levels; ++i)
+        m_levels[i].resize(level_slots);
+}
+
+//======================================================================================//
+
+TimerWheel::~TimerWheel()
+{
+    purge();
+}
+
+//======================================================================================//
+
+TimerWheel::timer_id
+TimerWheel::schedule(time_point _when, duration _period, function_type&& _func)
+{
+    auto* _entry = new entry{};
+    _entry->id   = ++m_counter;
+    _entry->func = std::make_shared<function_type>(std::move(_func));
+    if(_period > duration::zero())
+    {
+        auto _r        = m_resolution.count();
+        _entry->period = std::max<tick_type>((_period.count() + _r - 1) / _r, 1);
+    }
+
+    AutoLock _lk{ m_mutex };
+    // nothing is live so restart the wheel at the current time instead of walking
+    // through all the ticks that passed while it was idle
+    if(m_entries.empty())
+    {
+        purge();
+        m_current = std::max(m_current, to_tick(clock_type::now(), false));
+        m_next.store(~tick_type{ 0 }, std::memory_order_relaxed);
+    }
+
+    _entry->expiry = std::max(to_tick(_when, true), m_current);
+    m_entries.emplace(_entry->id, _entry);
+    ++m_size;
+
+    auto _due = place(_entry);
+    // sequentially consistent so the pool sees either this deadline or the deadline
+    // of the thread parked on the timers
+    if(_due < m_next.load(std::memory_order_relaxed))
+        m_next.store(_due);
+
+    return _entry->id;
+}
+
+//======================================================================================//
+
+bool
+TimerWheel::cancel(timer_id _id)
+{
+    AutoLock _lk{ m_mutex };
+    auto     itr = m_entries.find(_id);
+    if(itr == m_entries.end())
+        return false;
+    // the entry is released when the wheel reaches its slot
+    itr->second->cancelled = true;
+    m_entries.erase(itr);
+    --m_size;
+    return true;
+}
+
+//======================================================================================//
+
+TimerWheel::size_type
+TimerWheel::advance(time_point _now, task_list_t& _tasks)
+{
+    AutoLock _lk{ m_mutex, std::try_to_lock };
+    if(!_lk.owns_lock())
+        return 0;
+
+    auto _n      = _tasks.size();
+    auto _target = to_tick(_now, false);
+    auto _next   = m_next.load(std::memory_order_relaxed);
+
+    while(m_current <= _target && !m_entries.empty())
+    {
+        // no slot holds anything before the next deadline so skip straight to it
+        if(m_current < _next)
+        {
+            m_current = std::min(_next, _target + 1);
+            continue;
+        }
+
+        // move entries from the outer levels to the inner levels before expiring
+        for(size_t i = num_levels - 1; i > 0; --i)
+        {
+            if((m_current & ((tick_type{ 1 } << level_shift(i)) - 1)) == 0)
+                cascade(i);
+        }
+
+        expire(_tasks);
+        ++m_current;
+        _next = compute_next();
+    }
+
+    if(m_entries.empty())
+        _next = ~tick_type{ 0 };
+    m_next.store(_next, std::memory_order_release);
+
+    return _tasks.size() - _n;
+}
+
+//======================================================================================//
+
+void
+TimerWheel::set_error_handler(error_handler _func)
+{
+    AutoLock _lk{ m_mutex };
+    if(_func)
+        m_on_error = std::make_shared<const error_handler>(std::move(_func));
+    else
+        m_on_error.reset();
+}
+
+//======================================================================================//
+
+TimerWheel::tick_type
+TimerWheel::place(entry* _entry)
+{
+    auto _expiry = std::max(_entry->expiry, m_current);
+    if(_expiry - m_current < root_slots)
+    {
+        m_levels[0][_expiry & (root_slots - 1)].emplace_back(_entry);
+        return _expiry;
+    }
+
+    // outer levels are due when the slot is cascaded into the inner levels
+    for(size_t i = 1; i < num_levels; ++i)
+    {
+        auto _shift = level_shift(i);
+        if((_expiry >> _shift) - (m_current >> _shift) < level_slots)
+        {
+            m_levels[i][(_expiry >> _shift) & (level_slots - 1)].emplace_back(_entry);
+            return (_expiry >> _shift) << _shift;
+        }
+    }
+
+    auto _shift = level_shift(num_levels - 1);
+    m_overflow.emplace_back(_entry);
+    return ((m_current >> _shift) + 1) << _shift;
+}
+
+//======================================================================================//
+
+void
+TimerWheel::cascade(size_t _level)
+{
+    auto _shift = level_shift(_level);
+
+    slot_type _slot{};
+    std::swap(_slot, m_levels[_level][(m_current >> _shift) & (level_slots - 1)]);
+    // the overflow list is re-examined every time the outermost level turns over
+    if(_level + 1 == num_levels)
+    {
+        _slot.insert(_slot.end(), m_overflow.begin(), m_overflow.end());
+        m_overflow.clear();
+    }
+
+    for(auto* itr : _slot)
+    {
+        if(itr->cancelled)
+            delete itr;
+        else
+            place(itr);
+    }
+}
+
+//======================================================================================//
+
+void
+TimerWheel::expire(task_list_t& _tasks)
+{
+    slot_type _slot{};
+    std::swap(_slot, m_levels[0][m_current & (root_slots - 1)]);
+
+    for(auto* itr : _slot)
+    {
+        if(itr->cancelled)
+        {
+            delete itr;
+            continue;
+        }
+
+        if(itr->period == 0)
+        {
+            // one-shot timers hand their function over to the task
+            auto _func = std::move(itr->func);
+            _tasks.emplace_back(std::make_shared<internal::timer_task>(
+                [_func]() { (*_func)(); }, itr->id, m_on_error));
+            m_entries.erase(itr->id);
+            --m_size;
+            delete itr;
+        }
+        else
+        {
+            // periodic timers are re-armed relative to when they were due, not when
+            // the wheel got around to them, so the period does not drift
+            auto _func = itr->func;
+            _tasks.emplace_back(std::make_shared<internal::timer_task>(
+                [_func]() { (*_func)(); }, itr->id, m_on_error));
+            itr->expiry = std::max(itr->expiry + itr->period, m_current + 1);
+            place(itr);
+        }
+    }
+}
+
+//======================================================================================//
+
+void
+TimerWheel::purge()
+{
+    for(auto& litr : m_levels)
+    {
+        for(auto& sitr : litr)
+        {
+            for(auto* itr : sitr)
+                delete itr;
+            sitr.clear();
+        }
+    }
+    for(auto* itr : m_overflow)
+        delete itr;
+    m_overflow.clear();
+}
+
+//======================================================================================//
+
+TimerWheel::tick_type
+TimerWheel::compute_next() const
+{
+    auto _next = ~tick_type{ 0 };
+
+    // the inner level holds the exact expiry ticks
+    for(tick_type i = 0; i < root_slots; ++i)
+    {
+        if(!m_levels[0][(m_current + i) & (root_slots - 1)].empty())
+        {
+            _next = m_current + i;
+            break;
+        }
+    }
+
+    // the outer levels are due when their slot is cascaded and a cascade can not be
+    // skipped even if the inner level has an earlier expiry after it
+    for(size_t l = 1; l < num_levels; ++l)
+    {
+        auto _shift = level_shift(l);
+        auto _base  = (m_current >> _shift);
+        for(tick_type i = 0; i < level_slots; ++i)
+        {
+            auto _boundary = (_base + i) << _shift;
+            if(_boundary >= _next)
+                break;
+            if(_boundary >= m_current &&
+               !m_levels[l][(_base + i) & (level_slots - 1)].empty())
+            {
+                _next = _boundary;
+                break;
+            }
+        }
+    }
+
+    if(!m_overflow.empty())
+    {
+        auto _shift = level_shift(num_levels - 1);
+        _next       = std::min(_next, ((m_current >> _shift) + 1) << _shift);
+    }
+
+    return _next;
+}
+
+//======================================================================================//
+
+}  // namespace PTL
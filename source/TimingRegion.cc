@@ -0,0 +1,377 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+// ---------------------------------------------------------------
+//  Tasking class implementation
+//
+// Class Description:
+//
+// This file implements the calibration of the CycleClock, the per-thread
+// tables of the timing regions and their reporters
+//
+// ---------------------------------------------------------------
+
+#include "PTL/TimingRegion.hh"
+
+#include "PTL/AutoLock.hh"
+#include "PTL/ThreadPool.hh"
+#include "PTL/Threading.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <unordered_map>
+
+namespace PTL
+{
+namespace
+{
+using clock_type = std::chrono::steady_clock;
+
+//--------------------------------------------------------------------------------------//
+// the start of the calibration interval of the CycleClock, taken when the library is
+// loaded so the interval has usually passed when the rate is needed
+//
+struct calibration_origin
+{
+    uint64_t               ticks = CycleClock::now();
+    clock_type::time_point time  = clock_type::now();
+};
+
+const calibration_origin&
+origin()
+{
+    static calibration_origin _v{};
+    return _v;
+}
+
+const calibration_origin& load_origin = origin();
+
+//--------------------------------------------------------------------------------------//
+// the regions of a thread: the index is only used by the owning thread and the lock
+// guards the growth of the entries against the threads which merge them
+//
+struct timing_table
+{
+    using entry_type = internal::timing_entry;
+
+    explicit timing_table(uintmax_t _tid)
+    : tid{ _tid }
+    {}
+
+    Mutex                                        mutex{};
+    std::deque<entry_type>                       entries{};
+    std::unordered_map<const char*, entry_type*> index{};
+    uintmax_t                                    tid = 0;
+};
+
+struct timing_state
+{
+    Mutex                                      mutex{};
+    std::vector<std::shared_ptr<timing_table>> tables{};
+    // the regions of the exited threads merged by name
+    std::map<std::string, TimingResult> retired{};
+};
+
+//--------------------------------------------------------------------------------------//
+// never deleted: the regions of the threads which outlive the statics remain valid
+//
+timing_state&
+state()
+{
+    static auto* _instance = new timing_state{};
+    return *_instance;
+}
+
+//--------------------------------------------------------------------------------------//
+// adds the region of a thread (or the merged regions of several threads) to _v
+//
+void
+merge(TimingResult& _v, const TimingResult& _rhs)
+{
+    _v.min = (_v.count == 0) ? _rhs.min : std::min(_v.min, _rhs.min);
+    _v.max = std::max(_v.max, _rhs.max);
+    _v.count += _rhs.count;
+    _v.total += _rhs.total;
+    _v.threads += _rhs.threads;
+}
+
+// the region of one thread, the table of the entry is locked by the caller
+TimingResult
+get_result(const internal::timing_entry& _entry)
+{
+    TimingResult _v{};
+    _v.count   = _entry.count.load(std::memory_order_relaxed);
+    _v.total   = CycleClock::seconds(_entry.ticks.load(std::memory_order_relaxed));
+    _v.min     = CycleClock::seconds(_entry.min.load(std::memory_order_relaxed));
+    _v.max     = CycleClock::seconds(_entry.max.load(std::memory_order_relaxed));
+    _v.threads = 1;
+    return _v;
+}
+
+//--------------------------------------------------------------------------------------//
+
+thread_local timing_table* tl_table = nullptr;
+
+// merges the regions of the thread into the retired regions and releases its table
+// when it exits
+struct timing_table_releaser
+{
+    ~timing_table_releaser()
+    {
+        if(!tl_table)
+            return;
+        auto&    _state = state();
+        AutoLock _lk(_state.mutex);
+        auto     itr = std::find_if(
+            _state.tables.begin(), _state.tables.end(),
+            [](const std::shared_ptr<timing_table>& _table) {
+                return _table.get() == tl_table;
+            });
+        if(itr != _state.tables.end())
+        {
+            AutoLock _table_lk((*itr)->mutex);
+            for(const auto& eitr : (*itr)->entries)
+            {
+                auto _result = get_result(eitr);
+                if(_result.count > 0)
+                    merge(_state.retired[eitr.name], _result);
+            }
+            _table_lk.unlock();
+            _state.tables.erase(itr);
+        }
+        tl_table = nullptr;
+    }
+};
+
+//--------------------------------------------------------------------------------------//
+
+timing_table*
+this_table()
+{
+    if(!tl_table)
+    {
+        static thread_local timing_table_releaser _releaser{};
+
+        auto&    _state = state();
+        AutoLock _lk(_state.mutex);
+        _state.tables.emplace_back(
+            std::make_shared<timing_table>(ThreadPool::get_this_thread_id()));
+        tl_table = _state.tables.back().get();
+    }
+    return tl_table;
+}
+}  // namespace
+
+//======================================================================================//
+
+const char*
+CycleClock::source()
+{
+#if defined(PTL_CYCLE_CLOCK_USE_TSC)
+    return "tsc";
+#elif defined(PTL_CYCLE_CLOCK_USE_MONOTONIC_RAW)
+    return "clock_monotonic_raw";
+#else
+    return "steady_clock";
+#endif
+}
+
+//======================================================================================//
+
+double
+CycleClock::ticks_per_second()
+{
+#if defined(PTL_CYCLE_CLOCK_USE_TSC)
+    static double _value = []() {
+        const auto& _origin = origin();
+        while(clock_type::now() - _origin.time < std::chrono::milliseconds{ 10 })
+        {}
+        auto _ticks = now();
+        auto _time  = std::chrono::duration<double>(clock_type::now() - _origin.time);
+        return static_cast<double>(_ticks - _origin.ticks) / _time.count();
+    }();
+    return _value;
+#else
+    // the ticks are nanoseconds
+    return 1.0e9;
+#endif
+}
+
+//======================================================================================//
+
+internal::timing_entry*
+TimingRegion::get_entry(const char* _name)
+{
+    auto* _table = this_table();
+    auto  itr    = _table->index.find(_name);
+    if(itr != _table->index.end())
+        return itr->second;
+
+    AutoLock _lk(_table->mutex);
+    _table->entries.emplace_back();
+    auto* _entry = &_table->entries.back();
+    _entry->name = _name;
+    _table->index.emplace(_name, _entry);
+    return _entry;
+}
+
+//======================================================================================//
+
+TimingRegion::result_list_t
+TimingRegion::get_results()
+{
+    // a table is either in the list or merged into the retired regions
+    auto&                                      _state = state();
+    std::vector<std::shared_ptr<timing_table>> _tables{};
+    std::map<std::string, TimingResult>        _merged{};
+    {
+        AutoLock _lk(_state.mutex);
+        _tables = _state.tables;
+        _merged = _state.retired;
+    }
+
+    for(const auto& titr : _tables)
+    {
+        AutoLock _lk(titr->mutex);
+        for(const auto& itr : titr->entries)
+        {
+            auto _result = get_result(itr);
+            if(_result.count > 0)
+                merge(_merged[itr.name], _result);
+        }
+    }
+
+    result_list_t _v{};
+    _v.reserve(_merged.size());
+    for(auto& itr : _merged)
+    {
+        itr.second.name = itr.first;
+        _v.emplace_back(std::move(itr.second));
+    }
+    std::sort(_v.begin(), _v.end(),
+              [](const TimingResult& lhs, const TimingResult& rhs) {
+                  return lhs.total > rhs.total;
+              });
+    return _v;
+}
+
+//======================================================================================//
+
+void
+TimingRegion::reset()
+{
+    auto&                                      _state = state();
+    std::vector<std::shared_ptr<timing_table>> _tables{};
+    {
+        AutoLock _lk(_state.mutex);
+        _state.retired.clear();
+        _tables = _state.tables;
+    }
+
+    for(const auto& titr : _tables)
+    {
+        AutoLock _lk(titr->mutex);
+        for(auto& itr : titr->entries)
+        {
+            itr.count.store(0, std::memory_order_relaxed);
+            itr.ticks.store(0, std::memory_order_relaxed);
+            itr.min.store(std::numeric_limits<uint64_t>::max(),
+                          std::memory_order_relaxed);
+            itr.max.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+//======================================================================================//
+
+void
+TimingRegion::report(std::ostream& os)
+{
+    report(os, table_reporter());
+}
+
+//======================================================================================//
+
+void
+TimingRegion::report(std::ostream& os, const reporter_type& _reporter)
+{
+    if(_reporter)
+        _reporter(os, get_results());
+}
+
+//======================================================================================//
+
+TimingRegion::reporter_type
+TimingRegion::table_reporter()
+{
+    return [](std::ostream& os, const result_list_t& _results) {
+        size_t _width = 6;
+        for(const auto& itr : _results)
+            _width = std::max(_width, itr.name.length());
+
+        // so fixed doesn't propagate
+        std::stringstream ss;
+        ss << "[PTL::TimingRegion] " << _results.size() << " regions ("
+           << CycleClock::source() << ")\n";
+        ss << "    " << std::setw(_width) << std::left << "region" << std::right
+           << std::setw(12) << "count" << std::setw(14) << "total [s]" << std::setw(12)
+           << "mean [us]" << std::setw(12) << "min [us]" << std::setw(12) << "max [us]"
+           << std::setw(9) << "threads"
+           << "\n";
+        ss << std::fixed;
+        for(const auto& itr : _results)
+        {
+            ss << "    " << std::setw(_width) << std::left << itr.name << std::right
+               << std::setw(12) << itr.count << std::setprecision(6) << std::setw(14)
+               << itr.total << std::setprecision(3) << std::setw(12)
+               << itr.mean() * 1.0e6 << std::setw(12) << itr.min * 1.0e6
+               << std::setw(12) << itr.max * 1.0e6 << std::setw(9) << itr.threads
+               << "\n";
+        }
+        os << ss.str();
+    };
+}
+
+//======================================================================================//
+
+TimingRegion::reporter_type
+TimingRegion::timer_reporter()
+{
+    // the format of operator<<(std::ostream&, const Timer&) for the real time
+    return [](std::ostream& os, const result_list_t& _results) {
+        std::stringstream ss;
+        ss << std::fixed;
+        for(const auto& itr : _results)
+        {
+            ss << itr.name << " : Real=" << itr.total << "s [Calls=" << itr.count
+               << ", Threads=" << itr.threads << "]\n";
+        }
+        os << ss.str();
+    };
+}
+
+//======================================================================================//
+
+}  // namespace PTL
@@ -0,0 +1,427 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+//
+// ---------------------------------------------------------------
+//  Tasking class implementation
+//
+// Class Description:
+//
+// This file implements the discovery of the CPU topology from sysfs and
+// the cpu_placement policies
+//
+// ---------------------------------------------------------------
+
+#include "PTL/Topology.hh"
+
+#include "PTL/Types.hh"
+#include "PTL/Utility.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <tuple>
+#include <utility>
+
+#if defined(PTL_LINUX)
+#    include <sched.h>
+#    include <unistd.h>
+#endif
+
+//======================================================================================//
+
+namespace PTL
+{
+namespace
+{
+//======================================================================================//
+
+std::string
+read_line(const std::string& _fname)
+{
+    std::ifstream ifs{ _fname };
+    std::string   _line{};
+    if(ifs)
+        std::getline(ifs, _line);
+    return _line;
+}
+
+//--------------------------------------------------------------------------------------//
+
+int
+read_int(const std::string& _fname, int _default)
+{
+    auto _line = read_line(_fname);
+    if(_line.empty())
+        return _default;
+    try
+    {
+        return std::stoi(_line);
+    } catch(std::exception&)
+    {
+        return _default;
+    }
+}
+
+//--------------------------------------------------------------------------------------//
+
+Topology::cpu_list_t
+sequence(int _n)
+{
+    Topology::cpu_list_t _v(std::max(_n, 1));
+    for(size_t i = 0; i < _v.size(); ++i)
+        _v.at(i) = static_cast<int>(i);
+    return _v;
+}
+
+//======================================================================================//
+}  // namespace
+
+//======================================================================================//
+
+const Topology&
+Topology::instance()
+{
+    // the affinity mask of the process does not describe a fake sysfs tree
+    static auto     _root = GetEnv<std::string>("PTL_SYSFS_ROOT", "");
+    static Topology _v =
+        (_root.empty()) ? discover("/sys/devices/system", allowed_cpus()) : discover(_root);
+    return _v;
+}
+
+//======================================================================================//
+
+int&
+Topology::thread_node()
+{
+    static thread_local int _v = -1;
+    return _v;
+}
+
+//======================================================================================//
+
+Topology::cpu_list_t
+Topology::allowed_cpus()
+{
+#if defined(PTL_LINUX)
+    // the mask of the main thread (whose thread id is the process id) rather than
+    // of the calling thread, which may be a worker pinned to a single CPU.
+    // The mask may need to be larger than cpu_set_t on very large machines
+    for(int _size = CPU_SETSIZE; _size <= (1 << 16); _size *= 2)
+    {
+        cpu_set_t* _mask  = CPU_ALLOC(_size);
+        size_t     _bytes = CPU_ALLOC_SIZE(_size);
+        CPU_ZERO_S(_bytes, _mask);
+        int _ret = sched_getaffinity(getpid(), _bytes, _mask);
+        if(_ret == 0)
+        {
+            cpu_list_t _cpus{};
+            for(int i = 0; i < _size; ++i)
+            {
+                if(CPU_ISSET_S(i, _bytes, _mask))
+                    _cpus.emplace_back(i);
+            }
+            CPU_FREE(_mask);
+            if(!_cpus.empty())
+                return _cpus;
+            break;
+        }
+        CPU_FREE(_mask);
+        if(errno != EINVAL)
+            break;
+    }
+#endif
+    return sequence(std::thread::hardware_concurrency());
+}
+
+//======================================================================================//
+
+Topology::cpu_list_t
+Topology::parse_cpu_list(const std::string& _str)
+{
+    cpu_list_t        _cpus{};
+    std::stringstream ss{ _str };
+    std::string       _range{};
+    while(std::getline(ss, _range, ','))
+    {
+        try
+        {
+            auto _dash  = _range.find('-');
+            int  _first = std::stoi(_range.substr(0, _dash));
+            int  _last  = _first;
+            if(_dash != std::string::npos)
+                _last = std::stoi(_range.substr(_dash + 1));
+            for(int i = _first; i <= _last; ++i)
+                _cpus.emplace_back(i);
+        } catch(std::exception&)
+        {}
+    }
+    return _cpus;
+}
+
+//======================================================================================//
+
+Topology::size_type
+Topology::parse_size(const std::string& _str)
+{
+    std::stringstream ss{ _str };
+    size_type         _size = 0;
+    char              _unit = '\0';
+    if(!(ss >> _size))
+        return 0;
+    ss >> _unit;
+    switch(_unit)
+    {
+        case 'K':
+        case 'k': return _size << 10;
+        case 'M':
+        case 'm': return _size << 20;
+        case 'G':
+        case 'g': return _size << 30;
+        default: return _size;
+    }
+}
+
+//======================================================================================//
+
+Topology
+Topology::discover(const std::string& _root, const cpu_list_t& _allowed)
+{
+    Topology _topo{};
+
+    auto _present = parse_cpu_list(read_line(_root + "/cpu/online"));
+    if(_present.empty())
+        _present = parse_cpu_list(read_line(_root + "/cpu/possible"));
+    if(_present.empty())
+        _present = (_allowed.empty()) ? sequence(std::thread::hardware_concurrency())
+                                      : _allowed;
+
+    std::set<int> _allowed_set{ _allowed.begin(), _allowed.end() };
+    cpu_list_t    _cpus{};
+    for(auto itr : _present)
+    {
+        if(_allowed_set.empty() || _allowed_set.count(itr) > 0)
+            _cpus.emplace_back(itr);
+    }
+    // the allowed CPUs are not online in the tree, e.g. sysfs is not mounted
+    if(_cpus.empty())
+        _cpus = (_allowed.empty()) ? _present : _allowed;
+
+    std::map<int, int> _cpu_nodes{};
+    for(auto itr : parse_cpu_list(read_line(_root + "/node/online")))
+    {
+        auto _dir = _root + "/node/node" + std::to_string(itr);
+        for(auto citr : parse_cpu_list(read_line(_dir + "/cpulist")))
+            _cpu_nodes[citr] = itr;
+    }
+
+    // physical cores are identified by the package and core id. Each core gets an
+    // index in the order of its first CPU and the SMT index counts the CPUs of the
+    // core which are included
+    std::map<std::pair<int, int>, int> _core_index{};
+    std::map<int, int>                 _core_smt{};
+    std::set<int>                      _sockets{};
+    std::set<int>                      _nodes{};
+    // caches shared by several CPUs are listed once
+    std::set<std::tuple<int, std::string, cpu_list_t>> _caches{};
+    std::sort(_cpus.begin(), _cpus.end());
+    for(auto itr : _cpus)
+    {
+        auto _dir = _root + "/cpu/cpu" + std::to_string(itr);
+
+        Cpu _cpu{};
+        _cpu.cpu    = itr;
+        _cpu.socket = std::max(read_int(_dir + "/topology/physical_package_id", 0), 0);
+        auto _id    = read_int(_dir + "/topology/core_id", itr);
+        auto _key   = std::make_pair(_cpu.socket, _id);
+        if(_core_index.find(_key) == _core_index.end())
+        {
+            auto _idx         = static_cast<int>(_core_index.size());
+            _core_index[_key] = _idx;
+        }
+        _cpu.core = _core_index.at(_key);
+        _cpu.smt  = _core_smt[_cpu.core]++;
+        _cpu.node = (_cpu_nodes.count(itr) > 0) ? _cpu_nodes.at(itr) : 0;
+        _sockets.insert(_cpu.socket);
+        _nodes.insert(_cpu.node);
+        _topo.m_cpus.emplace_back(_cpu);
+        if(static_cast<int>(_topo.m_cpu_nodes.size()) <= itr)
+            _topo.m_cpu_nodes.resize(itr + 1, 0);
+        _topo.m_cpu_nodes.at(itr) = _cpu.node;
+
+        for(int i = 0;; ++i)
+        {
+            auto _cdir  = _dir + "/cache/index" + std::to_string(i);
+            int  _level = read_int(_cdir + "/level", -1);
+            if(_level < 0)
+                break;
+            Cache _cache{};
+            _cache.level = _level;
+            _cache.type  = read_line(_cdir + "/type");
+            _cache.size  = parse_size(read_line(_cdir + "/size"));
+            _cache.cpus  = parse_cpu_list(read_line(_cdir + "/shared_cpu_list"));
+            if(_cache.cpus.empty())
+                _cache.cpus = { itr };
+            if(_caches.insert(std::make_tuple(_cache.level, _cache.type, _cache.cpus))
+                   .second)
+                _topo.m_caches.emplace_back(_cache);
+        }
+    }
+
+    _topo.m_num_cores   = _core_index.size();
+    _topo.m_num_sockets = _sockets.size();
+    _topo.m_nodes       = std::vector<int>{ _nodes.begin(), _nodes.end() };
+    return _topo;
+}
+
+//======================================================================================//
+
+int
+Topology::node_of(int _cpu) const
+{
+    if(_cpu < 0 || _cpu >= static_cast<int>(m_cpu_nodes.size()))
+        return 0;
+    return m_cpu_nodes[_cpu];
+}
+
+//======================================================================================//
+
+int
+Topology::current_node() const
+{
+    if(m_nodes.size() < 2)
+        return (m_nodes.empty()) ? 0 : m_nodes.front();
+    if(thread_node() >= 0)
+        return thread_node();
+#if defined(PTL_LINUX)
+    return node_of(sched_getcpu());
+#else
+    return 0;
+#endif
+}
+
+//======================================================================================//
+
+Topology::cpu_list_t
+Topology::node_cpus(int _node) const
+{
+    cpu_list_t _cpus{};
+    for(const auto& itr : m_cpus)
+    {
+        if(itr.node == _node)
+            _cpus.emplace_back(itr.cpu);
+    }
+    return _cpus;
+}
+
+//======================================================================================//
+
+Topology::cpu_list_t
+Topology::placement(short _policy) const
+{
+    // the index of each core within its socket, used to interleave the sockets
+    std::map<int, int> _core_rank{};
+    std::map<int, int> _socket_cores{};
+    for(const auto& itr : m_cpus)
+    {
+        if(_core_rank.find(itr.core) == _core_rank.end())
+            _core_rank[itr.core] = _socket_cores[itr.socket]++;
+    }
+
+    auto _cpus    = m_cpus;
+    auto _compact = [](const Cpu& lhs, const Cpu& rhs) {
+        return std::make_tuple(lhs.socket, lhs.core, lhs.smt) <
+               std::make_tuple(rhs.socket, rhs.core, rhs.smt);
+    };
+
+    cpu_list_t _order{};
+    switch(_policy)
+    {
+        case cpu_placement::COMPACT:
+        {
+            std::sort(_cpus.begin(), _cpus.end(), _compact);
+            for(const auto& itr : _cpus)
+                _order.emplace_back(itr.cpu);
+            break;
+        }
+        case cpu_placement::SCATTER:
+        {
+            std::sort(_cpus.begin(), _cpus.end(), [&](const Cpu& lhs, const Cpu& rhs) {
+                return std::make_tuple(lhs.smt, _core_rank.at(lhs.core), lhs.socket) <
+                       std::make_tuple(rhs.smt, _core_rank.at(rhs.core), rhs.socket);
+            });
+            for(const auto& itr : _cpus)
+                _order.emplace_back(itr.cpu);
+            break;
+        }
+        case cpu_placement::PHYSICAL_CORES:
+        {
+            std::sort(_cpus.begin(), _cpus.end(), _compact);
+            for(const auto& itr : _cpus)
+            {
+                if(itr.smt == 0)
+                    _order.emplace_back(itr.cpu);
+            }
+            break;
+        }
+        case cpu_placement::NUMA_ROUND_ROBIN:
+        {
+            std::sort(_cpus.begin(), _cpus.end(), _compact);
+            std::map<int, cpu_list_t> _node_order{};
+            for(const auto& itr : _cpus)
+                _node_order[itr.node].emplace_back(itr.cpu);
+            for(size_t i = 0; _order.size() < _cpus.size(); ++i)
+            {
+                for(const auto& itr : _node_order)
+                {
+                    if(i < itr.second.size())
+                        _order.emplace_back(itr.second.at(i));
+                }
+            }
+            break;
+        }
+        default:
+        {
+            for(const auto& itr : _cpus)
+                _order.emplace_back(itr.cpu);
+            break;
+        }
+    }
+    return _order;
+}
+
+//======================================================================================//
+
+std::function<intmax_t(intmax_t)>
+Topology::placement_functor(short _policy) const
+{
+    auto _order = placement(_policy);
+    return [_order](intmax_t _idx) -> intmax_t {
+        if(_order.empty())
+            return _idx;
+        return _order.at(_idx % static_cast<intmax_t>(_order.size()));
+    };
+}
+
+//======================================================================================//
+
+}  // namespace PTL
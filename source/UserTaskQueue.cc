@@ -26,16 +26,18 @@
 #include "PTL/UserTaskQueue.hh"
 
 #include "PTL/AutoLock.hh"
-#include "PTL/TaskGroup.hh"
+#include "PTL/TaskHooks.hh"
+#include "PTL/TaskTracer.hh"
 #include "PTL/ThreadData.hh"
 #include "PTL/ThreadPool.hh"
 #include "PTL/Utility.hh"
 
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <functional>
 #include <iostream>
-#include <map>
+#include <iterator>
 #include <stdexcept>
 #include <system_error>
 #include <thread>
@@ -48,18 +50,20 @@ using namespace PTL;
 UserTaskQueue::UserTaskQueue(intmax_t nworkers, UserTaskQueue* parent)
 : VUserTaskQueue(nworkers)
 , m_is_clone((parent) != nullptr)
+, m_numa((parent) ? parent->m_numa
+                  : (Topology::instance().num_nodes() > 1 &&
+                     GetEnv<bool>("PTL_NUMA_QUEUE", true)))
 , m_thread_bin((parent) ? (ThreadPool::get_this_thread_id() % (nworkers + 1)) : 0)
 , m_insert_bin((parent) ? (ThreadPool::get_this_thread_id() % (nworkers + 1)) : 0)
-, m_hold((parent) ? parent->m_hold : new std::atomic_bool(false))
 , m_ntasks((parent) ? parent->m_ntasks : new std::atomic_uintmax_t(0))
 , m_mutex((parent) ? parent->m_mutex : new Mutex{})
-, m_subqueues((parent) ? parent->m_subqueues : new TaskSubQueueContainer())
+, m_subqueues((parent) ? parent->m_subqueues.load() : new TaskSubQueueContainer())
 {
     // create nthreads + 1 subqueues so there is always a subqueue available
     if(!parent)
     {
         for(intmax_t i = 0; i < nworkers + 1; ++i)
-            m_subqueues->emplace_back(new TaskSubQueue(m_ntasks));
+            m_subqueues.load()->emplace_back(new TaskSubQueue(m_ntasks));
     }
 
 #if defined(DEBUG)
@@ -72,10 +76,9 @@ UserTaskQueue::UserTaskQueue(intmax_t nworkers, UserTaskQueue* parent)
            << "this = " << this << ", "
            << "clone = " << std::boolalpha << m_is_clone << ", "
            << "thread = " << m_thread_bin << ", "
-           << "insert = " << m_insert_bin << ", "
-           << "hold = " << m_hold->load() << " @ " << m_hold << ", "
+           << "insert = " << m_insert_bin.load() << ", "
            << "tasks = " << m_ntasks->load() << " @ " << m_ntasks << ", "
-           << "subqueue = " << m_subqueues << ", "
+           << "subqueue = " << m_subqueues.load() << ", "
            << "size = " << true_size() << ", "
            << "empty = " << true_empty();
         std::cout << ss.str() << std::endl;
@@ -89,16 +92,18 @@ UserTaskQueue::~UserTaskQueue()
 {
     if(!m_is_clone)
     {
-        for(auto& itr : *m_subqueues)
+        auto* _subqueues = m_subqueues.load();
+        for(auto& itr : *_subqueues)
         {
             assert(itr->empty());
             delete itr;
         }
-        m_subqueues->clear();
-        delete m_hold;
+        _subqueues->clear();
+        for(auto& itr : m_retired_subqueues)
+            delete itr;
         delete m_ntasks;
         delete m_mutex;
-        delete m_subqueues;
+        delete _subqueues;
     }
 }
 
@@ -110,22 +115,42 @@ UserTaskQueue::resize(intmax_t n)
     if(!m_mutex)
         throw std::runtime_error("nullptr to mutex");
     AutoLock lk(m_mutex);
-    if(m_workers < n)
+    intmax_t _workers   = m_workers.load(std::memory_order_relaxed);
+    auto*    _subqueues = m_subqueues.load(std::memory_order_relaxed);
+    if(_workers < n)
     {
-        while(m_workers < n)
+        // other threads may be indexing the bins so the container is never modified
+        // in place: a new one is published and the old one is kept until destruction
+        if(static_cast<intmax_t>(_subqueues->size()) < n + 1)
         {
-            m_subqueues->emplace_back(new TaskSubQueue(m_ntasks));
-            ++m_workers;
+            m_retired_subqueues.emplace_back(_subqueues);
+            _subqueues = new TaskSubQueueContainer(*_subqueues);
+            while(static_cast<intmax_t>(_subqueues->size()) < n + 1)
+                _subqueues->emplace_back(new TaskSubQueue(m_ntasks));
+            m_subqueues.store(_subqueues, std::memory_order_release);
         }
+        // published after the bins so a thread which loads the new number of
+        // workers also loads the bins of the new workers
+        m_workers.store(n, std::memory_order_release);
     }
-    else if(m_workers > n)
+    else if(_workers > n)
     {
-        while(m_workers > n)
+        // the bins beyond the new number of workers are kept (and reused if the
+        // queue grows again) but their tasks are moved into the remaining bins
+        intmax_t _nbins = _workers + 1;
+        m_workers.store(n, std::memory_order_release);
+
+        task_list_t _tasks{};
+        for(intmax_t i = n + 1; i < _nbins; ++i)
         {
-            delete m_subqueues->back();
-            m_subqueues->pop_back();
-            --m_workers;
+            TaskSubQueue* task_subq = (*_subqueues)[i];
+            while(!task_subq->AcquireClaim())
+                ;
+            while(!task_subq->empty())
+                _tasks.emplace_back(task_subq->PopTask());
+            task_subq->ReleaseClaim();
         }
+        DistributeTasks(_tasks);
     }
 }
 
@@ -141,10 +166,17 @@ UserTaskQueue::clone()
 intmax_t
 UserTaskQueue::GetThreadBin() const
 {
-    // get a thread id number
-    static thread_local intmax_t tl_bin =
-        (m_thread_bin + ThreadPool::get_this_thread_id()) % (m_workers + 1);
-    return tl_bin;
+    // computed for this queue on every call since a thread may use several queues and
+    // the number of bins changes when the queue is resized. The workers of the pool
+    // owning the queue use their slot, which is distinct from the slot of the other
+    // workers of the pool, the attached threads use a slot past the ones of the
+    // workers and the pool thread(s) use bin zero. The other threads are spread by
+    // their thread index
+    auto* _data = ThreadData::GetInstance();
+    if(_data && _data->current_queue == this)
+        return std::max<intmax_t>(_data->worker_slot.load(std::memory_order_relaxed), 0) %
+               GetNumBins();
+    return (m_thread_bin + ThreadPool::get_this_thread_id()) % GetNumBins();
 }
 
 //======================================================================================//
@@ -152,7 +184,22 @@ UserTaskQueue::GetThreadBin() const
 intmax_t
 UserTaskQueue::GetInsertBin() const
 {
-    return (++m_insert_bin % (m_workers + 1));
+    return ((m_insert_bin.fetch_add(1, std::memory_order_relaxed) + 1) % GetNumBins());
+}
+
+//======================================================================================//
+
+intmax_t
+UserTaskQueue::GetNodeBin(int _node, intmax_t _n) const
+{
+    intmax_t _nbins     = GetNumBins();
+    auto&    _subqueues = GetSubQueues();
+    for(intmax_t i = 0; i < _nbins; ++i)
+    {
+        if(_subqueues[(_n + i) % _nbins]->GetNode() == _node)
+            return (_n + i) % _nbins;
+    }
+    return _n % _nbins;
 }
 
 //======================================================================================//
@@ -160,9 +207,11 @@ UserTaskQueue::GetInsertBin() const
 UserTaskQueue::task_pointer
 UserTaskQueue::GetThreadBinTask()
 {
-    intmax_t      tbin      = GetThreadBin();
-    TaskSubQueue* task_subq = (*m_subqueues)[tbin % (m_workers + 1)];
-    task_pointer  _task     = nullptr;
+    intmax_t      _nbins     = GetNumBins();
+    auto&         _subqueues = GetSubQueues();
+    intmax_t      tbin       = GetThreadBin();
+    TaskSubQueue* task_subq  = _subqueues[tbin % _nbins];
+    task_pointer  _task      = nullptr;
 
     //------------------------------------------------------------------------//
     auto get_task = [&]() {
@@ -198,21 +247,24 @@ UserTaskQueue::GetTask(intmax_t subq, intmax_t nitr)
     if(this->true_empty())
         return nullptr;
 
+    // the bins are indexed modulo this snapshot of the number of bins since
+    // resize() may change it concurrently
+    intmax_t _nbins     = GetNumBins();
+    auto&    _subqueues = GetSubQueues();
+
     // ensure the thread has a bin assignment
-    intmax_t tbin = GetThreadBin();
+    intmax_t tbin = GetThreadBin() % _nbins;
     intmax_t n    = (subq < 0) ? tbin : subq;
     if(nitr < 1)
-        nitr = (m_workers + 1);  // * m_ntasks->load(std::memory_order_relaxed);
-
-    if(m_hold->load(std::memory_order_relaxed))
-    {
-        return GetThreadBinTask();
-    }
+        nitr = _nbins;  // * m_ntasks->load(std::memory_order_relaxed);
 
     task_pointer _task = nullptr;
+#if defined(PTL_USE_STATISTICS)
+    ThreadData* _data = ThreadData::GetInstance();
+#endif
     //------------------------------------------------------------------------//
     auto get_task = [&](intmax_t _n) {
-        TaskSubQueue* task_subq = (*m_subqueues)[_n % (m_workers + 1)];
+        TaskSubQueue* task_subq = _subqueues[_n % _nbins];
         // try to acquire a claim for the bin
         // if acquired, no other threads will access bin until claim is released
         if(!task_subq->empty() && task_subq->AcquireClaim())
@@ -222,28 +274,115 @@ UserTaskQueue::GetTask(intmax_t subq, intmax_t nitr)
             // release the claim on the bin
             task_subq->ReleaseClaim();
         }
+#if defined(PTL_USE_STATISTICS)
+        else if(_data && !task_subq->empty())
+            _data->statistics.add(ThreadStatistics::failed_claims);
+        if(_task && _data)
+            _data->statistics.add((_n % _nbins == tbin)
+                                      ? ThreadStatistics::local_pops
+                                      : ThreadStatistics::steals);
+#endif
         if(_task)
+        {
             --(*m_ntasks);
+            if(_n % _nbins != tbin)
+            {
+                TaskTracer::record(TaskTracer::steal, _task.get(), _task->label());
+                TaskHooks::notify(TaskHooks::steal, _task.get());
+            }
+        }
         // return success if valid pointer
         return (_task != nullptr);
     };
     //------------------------------------------------------------------------//
 
+    // with a NUMA-partitioned queue, the bin of this thread is tagged with its
+    // node and the bins of the same node (or of no known node) are exhausted
+    // before stealing from the bins of remote nodes
+    if(m_numa)
+    {
+        int _node = CurrentNode();
+        _subqueues[tbin]->SetNode(_node);
+        for(intmax_t i = 0; i < nitr; ++i)
+        {
+            intmax_t _n     = (n + i) % _nbins;
+            int      _bnode = _subqueues[_n]->GetNode();
+            if((_bnode < 0 || _bnode == _node) && get_task(_n))
+                return _task;
+        }
+    }
+
     // there are num_workers+1 bins so there is always a bin that is open
     // execute num_workers+2 iterations so the thread checks its bin twice
     // while(!empty())
     {
         for(intmax_t i = 0; i < nitr; ++i, ++n)
         {
-            if(get_task(n % (m_workers + 1)))
+            if(get_task(n % _nbins))
                 return _task;
         }
     }
 
+    // bins removed by resize() are drained when the queue shrinks but a task may
+    // have been inserted into one of them concurrently so they are swept as well
+    for(size_type i = _nbins; i < _subqueues.size(); ++i)
+    {
+        TaskSubQueue* task_subq = _subqueues[i];
+        if(!task_subq->empty() && task_subq->AcquireClaim())
+        {
+            _task = task_subq->PopTask(false);
+            task_subq->ReleaseClaim();
+        }
+        if(_task)
+        {
+            --(*m_ntasks);
+            TaskTracer::record(TaskTracer::steal, _task.get(), _task->label());
+            TaskHooks::notify(TaskHooks::steal, _task.get());
+#if defined(PTL_USE_STATISTICS)
+            if(_data)
+                _data->statistics.add(ThreadStatistics::steals);
+#endif
+            return _task;
+        }
+    }
+
     // only reached if looped over all bins (and looked in own bin twice)
     // and found no work so return an empty task and the thread will be put to
     // sleep if there is still no work by the time it reaches its
     // condition variable
+#if defined(PTL_USE_STATISTICS)
+    if(_data)
+        _data->statistics.add(ThreadStatistics::failed_steals);
+#endif
+    return _task;
+}
+
+//======================================================================================//
+
+UserTaskQueue::task_pointer
+UserTaskQueue::StealTask()
+{
+    if(this->empty())
+        return nullptr;
+
+    intmax_t     _nbins     = GetNumBins();
+    auto&        _subqueues = GetSubQueues();
+    intmax_t     n          = GetInsertBin();
+    task_pointer _task      = nullptr;
+    for(intmax_t i = 0; i < _nbins; ++i)
+    {
+        TaskSubQueue* task_subq = _subqueues[(n + i) % _nbins];
+        if(!task_subq->empty() && task_subq->AcquireClaim())
+        {
+            _task = task_subq->StealTask();
+            task_subq->ReleaseClaim();
+        }
+        if(_task)
+        {
+            --(*m_ntasks);
+            return _task;
+        }
+    }
     return _task;
 }
 
@@ -254,15 +393,19 @@ UserTaskQueue::InsertTask(task_pointer&& task, ThreadData* data, intmax_t subq)
 {
     // increment number of tasks
     ++(*m_ntasks);
+    TaskTracer::record(TaskTracer::enqueue, task.get(), task->label());
+    TaskHooks::notify(TaskHooks::enqueue, task.get());
+    if(TaskLatency::enabled() && task->submit_time() == 0)
+        task->set_submit_time(TaskLatency::now());
 
-    bool     spin = m_hold->load(std::memory_order_relaxed);
     intmax_t tbin = GetThreadBin();
 
+    // tasks inserted into a specific bin are meant for the threads of this queue
+    if(subq >= 0)
+        task->set_pool_bound(true);
+
     if(data && data->within_task)
-    {
         subq = tbin;
-        // spin = true;
-    }
 
     // subq is -1 unless specified so unless specified
     // GetInsertBin() call increments a counter and returns
@@ -270,13 +413,31 @@ UserTaskQueue::InsertTask(task_pointer&& task, ThreadData* data, intmax_t subq)
     // among the bins
     intmax_t n = (subq < 0) ? GetInsertBin() : subq;
 
+    // with a NUMA-partitioned queue, start from a bin on the node requested by the
+    // task or else on the node of the submitting thread
+    int _node = -1;
+    if(m_numa && subq < 0)
+    {
+        _node = (task->numa_node() >= 0) ? task->numa_node() : CurrentNode();
+        n     = GetNodeBin(_node, n);
+    }
+
+    return InsertIntoBin(std::move(task), n, _node);
+}
+
+//======================================================================================//
+
+intmax_t
+UserTaskQueue::InsertIntoBin(task_pointer&& task, intmax_t n, int _node)
+{
+    // the bins are indexed modulo this snapshot of the number of bins since
+    // resize() may change it concurrently
+    intmax_t _nbins     = GetNumBins();
+    auto&    _subqueues = GetSubQueues();
+
     //------------------------------------------------------------------------//
     auto insert_task = [&](intmax_t _n) {
-        TaskSubQueue* task_subq = (*m_subqueues)[_n];
-        // TaskSubQueue* next_subq = (*m_subqueues)[(_n + 1) % (m_workers + 1)];
-        // if not threads bin and size difference, insert into smaller
-        // if(n != tbin && next_subq->size() < task_subq->size())
-        //    task_subq = next_subq;
+        TaskSubQueue* task_subq = _subqueues[_n];
         // try to acquire a claim for the bin
         // if acquired, no other threads will access bin until claim is released
         if(task_subq->AcquireClaim())
@@ -292,181 +453,117 @@ UserTaskQueue::InsertTask(task_pointer&& task, ThreadData* data, intmax_t subq)
     };
     //------------------------------------------------------------------------//
 
-    // if not in "hold/spin mode", where thread only inserts tasks into
-    // specified bin, then move onto next bin
-    //
-    if(spin)
+    // if the bin is claimed, try the other bins of the node first
+    if(_node >= 0)
     {
-        n = n % (m_workers + 1);
-        while(!insert_task(n))
-            ;
-        return n;
+        for(intmax_t i = 0; i < _nbins; ++i)
+        {
+            auto _n = (n + i) % _nbins;
+            if(_subqueues[_n]->GetNode() == _node && insert_task(_n))
+                return _n;
+        }
     }
 
     // there are num_workers+1 bins so there is always a bin that is open
-    // execute num_workers+2 iterations so the thread checks its bin twice
     while(true)
     {
-        auto _n = (n++) % (m_workers + 1);
+        auto _n = (n++) % _nbins;
         if(insert_task(_n))
             return _n;
     }
-    return GetThreadBin();
 }
 
 //======================================================================================//
 
-void
-UserTaskQueue::ExecuteOnAllThreads(ThreadPool* tp, function_type func)
+UserTaskQueue::size_type
+UserTaskQueue::InsertTasks(task_list_t&& _tasks)
 {
-    using task_group_type      = TaskGroup<int, int>;
-    using thread_execute_map_t = std::map<int64_t, bool>;
-
-    if(!tp->is_alive())
-    {
-        func();
-        return;
-    }
-
-    task_group_type tg{ [](int& ref, int i) { return (ref += i); }, tp };
-
-    // wait for all threads to finish any work
-    // NOTE: will cause deadlock if called from a task
-    while(tp->get_active_threads_count() > 0)
-        ThisThread::sleep_for(std::chrono::milliseconds(10));
+    size_type _ntot = _tasks.size();
+    if(_ntot == 0)
+        return 0;
 
-    thread_execute_map_t                thread_execute_map{};
-    std::vector<std::shared_ptr<VTask>> _tasks{};
-    _tasks.reserve(m_workers + 1);
+    // increment number of tasks
+    *m_ntasks += _ntot;
 
-    AcquireHold();
-    for(int i = 0; i < (m_workers + 1); ++i)
+    if(TaskLatency::enabled())
     {
-        if(i == GetThreadBin())
-            continue;
-
-        //--------------------------------------------------------------------//
-        auto thread_specific_func = [&]() {
-            ScopeDestructor _dtor = tg.get_scope_destructor();
-            static Mutex    _mtx;
-            _mtx.lock();
-            bool& _executed = thread_execute_map[GetThreadBin()];
-            _mtx.unlock();
-            if(!_executed)
-            {
-                func();
-                _executed = true;
-                return 1;
-            }
-            return 0;
-        };
-        //--------------------------------------------------------------------//
-
-        InsertTask(tg.wrap(thread_specific_func), ThreadData::GetInstance(), i);
+        auto _now = TaskLatency::now();
+        for(auto& itr : _tasks)
+        {
+            if(itr->submit_time() == 0)
+                itr->set_submit_time(_now);
+        }
     }
 
-    tp->notify_all();
-    int nexecuted = tg.join();
-    if(nexecuted != m_workers)
-    {
-        std::stringstream msg;
-        msg << "Failure executing routine on all threads! Only " << nexecuted
-            << " threads executed function out of " << m_workers << " workers";
-        std::cerr << msg.str() << std::endl;
-    }
-    ReleaseHold();
+    DistributeTasks(_tasks);
+    _tasks.clear();
+    return _ntot;
 }
 
 //======================================================================================//
 
 void
-UserTaskQueue::ExecuteOnSpecificThreads(ThreadIdSet tid_set, ThreadPool* tp,
-                                        function_type func)
+UserTaskQueue::DistributeTasks(task_list_t& _tasks)
 {
-    using task_group_type      = TaskGroup<int, int>;
-    using thread_execute_map_t = std::map<int64_t, bool>;
-
-    task_group_type tg{ [](int& ref, int i) { return (ref += i); }, tp };
-
-    // wait for all threads to finish any work
-    // NOTE: will cause deadlock if called from a task
-    while(tp->get_active_threads_count() > 0)
-        ThisThread::sleep_for(std::chrono::milliseconds(10));
-
-    if(!tp->is_alive())
+    // the tasks requesting a NUMA node are placed one at a time, like InsertTask
+    if(m_numa)
     {
-        func();
-        return;
-    }
-
-    thread_execute_map_t thread_execute_map{};
-
-    //========================================================================//
-    // wrap the function so that it will only be executed if the thread
-    // has an ID in the set
-    auto thread_specific_func = [&]() {
-        ScopeDestructor _dtor = tg.get_scope_destructor();
-        static Mutex    _mtx;
-        _mtx.lock();
-        bool& _executed = thread_execute_map[GetThreadBin()];
-        _mtx.unlock();
-        if(!_executed && tid_set.count(ThisThread::get_id()) > 0)
+        auto _hinted = std::stable_partition(
+            _tasks.begin(), _tasks.end(),
+            [](const task_pointer& _task) { return _task->numa_node() < 0; });
+        for(auto itr = _hinted; itr != _tasks.end(); ++itr)
         {
-            func();
-            _executed = true;
-            return 1;
+            int _node = (*itr)->numa_node();
+            InsertIntoBin(std::move(*itr), GetNodeBin(_node, GetInsertBin()), _node);
         }
-        return 0;
-    };
-    //========================================================================//
+        _tasks.erase(_hinted, _tasks.end());
+    }
 
-    if(tid_set.count(ThisThread::get_id()) > 0)
-        func();
+    size_type _ntot = _tasks.size();
+    if(_ntot == 0)
+        return;
 
-    AcquireHold();
-    for(int i = 0; i < (m_workers + 1); ++i)
-    {
-        if(i == GetThreadBin())
-            continue;
+    // split the batch evenly among the bins so each bin is claimed once
+    // instead of once per task
+    size_type _nbins     = static_cast<size_type>(GetNumBins());
+    auto&     _subqueues = GetSubQueues();
+    size_type _nchunk    = (_ntot + _nbins - 1) / _nbins;
+    intmax_t  n          = GetInsertBin();
 
-        InsertTask(tg.wrap(thread_specific_func), ThreadData::GetInstance(), i);
-    }
-    tp->notify_all();
-    decltype(tid_set.size()) nexecuted = tg.join();
-    if(nexecuted != tid_set.size())
+    auto _beg = _tasks.begin();
+    while(_beg != _tasks.end())
     {
-        std::stringstream msg;
-        msg << "Failure executing routine on specific threads! Only " << nexecuted
-            << " threads executed function out of " << tid_set.size() << " workers";
-        std::cerr << msg.str() << std::endl;
+        auto _end = _beg + std::min<intmax_t>(_nchunk, std::distance(_beg, _tasks.end()));
+        while(true)
+        {
+            TaskSubQueue* task_subq = _subqueues[(n++) % _nbins];
+            if(task_subq->AcquireClaim())
+            {
+                task_subq->PushTasks(_beg, _end);
+                task_subq->ReleaseClaim();
+                break;
+            }
+        }
+        _beg = _end;
     }
-    ReleaseHold();
 }
 
 //======================================================================================//
 
 void
-UserTaskQueue::AcquireHold()
+UserTaskQueue::ExecuteOnAllThreads(ThreadPool* tp, function_type func)
 {
-    bool _hold;
-    while(!(_hold = m_hold->load(std::memory_order_relaxed)))
-    {
-        m_hold->compare_exchange_strong(_hold, true, std::memory_order_release,
-                                        std::memory_order_relaxed);
-    }
+    // the workers pick up the function from the broadcast slot of the thread-pool
+    tp->execute_on_all_threads(std::move(func));
 }
 
 //======================================================================================//
 
 void
-UserTaskQueue::ReleaseHold()
+UserTaskQueue::ExecuteOnSpecificThreads(ThreadIdSet tid_set, ThreadPool* tp,
+                                        function_type func)
 {
-    bool _hold;
-    while((_hold = m_hold->load(std::memory_order_relaxed)))
-    {
-        m_hold->compare_exchange_strong(_hold, false, std::memory_order_release,
-                                        std::memory_order_relaxed);
-    }
+    tp->execute_on_specific_threads(tid_set, std::move(func));
 }
 
 //======================================================================================//
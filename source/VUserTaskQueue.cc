@@ -26,10 +26,13 @@
 //  ---------------------------------------------------------------
 
 #include "PTL/VUserTaskQueue.hh"
+#include "PTL/Concurrency.hh"
 #include "PTL/TaskRunManager.hh"
 #include "PTL/Utility.hh"  // for PTL
+#include "PTL/VTask.hh"
 #include <cstdint>         // for intmax_t
 #include <thread>          // for thread
+#include <utility>         // for move
 
 using namespace PTL;
 
@@ -42,9 +45,24 @@ VUserTaskQueue::VUserTaskQueue(intmax_t nworkers)
     {
         TaskRunManager* rm = TaskRunManager::GetMasterRunManager();
         m_workers          = (rm) ? rm->GetNumberOfThreads() + 1  // number of threads + 1
-                         : (2 * std::thread::hardware_concurrency()) + 1;
+                         : (2 * effective_concurrency()) + 1;
         // hyperthreads + 1
     }
 }
 
 //======================================================================================//
+
+VUserTaskQueue::size_type
+VUserTaskQueue::InsertTasks(task_list_t&& _tasks)
+{
+    size_type _n = 0;
+    for(auto& itr : _tasks)
+    {
+        InsertTask(std::move(itr));
+        ++_n;
+    }
+    _tasks.clear();
+    return _n;
+}
+
+//======================================================================================//
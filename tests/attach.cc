@@ -0,0 +1,156 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+/// \file attach.cc
+/// \brief A thread attached to a ThreadPool executes the tasks of the pool while it
+/// waits (on a task group or in execute_until) and leaves the pool when it detaches.
+/// The threads attached at the same time use different bins
+
+#include "ptl_test.hh"
+
+#include "PTL/Task.hh"
+#include "PTL/TaskGroup.hh"
+#include "PTL/ThreadPool.hh"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+using namespace PTL;
+
+namespace
+{
+constexpr int num_tasks = 100;
+
+template <typename FuncT>
+std::shared_ptr<Task<void>>
+make_task(FuncT&& _func)
+{
+    return std::make_shared<Task<void>>(true, 0, std::forward<FuncT>(_func));
+}
+
+// holds the single worker of the pool until released
+struct worker_gate
+{
+    std::atomic<bool> started{ false };
+    std::atomic<bool> released{ false };
+
+    void hold(ThreadPool& _tp)
+    {
+        _tp.add_task(make_task([this]() {
+            started = true;
+            while(!released.load())
+                std::this_thread::yield();
+        }));
+        while(!started.load())
+            std::this_thread::yield();
+    }
+};
+}  // namespace
+
+//--------------------------------------------------------------------------------------//
+
+int
+main()
+{
+    ThreadPool::Config _cfg{};
+    _cfg.pool_size = 1;
+    ThreadPool tp{ _cfg };
+
+    worker_gate _gate{};
+    _gate.hold(tp);
+
+    std::thread([&tp]() {
+        PTL_CHECK(!tp.is_attached());
+        ThreadPool::ScopedAttach _attach{ &tp };
+        PTL_CHECK(tp.is_attached());
+        PTL_CHECK(!tp.attach());
+
+        // the worker is held so the attached thread executes the tasks of its group
+        auto           _self = std::this_thread::get_id();
+        TaskGroup<int> tg([](int& lhs, int rhs) { return lhs += rhs; }, &tp);
+        for(int i = 0; i < num_tasks; ++i)
+            tg.exec([_self]() { return (std::this_thread::get_id() == _self) ? 1 : 0; });
+        PTL_CHECK(tg.join() == num_tasks);
+
+        // the tasks submitted by another thread go through the inbox
+        std::atomic<int> _count{ 0 };
+        std::thread([&tp, &_count]() {
+            for(int i = 0; i < num_tasks; ++i)
+                tp.add_task(make_task([&_count]() { ++_count; }));
+        }).join();
+        tp.execute_until([&_count]() { return _count.load() == num_tasks; });
+        PTL_CHECK(_count.load() == num_tasks);
+
+        // a task submitted while the thread waits in execute_until wakes it up
+        std::atomic<bool> _done{ false };
+        std::thread       _late([&tp, &_done]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds{ 20 });
+            tp.add_task(make_task([&_done]() { _done = true; }));
+        });
+        tp.execute_until([&_done]() { return _done.load(); });
+        _late.join();
+        PTL_CHECK(_done.load());
+    }).join();
+
+    _gate.released = true;
+
+    // the threads of the pool cannot attach and a detached thread only waits
+    std::atomic<bool> _worker_attached{ true };
+    {
+        TaskGroup<void> tg(&tp);
+        tg.exec([&tp, &_worker_attached]() { _worker_attached = tp.attach(); });
+        tg.join();
+    }
+    PTL_CHECK(!_worker_attached.load());
+
+    std::thread([&tp]() {
+        PTL_CHECK(tp.attach());
+        tp.detach();
+        PTL_CHECK(!tp.is_attached());
+
+        std::atomic<int> _count{ 0 };
+        tp.add_task(make_task([&_count]() { ++_count; }));
+        tp.execute_until([&_count]() { return _count.load() == 1; });
+    }).join();
+
+    // the threads attached at the same time take their tasks from different bins
+    std::atomic<int>        _nattached{ 0 };
+    std::array<intmax_t, 2> _bins{};
+    auto                    _attach_bin = [&tp, &_nattached, &_bins](size_t _i) {
+        ThreadPool::ScopedAttach _attach{ &tp };
+        _bins.at(_i) = tp.get_queue()->GetThreadBin();
+        ++_nattached;
+        while(_nattached.load() < 2)
+            std::this_thread::yield();
+    };
+    std::thread _first(_attach_bin, 0);
+    std::thread _second(_attach_bin, 1);
+    _first.join();
+    _second.join();
+    PTL_CHECK(_bins.at(0) != _bins.at(1));
+
+    tp.destroy_threadpool();
+
+    // nor to a pool which is not running
+    std::thread([&tp]() { PTL_CHECK(!tp.attach()); }).join();
+    return ptl_test::result();
+}
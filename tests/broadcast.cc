@@ -0,0 +1,216 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+/// \file broadcast.cc
+/// \brief A broadcast executes its function exactly once on every worker, whether it
+/// is issued from the main thread, from several threads at once or from a task, and
+/// returns the number of threads which executed it. A targeted broadcast only waits on
+/// the targeted workers and, once the pool is stopped, only executes on a targeted
+/// caller. With the TBB backend it executes at most once per thread
+
+#include "ptl_test.hh"
+
+#include "PTL/TaskGroup.hh"
+#include "PTL/ThreadPool.hh"
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace PTL;
+
+namespace
+{
+constexpr size_t pool_size      = 4;
+constexpr int    num_broadcasts = 50;
+constexpr int    num_callers    = 3;
+
+using count_map_t = std::map<std::thread::id, int>;
+
+// the number of times each thread executed the function of a broadcast
+struct broadcast_counter
+{
+    std::mutex  mutex{};
+    count_map_t counts{};
+
+    void operator()()
+    {
+        std::lock_guard<std::mutex> _lk(mutex);
+        ++counts[std::this_thread::get_id()];
+    }
+
+    bool once_on(size_t _n)
+    {
+        std::lock_guard<std::mutex> _lk(mutex);
+        if(counts.size() != _n)
+            return false;
+        for(const auto& itr : counts)
+        {
+            if(itr.second != 1)
+                return false;
+        }
+        return true;
+    }
+};
+}  // namespace
+
+//--------------------------------------------------------------------------------------//
+
+int
+main()
+{
+    ThreadPool::Config _cfg{};
+    _cfg.pool_size = pool_size;
+    ThreadPool tp{ _cfg };
+
+    // from the main thread, which does not take part
+    std::set<std::thread::id> _workers{};
+    for(int i = 0; i < num_broadcasts; ++i)
+    {
+        broadcast_counter _counter{};
+        PTL_CHECK(tp.execute_on_all_threads([&_counter]() { _counter(); }) == pool_size);
+        PTL_CHECK(_counter.once_on(pool_size));
+        for(const auto& itr : _counter.counts)
+            _workers.insert(itr.first);
+    }
+    PTL_CHECK(_workers.size() == pool_size);
+    PTL_CHECK(_workers.count(std::this_thread::get_id()) == 0);
+
+    // from several threads at once: the broadcasts wait for each other
+    std::atomic<int>         _failed{ 0 };
+    std::vector<std::thread> _callers{};
+    for(int c = 0; c < num_callers; ++c)
+    {
+        _callers.emplace_back([&tp, &_failed]() {
+            for(int i = 0; i < num_broadcasts; ++i)
+            {
+                broadcast_counter _counter{};
+                tp.execute_on_all_threads([&_counter]() { _counter(); });
+                if(!_counter.once_on(pool_size))
+                    ++_failed;
+            }
+        });
+    }
+
+    // from the tasks of the pool while the other broadcasts are in progress: the
+    // calling worker executes the function itself
+    {
+        TaskGroup<void> tg(&tp);
+        for(int i = 0; i < num_broadcasts; ++i)
+        {
+            tg.exec([&tp, &_failed]() {
+                broadcast_counter _counter{};
+                tp.execute_on_all_threads([&_counter]() { _counter(); });
+                if(!_counter.once_on(pool_size))
+                    ++_failed;
+            });
+        }
+        tg.join();
+    }
+
+    for(auto& itr : _callers)
+        itr.join();
+    PTL_CHECK(_failed.load() == 0);
+
+    // only on the specified workers
+    std::set<std::thread::id> _subset{ *_workers.begin(), *_workers.rbegin() };
+    for(int i = 0; i < num_broadcasts; ++i)
+    {
+        broadcast_counter _counter{};
+        auto _n = tp.execute_on_specific_threads(_subset, [&_counter]() { _counter(); });
+        PTL_CHECK(_n == _subset.size());
+        PTL_CHECK(_counter.once_on(_subset.size()));
+        for(const auto& itr : _counter.counts)
+            PTL_CHECK(_subset.count(itr.first) == 1);
+    }
+
+    // a busy worker which is not targeted does not delay the broadcast: the worker is
+    // held until the broadcast returns (or, if the broadcast waits on it, for 5 s)
+    {
+        std::atomic<bool>            _held{ false };
+        std::atomic<bool>            _released{ false };
+        std::atomic<bool>            _expired{ false };
+        std::atomic<std::thread::id> _busy{};
+        TaskGroup<void>              tg(&tp);
+        tg.exec([&]() {
+            _busy     = std::this_thread::get_id();
+            _held     = true;
+            auto _end = std::chrono::steady_clock::now() + std::chrono::seconds{ 5 };
+            while(!_released.load())
+            {
+                if(std::chrono::steady_clock::now() > _end)
+                {
+                    _expired = true;
+                    break;
+                }
+                std::this_thread::yield();
+            }
+        });
+        while(!_held.load())
+            std::this_thread::yield();
+
+        std::set<std::thread::id> _others = _workers;
+        _others.erase(_busy.load());
+        broadcast_counter _counter{};
+        auto _n = tp.execute_on_specific_threads(_others, [&_counter]() { _counter(); });
+        _released = true;
+        tg.join();
+        PTL_CHECK(!_expired.load());
+        PTL_CHECK(_n == _others.size());
+        PTL_CHECK(_counter.once_on(_others.size()));
+    }
+
+    tp.destroy_threadpool();
+
+    // once the pool is stopped, the function is only executed by a targeted caller
+    {
+        broadcast_counter _counter{};
+        auto              _func = [&_counter]() { _counter(); };
+        PTL_CHECK(tp.execute_on_specific_threads(_subset, _func) == 0);
+        PTL_CHECK(_counter.counts.empty());
+        PTL_CHECK(tp.execute_on_specific_threads({ std::this_thread::get_id() }, _func) ==
+                  1);
+        PTL_CHECK(tp.execute_on_all_threads(_func) == 1);
+        PTL_CHECK(_counter.counts.size() == 1 &&
+                  _counter.counts.begin()->second == 2);
+    }
+
+#if defined(PTL_USE_TBB)
+    // the threads joining the arena of a TBB pool execute the function at most once
+    // and the count says how many did
+    ThreadPool::Config _tbb_cfg{};
+    _tbb_cfg.use_tbb   = true;
+    _tbb_cfg.pool_size = pool_size;
+    ThreadPool _tbb_tp{ _tbb_cfg };
+    for(int i = 0; i < num_broadcasts; ++i)
+    {
+        broadcast_counter _counter{};
+        auto _n = _tbb_tp.execute_on_all_threads([&_counter]() { _counter(); });
+        PTL_CHECK(_n >= 1 && _n <= pool_size);
+        PTL_CHECK(_counter.once_on(_n));
+    }
+    _tbb_tp.destroy_threadpool();
+#endif
+
+    return ptl_test::result();
+}
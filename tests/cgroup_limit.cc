@@ -0,0 +1,171 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+/// \file cgroup_limit.cc
+/// \brief CPU limits read from cgroup v1 and v2 fixture files in a temporary directory
+
+#include "ptl_fixture.hh"
+#include "ptl_test.hh"
+
+#include "PTL/Concurrency.hh"
+#include "PTL/Threading.hh"
+#include "PTL/Topology.hh"
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+using namespace PTL;
+
+namespace
+{
+using ptl_test::write_file;
+
+bool
+near(double _lhs, double _rhs)
+{
+    return std::fabs(_lhs - _rhs) < 1.0e-9;
+}
+
+// paths of the /proc/self/cgroup file and of the cgroup mount in the fixture
+struct fixture : ptl_test::fixture_dir
+{
+    std::string proc() const { return root + "/proc_self_cgroup"; }
+    std::string cgroup() const { return root + "/cgroup"; }
+};
+}  // namespace
+
+//--------------------------------------------------------------------------------------//
+
+void
+test_parse()
+{
+    PTL_CHECK(near(concurrency::parse_cpu_max("max 100000\n"), 0.0));
+    PTL_CHECK(near(concurrency::parse_cpu_max("max\n"), 0.0));
+    PTL_CHECK(near(concurrency::parse_cpu_max("250000 100000\n"), 2.5));
+    PTL_CHECK(near(concurrency::parse_cpu_max("50000 100000\n"), 0.5));
+    PTL_CHECK(near(concurrency::parse_cpu_max("150000\n"), 1.5));
+    PTL_CHECK(near(concurrency::parse_cpu_max("100000 0\n"), 0.0));
+    PTL_CHECK(near(concurrency::parse_cpu_max(""), 0.0));
+    PTL_CHECK(near(concurrency::parse_cpu_max("garbage 100000"), 0.0));
+
+    PTL_CHECK(near(concurrency::parse_cfs_quota(-1, 100000), 0.0));
+    PTL_CHECK(near(concurrency::parse_cfs_quota(200000, 100000), 2.0));
+    PTL_CHECK(near(concurrency::parse_cfs_quota(50000, 0), 0.0));
+
+    // the limit is rounded up and never reduces the CPUs below one
+    PTL_CHECK(concurrency::effective_concurrency(8, 2.5) == 3);
+    PTL_CHECK(concurrency::effective_concurrency(8, 0.5) == 1);
+    PTL_CHECK(concurrency::effective_concurrency(8, 0.0) == 8);
+    PTL_CHECK(concurrency::effective_concurrency(2, 4.0) == 2);
+    PTL_CHECK(concurrency::effective_concurrency(0, 0.0) == 1);
+}
+
+//--------------------------------------------------------------------------------------//
+
+void
+test_v2()
+{
+    // the most restrictive limit along the nested path of the process is used
+    fixture _f{};
+    write_file(_f.proc(), "0::/user.slice/app.scope\n");
+    write_file(_f.cgroup() + "/cpu.max", "max 100000\n");
+    write_file(_f.cgroup() + "/user.slice/cpu.max", "250000 100000\n");
+    write_file(_f.cgroup() + "/user.slice/app.scope/cpu.max", "max 100000\n");
+    PTL_CHECK(near(concurrency::cgroup_cpu_limit(_f.proc(), _f.cgroup()), 2.5));
+
+    write_file(_f.cgroup() + "/user.slice/app.scope/cpu.max", "120000 100000\n");
+    PTL_CHECK(near(concurrency::cgroup_cpu_limit(_f.proc(), _f.cgroup()), 1.2));
+
+    // without /proc/self/cgroup the root of the hierarchy is read
+    auto _missing = _f.root + "/missing";
+    PTL_CHECK(near(concurrency::cgroup_cpu_limit(_missing, _f.cgroup()), 0.0));
+    write_file(_f.cgroup() + "/cpu.max", "300000 100000\n");
+    PTL_CHECK(near(concurrency::cgroup_cpu_limit(_missing, _f.cgroup()), 3.0));
+}
+
+//--------------------------------------------------------------------------------------//
+
+void
+test_v1()
+{
+    fixture _f{};
+    write_file(_f.proc(), "12:memory:/docker/abc\n"
+                          "4:cpu,cpuacct:/docker/abc\n"
+                          "1:name=systemd:/docker/abc\n");
+
+    // a quota of -1 is unlimited
+    auto _dir = _f.cgroup() + "/cpu,cpuacct/docker/abc";
+    write_file(_dir + "/cpu.cfs_quota_us", "-1\n");
+    write_file(_dir + "/cpu.cfs_period_us", "100000\n");
+    PTL_CHECK(near(concurrency::cgroup_cpu_limit(_f.proc(), _f.cgroup()), 0.0));
+
+    write_file(_dir + "/cpu.cfs_quota_us", "150000\n");
+    PTL_CHECK(near(concurrency::cgroup_cpu_limit(_f.proc(), _f.cgroup()), 1.5));
+
+    // a more restrictive parent wins
+    auto _parent = _f.cgroup() + "/cpu,cpuacct/docker";
+    write_file(_parent + "/cpu.cfs_quota_us", "100000\n");
+    write_file(_parent + "/cpu.cfs_period_us", "100000\n");
+    PTL_CHECK(near(concurrency::cgroup_cpu_limit(_f.proc(), _f.cgroup()), 1.0));
+
+    // a level missing the period is skipped
+    remove((_parent + "/cpu.cfs_period_us").c_str());
+    PTL_CHECK(near(concurrency::cgroup_cpu_limit(_f.proc(), _f.cgroup()), 1.5));
+}
+
+//--------------------------------------------------------------------------------------//
+
+void
+test_missing()
+{
+    // no cgroup files at all means no limit
+    fixture _f{};
+    write_file(_f.proc(), "0::/user.slice\n");
+    PTL_CHECK(near(concurrency::cgroup_cpu_limit(_f.proc(), _f.cgroup()), 0.0));
+    auto _missing = _f.root + "/missing";
+    PTL_CHECK(near(concurrency::cgroup_cpu_limit(_missing, _f.root + "/none"), 0.0));
+}
+
+//--------------------------------------------------------------------------------------//
+
+int
+main()
+{
+    // the first call comes from a thread pinned to one CPU but the value is computed
+    // from the affinity mask of the process
+    unsigned _pinned = 0;
+    std::thread{ [&_pinned]() {
+        Threading::SetPinAffinity(Topology::allowed_cpus().front());
+        _pinned = effective_concurrency();
+    } }.join();
+    auto _expected = concurrency::effective_concurrency(concurrency::affinity_cpus(),
+                                                        concurrency::cgroup_cpu_limit());
+    PTL_CHECK(_pinned >= 1);
+    PTL_CHECK(_pinned == _expected);
+    PTL_CHECK(effective_concurrency() == _pinned);
+
+    test_parse();
+    test_v2();
+    test_v1();
+    test_missing();
+
+    return ptl_test::result();
+}
@@ -0,0 +1,131 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+/// \file coroutine.cc
+/// \brief A CoTask hops onto the thread-pool with resume_on, suspends on a TaskGroup
+/// until its tasks complete and propagates its exception through sync_wait
+
+#include "ptl_test.hh"
+
+#include "PTL/Coroutine.hh"
+#include "PTL/TaskGroup.hh"
+#include "PTL/ThreadPool.hh"
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace PTL;
+
+namespace
+{
+constexpr int num_tasks = 200;
+
+CoTask<std::thread::id>
+hop(ThreadPool* tp)
+{
+    co_await resume_on(tp);
+    co_return std::this_thread::get_id();
+}
+
+CoTask<int>
+await_group(ThreadPool* tp, std::atomic<int>* _executed)
+{
+    co_await resume_on(tp);
+    TaskGroup<int> tg([](int& lhs, int rhs) { return lhs += rhs; }, tp);
+    for(int i = 0; i < num_tasks; ++i)
+    {
+        tg.exec([_executed, i]() {
+            ++(*_executed);
+            return i;
+        });
+    }
+    // every task has completed once the coroutine is resumed
+    int _sum = co_await tg;
+    co_return (_executed->load() == num_tasks) ? _sum : -1;
+}
+
+// awaits another CoTask on the pool so the exception crosses a continuation
+CoTask<int>
+throw_on_pool(ThreadPool* tp)
+{
+    co_await resume_on(tp);
+    throw std::runtime_error{ "thrown on the pool" };
+    co_return 0;
+}
+
+CoTask<int>
+await_throw(ThreadPool* tp)
+{
+    int _v = co_await throw_on_pool(tp);
+    co_return _v + 1;
+}
+
+void
+test_resume_on(ThreadPool& tp)
+{
+    auto _main = std::this_thread::get_id();
+    auto _id   = sync_wait(hop(&tp));
+    PTL_CHECK(_id != _main);
+}
+
+void
+test_task_group(ThreadPool& tp)
+{
+    std::atomic<int> _executed{ 0 };
+    PTL_CHECK(sync_wait(await_group(&tp, &_executed)) ==
+              num_tasks * (num_tasks - 1) / 2);
+    PTL_CHECK(_executed.load() == num_tasks);
+}
+
+void
+test_exception(ThreadPool& tp)
+{
+    bool _caught = false;
+    try
+    {
+        sync_wait(await_throw(&tp));
+    } catch(std::runtime_error& e)
+    {
+        _caught = (std::string{ e.what() } == "thrown on the pool");
+    }
+    PTL_CHECK(_caught);
+}
+}  // namespace
+
+//--------------------------------------------------------------------------------------//
+
+int
+main()
+{
+    ThreadPool::Config _cfg{};
+    _cfg.pool_size = 4;
+    ThreadPool tp{ _cfg };
+
+    for(int i = 0; i < 20; ++i)
+    {
+        test_resume_on(tp);
+        test_task_group(tp);
+        test_exception(tp);
+    }
+
+    tp.destroy_threadpool();
+    return ptl_test::result();
+}
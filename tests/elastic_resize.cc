@@ -0,0 +1,116 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+/// \file elastic_resize.cc
+/// \brief Tasks submitted while an elastic ThreadPool grows on its own and is resized
+/// concurrently are all executed exactly once
+
+#include "ptl_test.hh"
+
+#include "PTL/TaskGroup.hh"
+#include "PTL/ThreadPool.hh"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace PTL;
+
+namespace
+{
+constexpr int num_submitters = 3;
+constexpr int num_rounds     = 20;
+constexpr int num_tasks      = 500;
+
+// keeps the queue backed up long enough for the pool to grow
+int
+busy_work(int _n)
+{
+    volatile int _v = 0;
+    for(int i = 0; i < _n; ++i)
+        _v = _v + i;
+    return 1;
+}
+}  // namespace
+
+//--------------------------------------------------------------------------------------//
+
+int
+main()
+{
+    ThreadPool::Config _cfg{};
+    _cfg.pool_size     = 1;
+    _cfg.elastic       = true;
+    _cfg.min_pool_size = 1;
+    _cfg.max_pool_size = 4;
+    _cfg.grow_delay    = std::chrono::milliseconds{ 1 };
+    _cfg.linger        = std::chrono::milliseconds{ 5 };
+    ThreadPool tp{ _cfg };
+
+    std::atomic<int>         _nested{ 0 };
+    std::atomic<int>         _finished{ 0 };
+    std::vector<int>         _sums(num_submitters, 0);
+    std::vector<std::thread> _submitters{};
+
+    // each submitter joins its rounds while the pool size changes underneath it and
+    // half of the tasks insert a task from the worker into the bin of the worker
+    for(int i = 0; i < num_submitters; ++i)
+    {
+        _submitters.emplace_back([&tp, &_nested, &_finished, &_sums, i]() {
+            for(int r = 0; r < num_rounds; ++r)
+            {
+                TaskGroup<int> tg([](int& lhs, int rhs) { return lhs += rhs; }, &tp);
+                for(int j = 0; j < num_tasks; ++j)
+                {
+                    tg.exec([&tp, &_nested, j]() {
+                        if(j % 2 == 0)
+                        {
+                            TaskGroup<void> nested{ &tp };
+                            nested.exec([&_nested]() { ++_nested; });
+                            nested.join();
+                        }
+                        return busy_work(1000);
+                    });
+                }
+                _sums.at(i) += tg.join();
+            }
+            ++_finished;
+        });
+    }
+
+    // grow and shrink the pool (and its queue) while the tasks are submitted
+    size_t _n = 0;
+    while(_finished.load() < num_submitters)
+    {
+        tp.resize(1 + (_n++ % 4));
+        std::this_thread::sleep_for(std::chrono::microseconds{ 500 });
+    }
+
+    for(auto& itr : _submitters)
+        itr.join();
+
+    for(auto& itr : _sums)
+        PTL_CHECK(itr == num_rounds * num_tasks);
+    PTL_CHECK(_nested.load() == num_submitters * num_rounds * num_tasks / 2);
+    PTL_CHECK(tp.size() >= 1 && tp.size() <= 4);
+
+    tp.destroy_threadpool();
+    return ptl_test::result();
+}
@@ -0,0 +1,121 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+/// \file elastic_retire.cc
+/// \brief Idle workers of an elastic ThreadPool retire while bursts of tasks make other
+/// threads grow the pool, without losing a task or leaving the size out of its limits
+
+#include "ptl_test.hh"
+
+#include "PTL/TaskGroup.hh"
+#include "PTL/ThreadPool.hh"
+#include "PTL/VUserTaskQueue.hh"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace PTL;
+
+namespace
+{
+constexpr int    num_submitters = 4;
+constexpr int    num_bursts     = 40;
+constexpr int    num_tasks      = 200;
+constexpr size_t max_size       = 4;
+
+int
+busy_work(int _n)
+{
+    volatile int _v = 0;
+    for(int i = 0; i < _n; ++i)
+        _v = _v + i;
+    return 1;
+}
+}  // namespace
+
+//--------------------------------------------------------------------------------------//
+
+int
+main()
+{
+    ThreadPool::Config _cfg{};
+    _cfg.pool_size     = 1;
+    _cfg.elastic       = true;
+    _cfg.min_pool_size = 1;
+    _cfg.max_pool_size = max_size;
+    _cfg.grow_delay    = std::chrono::milliseconds{ 1 };
+    _cfg.linger        = std::chrono::milliseconds{ 1 };
+    ThreadPool tp{ _cfg };
+
+    std::atomic<int>         _finished{ 0 };
+    std::atomic<bool>        _out_of_limits{ false };
+    std::vector<int>         _sums(num_submitters, 0);
+    std::vector<std::thread> _submitters{};
+
+    // the submitters are staggered so that the bursts of some of them grow the pool
+    // (from the busy workers) while the workers left idle between the bursts of the
+    // others linger and retire (shrinking the queue)
+    for(int i = 0; i < num_submitters; ++i)
+    {
+        _submitters.emplace_back([&tp, &_finished, &_sums, i]() {
+            for(int b = 0; b < num_bursts; ++b)
+            {
+                TaskGroup<int> tg([](int& lhs, int rhs) { return lhs += rhs; }, &tp);
+                for(int j = 0; j < num_tasks; ++j)
+                    tg.exec([]() { return busy_work(2000); });
+                _sums.at(i) += tg.join();
+                std::this_thread::sleep_for(std::chrono::milliseconds{ 1 + (b + i) % 4 });
+            }
+            ++_finished;
+        });
+    }
+
+    // the size is read without a lock while it changes
+    while(_finished.load() < num_submitters)
+    {
+        auto _size = tp.size();
+        if(_size < 1 || _size > max_size)
+            _out_of_limits = true;
+        std::this_thread::yield();
+    }
+
+    for(auto& itr : _submitters)
+        itr.join();
+
+    for(auto& itr : _sums)
+        PTL_CHECK(itr == num_bursts * num_tasks);
+    PTL_CHECK(!_out_of_limits.load());
+
+    // with nothing left to do the pool shrinks back to the minimum
+    for(int i = 0; i < 2000 && tp.size() > 1; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+    PTL_CHECK(tp.size() == 1);
+    PTL_CHECK(tp.get_queue()->workers() == 1);
+
+    // and grows again
+    TaskGroup<int> tg([](int& lhs, int rhs) { return lhs += rhs; }, &tp);
+    for(int j = 0; j < 4 * num_tasks; ++j)
+        tg.exec([]() { return busy_work(2000); });
+    PTL_CHECK(tg.join() == 4 * num_tasks);
+
+    tp.destroy_threadpool();
+    return ptl_test::result();
+}
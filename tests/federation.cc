@@ -0,0 +1,123 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+/// \file federation.cc
+/// \brief The idle workers of a linked ThreadPool execute tasks of the donor pool and
+/// the links are removed when the donor is deleted while the helpers are stealing
+
+#include "ptl_test.hh"
+
+#include "PTL/TaskGroup.hh"
+#include "PTL/ThreadPool.hh"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+
+using namespace PTL;
+
+namespace
+{
+constexpr int num_tasks  = 200;
+constexpr int num_donors = 20;
+
+using thread_set_t = std::set<std::thread::id>;
+
+void
+sleep_for(int _ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds{ _ms });
+}
+}  // namespace
+
+//--------------------------------------------------------------------------------------//
+
+int
+main()
+{
+    ThreadPool::Config _cfg{};
+    _cfg.pool_size = 3;
+    ThreadPool helper{ _cfg };
+
+    std::mutex   _mutex{};
+    thread_set_t _helper_threads{};
+    {
+        TaskGroup<void> tg(&helper);
+        for(int i = 0; i < 30; ++i)
+            tg.exec([&]() {
+                sleep_for(2);
+                std::lock_guard<std::mutex> _lk(_mutex);
+                _helper_threads.insert(std::this_thread::get_id());
+            });
+        tg.join();
+    }
+
+    // a single busy worker in the donor leaves a backlog for the helpers
+    {
+        _cfg.pool_size = 1;
+        ThreadPool donor{ _cfg };
+        helper.link_pool(&donor);
+
+        std::atomic<int> _count{ 0 };
+        std::atomic<int> _helped{ 0 };
+        TaskGroup<void>  tg(&donor);
+        for(int i = 0; i < num_tasks; ++i)
+            tg.exec([&]() {
+                sleep_for(1);
+                ++_count;
+                std::lock_guard<std::mutex> _lk(_mutex);
+                if(_helper_threads.count(std::this_thread::get_id()) > 0)
+                    ++_helped;
+            });
+        tg.join();
+
+        PTL_CHECK(_count.load() == num_tasks);
+        PTL_CHECK(_helped.load() > 0);
+        donor.destroy_threadpool();
+    }
+
+    // the donors are deleted without destroy_threadpool() while the idle helpers keep
+    // polling their queues
+    for(int n = 0; n < num_donors; ++n)
+    {
+        auto* donor = new ThreadPool{ _cfg };
+        helper.link_pool(donor);
+
+        std::atomic<int> _count{ 0 };
+        TaskGroup<void>  tg(donor);
+        for(int i = 0; i < num_tasks / 4; ++i)
+            tg.exec([&]() { ++_count; });
+        tg.join();
+        PTL_CHECK(_count.load() == num_tasks / 4);
+        delete donor;
+    }
+
+    // and the helper is left without dangling links
+    std::atomic<int> _count{ 0 };
+    TaskGroup<void>  tg(&helper);
+    for(int i = 0; i < num_tasks; ++i)
+        tg.exec([&]() { ++_count; });
+    tg.join();
+    PTL_CHECK(_count.load() == num_tasks);
+
+    helper.destroy_threadpool();
+    return ptl_test::result();
+}
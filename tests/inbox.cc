@@ -0,0 +1,178 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+/// \file inbox.cc
+/// \brief The tasks submitted by threads outside of the pool are moved from the inbox
+/// into the queue in batches without losing a task and the batches keep the NUMA
+/// node requested by the tasks
+
+#include "ptl_test.hh"
+
+#include "PTL/Task.hh"
+#include "PTL/TaskGroup.hh"
+#include "PTL/ThreadPool.hh"
+#include "PTL/Topology.hh"
+#include "PTL/UserTaskQueue.hh"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace PTL;
+
+namespace
+{
+constexpr int num_producers = 4;
+constexpr int num_tasks     = 1000;
+
+using task_list_t = VUserTaskQueue::task_list_t;
+
+std::shared_ptr<Task<void>>
+make_task(int _node)
+{
+    auto _task = std::make_shared<Task<void>>(true, 0, []() {});
+    _task->set_numa_node(_node);
+    return _task;
+}
+
+// exposes the bins of the queue
+struct probe_queue : UserTaskQueue
+{
+    using UserTaskQueue::GetNumBins;
+    using UserTaskQueue::GetSubQueues;
+    using UserTaskQueue::UserTaskQueue;
+};
+
+//--------------------------------------------------------------------------------------//
+
+void
+test_producers()
+{
+    ThreadPool::Config _cfg{};
+    _cfg.pool_size = 4;
+    ThreadPool tp{ _cfg };
+
+    // the producers are not threads of the pool so their tasks go through the inbox
+    std::vector<long>        _sums(num_producers, 0);
+    std::vector<std::thread> _producers{};
+    for(int p = 0; p < num_producers; ++p)
+    {
+        _producers.emplace_back([&tp, &_sums, p]() {
+            TaskGroup<long> tg([](long& lhs, long rhs) { return lhs += rhs; }, &tp);
+            for(long i = 0; i < num_tasks; ++i)
+                tg.exec([i]() { return i; });
+            _sums.at(p) = tg.join();
+        });
+    }
+    for(auto& itr : _producers)
+        itr.join();
+
+    for(auto& itr : _sums)
+        PTL_CHECK(itr == static_cast<long>(num_tasks) * (num_tasks - 1) / 2);
+    tp.destroy_threadpool();
+}
+
+//--------------------------------------------------------------------------------------//
+
+void
+test_batches()
+{
+    ThreadPool::Config _cfg{};
+    _cfg.pool_size = 4;
+    ThreadPool tp{ _cfg };
+
+    // a burst larger than a batch from the idle pool is spread over the workers and
+    // the tasks requesting a NUMA node are executed like the others
+    std::mutex                _mutex{};
+    std::set<std::thread::id> _threads{};
+    std::atomic<int>          _count{ 0 };
+    for(int i = 0; i < num_tasks; ++i)
+    {
+        auto _task = std::make_shared<Task<void>>(true, 0, [&]() {
+            std::this_thread::sleep_for(std::chrono::microseconds{ 100 });
+            {
+                std::lock_guard<std::mutex> _lk(_mutex);
+                _threads.insert(std::this_thread::get_id());
+            }
+            ++_count;
+        });
+        _task->set_numa_node(i % 2 - 1);
+        tp.add_task(std::move(_task));
+    }
+    while(_count.load() < num_tasks)
+        std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+
+    PTL_CHECK(_threads.size() > 1);
+    PTL_CHECK(_threads.count(std::this_thread::get_id()) == 0);
+    tp.destroy_threadpool();
+}
+
+//--------------------------------------------------------------------------------------//
+
+void
+test_numa_bins()
+{
+    // the queue is only partitioned by NUMA node on a machine with several nodes
+    if(Topology::instance().num_nodes() < 2)
+        return;
+
+    // the first half of the bins belongs to node 0 and the other half to node 1
+    probe_queue _queue{ 3 };
+    auto&       _bins  = _queue.GetSubQueues();
+    auto        _nbins = _queue.GetNumBins();
+    for(intmax_t i = 0; i < _nbins; ++i)
+        _bins[i]->SetNode((2 * i < _nbins) ? 0 : 1);
+
+    task_list_t _tasks{};
+    for(int i = 0; i < 3 * num_tasks; ++i)
+        _tasks.emplace_back(make_task(i % 3 - 1));
+    PTL_CHECK(_queue.InsertTasks(std::move(_tasks)) == 3 * num_tasks);
+
+    int _total    = 0;
+    int _misplace = 0;
+    for(intmax_t i = 0; i < _nbins; ++i)
+    {
+        PTL_CHECK(_bins[i]->AcquireClaim());
+        while(auto _task = _bins[i]->PopTask())
+        {
+            if(_task->numa_node() >= 0 && _task->numa_node() != _bins[i]->GetNode())
+                ++_misplace;
+            ++_total;
+        }
+        _bins[i]->ReleaseClaim();
+    }
+    PTL_CHECK(_total == 3 * num_tasks);
+    PTL_CHECK(_misplace == 0);
+}
+}  // namespace
+
+//--------------------------------------------------------------------------------------//
+
+int
+main()
+{
+    test_producers();
+    test_batches();
+    test_numa_bins();
+    return ptl_test::result();
+}
@@ -0,0 +1,167 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+/// \file latency_histogram.cc
+/// \brief The percentiles of a LatencyHistogram are within the width of a bucket of
+/// the exact percentiles of the recorded values, whether the values are recorded by
+/// several threads or merged from several histograms, and the workers of a pool
+/// record the service time of every task when TaskLatency is enabled
+
+#include "ptl_test.hh"
+
+#include "PTL/LatencyHistogram.hh"
+#include "PTL/TaskGroup.hh"
+#include "PTL/ThreadPool.hh"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using namespace PTL;
+
+namespace
+{
+constexpr uint64_t num_values  = 1000;
+constexpr uint64_t unit        = 1000;  // the values are 1 to 1000 microseconds
+constexpr int      num_threads = 4;
+constexpr int      num_tasks   = 50;
+
+// the value of rank ceil(p% of the count) of the values 1, 2, ... num_values (x unit)
+uint64_t
+exact_percentile(double _p)
+{
+    auto _rank = static_cast<uint64_t>(std::ceil(_p / 100.0 * num_values));
+    return ((_rank > 0) ? _rank : 1) * unit;
+}
+
+// true if the percentiles are the exact ones rounded up to the end of their bucket
+bool
+check_percentiles(const LatencyHistogram& _hist)
+{
+    for(double _p : { 0.0, 1.0, 10.0, 25.0, 50.0, 75.0, 90.0, 99.0, 99.9, 100.0 })
+    {
+        auto _exact = exact_percentile(_p);
+        auto _v     = _hist.percentile(_p);
+        if(_v < _exact || _v > _exact + _exact / LatencyHistogram::sub_buckets)
+            return false;
+    }
+    return true;
+}
+}  // namespace
+
+//--------------------------------------------------------------------------------------//
+
+int
+main()
+{
+    // an empty histogram
+    LatencyHistogram _empty{};
+    PTL_CHECK(_empty.count() == 0);
+    PTL_CHECK(_empty.percentile(50.0) == 0);
+    PTL_CHECK(_empty.min() == 0 && _empty.max() == 0 && _empty.mean() == 0.0);
+
+    // the small values have a bucket of their own
+    LatencyHistogram _small{};
+    for(uint64_t i = 1; i <= 10; ++i)
+        _small.record(i);
+    PTL_CHECK(_small.percentile(50.0) == 5);
+    PTL_CHECK(_small.percentile(90.0) == 9);
+    PTL_CHECK(_small.percentile(100.0) == 10);
+    PTL_CHECK(_small.mean() == 5.5);
+
+    // every value lies within its bucket, which is at most 1/16 of the value wide
+    for(uint64_t _v : { uint64_t{ 15 }, uint64_t{ 16 }, uint64_t{ 17 }, uint64_t{ 1000 },
+                        uint64_t{ 1023 }, uint64_t{ 1024 }, uint64_t{ 123456789 },
+                        UINT64_MAX })
+    {
+        auto _bucket = LatencyHistogram::bucket(_v);
+        auto _lower  = LatencyHistogram::lower_bound(_bucket);
+        auto _upper  = LatencyHistogram::upper_bound(_bucket);
+        PTL_CHECK(_bucket < LatencyHistogram::num_buckets);
+        PTL_CHECK(_lower <= _v && _v <= _upper);
+        PTL_CHECK(_upper - _lower <= _lower / LatencyHistogram::sub_buckets);
+    }
+
+    // known values recorded by one thread
+    LatencyHistogram _hist{};
+    for(uint64_t i = 1; i <= num_values; ++i)
+        _hist.record(i * unit);
+    PTL_CHECK(_hist.count() == num_values);
+    PTL_CHECK(_hist.min() == unit);
+    PTL_CHECK(_hist.max() == num_values * unit);
+    PTL_CHECK(_hist.mean() == 0.5 * (num_values + 1) * unit);
+    PTL_CHECK(check_percentiles(_hist));
+
+    // the same values recorded by several threads at once
+    LatencyHistogram         _shared{};
+    std::vector<std::thread> _threads{};
+    for(int t = 0; t < num_threads; ++t)
+    {
+        _threads.emplace_back([t, &_shared]() {
+            for(uint64_t i = 1 + t; i <= num_values; i += num_threads)
+                _shared.record(i * unit);
+        });
+    }
+    for(auto& itr : _threads)
+        itr.join();
+    PTL_CHECK(_shared.count() == num_values);
+    PTL_CHECK(check_percentiles(_shared));
+
+    // the odd and the even values merged
+    LatencyHistogram _odd{};
+    LatencyHistogram _even{};
+    for(uint64_t i = 1; i <= num_values; ++i)
+        ((i % 2 == 1) ? _odd : _even).record(i * unit);
+    LatencyHistogram _merged{ _odd };
+    _merged.merge(_even);
+    PTL_CHECK(_merged.count() == num_values);
+    PTL_CHECK(_merged.min() == unit && _merged.max() == num_values * unit);
+    PTL_CHECK(check_percentiles(_merged));
+
+    _merged.reset();
+    PTL_CHECK(_merged.count() == 0 && _merged.percentile(99.0) == 0);
+
+#if defined(PTL_USE_STATISTICS)
+    // the service time of every task executed by the workers
+    TaskLatency::enable();
+    ThreadPool::Config _cfg{};
+    _cfg.use_tbb   = false;
+    _cfg.pool_size = 2;
+    ThreadPool tp{ _cfg };
+
+    TaskGroup<void> tg{ &tp };
+    for(int i = 0; i < num_tasks; ++i)
+        tg.exec([]() { std::this_thread::sleep_for(std::chrono::milliseconds{ 1 }); });
+    tg.join();
+
+    auto _latency = tp.get_latency();
+    PTL_CHECK(_latency.service.count() == num_tasks);
+    PTL_CHECK(_latency.queue_wait.count() == num_tasks);
+    PTL_CHECK(_latency.service.percentile(0.0) >= 1000000);
+
+    tp.reset_statistics();
+    PTL_CHECK(tp.get_latency().service.count() == 0);
+    tp.destroy_threadpool();
+    TaskLatency::disable();
+#endif
+
+    return ptl_test::result();
+}
@@ -0,0 +1,194 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+/// \file mailbox.cc
+/// \brief The tasks submitted for a specific worker are only executed by that worker,
+/// which is woken up for them while idle and which no other worker steals them from.
+/// Their enqueue event is reported before they execute
+
+#include "ptl_test.hh"
+
+#include "PTL/Task.hh"
+#include "PTL/TaskHooks.hh"
+#include "PTL/ThreadPool.hh"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace PTL;
+
+namespace
+{
+constexpr size_t pool_size = 4;
+constexpr int    num_tasks = 100;
+
+using clock_type = std::chrono::steady_clock;
+
+template <typename FuncT>
+std::shared_ptr<Task<void>>
+make_task(FuncT&& _func)
+{
+    return std::make_shared<Task<void>>(true, 0, std::forward<FuncT>(_func));
+}
+
+// waits up to ten seconds for the count to reach the value
+bool
+wait_for(const std::atomic<int>& _count, int _value)
+{
+    auto _end = clock_type::now() + std::chrono::seconds{ 10 };
+    while(_count.load() < _value && clock_type::now() < _end)
+        std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+    return (_count.load() >= _value);
+}
+}  // namespace
+
+//--------------------------------------------------------------------------------------//
+
+int
+main()
+{
+    ThreadPool::Config _cfg{};
+    _cfg.pool_size = pool_size;
+    ThreadPool tp{ _cfg };
+
+    std::mutex                _mutex{};
+    std::set<std::thread::id> _workers{};
+    tp.execute_on_all_threads([&]() {
+        std::lock_guard<std::mutex> _lk(_mutex);
+        _workers.insert(std::this_thread::get_id());
+    });
+    PTL_CHECK(_workers.size() == pool_size);
+
+    // every task runs on the worker it was submitted for, the workers are idle so each
+    // of the first tasks has to wake its worker
+    std::atomic<int> _count{ 0 };
+    std::atomic<int> _misplaced{ 0 };
+    for(int i = 0; i < num_tasks; ++i)
+    {
+        for(const auto& itr : _workers)
+        {
+            auto _tid = itr;
+            tp.add_thread_task(_tid, make_task([&_count, &_misplaced, _tid]() {
+                if(std::this_thread::get_id() != _tid)
+                    ++_misplaced;
+                ++_count;
+            }));
+        }
+    }
+    PTL_CHECK(wait_for(_count, num_tasks * static_cast<int>(pool_size)));
+    PTL_CHECK(_misplaced.load() == 0);
+
+    // one worker at a time while the pool is idle
+    for(const auto& itr : _workers)
+    {
+        std::atomic<int> _single{ 0 };
+        auto             _tid = itr;
+        tp.add_thread_task(_tid, make_task([&_single, &_misplaced, _tid]() {
+            if(std::this_thread::get_id() != _tid)
+                ++_misplaced;
+            ++_single;
+        }));
+        PTL_CHECK(wait_for(_single, 1));
+    }
+    PTL_CHECK(_misplaced.load() == 0);
+
+    // the tasks for a busy worker wait for it while the other workers are idle
+    auto              _busy = *_workers.begin();
+    std::atomic<bool> _started{ false };
+    std::atomic<bool> _release{ false };
+    tp.add_thread_task(_busy, make_task([&]() {
+        _started = true;
+        while(!_release.load())
+            std::this_thread::yield();
+    }));
+    while(!_started.load())
+        std::this_thread::yield();
+
+    _count = 0;
+    for(int i = 0; i < num_tasks; ++i)
+    {
+        tp.add_thread_task(_busy, make_task([&_count, &_misplaced, _busy]() {
+            if(std::this_thread::get_id() != _busy)
+                ++_misplaced;
+            ++_count;
+        }));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds{ 20 });
+    PTL_CHECK(_count.load() == 0);
+    _release = true;
+    PTL_CHECK(wait_for(_count, num_tasks));
+    PTL_CHECK(_misplaced.load() == 0);
+
+    // the calling thread executes its own task and other threads are rejected
+    int  _value = 0;
+    auto _self  = std::this_thread::get_id();
+    tp.add_thread_task(_self, make_task([&_value]() { _value = 1; }));
+    PTL_CHECK(_value == 1);
+
+    std::thread::id _other{};
+    std::thread([&_other]() { _other = std::this_thread::get_id(); }).join();
+    bool _thrown = false;
+    try
+    {
+        tp.add_thread_task(_other, make_task([]() {}));
+    } catch(std::runtime_error&)
+    {
+        _thrown = true;
+    }
+    PTL_CHECK(_thrown);
+
+#if defined(PTL_USE_TASK_HOOKS)
+    // the enqueue event of each task precedes its execution
+    std::set<const void*> _enqueued{};
+    std::atomic<int>      _unreported{ 0 };
+    auto                  _hook = TaskHooks::add(
+        [&](TaskHooks::event_type, const void* _task) {
+            std::lock_guard<std::mutex> _lk(_mutex);
+            _enqueued.insert(_task);
+        },
+        TaskHooks::mask(TaskHooks::enqueue));
+
+    _count = 0;
+    for(int i = 0; i < num_tasks; ++i)
+    {
+        // the task looks itself up in the reported tasks
+        auto _self = std::make_shared<const void*>(nullptr);
+        auto _task = make_task([&, _self]() {
+            std::lock_guard<std::mutex> _lk(_mutex);
+            if(_enqueued.count(*_self) == 0)
+                ++_unreported;
+            ++_count;
+        });
+        *_self = _task.get();
+        tp.add_thread_task(*_workers.rbegin(), std::move(_task));
+    }
+    PTL_CHECK(wait_for(_count, num_tasks));
+    PTL_CHECK(_unreported.load() == 0);
+    TaskHooks::remove(_hook);
+#endif
+
+    tp.destroy_threadpool();
+    return ptl_test::result();
+}
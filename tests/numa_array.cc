@@ -0,0 +1,141 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+/// \file numa_array.cc
+/// \brief NumaArray chunks start on page boundaries and are bound to the nodes of the
+/// workers processing them, and a throwing copy during the first touch releases
+/// everything which was constructed
+
+#include "ptl_test.hh"
+
+#include "PTL/NumaMemory.hh"
+#include "PTL/ThreadPool.hh"
+
+#include <algorithm>
+#include <atomic>
+
+using namespace PTL;
+
+namespace
+{
+std::atomic<long> alive{ 0 };
+std::atomic<long> copies{ 0 };
+long              throw_at = -1;
+
+// 24 bytes, which does not divide the page size
+struct element
+{
+    element() { ++alive; }
+    element(const element&)
+    {
+        if(++copies == throw_at)
+            throw 1;
+        ++alive;
+    }
+    ~element() { --alive; }
+
+    double value[3] = { 0.0, 0.0, 0.0 };
+};
+
+void
+test_alignment(ThreadPool* tp)
+{
+    element            _init{};
+    NumaArray<element> _array{ 100000, _init, tp, 4 };
+    NumaArray<char>    _bytes{ 100000, 'a', tp, 3 };
+    PTL_CHECK(_array.chunks() > 1);
+    for(size_t i = 0; i < _array.chunks(); ++i)
+    {
+        auto _offset = _array.chunk_range(i).first * sizeof(element);
+        PTL_CHECK(_offset % numa::page_size() == 0);
+    }
+    for(size_t i = 0; i < _bytes.chunks(); ++i)
+        PTL_CHECK(_bytes.chunk_range(i).first % numa::page_size() == 0);
+    PTL_CHECK(alive.load() == 100001);
+}
+
+void
+test_chunk_nodes(ThreadPool* tp)
+{
+    // a chunk is on the node of the CPU of its worker if the worker is pinned and
+    // always on one of the node IDs of the topology
+    const auto&     _nodes = Topology::instance().nodes();
+    NumaArray<char> _array{ 100000, 'a', tp, 4 };
+    PTL_CHECK(_array.chunks() > 1);
+    for(size_t i = 0; i < _array.chunks(); ++i)
+    {
+        auto _node   = _array.chunk_node(i);
+        auto _worker = tp->get_worker_node(i * tp->size() / _array.chunks());
+        PTL_CHECK(std::find(_nodes.begin(), _nodes.end(), _node) != _nodes.end());
+        PTL_CHECK(_worker < 0 || _node == _worker);
+    }
+}
+
+void
+test_throwing_copy(ThreadPool* tp)
+{
+    element _init{};
+    throw_at     = 30000;
+    copies       = 0;
+    bool _caught = false;
+    try
+    {
+        NumaArray<element> _array{ 100000, _init, tp, 4 };
+    } catch(int)
+    {
+        _caught = true;
+    }
+    throw_at = -1;
+    PTL_CHECK(_caught);
+    // only the initial value is left
+    PTL_CHECK(alive.load() == 1);
+}
+}  // namespace
+
+//--------------------------------------------------------------------------------------//
+
+int
+main()
+{
+    ThreadPool::Config _cfg{};
+    _cfg.pool_size = 4;
+    ThreadPool tp{ _cfg };
+
+    test_alignment(&tp);
+    PTL_CHECK(alive.load() == 0);
+    test_throwing_copy(&tp);
+    test_throwing_copy(nullptr);
+    PTL_CHECK(alive.load() == 0);
+    test_chunk_nodes(&tp);
+
+    tp.destroy_threadpool();
+
+    // the workers pinned in turn to the CPUs of the process
+    const auto& _cpus = Topology::instance().cpus();
+    _cfg.use_affinity = true;
+    _cfg.set_affinity = [&_cpus](intmax_t i) -> intmax_t {
+        return (_cpus.empty()) ? i : _cpus.at(i % _cpus.size()).cpu;
+    };
+    ThreadPool _pinned{ _cfg };
+    test_chunk_nodes(&_pinned);
+    auto _first = _pinned.get_worker_node(0);
+    PTL_CHECK(_first < 0 || _first == Topology::instance().node_of(_cpus.at(0).cpu));
+    _pinned.destroy_threadpool();
+    return ptl_test::result();
+}
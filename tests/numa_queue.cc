@@ -0,0 +1,160 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+/// \file numa_queue.cc
+/// \brief With the topology of a fake sysfs tree of two NUMA nodes, the tasks
+/// requesting a node are inserted into the bins of that node and a thread takes the
+/// tasks of its node before it steals from the bins of the other node
+
+#include "ptl_fixture.hh"
+#include "ptl_test.hh"
+
+#include "PTL/Task.hh"
+#include "PTL/Topology.hh"
+#include "PTL/UserTaskQueue.hh"
+
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace PTL;
+
+namespace
+{
+using ptl_test::write_file;
+using task_pointer = UserTaskQueue::task_pointer;
+
+constexpr int num_tasks = 20;
+
+// two NUMA nodes of two CPUs
+struct fake_sysfs : ptl_test::fixture_dir
+{
+    fake_sysfs()
+    {
+        write_file(root + "/cpu/online", "0-3\n");
+        write_file(root + "/node/online", "0-1\n");
+        write_file(root + "/node/node0/cpulist", "0-1\n");
+        write_file(root + "/node/node1/cpulist", "2-3\n");
+        for(int i = 0; i < 4; ++i)
+        {
+            auto _dir = root + "/cpu/cpu" + std::to_string(i) + "/topology";
+            write_file(_dir + "/physical_package_id", std::to_string(i / 2));
+            write_file(_dir + "/core_id", std::to_string(i % 2));
+        }
+    }
+};
+
+task_pointer
+make_task(int _node)
+{
+    auto _task = std::make_shared<PackagedTask<void>>([]() {});
+    _task->set_numa_node(_node);
+    return _task;
+}
+
+// tags the bin of the calling thread with its node: a thread tags its bin when it
+// takes a task
+intmax_t
+tag_bin(UserTaskQueue& _queue, int _node)
+{
+    Topology::set_current_node(_node);
+    _queue.InsertTask(make_task(-1));
+    _queue.GetTask();
+    return _queue.GetThreadBin();
+}
+
+// the nodes of the tasks in the order they were taken by the calling thread
+std::vector<int>
+take_all(UserTaskQueue& _queue)
+{
+    std::vector<int> _nodes{};
+    while(auto _task = _queue.GetTask())
+        _nodes.emplace_back(_task->numa_node());
+    return _nodes;
+}
+
+// true if the tasks of _node were all taken before the first task of another node
+bool
+local_first(const std::vector<int>& _nodes, int _node)
+{
+    bool _stolen = false;
+    for(auto itr : _nodes)
+    {
+        if(itr != _node)
+            _stolen = true;
+        else if(_stolen)
+            return false;
+    }
+    return true;
+}
+}  // namespace
+
+//--------------------------------------------------------------------------------------//
+
+int
+main()
+{
+    // the topology is discovered once, from the fake tree
+    fake_sysfs _sysfs{};
+    setenv("PTL_SYSFS_ROOT", _sysfs.root.c_str(), 1);
+    PTL_CHECK(Topology::instance().num_nodes() == 2);
+
+    // four bins: one of each node and two which are not tagged
+    UserTaskQueue _queue{ 3 };
+    intmax_t      _bin0 = tag_bin(_queue, 0);
+    intmax_t      _bin1 = -1;
+    std::thread{ [&]() { _bin1 = tag_bin(_queue, 1); } }.join();
+    PTL_CHECK(_bin0 != _bin1);
+    PTL_CHECK(_queue.empty());
+
+    // the tasks are inserted into the bin of their node, whichever thread inserts them
+    for(int i = 0; i < num_tasks; ++i)
+    {
+        PTL_CHECK(_queue.InsertTask(make_task(1)) == _bin1);
+        PTL_CHECK(_queue.InsertTask(make_task(0)) == _bin0);
+    }
+    PTL_CHECK(_queue.bin_size(_bin0) == num_tasks);
+    PTL_CHECK(_queue.bin_size(_bin1) == num_tasks);
+
+    // a thread of node 0 takes all the tasks of node 0 before stealing the others
+    auto _nodes = take_all(_queue);
+    PTL_CHECK(_nodes.size() == 2 * num_tasks);
+    PTL_CHECK(local_first(_nodes, 0));
+    PTL_CHECK(_queue.empty());
+
+    // and a thread of node 1 takes the tasks of node 1 first
+    for(int i = 0; i < num_tasks; ++i)
+    {
+        _queue.InsertTask(make_task(0));
+        _queue.InsertTask(make_task(1));
+    }
+    intmax_t _bin = -1;
+    std::thread{ [&]() {
+        Topology::set_current_node(1);
+        _bin   = _queue.GetThreadBin();
+        _nodes = take_all(_queue);
+    } }.join();
+    PTL_CHECK(_bin == _bin1);
+    PTL_CHECK(_nodes.size() == 2 * num_tasks);
+    PTL_CHECK(local_first(_nodes, 1));
+    PTL_CHECK(_queue.empty());
+
+    return ptl_test::result();
+}
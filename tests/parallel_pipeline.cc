@@ -0,0 +1,200 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+/// \file parallel_pipeline.cc
+/// \brief A parallel_pipeline delivers the tokens to a serial_in_order filter in input
+/// order, never has more than max_tokens tokens in flight, runs a serial filter one
+/// token at a time and accepts filters with a non-const call operator and move-only
+/// filters
+
+#include "ptl_test.hh"
+
+#include "PTL/ParallelPipeline.hh"
+#include "PTL/ThreadPool.hh"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace PTL;
+
+namespace
+{
+constexpr int num_items = 2000;
+
+struct pipeline_state
+{
+    std::atomic<int>  in_flight{ 0 };
+    std::atomic<int>  max_in_flight{ 0 };
+    std::atomic<int>  serial_busy{ 0 };
+    std::atomic<bool> serial_overlap{ false };
+    std::vector<int>  output = {};
+};
+
+// input filter keeping its position in a member
+struct generator
+{
+    int operator()(flow_control& _fc)
+    {
+        if(m_next == num_items)
+        {
+            _fc.stop();
+            return 0;
+        }
+        int _n = ++m_state->in_flight;
+        int _m = m_state->max_in_flight.load();
+        while(_n > _m && !m_state->max_in_flight.compare_exchange_weak(_m, _n))
+        {}
+        return m_next++;
+    }
+
+    pipeline_state* m_state = nullptr;
+    int             m_next  = 0;
+};
+
+// parallel filter which keeps the tokens in flight long enough to overlap
+int
+transform(int _v)
+{
+    std::this_thread::sleep_for(std::chrono::microseconds{ (_v % 7) * 20 });
+    return 2 * _v;
+}
+
+// serial filter counting the items it has seen in a member
+struct counter
+{
+    int operator()(int _v)
+    {
+        if(++m_state->serial_busy != 1)
+            m_state->serial_overlap = true;
+        ++m_count;
+        std::this_thread::sleep_for(std::chrono::microseconds{ 5 });
+        --m_state->serial_busy;
+        return _v;
+    }
+
+    pipeline_state* m_state = nullptr;
+    int             m_count = 0;
+};
+
+struct collector
+{
+    void operator()(int _v)
+    {
+        m_state->output.emplace_back(_v);
+        --m_state->in_flight;
+    }
+
+    pipeline_state* m_state = nullptr;
+};
+
+void
+test_pipeline(ThreadPool& tp, size_t _max_tokens)
+{
+    pipeline_state _state{};
+    generator      _gen{};
+    counter        _count{};
+    collector      _collect{};
+    _gen.m_state     = &_state;
+    _count.m_state   = &_state;
+    _collect.m_state = &_state;
+
+    parallel_pipeline(
+        _max_tokens,
+        make_filter<void, int>(filter_mode::serial_in_order, _gen) &
+            make_filter<int, int>(filter_mode::parallel, transform) &
+            make_filter<int, int>(filter_mode::serial_out_of_order, _count) &
+            make_filter<int, void>(filter_mode::serial_in_order, _collect),
+        &tp);
+
+    bool _ordered = (_state.output.size() == static_cast<size_t>(num_items));
+    for(size_t i = 0; _ordered && i < _state.output.size(); ++i)
+        _ordered = (_state.output.at(i) == 2 * static_cast<int>(i));
+
+    PTL_CHECK(_ordered);
+    PTL_CHECK(_state.max_in_flight.load() >= 1);
+    PTL_CHECK(_state.max_in_flight.load() <= static_cast<int>(_max_tokens));
+    PTL_CHECK(_state.in_flight.load() == 0);
+    PTL_CHECK(!_state.serial_overlap.load());
+}
+
+// move-only filters
+struct unique_generator
+{
+    int operator()(flow_control& _fc)
+    {
+        if(*m_next == num_items)
+            _fc.stop();
+        return (*m_next)++;
+    }
+
+    std::unique_ptr<int> m_next = std::unique_ptr<int>{ new int{ 0 } };
+};
+
+struct unique_collector
+{
+    void operator()(int _v)
+    {
+        ++(*m_count);
+        m_output->emplace_back(_v);
+    }
+
+    std::vector<int>*    m_output = nullptr;
+    std::unique_ptr<int> m_count  = std::unique_ptr<int>{ new int{ 0 } };
+};
+
+void
+test_move_only(ThreadPool& tp)
+{
+    std::vector<int> _output{};
+    unique_collector _collect{};
+    _collect.m_output = &_output;
+
+    parallel_pipeline(
+        4,
+        make_filter<void, int>(filter_mode::serial_in_order, unique_generator{}) &
+            make_filter<int, void>(filter_mode::serial_in_order, std::move(_collect)),
+        &tp);
+
+    bool _ordered = (_output.size() == static_cast<size_t>(num_items));
+    for(size_t i = 0; _ordered && i < _output.size(); ++i)
+        _ordered = (_output.at(i) == static_cast<int>(i));
+    PTL_CHECK(_ordered);
+}
+}  // namespace
+
+//--------------------------------------------------------------------------------------//
+
+int
+main()
+{
+    ThreadPool::Config _cfg{};
+    _cfg.pool_size = 4;
+    ThreadPool tp{ _cfg };
+
+    test_pipeline(tp, 1);
+    test_pipeline(tp, 3);
+    test_pipeline(tp, 16);
+    test_move_only(tp);
+
+    tp.destroy_threadpool();
+    return ptl_test::result();
+}
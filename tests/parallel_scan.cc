@@ -0,0 +1,188 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+/// \file parallel_scan.cc
+/// \brief The parallel scans and stream compaction match the standard algorithms on
+/// empty, single-element, odd-sized and multi-chunk inputs. An exception of the chunk
+/// executed by the calling thread is only rethrown once the other chunks complete
+
+#include "ptl_test.hh"
+
+#include "PTL/ParallelAlgorithms.hh"
+#include "PTL/ThreadPool.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace PTL;
+
+namespace
+{
+// small enough that the larger inputs are split into one chunk per thread
+constexpr size_t grain = 64;
+
+const size_t input_sizes[] = { 0, 1, 63, 1001, 4097 };
+
+std::vector<long>
+make_input(size_t _n)
+{
+    std::vector<long> _v(_n);
+    for(size_t i = 0; i < _n; ++i)
+        _v.at(i) = static_cast<long>((i * 7919) % 113) - 50;
+    return _v;
+}
+
+bool
+is_odd(long _v)
+{
+    return (_v % 2) != 0;
+}
+
+void
+test_inclusive_scan(ThreadPool& tp, size_t _n)
+{
+    auto              _in = make_input(_n);
+    std::vector<long> _expect(_n);
+    std::vector<long> _out(_n, -1);
+    std::inclusive_scan(_in.begin(), _in.end(), _expect.begin());
+    auto _end = parallel_scan(_in.begin(), _in.end(), _out.begin(), &tp, grain);
+    PTL_CHECK(_end == _out.end());
+    PTL_CHECK(_out == _expect);
+
+    // an associative but non-commutative operation catches chunks combined out of order
+    std::vector<std::string> _sin(_n);
+    for(size_t i = 0; i < _n; ++i)
+        _sin.at(i) = std::string(1, static_cast<char>('a' + (i % 26)));
+    std::vector<std::string> _sexpect(_n);
+    std::vector<std::string> _sout(_n);
+    std::inclusive_scan(_sin.begin(), _sin.end(), _sexpect.begin(),
+                        std::plus<std::string>{});
+    parallel_scan(_sin.begin(), _sin.end(), _sout.begin(), std::plus<std::string>{}, &tp,
+                  grain);
+    PTL_CHECK(_sout == _sexpect);
+}
+
+void
+test_exclusive_scan(ThreadPool& tp, size_t _n)
+{
+    auto              _in = make_input(_n);
+    std::vector<long> _expect(_n);
+    std::vector<long> _out(_n, -1);
+    std::exclusive_scan(_in.begin(), _in.end(), _expect.begin(), 10L);
+    auto _end =
+        parallel_exclusive_scan(_in.begin(), _in.end(), _out.begin(), 10L, &tp, grain);
+    PTL_CHECK(_end == _out.end());
+    PTL_CHECK(_out == _expect);
+
+    std::vector<std::string> _sin(_n);
+    for(size_t i = 0; i < _n; ++i)
+        _sin.at(i) = std::string(1, static_cast<char>('a' + (i % 26)));
+    std::vector<std::string> _sexpect(_n);
+    std::vector<std::string> _sout(_n);
+    std::exclusive_scan(_sin.begin(), _sin.end(), _sexpect.begin(), std::string{ ">" },
+                        std::plus<std::string>{});
+    parallel_exclusive_scan(_sin.begin(), _sin.end(), _sout.begin(), std::string{ ">" },
+                            std::plus<std::string>{}, &tp, grain);
+    PTL_CHECK(_sout == _sexpect);
+}
+
+void
+test_compact(ThreadPool& tp, size_t _n)
+{
+    auto              _in = make_input(_n);
+    std::vector<long> _expect{};
+    std::vector<long> _out(_n, -1);
+    std::copy_if(_in.begin(), _in.end(), std::back_inserter(_expect), is_odd);
+    auto _end =
+        parallel_compact(_in.begin(), _in.end(), _out.begin(), is_odd, &tp, grain);
+    PTL_CHECK(static_cast<size_t>(_end - _out.begin()) == _expect.size());
+    _out.erase(_end, _out.end());
+    PTL_CHECK(_out == _expect);
+}
+
+void
+test_partition(ThreadPool& tp, size_t _n)
+{
+    auto _in     = make_input(_n);
+    auto _expect = _in;
+    auto _mid    = std::stable_partition(_expect.begin(), _expect.end(), is_odd);
+    auto _ntrue  = static_cast<size_t>(_mid - _expect.begin());
+
+    std::vector<long> _true(_n, -1);
+    std::vector<long> _false(_n, -1);
+    auto _ends = parallel_partition(_in.begin(), _in.end(), _true.begin(), _false.begin(),
+                                    is_odd, &tp, grain);
+    PTL_CHECK(static_cast<size_t>(_ends.first - _true.begin()) == _ntrue);
+    PTL_CHECK(static_cast<size_t>(_ends.second - _false.begin()) == _n - _ntrue);
+    PTL_CHECK(std::equal(_true.begin(), _ends.first, _expect.begin()));
+    PTL_CHECK(std::equal(_false.begin(), _ends.second, _mid));
+}
+
+void
+test_chunk_exception(ThreadPool& tp)
+{
+    constexpr size_t _nchunks = 5;
+    std::atomic<int> _done{ 0 };
+    bool             _caught = false;
+    try
+    {
+        internal::parallel_chunks(&tp, _nchunks, [&_done](size_t i) {
+            if(i == 0)
+                throw std::runtime_error("chunk zero");
+            std::this_thread::sleep_for(std::chrono::milliseconds{ 20 });
+            ++_done;
+        });
+    } catch(std::runtime_error&)
+    {
+        _caught = true;
+    }
+    PTL_CHECK(_caught);
+    PTL_CHECK(_done.load() == static_cast<int>(_nchunks - 1));
+}
+}  // namespace
+
+//--------------------------------------------------------------------------------------//
+
+int
+main()
+{
+    ThreadPool::Config _cfg{};
+    _cfg.pool_size = 4;
+    ThreadPool tp{ _cfg };
+
+    for(auto _n : input_sizes)
+    {
+        test_inclusive_scan(tp, _n);
+        test_exclusive_scan(tp, _n);
+        test_compact(tp, _n);
+        test_partition(tp, _n);
+    }
+    test_chunk_exception(tp);
+
+    tp.destroy_threadpool();
+    return ptl_test::result();
+}
@@ -0,0 +1,126 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+/// \file parallel_sort.cc
+/// \brief The parallel merge and sort match the standard algorithms on empty,
+/// single-element, odd-sized and multi-chunk inputs
+
+#include "ptl_test.hh"
+
+#include "PTL/ParallelAlgorithms.hh"
+#include "PTL/ThreadPool.hh"
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
+using namespace PTL;
+
+namespace
+{
+// small enough that the larger inputs are split into one chunk per thread
+constexpr size_t grain = 64;
+
+const size_t input_sizes[] = { 0, 1, 63, 1001, 4097 };
+
+// the second member records the position so the stability of the merge is visible
+using entry_t = std::pair<int, int>;
+
+std::vector<int>
+make_input(size_t _n, size_t _seed)
+{
+    std::vector<int> _v(_n);
+    for(size_t i = 0; i < _n; ++i)
+        _v.at(i) = static_cast<int>(((i + _seed) * 7919) % 211);
+    return _v;
+}
+
+bool
+key_less(const entry_t& lhs, const entry_t& rhs)
+{
+    return lhs.first < rhs.first;
+}
+
+void
+test_merge(ThreadPool& tp, size_t _n1, size_t _n2)
+{
+    std::vector<entry_t> _lhs{};
+    std::vector<entry_t> _rhs{};
+    for(auto itr : make_input(_n1, 1))
+        _lhs.emplace_back(itr, static_cast<int>(_lhs.size()));
+    for(auto itr : make_input(_n2, 2))
+        _rhs.emplace_back(itr, -static_cast<int>(_rhs.size()) - 1);
+    std::stable_sort(_lhs.begin(), _lhs.end(), key_less);
+    std::stable_sort(_rhs.begin(), _rhs.end(), key_less);
+
+    std::vector<entry_t> _expect(_n1 + _n2);
+    std::vector<entry_t> _out(_n1 + _n2);
+    std::merge(_lhs.begin(), _lhs.end(), _rhs.begin(), _rhs.end(), _expect.begin(),
+               key_less);
+    auto _end = parallel_merge(_lhs.begin(), _lhs.end(), _rhs.begin(), _rhs.end(),
+                               _out.begin(), key_less, &tp, grain);
+    PTL_CHECK(_end == _out.end());
+    PTL_CHECK(_out == _expect);
+}
+
+void
+test_sort(ThreadPool& tp, size_t _n)
+{
+    auto _expect = make_input(_n, 0);
+    auto _out    = _expect;
+    std::stable_sort(_expect.begin(), _expect.end());
+    parallel_sort(_out.begin(), _out.end(), &tp, grain);
+    PTL_CHECK(_out == _expect);
+
+    _expect = make_input(_n, 3);
+    _out    = _expect;
+    std::stable_sort(_expect.begin(), _expect.end(), std::greater<int>{});
+    parallel_sort(_out.begin(), _out.end(), std::greater<int>{}, &tp, grain);
+    PTL_CHECK(_out == _expect);
+
+    // already sorted and reversed inputs
+    std::sort(_out.begin(), _out.end());
+    parallel_sort(_out.begin(), _out.end(), &tp, grain);
+    PTL_CHECK(std::is_sorted(_out.begin(), _out.end()));
+    std::reverse(_out.begin(), _out.end());
+    parallel_sort(_out.begin(), _out.end(), &tp, grain);
+    PTL_CHECK(std::is_sorted(_out.begin(), _out.end()));
+}
+}  // namespace
+
+//--------------------------------------------------------------------------------------//
+
+int
+main()
+{
+    ThreadPool::Config _cfg{};
+    _cfg.pool_size = 4;
+    ThreadPool tp{ _cfg };
+
+    for(auto _n : input_sizes)
+    {
+        test_sort(tp, _n);
+        for(auto _m : input_sizes)
+            test_merge(tp, _n, _m);
+    }
+
+    tp.destroy_threadpool();
+    return ptl_test::result();
+}
@@ -0,0 +1,83 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+/// \file ptl_fixture.hh
+/// \brief Temporary directories of fixture files (e.g. a fake sysfs or cgroup tree)
+/// for the unit tests. POSIX only
+
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#include <ftw.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ptl_test
+{
+// create the directory and its parents
+inline void
+make_dirs(const std::string& _path)
+{
+    for(size_t _pos = _path.find('/', 1); _pos != std::string::npos;
+        _pos        = _path.find('/', _pos + 1))
+        mkdir(_path.substr(0, _pos).c_str(), 0755);
+    mkdir(_path.c_str(), 0755);
+}
+
+// write the file, creating its directory
+inline void
+write_file(const std::string& _fname, const std::string& _contents)
+{
+    make_dirs(_fname.substr(0, _fname.find_last_of('/')));
+    std::ofstream ofs{ _fname };
+    ofs << _contents;
+}
+
+inline int
+remove_entry(const char* _path, const struct stat*, int, struct FTW*)
+{
+    return remove(_path);
+}
+
+// temporary directory holding the fixtures of one test case, removed on exit
+struct fixture_dir
+{
+    fixture_dir()
+    {
+        char _tmpl[] = "/tmp/ptl-test-XXXXXX";
+        if(mkdtemp(_tmpl))
+            root = _tmpl;
+    }
+
+    ~fixture_dir()
+    {
+        if(!root.empty())
+            nftw(root.c_str(), remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+    }
+
+    fixture_dir(const fixture_dir&) = delete;
+    fixture_dir& operator=(const fixture_dir&) = delete;
+
+    std::string root = {};
+};
+}  // namespace ptl_test
@@ -0,0 +1,201 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+/// \file ptl_json.hh
+/// \brief Minimal JSON reader for the unit tests which check the documents written
+/// by the library (e.g. the Chrome traces)
+
+#pragma once
+
+#include <cctype>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ptl_test
+{
+struct json_value
+{
+    enum kind_type
+    {
+        null_value,
+        bool_value,
+        number_value,
+        string_value,
+        array_value,
+        object_value
+    };
+
+    kind_type                                       kind    = null_value;
+    bool                                            boolean = false;
+    double                                          number  = 0.0;
+    std::string                                     str     = {};
+    std::vector<json_value>                         array   = {};
+    std::vector<std::pair<std::string, json_value>> object  = {};
+
+    // the member of an object (nullptr if missing)
+    const json_value* find(const std::string& _key) const
+    {
+        for(const auto& itr : object)
+        {
+            if(itr.first == _key)
+                return &itr.second;
+        }
+        return nullptr;
+    }
+
+    // the string of a member of an object (empty if missing)
+    std::string get(const std::string& _key) const
+    {
+        auto* _v = find(_key);
+        return (_v && _v->kind == string_value) ? _v->str : std::string{};
+    }
+};
+
+// recursive descent parser, parse() returns false if the document is not valid
+class json_reader
+{
+public:
+    explicit json_reader(const std::string& _text)
+    : m_text{ _text }
+    {}
+
+    bool parse(json_value& _v)
+    {
+        m_pos = 0;
+        if(!value(_v))
+            return false;
+        skip();
+        return m_pos == m_text.size();
+    }
+
+private:
+    void skip()
+    {
+        while(m_pos < m_text.size() && isspace(static_cast<unsigned char>(m_text[m_pos])))
+            ++m_pos;
+    }
+
+    bool consume(char _c)
+    {
+        skip();
+        if(m_pos < m_text.size() && m_text[m_pos] == _c)
+        {
+            ++m_pos;
+            return true;
+        }
+        return false;
+    }
+
+    bool literal(const char* _word)
+    {
+        std::string _w{ _word };
+        if(m_text.compare(m_pos, _w.size(), _w) != 0)
+            return false;
+        m_pos += _w.size();
+        return true;
+    }
+
+    bool string(std::string& _s)
+    {
+        if(!consume('"'))
+            return false;
+        while(m_pos < m_text.size() && m_text[m_pos] != '"')
+        {
+            if(m_text[m_pos] == '\\')
+            {
+                if(++m_pos >= m_text.size())
+                    return false;
+                // only the escapes written by the library are decoded
+                if(m_text[m_pos] == 'u')
+                    return false;
+            }
+            else if(static_cast<unsigned char>(m_text[m_pos]) < 0x20)
+                return false;
+            _s += m_text[m_pos++];
+        }
+        return consume('"');
+    }
+
+    bool value(json_value& _v)
+    {
+        skip();
+        if(m_pos >= m_text.size())
+            return false;
+
+        char _c = m_text[m_pos];
+        if(_c == '{')
+        {
+            _v.kind = json_value::object_value;
+            ++m_pos;
+            if(consume('}'))
+                return true;
+            do
+            {
+                std::pair<std::string, json_value> _member{};
+                if(!string(_member.first) || !consume(':') || !value(_member.second))
+                    return false;
+                _v.object.emplace_back(std::move(_member));
+            } while(consume(','));
+            return consume('}');
+        }
+        if(_c == '[')
+        {
+            _v.kind = json_value::array_value;
+            ++m_pos;
+            if(consume(']'))
+                return true;
+            do
+            {
+                _v.array.emplace_back();
+                if(!value(_v.array.back()))
+                    return false;
+            } while(consume(','));
+            return consume(']');
+        }
+        if(_c == '"')
+        {
+            _v.kind = json_value::string_value;
+            return string(_v.str);
+        }
+        if(literal("true") || literal("false"))
+        {
+            _v.kind    = json_value::bool_value;
+            _v.boolean = (m_text[m_pos - 1] == 'e' && m_text[m_pos - 2] == 'u');
+            return true;
+        }
+        if(literal("null"))
+            return true;
+
+        const char* _begin = m_text.c_str() + m_pos;
+        char*       _end   = nullptr;
+        _v.kind            = json_value::number_value;
+        _v.number          = strtod(_begin, &_end);
+        if(_end == _begin)
+            return false;
+        m_pos += static_cast<size_t>(_end - _begin);
+        return true;
+    }
+
+private:
+    const std::string& m_text;
+    size_t             m_pos = 0;
+};
+}  // namespace ptl_test
@@ -0,0 +1,60 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+/// \file ptl_test.hh
+/// \brief Minimal checks for the unit tests
+///
+/// A failed check prints the expression and location and makes the test exit with
+/// a non-zero code. The tests are plain executables registered with ctest
+
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace ptl_test
+{
+inline int&
+failures()
+{
+    static int _v = 0;
+    return _v;
+}
+
+inline void
+check(bool _ok, const char* _expr, const char* _file, int _line)
+{
+    if(_ok)
+        return;
+    ++failures();
+    fprintf(stderr, "%s:%i: check failed: %s\n", _file, _line, _expr);
+}
+
+// exit code of the test
+inline int
+result()
+{
+    if(failures() > 0)
+        fprintf(stderr, "%i check(s) failed\n", failures());
+    return (failures() > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+}  // namespace ptl_test
+
+#define PTL_CHECK(EXPR)                                                                 \
+    ::ptl_test::check(static_cast<bool>(EXPR), #EXPR, __FILE__, __LINE__)
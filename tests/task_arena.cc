@@ -0,0 +1,243 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+/// \file task_arena.cc
+/// \brief The workers respect the concurrency limit and the weights of the task arenas
+/// and an arena outlives the thread-pool it was created in. An arena destroyed while a
+/// worker executes one of its tasks waits for it
+
+#include "ptl_test.hh"
+
+#include "PTL/Task.hh"
+#include "PTL/TaskArena.hh"
+#include "PTL/ThreadPool.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace PTL;
+
+namespace
+{
+constexpr int num_tasks = 200;
+
+void
+wait_for(const std::atomic<int>& _count, int _value)
+{
+    while(_count.load() < _value)
+        std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+}
+
+// the maximum number of tasks of an arena which executed at the same time
+struct concurrency_tracker
+{
+    std::atomic<int> active{ 0 };
+    std::atomic<int> peak{ 0 };
+    std::atomic<int> count{ 0 };
+
+    void operator()()
+    {
+        int _n    = ++active;
+        int _peak = peak.load();
+        while(_n > _peak && !peak.compare_exchange_weak(_peak, _n))
+        {}
+        std::this_thread::sleep_for(std::chrono::microseconds{ 200 });
+        --active;
+        ++count;
+    }
+};
+
+void
+test_concurrency_limit()
+{
+    ThreadPool::Config _cfg{};
+    _cfg.pool_size = 4;
+    ThreadPool tp{ _cfg };
+
+    concurrency_tracker _serial{};
+    concurrency_tracker _pair{};
+    {
+        TaskArena _serial_arena{ &tp, 1 };
+        TaskArena _pair_arena{ &tp, 2 };
+        for(int i = 0; i < num_tasks; ++i)
+        {
+            _serial_arena.enqueue([&_serial]() { _serial(); });
+            _pair_arena.enqueue([&_pair]() { _pair(); });
+        }
+        wait_for(_serial.count, num_tasks);
+        wait_for(_pair.count, num_tasks);
+    }
+
+    PTL_CHECK(_serial.peak.load() == 1);
+    PTL_CHECK(_pair.peak.load() <= 2);
+    tp.destroy_threadpool();
+}
+
+//--------------------------------------------------------------------------------------//
+
+void
+test_weights()
+{
+    ThreadPool::Config _cfg{};
+    _cfg.pool_size = 1;
+    ThreadPool tp{ _cfg };
+
+    // the single worker is held by a task of the pool while the arenas are filled
+    std::atomic<bool> _started{ false };
+    std::atomic<bool> _release{ false };
+    tp.add_task(std::make_shared<Task<void>>(true, 0, [&]() {
+        _started = true;
+        while(!_release.load())
+            std::this_thread::yield();
+    }));
+    while(!_started.load())
+        std::this_thread::yield();
+
+    std::mutex        _mutex{};
+    std::vector<char> _order{};
+    std::atomic<int>  _count{ 0 };
+    {
+        TaskArena _light{ &tp, 0, 1 };
+        TaskArena _heavy{ &tp, 0, 3 };
+        for(int i = 0; i < num_tasks; ++i)
+        {
+            _light.enqueue([&]() {
+                std::lock_guard<std::mutex> _lk(_mutex);
+                _order.push_back('l');
+                ++_count;
+            });
+            _heavy.enqueue([&]() {
+                std::lock_guard<std::mutex> _lk(_mutex);
+                _order.push_back('h');
+                ++_count;
+            });
+        }
+        _release = true;
+        wait_for(_count, 2 * num_tasks);
+    }
+
+    // while both arenas have tasks the heavy one receives three quarters of them
+    auto _heavy = std::count(_order.begin(), _order.begin() + num_tasks, 'h');
+    PTL_CHECK(_heavy >= 3 * num_tasks / 4 - 2 && _heavy <= 3 * num_tasks / 4 + 2);
+    tp.destroy_threadpool();
+}
+
+//--------------------------------------------------------------------------------------//
+
+void
+test_resize()
+{
+    ThreadPool::Config _cfg{};
+    _cfg.pool_size = 2;
+    ThreadPool tp{ _cfg };
+
+    TaskArena _arena{ &tp, 0 };
+    PTL_CHECK(_arena.get_queue()->workers() == 2);
+    tp.initialize_threadpool(4);
+    PTL_CHECK(_arena.get_queue()->workers() == 4);
+
+    concurrency_tracker _tracker{};
+    for(int i = 0; i < num_tasks; ++i)
+        _arena.enqueue([&_tracker]() { _tracker(); });
+    wait_for(_tracker.count, num_tasks);
+
+    // the arena executes its tasks in the calling thread once the pool is destroyed
+    tp.destroy_threadpool();
+    PTL_CHECK(_arena.pool() == nullptr);
+    int _value = 0;
+    _arena.enqueue([&_value]() { _value = 1; });
+    PTL_CHECK(_value == 1);
+}
+
+//--------------------------------------------------------------------------------------//
+
+void
+test_deleted_pool()
+{
+    ThreadPool::Config _cfg{};
+    _cfg.pool_size = 2;
+    auto* tp       = new ThreadPool{ _cfg };
+
+    TaskArena        _arena{ tp, 1 };
+    std::atomic<int> _count{ 0 };
+    for(int i = 0; i < num_tasks; ++i)
+        _arena.enqueue([&_count]() { ++_count; });
+    wait_for(_count, num_tasks);
+
+    // deleted without destroy_threadpool() the pool still detaches the arena
+    delete tp;
+    PTL_CHECK(_arena.pool() == nullptr);
+    _arena.enqueue([&_count]() { ++_count; });
+    PTL_CHECK(_count.load() == num_tasks + 1);
+}
+
+//--------------------------------------------------------------------------------------//
+
+void
+test_destroy_while_active()
+{
+    ThreadPool::Config _cfg{};
+    _cfg.pool_size = 2;
+    ThreadPool tp{ _cfg };
+
+    std::atomic<bool> _started{ false };
+    std::atomic<bool> _finished{ false };
+    {
+        TaskArena _arena{ &tp };
+        _arena.enqueue([&]() {
+            _started = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds{ 50 });
+            _finished = true;
+        });
+        while(!_started.load())
+            std::this_thread::yield();
+        PTL_CHECK(_arena.active() == 1);
+    }
+    PTL_CHECK(_finished.load());
+
+    // the workers keep selecting arenas while others are created and destroyed
+    std::atomic<int> _count{ 0 };
+    for(int i = 0; i < num_tasks; ++i)
+    {
+        TaskArena _arena{ &tp, 1 };
+        for(int j = 0; j < 4; ++j)
+            _arena.enqueue([&_count]() { ++_count; });
+    }
+    PTL_CHECK(_count.load() == 4 * num_tasks);
+    tp.destroy_threadpool();
+}
+}  // namespace
+
+//--------------------------------------------------------------------------------------//
+
+int
+main()
+{
+    test_concurrency_limit();
+    test_weights();
+    test_resize();
+    test_deleted_pool();
+    test_destroy_while_active();
+    return ptl_test::result();
+}
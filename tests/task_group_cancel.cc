@@ -0,0 +1,165 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+/// \file task_group_cancel.cc
+/// \brief Results of the tasks skipped after TaskGroup::cancel() are not joined and
+/// skipping does not throw
+
+#include "ptl_test.hh"
+
+#include "PTL/TaskGroup.hh"
+#include "PTL/ThreadPool.hh"
+
+#include <atomic>
+#include <exception>
+#include <vector>
+
+using namespace PTL;
+
+namespace
+{
+// result type without a default constructor
+struct value_t
+{
+    explicit value_t(int _v)
+    : value(_v)
+    {}
+
+    int value;
+};
+
+constexpr int num_tasks = 10000;
+}  // namespace
+
+//--------------------------------------------------------------------------------------//
+// join(accum): the skipped tasks do not contribute to the accumulated result
+//
+void
+test_accumulate(ThreadPool* tp)
+{
+    TaskGroup<int> tg([](int& lhs, int rhs) { return lhs += rhs; }, tp);
+    for(int i = 0; i < num_tasks; ++i)
+        tg.exec([&tg, i]() {
+            if(i == 100)
+                tg.cancel();
+            return 1;
+        });
+
+    int  _sum = -1;
+    bool _ok  = true;
+    try
+    {
+        _sum = tg.join();
+    } catch(...)
+    {
+        _ok = false;
+    }
+    PTL_CHECK(_ok);
+    PTL_CHECK(_sum == static_cast<int>(tg.completed()));
+    PTL_CHECK(tg.completed() + tg.skipped() == num_tasks);
+    PTL_CHECK(tg.skipped() > 0);
+
+    // the group is reusable after the cancellation is reset
+    tg.reset_cancellation();
+    for(int i = 0; i < 10; ++i)
+        tg.exec([]() { return 1; });
+    PTL_CHECK(tg.join() == 10);
+}
+
+//--------------------------------------------------------------------------------------//
+// join() of a task group with a void join and a non-void task result
+//
+void
+test_void_join(ThreadPool* tp)
+{
+    std::atomic<int>       _joined{ 0 };
+    TaskGroup<void, int>   tg([&_joined](int _v) { _joined += _v; }, tp);
+    std::atomic<uintmax_t> _ran{ 0 };
+    for(int i = 0; i < num_tasks; ++i)
+        tg.exec([&tg, &_ran, i]() {
+            ++_ran;
+            if(i == 100)
+                tg.cancel();
+            return 1;
+        });
+
+    bool _ok = true;
+    try
+    {
+        tg.join();
+    } catch(...)
+    {
+        _ok = false;
+    }
+    PTL_CHECK(_ok);
+    PTL_CHECK(_joined.load() == static_cast<int>(_ran.load()));
+    PTL_CHECK(tg.completed() == _ran.load());
+    PTL_CHECK(tg.completed() + tg.skipped() == num_tasks);
+
+    // a task group which is cancelled before any task executes joins nothing
+    _joined.store(0);
+    for(int i = 0; i < 100; ++i)
+        tg.exec([]() { return 1; });
+    tg.join();
+    PTL_CHECK(_joined.load() == 0);
+    tg.reset_cancellation();
+}
+
+//--------------------------------------------------------------------------------------//
+// join() of skipped tasks whose result cannot be value-initialized
+//
+void
+test_no_default(ThreadPool* tp)
+{
+    TaskGroup<int, value_t> tg([](int& lhs, value_t&& rhs) { return lhs += rhs.value; },
+                               tp);
+    tg.cancel();
+    for(int i = 0; i < 100; ++i)
+        tg.exec([]() { return value_t{ 1 }; });
+
+    int  _sum = -1;
+    bool _ok  = true;
+    try
+    {
+        _sum = tg.join();
+    } catch(...)
+    {
+        _ok = false;
+    }
+    PTL_CHECK(_ok);
+    PTL_CHECK(_sum == 0);
+    PTL_CHECK(tg.skipped() == 100);
+}
+
+//--------------------------------------------------------------------------------------//
+
+int
+main()
+{
+    ThreadPool::Config _cfg{};
+    _cfg.pool_size = 4;
+    ThreadPool tp{ _cfg };
+
+    test_accumulate(&tp);
+    test_void_join(&tp);
+    test_no_default(&tp);
+
+    tp.destroy_threadpool();
+    return ptl_test::result();
+}
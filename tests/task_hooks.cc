@@ -0,0 +1,157 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+/// \file task_hooks.cc
+/// \brief The callbacks registered with TaskHooks are invoked once per lifecycle
+/// event of the tasks, the task groups and the workers, only for the events of their
+/// mask, and no longer after they are removed
+
+#include "ptl_test.hh"
+
+#include "PTL/TaskGroup.hh"
+#include "PTL/TaskHooks.hh"
+#include "PTL/ThreadPool.hh"
+
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+
+using namespace PTL;
+
+#if defined(PTL_USE_TASK_HOOKS)
+namespace
+{
+constexpr size_t pool_size = 2;
+constexpr int    num_tasks = 100;
+
+// the number of calls of a callback for each event and the tasks which are executing
+struct hook_counter
+{
+    std::mutex                                mutex{};
+    std::array<size_t, TaskHooks::num_events> counts{};
+    std::set<const void*>                     executing{};
+    bool                                      unpaired = false;
+
+    void operator()(TaskHooks::event_type _type, const void* _obj)
+    {
+        std::lock_guard<std::mutex> _lk(mutex);
+        ++counts.at(_type);
+        // a task ends once, after it began
+        if(_type == TaskHooks::begin)
+            unpaired |= !executing.emplace(_obj).second;
+        else if(_type == TaskHooks::end)
+            unpaired |= (executing.erase(_obj) != 1);
+    }
+
+    size_t operator[](TaskHooks::event_type _type)
+    {
+        std::lock_guard<std::mutex> _lk(mutex);
+        return counts.at(_type);
+    }
+
+    TaskHooks::callback_type callback()
+    {
+        return [this](TaskHooks::event_type _type, const void* _obj) {
+            (*this)(_type, _obj);
+        };
+    }
+};
+
+// waits up to two seconds for the workers to start (or stop) asynchronously
+bool
+wait_for(hook_counter& _counter, TaskHooks::event_type _type, size_t _n)
+{
+    for(int i = 0; i < 2000 && _counter[_type] < _n; ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+    return _counter[_type] == _n;
+}
+
+void
+run_tasks(TaskGroup<void>& tg)
+{
+    for(int i = 0; i < num_tasks; ++i)
+        tg.exec([]() {});
+    tg.join();
+}
+}  // namespace
+#endif
+
+//--------------------------------------------------------------------------------------//
+
+int
+main()
+{
+#if defined(PTL_USE_TASK_HOOKS)
+    using hooks = TaskHooks;
+
+    // a callback of the workers and a callback of the tasks and the waits
+    hook_counter     _workers{};
+    hook_counter     _tasks{};
+    hooks::mask_type _worker_mask = hooks::mask(hooks::worker_start);
+    _worker_mask |= hooks::mask(hooks::worker_stop);
+    auto _worker_handle = hooks::add(_workers.callback(), _worker_mask);
+    PTL_CHECK(_worker_handle != 0);
+
+    ThreadPool::Config _cfg{};
+    _cfg.use_tbb   = false;
+    _cfg.pool_size = pool_size;
+    ThreadPool tp{ _cfg };
+    PTL_CHECK(wait_for(_workers, hooks::worker_start, pool_size));
+
+    auto _task_handle = hooks::add(_tasks.callback(), hooks::all_events & ~_worker_mask);
+    PTL_CHECK(_task_handle != 0 && _task_handle != _worker_handle);
+
+    // every task is created, enqueued, begins and ends once, and the join is one wait
+    TaskGroup<void> tg{ &tp };
+    run_tasks(tg);
+    PTL_CHECK(_tasks[hooks::create] == num_tasks);
+    PTL_CHECK(_tasks[hooks::enqueue] == num_tasks);
+    PTL_CHECK(_tasks[hooks::begin] == num_tasks);
+    PTL_CHECK(_tasks[hooks::end] == num_tasks);
+    PTL_CHECK(_tasks[hooks::wait_begin] == 1);
+    PTL_CHECK(_tasks[hooks::wait_end] == 1);
+    PTL_CHECK(_tasks[hooks::worker_start] == 0);
+    PTL_CHECK(!_tasks.unpaired && _tasks.executing.empty());
+    PTL_CHECK(_workers[hooks::begin] == 0);
+
+    // a removed callback is not invoked again, the others still are
+    PTL_CHECK(hooks::remove(_task_handle));
+    PTL_CHECK(!hooks::remove(_task_handle));
+    PTL_CHECK(!hooks::active(hooks::begin));
+    PTL_CHECK(hooks::active(hooks::worker_stop));
+    run_tasks(tg);
+    PTL_CHECK(_tasks[hooks::create] == num_tasks);
+    PTL_CHECK(_tasks[hooks::end] == num_tasks);
+    PTL_CHECK(_tasks[hooks::wait_end] == 1);
+
+    tp.destroy_threadpool();
+    PTL_CHECK(wait_for(_workers, hooks::worker_stop, pool_size));
+    PTL_CHECK(_workers[hooks::worker_start] == pool_size);
+
+    hooks::clear();
+    PTL_CHECK(!hooks::remove(_worker_handle));
+    PTL_CHECK(!hooks::active(hooks::worker_start));
+#else
+    PTL_CHECK(TaskHooks::add([](TaskHooks::event_type, const void*) {}) == 0);
+#endif
+
+    return ptl_test::result();
+}
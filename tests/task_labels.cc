@@ -0,0 +1,154 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+/// \file task_labels.cc
+/// \brief The label of a task, given explicitly or by a TaskLabel::Scope, is the
+/// same interned label in the hooks, the trace and the statistics of the pool
+
+#include "ptl_json.hh"
+#include "ptl_test.hh"
+
+#include "PTL/TaskGroup.hh"
+#include "PTL/TaskHooks.hh"
+#include "PTL/TaskLabel.hh"
+#include "PTL/TaskTracer.hh"
+#include "PTL/ThreadPool.hh"
+#include "PTL/VTask.hh"
+
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+using namespace PTL;
+using ptl_test::json_value;
+
+namespace
+{
+constexpr size_t num_tasks = 50;
+
+// the number of tasks which began with each label
+struct label_counter
+{
+    std::mutex                         mutex{};
+    std::map<const TaskLabel*, size_t> counts{};
+
+    void operator()(TaskHooks::event_type, const void* _obj)
+    {
+        auto*                       _task = static_cast<const VTask*>(_obj);
+        std::lock_guard<std::mutex> _lk(mutex);
+        ++counts[_task->label()];
+    }
+
+    size_t operator[](const TaskLabel* _label)
+    {
+        std::lock_guard<std::mutex> _lk(mutex);
+        return counts[_label];
+    }
+};
+
+// the number of tasks which began with each name in the trace
+std::map<std::string, size_t>
+traced_names()
+{
+    std::stringstream _ss{};
+    TaskTracer::dump(_ss);
+
+    auto                          _text = _ss.str();
+    json_value                    _doc{};
+    std::map<std::string, size_t> _v{};
+    if(!ptl_test::json_reader{ _text }.parse(_doc) || !_doc.find("traceEvents"))
+        return _v;
+    for(const auto& itr : _doc.find("traceEvents")->array)
+    {
+        if(itr.get("ph") == "B")
+            ++_v[itr.get("name")];
+    }
+    return _v;
+}
+}  // namespace
+
+//--------------------------------------------------------------------------------------//
+
+int
+main()
+{
+    // interning returns the same label for the same name and location
+    const TaskLabel* _scoped = TaskLabel::intern("scoped");
+    PTL_CHECK(_scoped == TaskLabel::intern(std::string{ "scoped" }));
+    PTL_CHECK(_scoped != TaskLabel::intern("scoped", __FILE__, __LINE__));
+    PTL_CHECK(std::string{ _scoped->name } == "scoped");
+    const TaskLabel* _direct = PTL_TASK_LABEL("direct");
+
+    label_counter _counter{};
+    auto          _handle = TaskHooks::add(
+        [&_counter](TaskHooks::event_type _type, const void* _obj) {
+            _counter(_type, _obj);
+        },
+        TaskHooks::mask(TaskHooks::begin));
+    TaskTracer::enable();
+
+    ThreadPool::Config _cfg{};
+    _cfg.use_tbb   = false;
+    _cfg.pool_size = 2;
+    ThreadPool tp{ _cfg };
+    tp.reset_statistics();
+
+    TaskGroup<void> tg{ &tp };
+    for(size_t i = 0; i < num_tasks; ++i)
+    {
+        tg.exec(_direct, []() {});
+        tg.exec([]() {});
+    }
+    {
+        TaskLabel::Scope _scope{ _scoped };
+        for(size_t i = 0; i < num_tasks; ++i)
+            tg.exec([]() {});
+    }
+    PTL_CHECK(TaskLabel::current() == nullptr);
+    tg.join();
+
+    // the hooks
+#if defined(PTL_USE_TASK_HOOKS)
+    PTL_CHECK(_counter[_direct] == num_tasks);
+    PTL_CHECK(_counter[_scoped] == num_tasks);
+    PTL_CHECK(_counter[nullptr] == num_tasks);
+#endif
+    TaskHooks::remove(_handle);
+
+    // the trace
+    auto _names = traced_names();
+    PTL_CHECK(_names["direct"] == num_tasks);
+    PTL_CHECK(_names["scoped"] == num_tasks);
+    PTL_CHECK(_names["task"] >= num_tasks);
+    TaskTracer::disable();
+
+    // the statistics
+#if defined(PTL_USE_STATISTICS)
+    std::map<const TaskLabel*, uintmax_t> _executed{};
+    for(const auto& itr : tp.get_label_statistics())
+        _executed[itr.label] += itr.tasks_executed;
+    PTL_CHECK(_executed.size() == 2);
+    PTL_CHECK(_executed[_direct] == num_tasks);
+    PTL_CHECK(_executed[_scoped] == num_tasks);
+#endif
+
+    tp.destroy_threadpool();
+    return ptl_test::result();
+}
@@ -0,0 +1,153 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+/// \file task_tracer.cc
+/// \brief The Chrome trace written by TaskTracer is valid JSON in which every task
+/// begins and ends on its thread, and the buffers of the threads which exited are
+/// reused by the threads which start recording afterwards
+
+#include "ptl_json.hh"
+#include "ptl_test.hh"
+
+#include "PTL/TaskGroup.hh"
+#include "PTL/TaskLabel.hh"
+#include "PTL/TaskTracer.hh"
+#include "PTL/ThreadPool.hh"
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace PTL;
+using ptl_test::json_value;
+
+namespace
+{
+constexpr int num_tasks   = 200;
+constexpr int num_threads = 20;
+
+// the events of the trace written by TaskTracer::dump (empty if not valid JSON)
+std::vector<json_value>
+dump_events()
+{
+    std::stringstream _ss{};
+    TaskTracer::dump(_ss);
+
+    auto       _text = _ss.str();
+    json_value _doc{};
+    if(!ptl_test::json_reader{ _text }.parse(_doc))
+        return {};
+    auto* _events = _doc.find("traceEvents");
+    return (_events) ? _events->array : std::vector<json_value>{};
+}
+
+size_t
+count(const std::vector<json_value>& _events, const std::string& _ph,
+      const std::string& _name)
+{
+    size_t _n = 0;
+    for(const auto& itr : _events)
+    {
+        if(itr.get("ph") == _ph && itr.get("name") == _name)
+            ++_n;
+    }
+    return _n;
+}
+
+// true if the B and E events of the tasks are nested on every thread
+bool
+balanced(const std::vector<json_value>& _events)
+{
+    std::map<double, int> _depth{};
+    for(const auto& itr : _events)
+    {
+        auto  _name = itr.get("name");
+        auto* _tid  = itr.find("tid");
+        if(!_tid || (_name != "task" && _name != "traced"))
+            continue;
+        auto& _d = _depth[_tid->number];
+        if(itr.get("ph") == "B")
+            ++_d;
+        else if(itr.get("ph") == "E" && --_d < 0)
+            return false;
+    }
+    for(const auto& itr : _depth)
+    {
+        if(itr.second != 0)
+            return false;
+    }
+    return true;
+}
+}  // namespace
+
+//--------------------------------------------------------------------------------------//
+
+int
+main()
+{
+    TaskTracer::enable();
+
+    ThreadPool::Config _cfg{};
+    _cfg.use_tbb   = false;
+    _cfg.pool_size = 2;
+    ThreadPool tp{ _cfg };
+
+    TaskGroup<void> tg{ &tp };
+    for(int i = 0; i < num_tasks; ++i)
+    {
+        tg.exec([]() {});
+        tg.exec(PTL_TASK_LABEL("traced"), []() {});
+    }
+    tg.join();
+
+    // a worker records the end of a task after the join is released, the timelines of
+    // the workers are complete once they have exited
+    tp.destroy_threadpool();
+
+    // every task begins and ends, the labeled tasks are named by their label
+    auto _events = dump_events();
+    PTL_CHECK(!_events.empty());
+    PTL_CHECK(count(_events, "B", "traced") == num_tasks);
+    PTL_CHECK(count(_events, "E", "traced") == num_tasks);
+    PTL_CHECK(count(_events, "B", "task") >= num_tasks);
+    PTL_CHECK(count(_events, "B", "task") == count(_events, "E", "task"));
+    PTL_CHECK(count(_events, "i", "enqueue") >= 2 * num_tasks);
+    PTL_CHECK(balanced(_events));
+
+    size_t _labeled = 0;
+    for(const auto& itr : _events)
+    {
+        auto* _args = itr.find("args");
+        if(itr.get("name") == "traced" && _args && _args->get("label") == "traced" &&
+           !_args->get("location").empty())
+            ++_labeled;
+    }
+    PTL_CHECK(_labeled == 2 * num_tasks);
+
+    // the threads recording one after the other reuse the same buffer (or the buffer
+    // of an exited worker)
+    auto _nthreads = count(_events, "M", "thread_name");
+    for(int i = 0; i < num_threads; ++i)
+        std::thread{ []() { TaskTracer::record(TaskTracer::enqueue); } }.join();
+    PTL_CHECK(count(dump_events(), "M", "thread_name") <= _nthreads + 1);
+
+    TaskTracer::disable();
+    return ptl_test::result();
+}
@@ -0,0 +1,138 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+/// \file thread_bins.cc
+/// \brief The workers of a ThreadPool each use a distinct bin of the queue of their
+/// pool, whether several pools run at the same time or a pool is created within a
+/// task of another pool
+
+#include "ptl_test.hh"
+
+#include "PTL/TaskGroup.hh"
+#include "PTL/ThreadPool.hh"
+#include "PTL/VUserTaskQueue.hh"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace PTL;
+
+namespace
+{
+constexpr int num_rounds = 20;
+
+// true if every worker of the pool used a distinct bin of the queue of the pool
+bool
+distinct_bins(ThreadPool& tp)
+{
+    std::mutex         _mutex{};
+    std::set<intmax_t> _bins{};
+    size_t             _count = 0;
+    tp.execute_on_all_threads([&]() {
+        auto                        _bin = tp.get_queue()->GetThreadBin();
+        std::lock_guard<std::mutex> _lk(_mutex);
+        _bins.emplace(_bin);
+        ++_count;
+    });
+
+    // bin zero is left to the thread(s) which created the pool
+    auto _n = static_cast<intmax_t>(tp.size());
+    return (_count == tp.size() && _bins.size() == tp.size() && *_bins.begin() >= 1 &&
+            *_bins.rbegin() <= _n);
+}
+
+ThreadPool::Config
+make_config(size_t _size)
+{
+    ThreadPool::Config _cfg{};
+    _cfg.use_tbb   = false;
+    _cfg.pool_size = _size;
+    return _cfg;
+}
+}  // namespace
+
+//--------------------------------------------------------------------------------------//
+
+int
+main()
+{
+    std::atomic<int>         _failed{ 0 };
+    std::vector<std::thread> _threads{};
+
+    // two pools whose workers are registered at the same time
+    for(size_t _size : { 3, 4 })
+    {
+        _threads.emplace_back([_size, &_failed]() {
+            ThreadPool tp{ make_config(_size) };
+            for(int i = 0; i < num_rounds; ++i)
+            {
+                if(!distinct_bins(tp))
+                    ++_failed;
+            }
+
+            // a pool created within a task: its workers use the bins of its own queue
+            // and the worker creating it keeps its bin in the queue of its pool
+            TaskGroup<void> tg(&tp);
+            tg.exec([&tp, &_failed]() {
+                auto       _bin = tp.get_queue()->GetThreadBin();
+                ThreadPool _nested{ make_config(2) };
+                for(int i = 0; i < num_rounds; ++i)
+                {
+                    if(!distinct_bins(_nested))
+                        ++_failed;
+                }
+                if(_bin < 1 || tp.get_queue()->GetThreadBin() != _bin)
+                    ++_failed;
+                _nested.destroy_threadpool();
+            });
+            tg.join();
+
+            if(!distinct_bins(tp))
+                ++_failed;
+            tp.destroy_threadpool();
+        });
+    }
+
+    for(auto& itr : _threads)
+        itr.join();
+
+    PTL_CHECK(_failed.load() == 0);
+
+    // the slots stay dense when the pool is resized. The workers asked to stop exit
+    // (and hand over their slot) after resize() returns
+    ThreadPool tp{ make_config(4) };
+    for(size_t _size : { 2, 5, 3, 1, 4 })
+    {
+        tp.resize(_size);
+        bool _distinct = distinct_bins(tp);
+        for(int i = 0; i < 2000 && !_distinct; ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+            _distinct = distinct_bins(tp);
+        }
+        PTL_CHECK(_distinct);
+    }
+    tp.destroy_threadpool();
+
+    return ptl_test::result();
+}
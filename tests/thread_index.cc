@@ -0,0 +1,142 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+/// \file thread_index.cc
+/// \brief Looking up the index of another thread never registers it, so the indices
+/// of threads which are never registered (or have exited) are not leaked, the index
+/// of an exited thread is reused and no two live threads share an index
+
+#include "ptl_test.hh"
+
+#include "PTL/ThreadPool.hh"
+
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <thread>
+
+using namespace PTL;
+
+namespace
+{
+void
+test_foreign_lookup()
+{
+    auto _nbefore = ThreadPool::get_thread_ids().size();
+
+    // a thread which exits without ever being registered
+    ThreadId    _tid{};
+    std::thread _thr{ [&_tid]() { _tid = ThisThread::get_id(); } };
+    _thr.join();
+
+    for(int i = 0; i < 100; ++i)
+    {
+        PTL_CHECK(ThreadPool::get_thread_id(_tid) == ThreadPool::unregistered_thread_id);
+        PTL_CHECK(ThreadPool::add_thread_id(_tid) == ThreadPool::unregistered_thread_id);
+    }
+    PTL_CHECK(ThreadPool::get_thread_ids().size() == _nbefore);
+    PTL_CHECK(ThreadPool::get_thread_ids().count(_tid) == 0);
+}
+
+void
+test_registered_lookup()
+{
+    std::atomic<int> _stage{ 0 };
+    ThreadId         _tid{};
+    uintmax_t        _idx = 0;
+    std::thread      _thr{ [&]() {
+        _tid = ThisThread::get_id();
+        _idx = ThreadPool::get_this_thread_id();
+        _stage.store(1);
+        while(_stage.load() != 2)
+            std::this_thread::yield();
+    } };
+
+    while(_stage.load() != 1)
+        std::this_thread::yield();
+
+    // the registered thread is found from this thread
+    PTL_CHECK(ThreadPool::get_thread_id(_tid) == _idx);
+    PTL_CHECK(ThreadPool::get_thread_ids().count(_tid) == 1);
+
+    _stage.store(2);
+    _thr.join();
+
+    // and its index is released when it exits
+    PTL_CHECK(ThreadPool::get_thread_id(_tid) == ThreadPool::unregistered_thread_id);
+    PTL_CHECK(ThreadPool::get_thread_ids().count(_tid) == 0);
+
+    // the lowest free index is taken so the next thread gets the index back
+    uintmax_t   _next = 0;
+    std::thread _other{ [&_next]() { _next = ThreadPool::get_this_thread_id(); } };
+    _other.join();
+    PTL_CHECK(_next == _idx);
+}
+
+void
+test_two_pools()
+{
+    // the workers of both pools ask for the indices after the index of this thread
+    ThreadPool::Config _cfg{};
+    _cfg.use_tbb   = false;
+    _cfg.pool_size = 3;
+    ThreadPool _a{ _cfg };
+    ThreadPool _b{ _cfg };
+
+    // the workers register when they start
+    ThreadPool::thread_id_map_t _ids{};
+    for(int i = 0; i < 2000 && _ids.size() < 7; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+        _ids = ThreadPool::get_thread_ids();
+    }
+
+    std::set<uintmax_t> _idx{};
+    for(const auto& itr : _ids)
+        _idx.emplace(itr.second);
+    PTL_CHECK(_ids.size() >= 7);
+    PTL_CHECK(_idx.size() == _ids.size());
+
+    _a.destroy_threadpool();
+    _b.destroy_threadpool();
+}
+
+void
+test_this_thread()
+{
+    auto _idx = ThreadPool::get_this_thread_id();
+    PTL_CHECK(ThreadPool::get_thread_id(ThisThread::get_id()) == _idx);
+    PTL_CHECK(ThreadPool::add_thread_id() == _idx);
+}
+}  // namespace
+
+//--------------------------------------------------------------------------------------//
+
+int
+main()
+{
+    test_this_thread();
+    for(int i = 0; i < 10; ++i)
+    {
+        test_foreign_lookup();
+        test_registered_lookup();
+    }
+    test_two_pools();
+    return ptl_test::result();
+}
@@ -0,0 +1,144 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+/// \file thread_statistics.cc
+/// \brief The statistics of a ThreadPool count every task executed by its workers and
+/// merge the executions of the labeled tasks by label. After reset_statistics() they
+/// only count the tasks executed afterwards
+
+#include "ptl_test.hh"
+
+#include "PTL/TaskGroup.hh"
+#include "PTL/TaskLabel.hh"
+#include "PTL/ThreadPool.hh"
+
+#include <chrono>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace PTL;
+
+#if defined(PTL_USE_STATISTICS)
+namespace
+{
+constexpr int num_tasks  = 200;
+constexpr int num_labels = 40;  // enough to grow the label table of a thread
+constexpr int num_each   = 5;
+constexpr int num_slow   = 20;
+
+uintmax_t
+tasks_executed(const ThreadPool& tp)
+{
+    uintmax_t _n = 0;
+    for(const auto& itr : tp.get_statistics())
+        _n += itr.tasks_executed;
+    return _n;
+}
+
+uintmax_t
+label_executions(const ThreadPool& tp)
+{
+    uintmax_t _n = 0;
+    for(const auto& itr : tp.get_label_statistics())
+        _n += itr.tasks_executed;
+    return _n;
+}
+}  // namespace
+#endif
+
+//--------------------------------------------------------------------------------------//
+
+int
+main()
+{
+#if defined(PTL_USE_STATISTICS)
+    // the main thread of a pool of two workers does not execute the tasks of the group
+    ThreadPool::Config _cfg{};
+    _cfg.use_tbb   = false;
+    _cfg.pool_size = 2;
+    ThreadPool tp{ _cfg };
+    tp.reset_statistics();
+
+    std::vector<const TaskLabel*> _labels{};
+    for(int i = 0; i < num_labels; ++i)
+        _labels.emplace_back(TaskLabel::intern("label-" + std::to_string(i)));
+    const TaskLabel* _slow = PTL_TASK_LABEL("slow");
+
+    TaskGroup<void> tg{ &tp };
+    for(int i = 0; i < num_tasks; ++i)
+        tg.exec([]() {});
+    for(int i = 0; i < num_each; ++i)
+    {
+        for(const auto* itr : _labels)
+            tg.exec(itr, []() {});
+    }
+    for(int i = 0; i < num_slow; ++i)
+    {
+        tg.exec(_slow,
+                []() { std::this_thread::sleep_for(std::chrono::milliseconds{ 1 }); });
+    }
+    tg.join();
+
+    // every task is counted once, by the worker which executed it
+    auto _stats = tp.get_statistics();
+    PTL_CHECK(_stats.size() == 2);
+    PTL_CHECK(tasks_executed(tp) == num_tasks + num_labels * num_each + num_slow);
+
+    std::set<ThreadId> _tids{};
+    for(const auto& itr : _stats)
+    {
+        _tids.emplace(itr.thread_id);
+        PTL_CHECK(itr.busy_time.count() > 0);
+    }
+    PTL_CHECK(_tids.size() == 2);
+
+    // the labeled tasks are merged by label, the slowest label first
+    auto _label_stats = tp.get_label_statistics();
+    PTL_CHECK(_label_stats.size() == num_labels + 1);
+    PTL_CHECK(!_label_stats.empty() && _label_stats.front().label == _slow);
+    PTL_CHECK(!_label_stats.empty() && _label_stats.front().tasks_executed == num_slow);
+    PTL_CHECK(!_label_stats.empty() &&
+              _label_stats.front().busy_time >= std::chrono::milliseconds{ num_slow });
+    for(const auto& itr : _label_stats)
+    {
+        if(itr.label != _slow)
+            PTL_CHECK(itr.tasks_executed == num_each);
+    }
+
+    // after a reset only the tasks executed afterwards are counted
+    tp.reset_statistics();
+    PTL_CHECK(tasks_executed(tp) == 0);
+    PTL_CHECK(tp.get_label_statistics().empty());
+
+    for(int i = 0; i < num_each; ++i)
+        tg.exec(_labels.front(), []() {});
+    tg.join();
+
+    PTL_CHECK(tasks_executed(tp) == num_each);
+    _label_stats = tp.get_label_statistics();
+    PTL_CHECK(_label_stats.size() == 1);
+    PTL_CHECK(!_label_stats.empty() && _label_stats.front().label == _labels.front());
+    PTL_CHECK(label_executions(tp) == num_each);
+
+    tp.destroy_threadpool();
+#endif
+    return ptl_test::result();
+}
@@ -0,0 +1,241 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+/// \file timer_wheel.cc
+/// \brief TimerWheel expires one-shot and periodic timers at their tick, cancels
+/// timers before and after they cascade and expires timers parked in the overflow
+/// list, and passes the exceptions of the timer functions to the error handler.
+/// advance() is driven with explicit time points so the test does not depend on
+/// the speed of the machine
+
+#include "ptl_test.hh"
+
+#include "PTL/TimerWheel.hh"
+
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <stdexcept>
+#include <vector>
+
+using namespace PTL;
+
+namespace
+{
+using tick_type = TimerWheel::tick_type;
+using task_list = TimerWheel::task_list_t;
+
+// long enough that the wall-clock time spent by a test never reaches a tick
+const TimerWheel::duration resolution = std::chrono::seconds{ 10 };
+
+// wheel plus the time points of its ticks. The origin of the wheel is taken when it is
+// constructed, just before t0, so scheduling half a tick early rounds up to the tick
+// and advancing to t0 + n ticks rounds down to the tick
+struct wheel_fixture
+{
+    TimerWheel             wheel{ resolution };
+    TimerWheel::time_point t0 = TimerWheel::clock_type::now();
+
+    TimerWheel::time_point at(tick_type _n) const
+    {
+        return t0 + static_cast<int64_t>(_n) * resolution - resolution / 2;
+    }
+
+    TimerWheel::time_point tick(tick_type _n) const
+    {
+        return t0 + static_cast<int64_t>(_n) * resolution;
+    }
+
+    // expires the timers up to tick _n and runs their tasks
+    size_t advance(tick_type _n)
+    {
+        task_list _tasks{};
+        auto      _ret = wheel.advance(tick(_n), _tasks);
+        for(auto& itr : _tasks)
+            (*itr)();
+        return _ret;
+    }
+
+    tick_type next_tick() const
+    {
+        return static_cast<tick_type>((wheel.next_deadline() - t0 + resolution / 2) /
+                                      resolution);
+    }
+};
+
+// the first tick of level three and the first tick which no longer fits in the levels
+constexpr tick_type level3_tick   = tick_type{ 1 } << 25;
+constexpr tick_type overflow_tick = tick_type{ 1 } << 26;
+
+void
+test_one_shot()
+{
+    wheel_fixture _w{};
+    int           _count = 0;
+    auto          _id    = _w.wheel.schedule(_w.at(5), TimerWheel::duration::zero(),
+                                   [&_count]() { ++_count; });
+
+    PTL_CHECK(_w.wheel.size() == 1);
+    PTL_CHECK(_w.next_tick() == 5);
+    PTL_CHECK(_w.advance(4) == 0);
+    PTL_CHECK(_count == 0);
+    PTL_CHECK(_w.advance(5) == 1);
+    PTL_CHECK(_count == 1);
+    PTL_CHECK(_w.wheel.empty());
+    PTL_CHECK(!_w.wheel.cancel(_id));
+    PTL_CHECK(_w.advance(1000) == 0);
+    PTL_CHECK(_count == 1);
+}
+
+void
+test_periodic()
+{
+    constexpr tick_type first  = 10;
+    constexpr tick_type period = 7;
+
+    wheel_fixture _w{};
+    int           _count = 0;
+    auto          _id    = _w.wheel.schedule(_w.at(first), period * resolution,
+                                   [&_count]() { ++_count; });
+
+    // the expirations missed between two calls are all handed out and the timer stays
+    // on its original schedule however late advance() is called
+    for(tick_type _t : { 9, 12, 30, 31, 100, 1000, 20000 })
+    {
+        _w.advance(_t);
+        auto _expect = (_t < first) ? 0 : (_t - first) / period + 1;
+        PTL_CHECK(_count == static_cast<int>(_expect));
+        PTL_CHECK(_w.next_tick() == first + _expect * period);
+    }
+
+    PTL_CHECK(_w.wheel.size() == 1);
+    PTL_CHECK(_w.wheel.cancel(_id));
+    PTL_CHECK(_w.wheel.empty());
+    auto _count_at_cancel = _count;
+    _w.advance(30000);
+    PTL_CHECK(_count == _count_at_cancel);
+}
+
+void
+test_cancel(bool _after_cascade)
+{
+    wheel_fixture _w{};
+    int           _cancelled = 0;
+    int           _other     = 0;
+    // beyond the root level so the timer starts in level one
+    auto _id = _w.wheel.schedule(_w.at(1000), TimerWheel::duration::zero(),
+                                 [&_cancelled]() { ++_cancelled; });
+    // keeps the wheel turning past the cancelled timer
+    _w.wheel.schedule(_w.at(1500), TimerWheel::duration::zero(),
+                      [&_other]() { ++_other; });
+
+    if(_after_cascade)
+    {
+        // the level one slot holding tick 1000 is cascaded into the root at tick 768
+        PTL_CHECK(_w.advance(800) == 0);
+        PTL_CHECK(_w.next_tick() == 1000);
+    }
+
+    PTL_CHECK(_w.wheel.cancel(_id));
+    PTL_CHECK(!_w.wheel.cancel(_id));
+    PTL_CHECK(_w.wheel.size() == 1);
+    PTL_CHECK(_w.advance(2000) == 1);
+    PTL_CHECK(_cancelled == 0);
+    PTL_CHECK(_other == 1);
+    PTL_CHECK(_w.wheel.empty());
+}
+
+void
+test_overflow()
+{
+    wheel_fixture _w{};
+    int           _level3   = 0;
+    int           _overflow = 0;
+    _w.wheel.schedule(_w.at(level3_tick), TimerWheel::duration::zero(),
+                      [&_level3]() { ++_level3; });
+    _w.wheel.schedule(_w.at(overflow_tick + 300), TimerWheel::duration::zero(),
+                      [&_overflow]() { ++_overflow; });
+
+    PTL_CHECK(_w.advance(level3_tick - 1) == 0);
+    PTL_CHECK(_w.advance(level3_tick) == 1);
+    PTL_CHECK(_level3 == 1);
+    PTL_CHECK(_w.advance(overflow_tick + 299) == 0);
+    PTL_CHECK(_overflow == 0);
+    PTL_CHECK(_w.next_tick() == overflow_tick + 300);
+    PTL_CHECK(_w.advance(overflow_tick + 300) == 1);
+    PTL_CHECK(_overflow == 1);
+    PTL_CHECK(_w.wheel.empty());
+}
+
+void
+test_error_handler()
+{
+    wheel_fixture _w{};
+    int           _count = 0;
+    auto          _throw = []() { throw std::runtime_error{ "timer" }; };
+
+    // without a handler the exception reaches the thread executing the task
+    _w.wheel.schedule(_w.at(1), TimerWheel::duration::zero(), _throw);
+    bool _thrown = false;
+    try
+    {
+        _w.advance(1);
+    } catch(std::runtime_error&)
+    {
+        _thrown = true;
+    }
+    PTL_CHECK(_thrown);
+
+    std::vector<TimerWheel::timer_id> _ids{};
+    _w.wheel.set_error_handler([&_ids](TimerWheel::timer_id _id, std::exception_ptr _e) {
+        try
+        {
+            std::rethrow_exception(_e);
+        } catch(std::runtime_error&)
+        {
+            _ids.emplace_back(_id);
+        }
+    });
+
+    // the periodic timer keeps running after its function threw
+    auto _periodic = _w.wheel.schedule(_w.at(2), 2 * resolution, _throw);
+    auto _one_shot = _w.wheel.schedule(_w.at(3), TimerWheel::duration::zero(), _throw);
+    _w.wheel.schedule(_w.at(3), TimerWheel::duration::zero(), [&_count]() { ++_count; });
+    PTL_CHECK(_w.advance(4) == 4);
+    PTL_CHECK(_count == 1);
+    PTL_CHECK(_ids.size() == 3 && _ids.at(0) == _periodic && _ids.at(1) == _one_shot &&
+              _ids.at(2) == _periodic);
+    PTL_CHECK(_w.wheel.cancel(_periodic));
+    PTL_CHECK(_w.wheel.empty());
+}
+}  // namespace
+
+//--------------------------------------------------------------------------------------//
+
+int
+main()
+{
+    test_one_shot();
+    test_periodic();
+    test_cancel(false);
+    test_cancel(true);
+    test_overflow();
+    test_error_handler();
+    return ptl_test::result();
+}
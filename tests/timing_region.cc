@@ -0,0 +1,149 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+/// \file timing_region.cc
+/// \brief The timing regions entered by several threads are merged by name: the
+/// counts and times add up, the extremes are those of all the threads, and the
+/// results are ordered by decreasing total time until they are reset. The regions of
+/// the threads which exited are kept
+
+#include "ptl_test.hh"
+
+#include "PTL/TimingRegion.hh"
+
+#include <chrono>
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace PTL;
+
+namespace
+{
+constexpr int      num_threads = 4;
+constexpr int      num_records = 100;
+constexpr int      num_sleeps  = 5;
+constexpr uint64_t unit        = 1000;  // ticks
+
+// a region of the same name in another string, i.e. a region with another key
+const std::string known_copy = "known";
+
+bool
+near(double _lhs, double _rhs)
+{
+    return std::fabs(_lhs - _rhs) <= 1.0e-9 * std::fabs(_rhs);
+}
+
+const TimingResult*
+find(const TimingRegion::result_list_t& _results, const std::string& _name)
+{
+    for(const auto& itr : _results)
+    {
+        if(itr.name == _name)
+            return &itr;
+    }
+    return nullptr;
+}
+}  // namespace
+
+//--------------------------------------------------------------------------------------//
+
+int
+main()
+{
+    // thread t records (t + 1) * unit ticks, half of them under the other key
+    std::vector<std::thread> _threads{};
+    for(int t = 0; t < num_threads; ++t)
+    {
+        _threads.emplace_back([t]() {
+            const char* _name = (t % 2 == 0) ? "known" : known_copy.c_str();
+            for(int i = 0; i < num_records; ++i)
+                TimingRegion::record(_name, (t + 1) * unit);
+            for(int i = 0; i < num_sleeps; ++i)
+            {
+                PTL_TIMING_REGION("sleep");
+                std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+            }
+        });
+    }
+    for(auto& itr : _threads)
+        itr.join();
+
+    auto  _results = TimingRegion::get_results();
+    auto* _known   = find(_results, "known");
+    auto* _sleep   = find(_results, "sleep");
+    PTL_CHECK(_results.size() == 2);
+    PTL_CHECK(_known != nullptr && _sleep != nullptr);
+    if(!_known || !_sleep)
+        return ptl_test::result();
+
+    // the known ticks: one result per name, whichever string holds the name
+    uint64_t _ticks = 0;
+    for(int t = 0; t < num_threads; ++t)
+        _ticks += num_records * (t + 1) * unit;
+    PTL_CHECK(_known->count == num_threads * num_records);
+    PTL_CHECK(_known->threads == num_threads);
+    PTL_CHECK(near(_known->total, CycleClock::seconds(_ticks)));
+    PTL_CHECK(near(_known->min, CycleClock::seconds(unit)));
+    PTL_CHECK(near(_known->max, CycleClock::seconds(num_threads * unit)));
+    PTL_CHECK(near(_known->mean(), _known->total / _known->count));
+
+    // the scoped regions last at least the sleep (the clock rate is calibrated so a
+    // margin is left)
+    PTL_CHECK(_sleep->count == num_threads * num_sleeps);
+    PTL_CHECK(_sleep->threads == num_threads);
+    PTL_CHECK(_sleep->min >= 0.9e-3);
+    PTL_CHECK(_sleep->max >= _sleep->min && _sleep->total >= _sleep->count * _sleep->min);
+
+    // in the order of decreasing total time
+    for(size_t i = 1; i < _results.size(); ++i)
+        PTL_CHECK(_results.at(i - 1).total >= _results.at(i).total);
+
+    // the reporters print every region
+    for(const auto& itr :
+        { TimingRegion::table_reporter(), TimingRegion::timer_reporter() })
+    {
+        std::stringstream _ss{};
+        TimingRegion::report(_ss, itr);
+        PTL_CHECK(_ss.str().find("known") != std::string::npos);
+        PTL_CHECK(_ss.str().find("sleep") != std::string::npos);
+    }
+
+    TimingRegion::reset();
+    PTL_CHECK(TimingRegion::get_results().empty());
+
+    // the regions of a running thread are merged with the ones of the exited threads
+    TimingRegion::record("known", unit);
+    std::thread([]() { TimingRegion::record("known", 2 * unit); }).join();
+    _results = TimingRegion::get_results();
+    _known   = find(_results, "known");
+    PTL_CHECK(_results.size() == 1 && _known != nullptr);
+    if(_known)
+    {
+        PTL_CHECK(_known->count == 2 && _known->threads == 2);
+        PTL_CHECK(near(_known->total, CycleClock::seconds(3 * unit)));
+        PTL_CHECK(near(_known->max, CycleClock::seconds(2 * unit)));
+    }
+    TimingRegion::reset();
+    PTL_CHECK(TimingRegion::get_results().empty());
+
+    return ptl_test::result();
+}
@@ -0,0 +1,182 @@
+//
+// MIT License
+// Copyright (c) 2020 Jonathan R. Madsen
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software. THE SOFTWARE IS PROVIDED
+// "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT
+// LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+// PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+// WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+//
+
+/// \file topology.cc
+/// \brief Topology discovered from a fake sysfs tree and the CPU orders of the
+/// cpu_placement policies
+
+#include "ptl_fixture.hh"
+#include "ptl_test.hh"
+
+#include "PTL/Topology.hh"
+
+#include <string>
+#include <vector>
+
+using namespace PTL;
+
+namespace
+{
+using cpu_list_t = Topology::cpu_list_t;
+using ptl_test::write_file;
+
+// two sockets (and NUMA nodes) of two cores with two SMT siblings each. As on Linux,
+// the first siblings of all cores are numbered before the second ones:
+//
+//      socket 0: core 0 = { 0, 4 }, core 1 = { 1, 5 }
+//      socket 1: core 0 = { 2, 6 }, core 1 = { 3, 7 }
+//
+struct fake_sysfs : ptl_test::fixture_dir
+{
+    fake_sysfs()
+    {
+        write_file(root + "/cpu/online", "0-7\n");
+        write_file(root + "/node/online", "0-1\n");
+        write_file(root + "/node/node0/cpulist", "0-1,4-5\n");
+        write_file(root + "/node/node1/cpulist", "2-3,6-7\n");
+        for(int i = 0; i < 8; ++i)
+        {
+            int  _socket = (i % 4) / 2;
+            int  _core   = i % 2;
+            auto _dir    = root + "/cpu/cpu" + std::to_string(i);
+            auto _l3     = (_socket == 0) ? "0-1,4-5\n" : "2-3,6-7\n";
+            write_file(_dir + "/topology/physical_package_id", std::to_string(_socket));
+            write_file(_dir + "/topology/core_id", std::to_string(_core));
+            write_file(_dir + "/cache/index0/level", "1\n");
+            write_file(_dir + "/cache/index0/type", "Data\n");
+            write_file(_dir + "/cache/index0/size", "32K\n");
+            write_file(_dir + "/cache/index0/shared_cpu_list",
+                       std::to_string(i % 4) + "," + std::to_string(i % 4 + 4));
+            write_file(_dir + "/cache/index1/level", "3\n");
+            write_file(_dir + "/cache/index1/type", "Unified\n");
+            write_file(_dir + "/cache/index1/size", "8192K\n");
+            write_file(_dir + "/cache/index1/shared_cpu_list", _l3);
+        }
+    }
+};
+}  // namespace
+
+//--------------------------------------------------------------------------------------//
+
+void
+test_parse()
+{
+    PTL_CHECK((Topology::parse_cpu_list("0-3,8,10-11") ==
+               cpu_list_t{ 0, 1, 2, 3, 8, 10, 11 }));
+    PTL_CHECK((Topology::parse_cpu_list("5\n") == cpu_list_t{ 5 }));
+    PTL_CHECK(Topology::parse_cpu_list("").empty());
+
+    PTL_CHECK(Topology::parse_size("32K") == 32 * 1024);
+    PTL_CHECK(Topology::parse_size("8M") == 8 * 1024 * 1024);
+    PTL_CHECK(Topology::parse_size("64") == 64);
+    PTL_CHECK(Topology::parse_size("") == 0);
+}
+
+//--------------------------------------------------------------------------------------//
+
+void
+test_discover()
+{
+    fake_sysfs _sysfs{};
+    auto       _topo = Topology::discover(_sysfs.root);
+
+    PTL_CHECK(_topo.num_cpus() == 8);
+    PTL_CHECK(_topo.num_cores() == 4);
+    PTL_CHECK(_topo.num_sockets() == 2);
+    PTL_CHECK(_topo.num_nodes() == 2);
+    PTL_CHECK((_topo.nodes() == std::vector<int>{ 0, 1 }));
+
+    // the SMT sibling of cpu 0 shares its core
+    const auto& _cpus = _topo.cpus();
+    PTL_CHECK(_cpus.at(0).core == _cpus.at(4).core);
+    PTL_CHECK(_cpus.at(0).smt == 0 && _cpus.at(4).smt == 1);
+    PTL_CHECK(_cpus.at(2).socket == 1 && _cpus.at(2).core != _cpus.at(0).core);
+
+    PTL_CHECK(_topo.node_of(5) == 0);
+    PTL_CHECK(_topo.node_of(6) == 1);
+    PTL_CHECK((_topo.node_cpus(1) == cpu_list_t{ 2, 3, 6, 7 }));
+
+    // one L1 per core and one L3 per socket
+    PTL_CHECK(_topo.caches().size() == 6);
+
+    PTL_CHECK((_topo.placement(cpu_placement::COMPACT) ==
+               cpu_list_t{ 0, 4, 1, 5, 2, 6, 3, 7 }));
+    PTL_CHECK((_topo.placement(cpu_placement::SCATTER) ==
+               cpu_list_t{ 0, 2, 1, 3, 4, 6, 5, 7 }));
+    PTL_CHECK((_topo.placement(cpu_placement::PHYSICAL_CORES) ==
+               cpu_list_t{ 0, 1, 2, 3 }));
+    PTL_CHECK((_topo.placement(cpu_placement::NUMA_ROUND_ROBIN) ==
+               cpu_list_t{ 0, 2, 4, 6, 1, 3, 5, 7 }));
+
+    // thread indices wrap around the placement order
+    auto _func = _topo.placement_functor(cpu_placement::COMPACT);
+    PTL_CHECK(_func(1) == 4 && _func(9) == 4);
+}
+
+//--------------------------------------------------------------------------------------//
+
+void
+test_allowed()
+{
+    // restricted to the first sibling of every core
+    fake_sysfs _sysfs{};
+    auto       _topo = Topology::discover(_sysfs.root, { 3, 2, 1, 0 });
+
+    PTL_CHECK(_topo.num_cpus() == 4);
+    PTL_CHECK(_topo.num_cores() == 4);
+    PTL_CHECK(_topo.num_sockets() == 2);
+    PTL_CHECK((_topo.placement(cpu_placement::COMPACT) == cpu_list_t{ 0, 1, 2, 3 }));
+    PTL_CHECK((_topo.placement(cpu_placement::SCATTER) == cpu_list_t{ 0, 2, 1, 3 }));
+
+    // restricted to the second node, whose ID is kept
+    auto _second = Topology::discover(_sysfs.root, { 2, 3, 6, 7 });
+    PTL_CHECK(_second.num_nodes() == 1);
+    PTL_CHECK((_second.nodes() == std::vector<int>{ 1 }));
+    PTL_CHECK((_second.node_cpus(1) == cpu_list_t{ 2, 3, 6, 7 }));
+}
+
+//--------------------------------------------------------------------------------------//
+
+void
+test_missing()
+{
+    // without sysfs, every allowed CPU is a core of a single socket and node
+    ptl_test::fixture_dir _empty{};
+    auto                  _topo = Topology::discover(_empty.root + "/none", { 0, 1, 2 });
+
+    PTL_CHECK(_topo.num_cpus() == 3);
+    PTL_CHECK(_topo.num_cores() == 3);
+    PTL_CHECK(_topo.num_sockets() == 1);
+    PTL_CHECK(_topo.num_nodes() == 1);
+    PTL_CHECK((_topo.nodes() == std::vector<int>{ 0 }));
+    PTL_CHECK((_topo.placement(cpu_placement::SCATTER) == cpu_list_t{ 0, 1, 2 }));
+}
+
+//--------------------------------------------------------------------------------------//
+
+int
+main()
+{
+    test_parse();
+    test_discover();
+    test_allowed();
+    test_missing();
+
+    return ptl_test::result();
+}